@@ -0,0 +1,158 @@
+/* delta_codec.c
+ *
+ * 差分 + zigzag + varint 块编码，见 delta_codec.h 的格式说明。
+ */
+
+#include "delta_codec.h"
+
+#include <errno.h>
+#include <string.h>
+
+static void put_le16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    put_le16(p, (uint16_t)v);
+    put_le16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint16_t get_le16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return get_le16(p) | ((uint32_t)get_le16(p + 2) << 16);
+}
+
+/* ====================== varint ====================== */
+
+size_t dc_varint_put(uint8_t *p, uint32_t v)
+{
+    size_t n = 0;
+
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+
+    return n;
+}
+
+size_t dc_varint_get(const uint8_t *p, size_t len, uint32_t *v)
+{
+    uint32_t out = 0;
+
+    for (size_t i = 0; i < len && i < 5; i++) {
+        out |= (uint32_t)(p[i] & 0x7F) << (7 * i);
+        if ((p[i] & 0x80) == 0) {
+            *v = out;
+            return i + 1;
+        }
+    }
+
+    return 0;
+}
+
+/* ====================== 编码 ====================== */
+
+void dc_block_begin(struct dc_encoder *enc, uint8_t *buf, size_t cap,
+                    uint8_t nch, uint32_t t0_ms)
+{
+    enc->buf = buf;
+    enc->cap = cap;
+    enc->nch = (nch > DC_MAX_CH) ? DC_MAX_CH : nch;
+    enc->n = 0;
+    enc->prev_t = t0_ms;
+    enc->prev_dt = 0;
+    memset(enc->prev, 0, sizeof(enc->prev));
+
+    put_le16(&buf[0], DC_BLOCK_MAGIC);
+    buf[2] = enc->nch;
+    buf[3] = 0;
+    put_le16(&buf[4], 0);
+    put_le32(&buf[6], t0_ms);
+
+    enc->len = DC_HDR_SIZE;
+}
+
+bool dc_block_put(struct dc_encoder *enc, uint32_t t_ms, const int16_t *v)
+{
+    if (enc->len + DC_FRAME_MAX(enc->nch) > enc->cap || enc->n == UINT16_MAX) {
+        return false;
+    }
+
+    int32_t dt = (int32_t)(t_ms - enc->prev_t);
+
+    enc->len += dc_varint_put(&enc->buf[enc->len],
+                              dc_zigzag32(dt - enc->prev_dt));
+    enc->prev_t = t_ms;
+    enc->prev_dt = dt;
+
+    for (uint8_t c = 0; c < enc->nch; c++) {
+        int32_t d = (int32_t)v[c] - (int32_t)enc->prev[c];
+
+        enc->len += dc_varint_put(&enc->buf[enc->len], dc_zigzag32(d));
+        enc->prev[c] = v[c];
+    }
+
+    enc->n++;
+    return true;
+}
+
+size_t dc_block_finish(struct dc_encoder *enc)
+{
+    put_le16(&enc->buf[4], enc->n);
+    return enc->len;
+}
+
+/* ====================== 解码 ====================== */
+
+int dc_block_decode(const uint8_t *buf, size_t len, dc_frame_cb_t cb,
+                    void *user)
+{
+    if (len < DC_HDR_SIZE || get_le16(&buf[0]) != DC_BLOCK_MAGIC ||
+        buf[2] > DC_MAX_CH) {
+        return -EBADMSG;
+    }
+
+    uint8_t  nch = buf[2];
+    uint16_t n = get_le16(&buf[4]);
+    uint32_t t = get_le32(&buf[6]);
+    int32_t  dt = 0;
+    int16_t  v[DC_MAX_CH] = { 0 };
+    size_t   off = DC_HDR_SIZE;
+
+    for (uint16_t i = 0; i < n; i++) {
+        uint32_t u;
+        size_t k = dc_varint_get(&buf[off], len - off, &u);
+
+        if (k == 0) {
+            return -EBADMSG;
+        }
+        off += k;
+        dt += dc_unzigzag32(u);
+        t += (uint32_t)dt;
+
+        for (uint8_t c = 0; c < nch; c++) {
+            k = dc_varint_get(&buf[off], len - off, &u);
+            if (k == 0) {
+                return -EBADMSG;
+            }
+            off += k;
+            v[c] = (int16_t)(v[c] + dc_unzigzag32(u));
+        }
+
+        if (cb) {
+            cb(t, v, nch, user);
+        }
+    }
+
+    return n;
+}
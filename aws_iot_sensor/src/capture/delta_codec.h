@@ -0,0 +1,65 @@
+#ifndef DELTA_CODEC_H_
+#define DELTA_CODEC_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 多通道 int16 时间序列的块压缩：
+ *   块头: magic(2) | nch(1) | rsv(1) | n(2) | t0_ms(4)
+ *   每帧: varint(zigzag(dt - 上一帧 dt)) + 每通道 varint(zigzag(v - 上一帧 v))
+ * 固定采样率时 dt 的二阶差分恒为 0，每帧只占 1 字节；
+ * 慢变通道的一阶差分通常 1 字节，所以比 2 字节原始值小得多。
+ */
+
+#define DC_BLOCK_MAGIC    0xCA9E
+#define DC_HDR_SIZE       10
+#define DC_MAX_CH         12
+
+/* 单帧最坏情况字节数：dt varint 5 字节 + 每通道 3 字节 */
+#define DC_FRAME_MAX(nch) (5 + 3 * (nch))
+
+static inline uint32_t dc_zigzag32(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t dc_unzigzag32(uint32_t v)
+{
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+/* varint 编码 / 解码，返回写入 / 读取的字节数（解码失败返回 0） */
+size_t dc_varint_put(uint8_t *p, uint32_t v);
+size_t dc_varint_get(const uint8_t *p, size_t len, uint32_t *v);
+
+struct dc_encoder {
+    uint8_t *buf;
+    size_t   cap;
+    size_t   len;
+
+    uint8_t  nch;
+    uint16_t n;
+    uint32_t prev_t;
+    int32_t  prev_dt;
+    int16_t  prev[DC_MAX_CH];
+};
+
+/* 开一个新块 */
+void dc_block_begin(struct dc_encoder *enc, uint8_t *buf, size_t cap,
+                    uint8_t nch, uint32_t t0_ms);
+
+/* 追加一帧；块剩余空间不够最坏情况时返回 false（调用方应 finish 后再开新块） */
+bool dc_block_put(struct dc_encoder *enc, uint32_t t_ms, const int16_t *v);
+
+/* 回填块头中的帧数，返回块总字节数 */
+size_t dc_block_finish(struct dc_encoder *enc);
+
+/* 解码一个块：每帧调用一次 cb；返回帧数，格式错误返回 -EBADMSG */
+typedef void (*dc_frame_cb_t)(uint32_t t_ms, const int16_t *v, uint8_t nch,
+                              void *user);
+int dc_block_decode(const uint8_t *buf, size_t len, dc_frame_cb_t cb,
+                    void *user);
+
+#endif /* DELTA_CODEC_H_ */
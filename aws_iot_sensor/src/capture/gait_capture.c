@@ -0,0 +1,479 @@
+/* gait_capture.c
+ *
+ * 步态抓拍：
+ * - 传感器线程在采集状态下以 CONFIG_HORSE_CAPTURE_RATE_HZ 调 gait_capture_push()，
+ *   帧进 capture_msgq；
+ * - capture_thread 取帧、按块压缩（delta_codec），每满一块写一次 flash；
+ *   文件格式：[块长度 u16][块] [块长度 u16][块] ...，每块可独立解码；
+ * - 采集结束后 upload_work 在系统工作队列里分块发布到 CAPTURE_TOPIC，
+ *   每块带 (session, seq, offset, total) 头，PUBACK 后才推进进度并落盘。
+ */
+
+#include "gait_capture.h"
+#include "delta_codec.h"
+#include "app_fs.h"
+#include "mqtt_id.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/fs/fs.h>
+#include <zephyr/sys/byteorder.h>
+#include <net/aws_iot.h>
+#include <stdio.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(gait_capture, LOG_LEVEL_INF);
+
+/* ====================== 参数可调 ====================== */
+
+#define CAPTURE_DIR             APP_FS_MNT "/cap"
+#define CAPTURE_DATA_PATH       CAPTURE_DIR "/cap.bin"
+#define CAPTURE_STATE_PATH      CAPTURE_DIR "/cap.state"
+
+#define CAPTURE_TOPIC           "horse_capture"
+#define CAPTURE_META_TOPIC      "horse_capture_meta"
+
+/* 压缩块大小：越大写 flash 次数越少，但掉电时丢得越多 */
+#define CAPTURE_BLOCK_SIZE      512
+
+/* 帧队列：100 Hz 下约 1.3 s 的缓冲，足够盖住一次 flash 擦写 */
+#define CAPTURE_QUEUE_DEPTH     128
+
+/* 传感器迟迟不出帧（比如 BNO 掉线）时，超过时长这么久就强制结束 */
+#define CAPTURE_STALL_MS        10000
+
+/* 上传一块之后等 PUBACK 的时间，超时重发 */
+#define CAPTURE_ACK_TIMEOUT_SEC 30
+#define CAPTURE_RETRY_SEC       10
+
+#define CAPTURE_THREAD_STACK    2048
+#define CAPTURE_THREAD_PRIO     6
+
+#define CAPTURE_STATE_MAGIC     0x47414954 /* "GAIT" */
+
+/* 每块上传数据前的头：session(2) seq(2) offset(4) total(4) */
+#define CAPTURE_CHUNK_HDR       12
+
+/* ====================== 状态 ====================== */
+
+enum capture_phase {
+    CAP_IDLE = 0,
+    CAP_ARMED,      /* 已触发，等写线程开文件 */
+    CAP_RUNNING,    /* 采集中 */
+    CAP_UPLOAD,     /* 采集完成，等待 / 正在上传 */
+};
+
+/* 持久化到 CAPTURE_STATE_PATH，重启后续传 */
+struct capture_state {
+    uint32_t magic;
+    uint16_t session;
+    uint8_t  trigger;
+    uint8_t  meta_sent;
+    uint32_t file_size;
+    uint32_t upload_off;
+    int64_t  start_utc_ms;     /* 还没 GNSS 校准时为 0 */
+    struct capture_stats stats;
+};
+
+K_MSGQ_DEFINE(capture_msgq, sizeof(struct capture_frame), CAPTURE_QUEUE_DEPTH, 8);
+static K_SEM_DEFINE(capture_start_sem, 0, 1);
+K_MUTEX_DEFINE(capture_lock);
+
+static atomic_t phase = ATOMIC_INIT(CAP_IDLE);
+static uint32_t req_seconds;
+static enum capture_trigger req_trigger;
+static int64_t  last_anomaly_ms;
+static atomic_t dropped;
+
+static struct capture_state st;
+
+/* 上传 in-flight 状态（只有一块在途） */
+static uint16_t inflight_id;
+static uint32_t inflight_len;
+
+static void upload_work_fn(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(upload_work, upload_work_fn);
+
+/* ====================== 工具函数 ====================== */
+
+static int state_save(void)
+{
+    int err = app_fs_write_file(CAPTURE_STATE_PATH, &st, sizeof(st));
+
+    if (err) {
+        LOG_ERR("capture state save failed (%d)", err);
+    }
+    return err;
+}
+
+static int write_block(struct fs_file_t *f, struct dc_encoder *enc)
+{
+    size_t len = dc_block_finish(enc);
+    uint8_t hdr[2] = { (uint8_t)len, (uint8_t)(len >> 8) };
+
+    if (fs_write(f, hdr, sizeof(hdr)) != sizeof(hdr) ||
+        fs_write(f, enc->buf, len) != (ssize_t)len) {
+        return -EIO;
+    }
+
+    st.stats.enc_bytes += len + sizeof(hdr);
+    return 0;
+}
+
+static void log_stats(const struct capture_stats *s)
+{
+    uint32_t ratio_x100 = s->enc_bytes ? (s->raw_bytes * 100U) / s->enc_bytes : 0;
+    uint32_t rate_hz    = s->duration_ms ? (s->frames * 1000U) / s->duration_ms : 0;
+    uint32_t sustain_hz = s->writer_busy_us ?
+                          (uint32_t)(((uint64_t)s->frames * 1000000U) / s->writer_busy_us) : 0;
+
+    LOG_INF("Capture: %u frames in %u ms (%u Hz), dropped %u",
+            s->frames, s->duration_ms, rate_hz, s->dropped);
+    LOG_INF("Capture: raw %u B -> %u B, ratio %u.%02u, writer can sustain ~%u Hz",
+            s->raw_bytes, s->enc_bytes, ratio_x100 / 100, ratio_x100 % 100,
+            sustain_hz);
+}
+
+/* ====================== 采集（写线程） ====================== */
+
+static void run_session(void)
+{
+    static uint8_t block[CAPTURE_BLOCK_SIZE];
+    struct dc_encoder enc;
+    struct fs_file_t f;
+    tb_ts_t t0 = 0;
+    bool first = true;
+    uint32_t dur_ms = req_seconds * 1000U;
+    int64_t start_uptime = k_uptime_get();
+    int err;
+
+    fs_file_t_init(&f);
+    err = fs_open(&f, CAPTURE_DATA_PATH, FS_O_CREATE | FS_O_WRITE | FS_O_TRUNC);
+    if (err) {
+        LOG_ERR("capture file open failed (%d)", err);
+        atomic_set(&phase, CAP_IDLE);
+        return;
+    }
+
+    memset(&st.stats, 0, sizeof(st.stats));
+    st.session++;
+    st.trigger = (uint8_t)req_trigger;
+    st.meta_sent = 0;
+    st.file_size = 0;
+    st.upload_off = 0;
+    st.start_utc_ms = 0;
+    atomic_set(&dropped, 0);
+
+    k_msgq_purge(&capture_msgq);
+    atomic_set(&phase, CAP_RUNNING);
+
+    LOG_INF("Capture session %u started (%u s, trigger %u)",
+            st.session, req_seconds, st.trigger);
+
+    while (1) {
+        struct capture_frame fr;
+
+        if (k_msgq_get(&capture_msgq, &fr, K_MSEC(500)) != 0) {
+            if (k_uptime_get() - start_uptime > (int64_t)dur_ms + CAPTURE_STALL_MS) {
+                LOG_WRN("Capture stalled, finishing early");
+                break;
+            }
+            continue;
+        }
+
+        uint32_t c0 = k_cycle_get_32();
+
+        if (first) {
+            t0 = fr.ts;
+            first = false;
+            (void)timebase_to_utc_ms(t0, &st.start_utc_ms);
+            dc_block_begin(&enc, block, sizeof(block), CAPTURE_NCH, 0);
+        }
+
+        uint32_t t_ms = timebase_delta_ms(t0, fr.ts);
+
+        if (t_ms >= dur_ms) {
+            break;
+        }
+
+        if (!dc_block_put(&enc, t_ms, fr.v)) {
+            err = write_block(&f, &enc);
+            if (err) {
+                LOG_ERR("capture block write failed (%d)", err);
+                break;
+            }
+            dc_block_begin(&enc, block, sizeof(block), CAPTURE_NCH, t_ms);
+            (void)dc_block_put(&enc, t_ms, fr.v);
+        }
+
+        st.stats.frames++;
+        st.stats.duration_ms = t_ms;
+        st.stats.writer_busy_us += k_cyc_to_us_floor32(k_cycle_get_32() - c0);
+    }
+
+    /* 先停掉生产者，再收尾；收尾期间不让上传 work 看到半成品状态 */
+    k_mutex_lock(&capture_lock, K_FOREVER);
+    atomic_set(&phase, CAP_UPLOAD);
+    k_msgq_purge(&capture_msgq);
+
+    if (!first && enc.n > 0) {
+        (void)write_block(&f, &enc);
+    }
+    (void)fs_close(&f);
+
+    st.stats.dropped   = (uint32_t)atomic_get(&dropped);
+    st.stats.raw_bytes = st.stats.frames * (4U + 2U * CAPTURE_NCH);
+    st.file_size       = st.stats.enc_bytes;
+
+    log_stats(&st.stats);
+
+    if (st.stats.frames == 0) {
+        atomic_set(&phase, CAP_IDLE);
+        (void)fs_unlink(CAPTURE_DATA_PATH);
+    } else {
+        (void)state_save();
+        k_work_reschedule(&upload_work, K_NO_WAIT);
+    }
+
+    k_mutex_unlock(&capture_lock);
+}
+
+static void capture_thread(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    while (1) {
+        k_sem_take(&capture_start_sem, K_FOREVER);
+        run_session();
+    }
+}
+
+K_THREAD_DEFINE(capture_thread_id, CAPTURE_THREAD_STACK, capture_thread,
+                NULL, NULL, NULL, CAPTURE_THREAD_PRIO, 0, 0);
+
+/* ====================== 上传（系统工作队列） ====================== */
+
+static int publish(const char *topic, const void *buf, size_t len,
+                   uint16_t message_id)
+{
+    struct aws_iot_data tx = { 0 };
+
+    tx.qos        = MQTT_QOS_1_AT_LEAST_ONCE;
+    tx.ptr        = (char *)buf;
+    tx.len        = len;
+    tx.message_id = message_id;
+    tx.topic.str  = topic;
+    tx.topic.len  = strlen(topic);
+
+    return aws_iot_send(&tx);
+}
+
+static int publish_meta(void)
+{
+    const struct capture_stats *s = &st.stats;
+    char json[200];
+    uint32_t ratio_x100 = s->enc_bytes ? (s->raw_bytes * 100U) / s->enc_bytes : 0;
+    uint32_t rate_hz    = s->duration_ms ? (s->frames * 1000U) / s->duration_ms : 0;
+    uint32_t sustain_hz = s->writer_busy_us ?
+                          (uint32_t)(((uint64_t)s->frames * 1000000U) / s->writer_busy_us) : 0;
+
+    int n = snprintf(json, sizeof(json),
+                     "{\"session\":%u,\"trigger\":%u,\"start_utc\":%lld,"
+                     "\"frames\":%u,\"dropped\":%u,\"rate_hz\":%u,"
+                     "\"bytes\":%u,\"ratio_x100\":%u,\"sustain_hz\":%u}",
+                     st.session, st.trigger, (long long)st.start_utc_ms,
+                     s->frames, s->dropped, rate_hz,
+                     st.file_size, ratio_x100, sustain_hz);
+
+    return publish(CAPTURE_META_TOPIC, json, n, mqtt_id_next());
+}
+
+static void upload_finish(void)
+{
+    LOG_INF("Capture session %u uploaded (%u B)", st.session, st.file_size);
+    (void)fs_unlink(CAPTURE_DATA_PATH);
+    (void)state_save();
+    atomic_set(&phase, CAP_IDLE);
+}
+
+static void upload_work_fn(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    static uint8_t chunk[CAPTURE_CHUNK_HDR + CONFIG_HORSE_CAPTURE_CHUNK_SIZE];
+    struct fs_file_t f;
+    ssize_t n;
+    int err;
+
+    k_mutex_lock(&capture_lock, K_FOREVER);
+
+    if (atomic_get(&phase) != CAP_UPLOAD) {
+        goto out;
+    }
+
+    if (st.upload_off >= st.file_size) {
+        upload_finish();
+        goto out;
+    }
+
+    if (!st.meta_sent) {
+        if (publish_meta() == 0) {
+            st.meta_sent = 1;
+        }
+    }
+
+    fs_file_t_init(&f);
+    err = fs_open(&f, CAPTURE_DATA_PATH, FS_O_READ);
+    if (err) {
+        LOG_ERR("capture file missing (%d), dropping session", err);
+        atomic_set(&phase, CAP_IDLE);
+        goto out;
+    }
+
+    (void)fs_seek(&f, st.upload_off, FS_SEEK_SET);
+    n = fs_read(&f, &chunk[CAPTURE_CHUNK_HDR], CONFIG_HORSE_CAPTURE_CHUNK_SIZE);
+    (void)fs_close(&f);
+
+    if (n <= 0) {
+        LOG_ERR("capture file read failed (%d)", (int)n);
+        k_work_reschedule(&upload_work, K_SECONDS(CAPTURE_RETRY_SEC));
+        goto out;
+    }
+
+    uint16_t seq = (uint16_t)(st.upload_off / CONFIG_HORSE_CAPTURE_CHUNK_SIZE);
+
+    sys_put_le16(st.session, &chunk[0]);
+    sys_put_le16(seq, &chunk[2]);
+    sys_put_le32(st.upload_off, &chunk[4]);
+    sys_put_le32(st.file_size, &chunk[8]);
+
+    inflight_id  = mqtt_id_next();
+    inflight_len = (uint32_t)n;
+
+    err = publish(CAPTURE_TOPIC, chunk, CAPTURE_CHUNK_HDR + n, inflight_id);
+    if (err) {
+        /* 多半是断线了，等重连后 gait_capture_resume_upload() 再触发 */
+        LOG_WRN("capture chunk %u publish failed (%d)", seq, err);
+        inflight_id = 0;
+        k_work_reschedule(&upload_work, K_SECONDS(CAPTURE_RETRY_SEC));
+        goto out;
+    }
+
+    /* 等 PUBACK；超时就重发同一块 */
+    k_work_reschedule(&upload_work, K_SECONDS(CAPTURE_ACK_TIMEOUT_SEC));
+
+out:
+    k_mutex_unlock(&capture_lock);
+}
+
+/* ====================== 对外接口 ====================== */
+
+int gait_capture_init(void)
+{
+    int err;
+
+    if (!app_fs_ready()) {
+        return -ENODEV;
+    }
+
+    err = app_fs_mkdir(CAPTURE_DIR);
+    if (err) {
+        return err;
+    }
+
+    if (app_fs_read_file(CAPTURE_STATE_PATH, &st, sizeof(st)) != 0 ||
+        st.magic != CAPTURE_STATE_MAGIC) {
+        memset(&st, 0, sizeof(st));
+        st.magic = CAPTURE_STATE_MAGIC;
+        return 0;
+    }
+
+    if (st.upload_off < st.file_size) {
+        LOG_INF("Capture session %u pending upload (%u/%u B)",
+                st.session, st.upload_off, st.file_size);
+        atomic_set(&phase, CAP_UPLOAD);
+    }
+
+    return 0;
+}
+
+int gait_capture_trigger(enum capture_trigger src, uint32_t seconds)
+{
+    if (!app_fs_ready()) {
+        return -ENODEV;
+    }
+
+    if (src == CAPTURE_TRIGGER_ANOMALY) {
+        int64_t now = k_uptime_get();
+
+        if (last_anomaly_ms != 0 &&
+            now - last_anomaly_ms < CONFIG_HORSE_CAPTURE_ANOMALY_COOLDOWN_MIN * 60000LL) {
+            return -EALREADY;
+        }
+        last_anomaly_ms = now;
+    }
+
+    if (!atomic_cas(&phase, CAP_IDLE, CAP_ARMED)) {
+        LOG_WRN("Capture busy, trigger %d ignored", src);
+        return -EBUSY;
+    }
+
+    req_seconds = CLAMP(seconds, 1, CONFIG_HORSE_CAPTURE_MAX_SECONDS);
+    req_trigger = src;
+    k_sem_give(&capture_start_sem);
+
+    return 0;
+}
+
+bool gait_capture_active(void)
+{
+    atomic_val_t p = atomic_get(&phase);
+
+    return p == CAP_ARMED || p == CAP_RUNNING;
+}
+
+uint32_t gait_capture_period_ms(void)
+{
+    return 1000U / CONFIG_HORSE_CAPTURE_RATE_HZ;
+}
+
+void gait_capture_push(const struct capture_frame *frame)
+{
+    if (atomic_get(&phase) != CAP_RUNNING) {
+        return;
+    }
+
+    if (k_msgq_put(&capture_msgq, frame, K_NO_WAIT) != 0) {
+        atomic_inc(&dropped);
+    }
+}
+
+void gait_capture_resume_upload(void)
+{
+    if (atomic_get(&phase) == CAP_UPLOAD) {
+        k_work_reschedule(&upload_work, K_SECONDS(1));
+    }
+}
+
+void gait_capture_on_puback(uint16_t message_id)
+{
+    k_mutex_lock(&capture_lock, K_FOREVER);
+
+    if (inflight_id != 0 && message_id == inflight_id) {
+        inflight_id = 0;
+        st.upload_off += inflight_len;
+        (void)state_save();
+        k_work_reschedule(&upload_work, K_NO_WAIT);
+    }
+
+    k_mutex_unlock(&capture_lock);
+}
+
+void gait_capture_get_stats(struct capture_stats *out)
+{
+    k_mutex_lock(&capture_lock, K_FOREVER);
+    *out = st.stats;
+    k_mutex_unlock(&capture_lock);
+}
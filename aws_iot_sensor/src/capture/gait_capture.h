@@ -0,0 +1,62 @@
+#ifndef GAIT_CAPTURE_H_
+#define GAIT_CAPTURE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "timebase.h"
+
+/*
+ * 高速步态抓拍（兽医检查用）
+ *
+ * 由 shadow 命令或步态异常触发，按 CONFIG_HORSE_CAPTURE_RATE_HZ 采集原始 IMU 数据，
+ * 差分 + zigzag varint 压缩后写入 littlefs，采集结束后在后台分块上传，
+ * 每块 PUBACK 之后才推进上传进度，断线 / 重启后从断点续传。
+ */
+
+/* 每帧通道：acc xyz, gyr xyz, euler heading/roll/pitch（BNO055 原始 LSB） */
+#define CAPTURE_NCH 9
+
+struct capture_frame {
+    tb_ts_t ts;
+    int16_t v[CAPTURE_NCH];
+};
+
+enum capture_trigger {
+    CAPTURE_TRIGGER_SHADOW = 0,   /* shadow delta 里的 "capture" 命令 */
+    CAPTURE_TRIGGER_ANOMALY,      /* 平衡 / 步态异常 */
+};
+
+/* 一次抓拍的统计，采集结束时打印并随上传元数据发出 */
+struct capture_stats {
+    uint32_t frames;
+    uint32_t dropped;          /* 队列满丢掉的帧 */
+    uint32_t duration_ms;
+    uint32_t raw_bytes;        /* 未压缩大小（时间戳 4 字节 + 通道 2 字节） */
+    uint32_t enc_bytes;        /* 压缩后写入 flash 的大小 */
+    uint32_t writer_busy_us;   /* 写线程编码 + 写 flash 的累计耗时 */
+};
+
+int gait_capture_init(void);
+
+/* 触发一次抓拍；正在采集或上一段还没传完时返回 -EBUSY */
+int gait_capture_trigger(enum capture_trigger src, uint32_t seconds);
+
+/* 是否处于采集状态（传感器线程据此切换到高速采样） */
+bool gait_capture_active(void);
+
+/* 采样周期（ms），采集状态下传感器线程用 */
+uint32_t gait_capture_period_ms(void);
+
+/* 传感器线程每采一帧调用一次，不阻塞 */
+void gait_capture_push(const struct capture_frame *frame);
+
+/* MQTT 连上之后调用，继续上传未完成的抓拍 */
+void gait_capture_resume_upload(void);
+
+/* MQTT PUBACK 回调里调用 */
+void gait_capture_on_puback(uint16_t message_id);
+
+void gait_capture_get_stats(struct capture_stats *out);
+
+#endif /* GAIT_CAPTURE_H_ */
@@ -0,0 +1,134 @@
+#include "colic_detector.h"
+
+#include <math.h>
+#include <string.h>
+
+/* 站立时 roll 基线的平滑系数 */
+#define ROLL0_ALPHA      0.01f
+
+/* 打滚要比左右倾阈值大得多：马侧躺再翻过去 roll 会超过 2 倍阈值 */
+#define ROLL_LYING_MULT  2.0f
+
+/* 桶计数饱和加一；加上了才同步加滑动和，保证出桶时减得回去 */
+static inline void sat_inc(uint8_t *v, uint16_t *sum)
+{
+    if (*v < UINT8_MAX) {
+        (*v)++;
+        (*sum)++;
+    }
+}
+
+/* 推进到 minute 对应的桶，把中间经过的桶清掉（最多 COLIC_BUCKETS 个） */
+static void advance(colic_detector_t *cd, uint32_t minute)
+{
+    if (!cd->started) {
+        cd->cur_minute = minute;
+        cd->started = true;
+        return;
+    }
+
+    if (minute <= cd->cur_minute) {
+        return;   /* 同一分钟，或者时间回退：留在当前桶 */
+    }
+
+    uint32_t steps = minute - cd->cur_minute;
+
+    if (steps > COLIC_BUCKETS) {
+        steps = COLIC_BUCKETS;
+    }
+
+    for (uint32_t i = 1; i <= steps; i++) {
+        uint32_t b = (cd->cur_minute + i) % COLIC_BUCKETS;
+
+        cd->lie_sum           -= cd->lie_cnt[b];
+        cd->roll_lying_sum    -= cd->roll_lying_cnt[b];
+        cd->roll_standing_sum -= cd->roll_standing_cnt[b];
+        cd->lie_cnt[b] = 0;
+        cd->roll_lying_cnt[b] = 0;
+        cd->roll_standing_cnt[b] = 0;
+    }
+
+    cd->cur_minute = minute;
+}
+
+static colic_level_t classify(const colic_detector_t *cd)
+{
+    if ((cd->lie_sum >= cd->alert_lie && cd->roll_lying_sum >= cd->alert_roll) ||
+        cd->lie_sum >= cd->alert_lie_only) {
+        return COLIC_LEVEL_ALERT;
+    }
+
+    if (cd->lie_sum >= cd->watch_lie || cd->roll_lying_sum > 0 ||
+        cd->roll_standing_sum >= cd->alert_roll) {
+        return COLIC_LEVEL_WATCH;
+    }
+
+    return COLIC_LEVEL_NONE;
+}
+
+void colic_detector_init(colic_detector_t *cd, float lr_thresh_deg)
+{
+    memset(cd, 0, sizeof(*cd));
+
+    cd->lr_thresh_deg  = lr_thresh_deg;
+    cd->watch_lie      = 2;
+    cd->alert_lie      = 2;
+    cd->alert_roll     = 3;
+    cd->alert_lie_only = 4;
+    cd->level          = COLIC_LEVEL_NONE;
+}
+
+colic_level_t colic_detector_update(colic_detector_t *cd, uint32_t t_s,
+                                    bool lying, bool roll_valid, float roll,
+                                    bool *escalated_if_nonnull)
+{
+    advance(cd, t_s / 60U);
+
+    uint32_t b = cd->cur_minute % COLIC_BUCKETS;
+
+    /* 站 → 卧 */
+    if (lying && !cd->was_lying) {
+        sat_inc(&cd->lie_cnt[b], &cd->lie_sum);
+    }
+    cd->was_lying = lying;
+
+    if (roll_valid) {
+        if (!cd->roll0_set) {
+            cd->roll0 = roll;
+            cd->roll0_set = true;
+        }
+
+        float ds = roll - cd->roll0;
+        float d = fabsf(ds);
+        float thresh = lying ? cd->lr_thresh_deg * ROLL_LYING_MULT : cd->lr_thresh_deg;
+        int8_t dir = (ds > 0.0f) ? 1 : -1;
+
+        /* 新的一次偏离：从基线附近出来，或者直接翻到另一侧（打滚翻身不经过基线） */
+        if (d > thresh && (!cd->in_excursion || dir != cd->exc_dir)) {
+            cd->in_excursion = true;
+            cd->exc_dir = dir;
+            if (lying) {
+                sat_inc(&cd->roll_lying_cnt[b], &cd->roll_lying_sum);
+            } else {
+                sat_inc(&cd->roll_standing_cnt[b], &cd->roll_standing_sum);
+            }
+        } else if (cd->in_excursion && d < thresh * 0.5f) {
+            /* 回到一半阈值以内才算这次结束（滞回） */
+            cd->in_excursion = false;
+        }
+
+        if (!lying && !cd->in_excursion) {
+            cd->roll0 += ROLL0_ALPHA * (roll - cd->roll0);
+        }
+    }
+
+    colic_level_t prev = cd->level;
+
+    cd->level = classify(cd);
+
+    if (escalated_if_nonnull) {
+        *escalated_if_nonnull = (cd->level > prev);
+    }
+
+    return cd->level;
+}
@@ -0,0 +1,76 @@
+#ifndef COLIC_DETECTOR_H_
+#define COLIC_DETECTOR_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * 疝痛（colic）打滚行为检测 —— 纯逻辑，不依赖内核，可以在 native_sim 上回放测试。
+ *
+ * 输入（每个样本）：时间（秒）、是否卧倒、可选的 roll（IMU 断电时没有）。
+ * 统计最近一小时（60 个 1 分钟桶的滑动窗口）：
+ *   - 卧倒次数（站→卧的次数）；
+ *   - 卧倒状态下 roll 偏离基线超过 lr_thresh_deg 的次数（打滚）；
+ *   - 站立时的大幅 roll 偏离次数（频繁侧倾 / 踢腹）。
+ * 每个样本只更新当前桶和三个滑动和，O(1)；时间跳跃时最多清 60 个桶。
+ */
+
+#define COLIC_BUCKETS      60     /* 1 分钟一个桶，共 1 小时 */
+
+typedef enum {
+    COLIC_LEVEL_NONE = 0,
+    COLIC_LEVEL_WATCH,            /* 有迹象，继续观察 */
+    COLIC_LEVEL_ALERT,            /* 反复卧倒 + 打滚，立即报警 */
+} colic_level_t;
+
+typedef struct {
+    /* 参数（init 给默认值，可以改） */
+    float   lr_thresh_deg;        /* 左右倾阈值，和平衡检测的 lr_thresh_deg 同义 */
+    uint8_t watch_lie;            /* 一小时卧倒次数 >= 这个 → WATCH */
+    uint8_t alert_lie;            /* 一小时卧倒次数 >= 这个 且 */
+    uint8_t alert_roll;           /* 卧倒打滚次数 >= 这个 → ALERT */
+    uint8_t alert_lie_only;       /* 或者只看卧倒次数 >= 这个 → ALERT */
+
+    /* 滑动窗口 */
+    uint8_t  lie_cnt[COLIC_BUCKETS];
+    uint8_t  roll_lying_cnt[COLIC_BUCKETS];
+    uint8_t  roll_standing_cnt[COLIC_BUCKETS];
+    uint16_t lie_sum;
+    uint16_t roll_lying_sum;
+    uint16_t roll_standing_sum;
+    uint32_t cur_minute;          /* 当前桶对应的分钟数 */
+    bool     started;
+
+    /* 单样本状态 */
+    bool  was_lying;
+    bool  in_excursion;
+    int8_t exc_dir;               /* 当前偏离方向 +1 / -1 */
+    bool  roll0_set;
+    float roll0;                  /* 站立时 roll 的慢基线 */
+
+    colic_level_t level;
+} colic_detector_t;
+
+void colic_detector_init(colic_detector_t *cd, float lr_thresh_deg);
+
+/*
+ * 喂一个样本。roll_valid == false 时忽略 roll（只统计卧倒）。
+ * escalated_if_nonnull：这次调用使级别升高时置 true。
+ * 返回当前级别。
+ */
+colic_level_t colic_detector_update(colic_detector_t *cd, uint32_t t_s,
+                                    bool lying, bool roll_valid, float roll,
+                                    bool *escalated_if_nonnull);
+
+/* 最近一小时的统计 */
+static inline uint16_t colic_detector_lie_count(const colic_detector_t *cd)
+{
+    return cd->lie_sum;
+}
+
+static inline uint16_t colic_detector_roll_count(const colic_detector_t *cd)
+{
+    return cd->roll_lying_sum;
+}
+
+#endif /* COLIC_DETECTOR_H_ */
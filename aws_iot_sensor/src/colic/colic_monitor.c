@@ -0,0 +1,164 @@
+/* colic_monitor.c
+ *
+ * 疝痛检测运行时外壳，见 colic_monitor.h。
+ * 两个传感器线程都会喂样本，detector 状态用 spinlock 保护；
+ * 发布放到系统工作队列里做，不阻塞传感器线程。
+ */
+
+#include "colic_monitor.h"
+#include "baro_posture.h"
+#include "sensor.h"
+#include "gait_capture.h"
+#include "mqtt_id.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <net/aws_iot.h>
+#include <stdio.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(colic_monitor, LOG_LEVEL_INF);
+
+/* ====================== 参数可调 ====================== */
+
+#define COLIC_ALERT_TOPIC       "horse_alert"
+
+/* 报警没发出去（还没连上）时的重试间隔 */
+#define COLIC_ALERT_RETRY_SEC   10
+
+/* ====================== 状态 ====================== */
+
+static struct k_spinlock colic_lock;
+static colic_detector_t detector;
+static bool detector_ready;
+
+/* 高采样期截止时间（k_uptime 秒），0 = 不在高采样期 */
+static atomic_t boost_until_s;
+
+/* 待发的报警快照 */
+static struct {
+    bool     pending;
+    uint32_t seq;         /* 每次新报警 +1：发送期间又来一次，发完不能把新的清掉 */
+    uint8_t  level;
+    uint16_t lie;
+    uint16_t roll;
+    int64_t  utc_ms;
+} alert;
+
+static void alert_work_fn(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(alert_work, alert_work_fn);
+
+/* ====================== 报警发布 ====================== */
+
+static void alert_work_fn(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    char json[160];
+    struct aws_iot_data tx = { 0 };
+
+    k_spinlock_key_t key = k_spin_lock(&colic_lock);
+    bool pending = alert.pending;
+    uint32_t seq = alert.seq;
+    int n = snprintf(json, sizeof(json),
+                     "{\"type\":\"colic\",\"level\":%u,\"lie_1h\":%u,"
+                     "\"roll_1h\":%u,\"utc_ms\":%lld}",
+                     alert.level, alert.lie, alert.roll, (long long)alert.utc_ms);
+    k_spin_unlock(&colic_lock, key);
+
+    if (!pending) {
+        return;
+    }
+
+    tx.qos       = MQTT_QOS_1_AT_LEAST_ONCE;
+    tx.message_id = mqtt_id_next();
+    tx.ptr       = json;
+    tx.len       = n;
+    tx.topic.str = COLIC_ALERT_TOPIC;
+    tx.topic.len = strlen(COLIC_ALERT_TOPIC);
+
+    int err = aws_iot_send(&tx);
+    if (err) {
+        LOG_WRN("Colic alert publish failed (%d), retrying", err);
+        k_work_reschedule(&alert_work, K_SECONDS(COLIC_ALERT_RETRY_SEC));
+        return;
+    }
+
+    LOG_WRN("Colic alert sent: %s", json);
+
+    key = k_spin_lock(&colic_lock);
+    if (alert.seq == seq) {
+        alert.pending = false;
+    }
+    k_spin_unlock(&colic_lock, key);
+}
+
+/* ====================== 喂样本 ====================== */
+
+static void feed(tb_ts_t ts, bool roll_valid, float roll)
+{
+    bool escalated = false;
+    uint32_t t_s = (uint32_t)(ts / TB_FREQ_HZ);
+    bool lying = (baro_posture_state() == POSTURE_LYING);
+
+    k_spinlock_key_t key = k_spin_lock(&colic_lock);
+
+    if (!detector_ready) {
+        colic_detector_init(&detector, SENSOR_LR_THRESH_DEG);
+        detector_ready = true;
+    }
+
+    colic_level_t level = colic_detector_update(&detector, t_s, lying,
+                                                roll_valid, roll, &escalated);
+
+    if (escalated && level == COLIC_LEVEL_ALERT) {
+        int64_t utc_ms = 0;
+
+        (void)timebase_to_utc_ms(ts, &utc_ms);
+        alert.pending = true;
+        alert.seq++;
+        alert.level   = level;
+        alert.lie     = colic_detector_lie_count(&detector);
+        alert.roll    = colic_detector_roll_count(&detector);
+        alert.utc_ms  = utc_ms;
+    }
+
+    k_spin_unlock(&colic_lock, key);
+
+    if (escalated) {
+        LOG_WRN("Colic level -> %d", level);
+    }
+
+    if (escalated && level == COLIC_LEVEL_ALERT) {
+        atomic_set(&boost_until_s,
+                   (atomic_val_t)(k_uptime_get() / 1000 +
+                                  CONFIG_HORSE_COLIC_BOOST_MIN * 60));
+        k_work_reschedule(&alert_work, K_NO_WAIT);
+        (void)gait_capture_trigger(CAPTURE_TRIGGER_ANOMALY,
+                                   CONFIG_HORSE_CAPTURE_DEFAULT_SECONDS);
+    }
+}
+
+/* ====================== 对外接口 ====================== */
+
+void colic_monitor_feed_imu(tb_ts_t ts, float roll)
+{
+    feed(ts, true, roll);
+}
+
+void colic_monitor_feed_posture(tb_ts_t ts)
+{
+    feed(ts, false, 0.0f);
+}
+
+bool colic_monitor_boost_active(void)
+{
+    atomic_val_t until = atomic_get(&boost_until_s);
+
+    return until != 0 && (k_uptime_get() / 1000) < until;
+}
+
+colic_level_t colic_monitor_level(void)
+{
+    return detector.level;
+}
@@ -0,0 +1,28 @@
+#ifndef COLIC_MONITOR_H_
+#define COLIC_MONITOR_H_
+
+#include <stdbool.h>
+
+#include "timebase.h"
+#include "colic_detector.h"
+
+/*
+ * 疝痛检测的运行时外壳：把 IMU / 气压卧倒信号喂给 colic_detector，
+ * 升到 ALERT 时立即 QoS1 发 horse_alert，并在一段时间内提高采样：
+ *  - IMU 常开（不再按占空比断电）；
+ *  - GNSS 保持 1 Hz 连续定位（省电策略不降级）；
+ *  - horse_data（含 GNSS 位置）上报间隔缩短，同时触发一次步态抓拍。
+ */
+
+/* IMU 线程按分频链 1 Hz 级别调用 */
+void colic_monitor_feed_imu(tb_ts_t ts, float roll);
+
+/* BME 线程每个样本调用（IMU 断电时只靠卧倒信号） */
+void colic_monitor_feed_posture(tb_ts_t ts);
+
+/* 是否处于报警后的高采样期 */
+bool colic_monitor_boost_active(void);
+
+colic_level_t colic_monitor_level(void);
+
+#endif /* COLIC_MONITOR_H_ */
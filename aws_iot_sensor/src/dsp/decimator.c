@@ -0,0 +1,351 @@
+/* decimator.c
+ *
+ * 多速率分频链，见 decimator.h。
+ * 只在采集线程里推进；订阅表在初始化阶段写好之后只读。
+ */
+
+#include "decimator.h"
+
+#include <zephyr/kernel.h>
+#include <errno.h>
+#include <string.h>
+
+/* ====================== 参数可调 ====================== */
+
+/* 每一级最多几个订阅者 */
+#define DECIM_MAX_SUBS      4
+
+/* 11 抽头半带低通（Q9）：10 Hz 内 < 0.1 dB，25 Hz -6 dB，30 Hz -13 dB，40 Hz -42 dB。
+ * 步态能量基本在 10 Hz 以下，折叠进来的 25~30 Hz 成分本身就很小。
+ */
+#define HB_TAPS             11
+#define HB_SHIFT            9
+#define HB_C0               256     /* 中心抽头 */
+#define HB_C1               150     /* ±1 */
+#define HB_C3               (-25)   /* ±3 */
+#define HB_C5               3       /* ±5 */
+
+#define CIC_MAX_ORDER       3
+
+/* 一整圈 heading（1/16 deg） */
+#define HEADING_FULL        5760
+
+/* 展开的 heading 超过这么多圈就整圈挪回 0 附近：半带里 HB_C0 * tap 在 ~729 圈溢出 int32 */
+#define HD_RECENTER_TURNS   16
+
+/* ====================== 状态 ====================== */
+
+struct cic {
+    uint8_t  order;
+    uint8_t  r;
+    uint8_t  cnt;
+    uint8_t  warm;            /* 清零后还要丢掉的输出个数 */
+    uint32_t gain;            /* r ^ order */
+    uint32_t delay_us;        /* 群延迟 order * (r - 1) / 2 个输入周期 */
+    uint32_t integ[DECIM_NCH][CIC_MAX_ORDER];
+    uint32_t comb[DECIM_NCH][CIC_MAX_ORDER];
+};
+
+static struct {
+    decim_cb_t cb;
+    void      *user;
+} subs[DECIM_TIER_COUNT][DECIM_MAX_SUBS];
+static uint8_t n_subs[DECIM_TIER_COUNT];
+
+/* 半带：每通道一条延迟线，phase 决定本次输入是否产生输出 */
+static int32_t hb_line[DECIM_NCH][HB_TAPS];
+static uint8_t hb_pos;
+static bool    hb_phase;
+static bool    hb_primed;
+
+/* heading 展开：跨段保持连续，1 Hz / 1/120 Hz 两级的状态才不会被断电打断 */
+static bool    hd_init;
+static int16_t hd_last_raw;
+static int32_t hd_unwrapped;
+
+/* 50 → 10 Hz，10 → 1 Hz，1 → 1/120 Hz */
+static struct cic cic10  = { .order = 3, .r = 5,   .gain = 125, .delay_us = 120000 };
+static struct cic cic1   = { .order = 2, .r = 10,  .gain = 100, .delay_us = 900000 };
+static struct cic cic120 = { .order = 1, .r = 120, .gain = 120, .delay_us = 59500000 };
+
+#define HB_DELAY_US 50000
+
+static const uint32_t period_ms[DECIM_TIER_COUNT] = {
+    [DECIM_TIER_100HZ] = 10,
+    [DECIM_TIER_50HZ]  = 20,
+    [DECIM_TIER_10HZ]  = 100,
+    [DECIM_TIER_1HZ]   = 1000,
+    [DECIM_TIER_120S]  = 120000,
+};
+
+/* ====================== 输出 ====================== */
+
+static tb_ts_t shift_ts(tb_ts_t ts, uint32_t delay_us)
+{
+    tb_ts_t d = (tb_ts_t)delay_us * TB_FREQ_HZ / 1000000U;
+
+    return (ts > d) ? ts - d : 0;
+}
+
+static void emit(enum decim_tier tier, tb_ts_t ts, const int32_t *y)
+{
+    if (n_subs[tier] == 0) {
+        return;
+    }
+
+    struct decim_sample s = { .ts = ts };
+
+    for (int ch = 0; ch < DECIM_NCH; ch++) {
+        if (ch == DECIM_CH_EUL) {
+            int32_t h = y[ch] % HEADING_FULL;
+
+            s.v[ch] = (int16_t)(h < 0 ? h + HEADING_FULL : h);
+        } else {
+            s.v[ch] = (int16_t)CLAMP(y[ch], INT16_MIN, INT16_MAX);
+        }
+    }
+
+    for (int i = 0; i < n_subs[tier]; i++) {
+        subs[tier][i].cb(&s, subs[tier][i].user);
+    }
+}
+
+/* ====================== 半带 FIR ÷2 ====================== */
+
+static int32_t hb_tap(int ch, int k)
+{
+    /* k = 0 是最新样本 */
+    return hb_line[ch][(hb_pos + HB_TAPS - k) % HB_TAPS];
+}
+
+static bool hb_push(const int32_t *x, int32_t *y)
+{
+    if (!hb_primed) {
+        /* 用第一个样本填满延迟线，没有启动瞬态 */
+        for (int ch = 0; ch < DECIM_NCH; ch++) {
+            for (int k = 0; k < HB_TAPS; k++) {
+                hb_line[ch][k] = x[ch];
+            }
+        }
+        hb_primed = true;
+    }
+
+    hb_pos = (hb_pos + 1) % HB_TAPS;
+    for (int ch = 0; ch < DECIM_NCH; ch++) {
+        hb_line[ch][hb_pos] = x[ch];
+    }
+
+    hb_phase = !hb_phase;
+    if (!hb_phase) {
+        return false;
+    }
+
+    /* 多相：偶数偏移的系数全是 0，只算中心和奇数相 */
+    for (int ch = 0; ch < DECIM_NCH; ch++) {
+        int32_t acc = HB_C0 * hb_tap(ch, 5) +
+                      HB_C1 * (hb_tap(ch, 4) + hb_tap(ch, 6)) +
+                      HB_C3 * (hb_tap(ch, 2) + hb_tap(ch, 8)) +
+                      HB_C5 * (hb_tap(ch, 0) + hb_tap(ch, 10));
+
+        y[ch] = (acc + (1 << (HB_SHIFT - 1))) >> HB_SHIFT;
+    }
+    return true;
+}
+
+/* ====================== CIC ====================== */
+
+static void cic_clear(struct cic *c)
+{
+    memset(c->integ, 0, sizeof(c->integ));
+    memset(c->comb, 0, sizeof(c->comb));
+    c->cnt = 0;
+    /* 从零状态开始，前 order - 1 个输出的冲激响应还没填满 */
+    c->warm = c->order - 1;
+}
+
+static int32_t div_round(int32_t v, uint32_t d)
+{
+    return (v >= 0) ? (int32_t)((v + d / 2) / d) : -(int32_t)((-v + d / 2) / d);
+}
+
+static bool cic_push(struct cic *c, const int32_t *x, int32_t *y)
+{
+    /* 积分器：按输入速率，无符号回绕，输出时差分会把回绕抵消掉 */
+    for (int ch = 0; ch < DECIM_NCH; ch++) {
+        uint32_t v = (uint32_t)x[ch];
+
+        for (int k = 0; k < c->order; k++) {
+            c->integ[ch][k] += v;
+            v = c->integ[ch][k];
+        }
+    }
+
+    if (++c->cnt < c->r) {
+        return false;
+    }
+    c->cnt = 0;
+
+    /* 梳状器：按输出速率 */
+    for (int ch = 0; ch < DECIM_NCH; ch++) {
+        uint32_t v = c->integ[ch][c->order - 1];
+
+        for (int k = 0; k < c->order; k++) {
+            uint32_t d = v - c->comb[ch][k];
+
+            c->comb[ch][k] = v;
+            v = d;
+        }
+        y[ch] = div_round((int32_t)v, c->gain);
+    }
+
+    if (c->warm > 0) {
+        c->warm--;
+        return false;
+    }
+    return true;
+}
+
+/*
+ * 把 ch 通道的全部历史输入都加上常数 delta：CIC 是线性的，
+ * 只要叠加一个同构 CIC 一直喂 delta 时的稳态（相位和 c 对齐），后面的输出就正好多 delta。
+ */
+static void cic_shift(struct cic *c, int ch, int32_t delta)
+{
+    uint32_t integ[CIC_MAX_ORDER] = { 0 };
+    uint32_t comb[CIC_MAX_ORDER] = { 0 };
+    /* 梳状器要 order 次输出以后才稳，多喂一轮保险 */
+    uint32_t n = (c->order + 1U) * c->r + c->cnt;
+
+    for (uint32_t i = 1; i <= n; i++) {
+        uint32_t v = (uint32_t)delta;
+
+        for (int k = 0; k < c->order; k++) {
+            integ[k] += v;
+            v = integ[k];
+        }
+
+        if (i % c->r == 0) {
+            v = integ[c->order - 1];
+            for (int k = 0; k < c->order; k++) {
+                uint32_t d = v - comb[k];
+
+                comb[k] = v;
+                v = d;
+            }
+        }
+    }
+
+    for (int k = 0; k < c->order; k++) {
+        c->integ[ch][k] += integ[k];
+        c->comb[ch][k] += comb[k];
+    }
+}
+
+/* 展开的 heading 和分频链里存着的历史一起整圈挪回 0 附近，输出对整圈取模所以不变 */
+static void hd_recenter(void)
+{
+    int32_t delta = -(hd_unwrapped / HEADING_FULL) * HEADING_FULL;
+
+    hd_unwrapped += delta;
+    for (int k = 0; k < HB_TAPS; k++) {
+        hb_line[DECIM_CH_EUL][k] += delta;
+    }
+    cic_shift(&cic10, DECIM_CH_EUL, delta);
+    cic_shift(&cic1, DECIM_CH_EUL, delta);
+    cic_shift(&cic120, DECIM_CH_EUL, delta);
+}
+
+/* ====================== 对外接口 ====================== */
+
+int decimator_subscribe(enum decim_tier tier, decim_cb_t cb, void *user)
+{
+    if (tier >= DECIM_TIER_COUNT || n_subs[tier] >= DECIM_MAX_SUBS) {
+        return -ENOMEM;
+    }
+
+    subs[tier][n_subs[tier]].cb = cb;
+    subs[tier][n_subs[tier]].user = user;
+    n_subs[tier]++;
+    return 0;
+}
+
+void decimator_restart(void)
+{
+    hb_primed = false;
+    hb_phase = false;
+    cic_clear(&cic10);
+
+    static bool first = true;
+
+    if (first) {
+        cic_clear(&cic1);
+        cic_clear(&cic120);
+        first = false;
+    }
+}
+
+void decimator_push(const struct decim_sample *s)
+{
+    int32_t x[DECIM_NCH];
+    int32_t y[DECIM_NCH];
+    tb_ts_t ts = s->ts;
+
+    /* heading 展开成连续值：相邻两次跳变超过半圈就认为跨过了 0/360 */
+    int16_t h = s->v[DECIM_CH_EUL];
+
+    if (!hd_init) {
+        hd_unwrapped = h;
+        hd_init = true;
+    } else {
+        int32_t d = h - hd_last_raw;
+
+        if (d > HEADING_FULL / 2) {
+            d -= HEADING_FULL;
+        } else if (d < -HEADING_FULL / 2) {
+            d += HEADING_FULL;
+        }
+        hd_unwrapped += d;
+
+        if (hd_unwrapped > HD_RECENTER_TURNS * HEADING_FULL ||
+            hd_unwrapped < -HD_RECENTER_TURNS * HEADING_FULL) {
+            hd_recenter();
+        }
+    }
+    hd_last_raw = h;
+
+    for (int ch = 0; ch < DECIM_NCH; ch++) {
+        x[ch] = s->v[ch];
+    }
+    x[DECIM_CH_EUL] = hd_unwrapped;
+
+    emit(DECIM_TIER_100HZ, ts, x);
+
+    if (!hb_push(x, y)) {
+        return;
+    }
+    ts = shift_ts(ts, HB_DELAY_US);
+    emit(DECIM_TIER_50HZ, ts, y);
+
+    if (!cic_push(&cic10, y, x)) {
+        return;
+    }
+    ts = shift_ts(ts, cic10.delay_us);
+    emit(DECIM_TIER_10HZ, ts, x);
+
+    if (!cic_push(&cic1, x, y)) {
+        return;
+    }
+    ts = shift_ts(ts, cic1.delay_us);
+    emit(DECIM_TIER_1HZ, ts, y);
+
+    if (!cic_push(&cic120, y, x)) {
+        return;
+    }
+    ts = shift_ts(ts, cic120.delay_us);
+    emit(DECIM_TIER_120S, ts, x);
+}
+
+uint32_t decimator_period_ms(enum decim_tier tier)
+{
+    return (tier < DECIM_TIER_COUNT) ? period_ms[tier] : 0;
+}
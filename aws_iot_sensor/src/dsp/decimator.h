@@ -0,0 +1,65 @@
+#ifndef DECIMATOR_H_
+#define DECIMATOR_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "timebase.h"
+
+/*
+ * 多速率分频链
+ *
+ * 采集线程只按 DECIM_BASE_HZ 读一路鬐甲 IMU，这里逐级降采样，
+ * 每个消费者按自己需要的速率订阅，不用各自再滤波 / 重采样：
+ *
+ *   100 Hz ──半带 FIR ÷2──► 50 Hz ──CIC3 ÷5──► 10 Hz ──CIC2 ÷10──► 1 Hz ──均值 ÷120──► 1/120 Hz
+ *   （跌倒 / 抓拍）        （步态）          （平衡 / 环形缓冲）  （姿态 / 疝痛）      （上报）
+ *
+ * 半带 FIR 一半系数是 0，多相实现只在输出点上算奇数相的 6 个乘法；
+ * CIC 只用加减，积分器按输入速率跑、梳状器按输出速率跑，整数回绕运算。
+ *
+ * 通道和步态抓拍一样：acc xyz, gyr xyz, euler heading/roll/pitch（BNO055 原始 LSB）。
+ * heading 在 0/360 处会跳变，进滤波器之前先展开成连续值，输出时再折回 0~5760。
+ *
+ * IMU 断电后重新采集时调用 decimator_restart()：10 Hz 及以上的级别清空重新预热；
+ * 1 Hz 和 1/120 Hz 两级跨占空比累计（统计的是 IMU 上电期间的数据）。
+ * 所有回调都在采集线程里同步调用，回调里不要阻塞。
+ */
+
+#define DECIM_BASE_HZ   100
+#define DECIM_NCH       9
+
+/* 通道下标 */
+#define DECIM_CH_ACC    0
+#define DECIM_CH_GYR    3
+#define DECIM_CH_EUL    6
+
+enum decim_tier {
+    DECIM_TIER_100HZ = 0,
+    DECIM_TIER_50HZ,
+    DECIM_TIER_10HZ,
+    DECIM_TIER_1HZ,
+    DECIM_TIER_120S,
+    DECIM_TIER_COUNT,
+};
+
+struct decim_sample {
+    tb_ts_t ts;           /* 已按各级群延迟往前修正 */
+    int16_t v[DECIM_NCH];
+};
+
+typedef void (*decim_cb_t)(const struct decim_sample *s, void *user);
+
+/* 订阅某一级的输出；初始化阶段调用，满了返回 -ENOMEM */
+int decimator_subscribe(enum decim_tier tier, decim_cb_t cb, void *user);
+
+/* 新的一段采集（IMU 重新上电） */
+void decimator_restart(void);
+
+/* 采集线程按 DECIM_BASE_HZ 调用 */
+void decimator_push(const struct decim_sample *s);
+
+/* 各级输出周期（ms） */
+uint32_t decimator_period_ms(enum decim_tier tier);
+
+#endif /* DECIMATOR_H_ */
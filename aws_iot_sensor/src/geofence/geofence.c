@@ -0,0 +1,783 @@
+/* geofence.c
+ *
+ * 多区域电子围栏 + 均匀网格索引，见 geofence.h。
+ */
+
+#include "geofence.h"
+
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+
+/* 纬度 1 度对应的距离（m），局部平面近似用 */
+#define M_PER_DEG_LAT       ((double)GEOFENCE_M_PER_DEG_LAT)
+#define EARTH_R_M           6371000.0
+#define DEG2RAD             (3.14159265358979323846 / 180.0)
+
+/* ====================== 几何 ====================== */
+
+double geofence_haversine_m(double lat1, double lon1, double lat2, double lon2)
+{
+    double dlat = (lat2 - lat1) * DEG2RAD;
+    double dlon = (lon2 - lon1) * DEG2RAD;
+    double a = sin(dlat / 2.0) * sin(dlat / 2.0) +
+               cos(lat1 * DEG2RAD) * cos(lat2 * DEG2RAD) *
+               sin(dlon / 2.0) * sin(dlon / 2.0);
+
+    return EARTH_R_M * 2.0 * atan2(sqrt(a), sqrt(1.0 - a));
+}
+
+float geofence_m_per_deg_lon(double lat)
+{
+    return (float)(M_PER_DEG_LAT * cos(lat * DEG2RAD));
+}
+
+/* ====================== 多边形 ====================== */
+
+/* 射线法（向 +x），半开区间 [y0, y1) 处理正好过顶点的情况 */
+static bool edge_crosses(const struct geofence_edge *e, float x, float y)
+{
+    return x < e->x0 + (y - e->y0) * e->dxdy;
+}
+
+static bool poly_inside(const struct geofence *gf, const struct geofence_zone *z,
+                        float x, float y)
+{
+    const struct geofence_edge *edges = &gf->edges[z->edge_off];
+    bool in = false;
+
+    if (z->n_slabs == 0) {
+        for (uint16_t k = 0; k < z->n_edges; k++) {
+            if (edges[k].y0 <= y && y < edges[k].y1 && edge_crosses(&edges[k], x, y)) {
+                in = !in;
+            }
+        }
+        return in;
+    }
+
+    /* 二分找 y 所在条带；条带里登记的边都整段跨过它，不用再比 y */
+    const struct geofence_slab *sl = &gf->slabs[z->slab_off];
+
+    if (y < sl[0].y || y >= sl[z->n_slabs].y) {
+        return false;
+    }
+
+    uint16_t lo = 0, hi = z->n_slabs - 1;
+
+    while (lo < hi) {
+        uint16_t mid = (lo + hi + 1) / 2;
+
+        if (sl[mid].y <= y) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    for (uint16_t k = sl[lo].start; k < sl[lo + 1].start; k++) {
+        if (edge_crosses(&edges[gf->slab_refs[k]], x, y)) {
+            in = !in;
+        }
+    }
+    return in;
+}
+
+/* 点到一条边的距离的平方 */
+static float edge_dist2(const struct geofence_edge *e, float x, float y)
+{
+    float ex = e->x1 - e->x0, ey = e->y1 - e->y0;
+    float px = x - e->x0, py = y - e->y0;
+    float len2 = ex * ex + ey * ey;
+    float t = (len2 > 0.0f) ? (px * ex + py * ey) / len2 : 0.0f;
+
+    t = fminf(fmaxf(t, 0.0f), 1.0f);
+    px -= t * ex;
+    py -= t * ey;
+    return px * px + py * py;
+}
+
+/* 点到任一条边的距离是否在 d 以内（只在判定离开时用，逐边算） */
+static bool poly_near_edge(const struct geofence *gf, const struct geofence_zone *z,
+                           float x, float y, float d)
+{
+    const struct geofence_edge *edges = &gf->edges[z->edge_off];
+
+    for (uint16_t k = 0; k < z->n_edges; k++) {
+        if (edge_dist2(&edges[k], x, y) <= d * d) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* 多边形按顶点纬度切条带，条带和登记表放不下就不切（逐边测） */
+static void build_slabs(struct geofence *gf, struct geofence_zone *z,
+                        uint16_t *slab_used, uint16_t *ref_used)
+{
+    const struct geofence_edge *edges = &gf->edges[z->edge_off];
+
+    z->n_slabs = 0;
+    if (z->n_edges < GEOFENCE_SLAB_MIN_EDGES ||
+        *slab_used + z->n_edges > GEOFENCE_MAX_EDGES) {
+        return;
+    }
+
+    /* 顶点纬度去重排序（每个顶点都是两条边的端点，去重后不超过 n_edges 个） */
+    struct geofence_slab *sl = &gf->slabs[*slab_used];
+    uint16_t m = 0;
+
+    for (uint16_t k = 0; k < 2 * z->n_edges; k++) {
+        float y = (k & 1) ? edges[k / 2].y1 : edges[k / 2].y0;
+        uint16_t j = m;
+
+        while (j > 0 && sl[j - 1].y > y) {
+            j--;
+        }
+        if (j > 0 && sl[j - 1].y == y) {
+            continue;
+        }
+        memmove(&sl[j + 1], &sl[j], (m - j) * sizeof(sl[0]));
+        sl[j].y = y;
+        m++;
+    }
+
+    uint16_t r = *ref_used;
+
+    for (uint16_t j = 0; j + 1 < m; j++) {
+        sl[j].start = r;
+        for (uint16_t k = 0; k < z->n_edges; k++) {
+            if (edges[k].y0 <= sl[j].y && edges[k].y1 >= sl[j + 1].y) {
+                if (r >= GEOFENCE_MAX_SLAB_REFS) {
+                    return;
+                }
+                gf->slab_refs[r++] = k;
+            }
+        }
+    }
+    sl[m - 1].start = r;
+
+    z->slab_off = *slab_used;
+    z->n_slabs = m - 1;
+    *slab_used += m;
+    *ref_used = r;
+}
+
+/* 删掉 / 替换多边形时把它的边从边表里挪走，后面的往前压 */
+static void poly_free(struct geofence *gf, const struct geofence_zone *z)
+{
+    uint16_t off = z->edge_off, n = z->n_edges;
+
+    memmove(&gf->edges[off], &gf->edges[off + n],
+            (gf->n_edges - off - n) * sizeof(gf->edges[0]));
+    gf->n_edges -= n;
+
+    for (uint16_t i = 0; i < gf->n_zones; i++) {
+        struct geofence_zone *o = &gf->zones[i];
+
+        if (o->shape == GEOFENCE_POLY && o->edge_off > off) {
+            o->edge_off -= n;
+        }
+    }
+}
+
+/* ====================== 包含判定 ====================== */
+
+static bool zone_contains(const struct geofence *gf, const struct geofence_zone *z,
+                          double lat, double lon)
+{
+    double m = z->inside ? GEOFENCE_HYST_M : 0.0;
+
+    if (z->shape == GEOFENCE_CIRCLE) {
+        double r = z->radius_m + m;
+
+        if (r > GEOFENCE_PROJ_RANGE_M) {
+            /* 大圆：投影误差不可忽略，纬度差已经超过半径就不用算球面距离了 */
+            if (fabs(lat - z->lat) * M_PER_DEG_LAT > r) {
+                return false;
+            }
+            return geofence_haversine_m(lat, lon, z->lat, z->lon) <= r;
+        }
+        return geofence_proj_dist2(lat, lon, z->lat, z->lon, z->m_per_deg_lon) <=
+               (z->inside ? z->r2_hyst : z->r2);
+    }
+
+    double dlat = m / gf->m_per_deg_lat;
+    double dlon = m / gf->m_per_deg_lon;
+
+    if (lat < z->lat - dlat || lat > z->lat2 + dlat ||
+        lon < z->lon - dlon || lon > z->lon2 + dlon) {
+        return false;
+    }
+    if (z->shape == GEOFENCE_RECT) {
+        return true;
+    }
+
+    /* 多边形：外包矩形里再用边表判定 */
+    float y = (float)(lat - z->lat) * GEOFENCE_M_PER_DEG_LAT;
+    float x = (float)(lon - z->lon) * z->m_per_deg_lon;
+
+    if (poly_inside(gf, z, x, y)) {
+        return true;
+    }
+    return z->inside && poly_near_edge(gf, z, x, y, (float)GEOFENCE_HYST_M);
+}
+
+/* 点到区域边界的距离（m），在里面、在外面都是正数 */
+static float zone_boundary_dist(const struct geofence *gf, const struct geofence_zone *z,
+                                double lat, double lon)
+{
+    if (z->shape == GEOFENCE_CIRCLE) {
+        float d = (z->radius_m > GEOFENCE_PROJ_RANGE_M) ?
+                  (float)geofence_haversine_m(lat, lon, z->lat, z->lon) :
+                  sqrtf(geofence_proj_dist2(lat, lon, z->lat, z->lon, z->m_per_deg_lon));
+
+        return fabsf(d - z->radius_m);
+    }
+
+    if (z->shape == GEOFENCE_RECT) {
+        /* 矩形不限大小，用索引平面的比例尺（双精度） */
+        double x = (lon - z->lon) * gf->m_per_deg_lon;
+        double y = (lat - z->lat) * gf->m_per_deg_lat;
+        double w = (z->lon2 - z->lon) * gf->m_per_deg_lon;
+        double h = (z->lat2 - z->lat) * gf->m_per_deg_lat;
+        double ox = fmax(fmax(-x, x - w), 0.0);
+        double oy = fmax(fmax(-y, y - h), 0.0);
+
+        if (ox > 0.0 || oy > 0.0) {
+            return (float)sqrt(ox * ox + oy * oy);
+        }
+        return (float)fmin(fmin(x, w - x), fmin(y, h - y));
+    }
+
+    const struct geofence_edge *edges = &gf->edges[z->edge_off];
+    float y = (float)(lat - z->lat) * GEOFENCE_M_PER_DEG_LAT;
+    float x = (float)(lon - z->lon) * z->m_per_deg_lon;
+    float d2 = INFINITY;
+
+    for (uint16_t k = 0; k < z->n_edges; k++) {
+        d2 = fminf(d2, edge_dist2(&edges[k], x, y));
+    }
+    return sqrtf(d2);
+}
+
+/* ====================== 网格索引 ====================== */
+
+static uint32_t cell_hash(int16_t ix, int16_t iy)
+{
+    return (((uint32_t)(uint16_t)ix * 73856093U) ^ ((uint32_t)(uint16_t)iy * 19349663U)) &
+           (GEOFENCE_BUCKETS - 1);
+}
+
+static int16_t to_cell(double m)
+{
+    double c = floor(m / GEOFENCE_CELL_M);
+
+    return (int16_t)fmax(fmin(c, INT16_MAX), INT16_MIN);
+}
+
+/* 区域外包矩形（加上迟滞余量）覆盖的格子范围 */
+static void zone_cells(const struct geofence *gf, const struct geofence_zone *z,
+                       int16_t *x0, int16_t *y0, int16_t *x1, int16_t *y1)
+{
+    double s, w, n, e;
+
+    if (z->shape == GEOFENCE_CIRCLE) {
+        double r = z->radius_m + GEOFENCE_HYST_M;
+
+        s = (z->lat - gf->lat0) * gf->m_per_deg_lat - r;
+        n = (z->lat - gf->lat0) * gf->m_per_deg_lat + r;
+        w = (z->lon - gf->lon0) * gf->m_per_deg_lon - r;
+        e = (z->lon - gf->lon0) * gf->m_per_deg_lon + r;
+    } else {
+        s = (z->lat  - gf->lat0) * gf->m_per_deg_lat - GEOFENCE_HYST_M;
+        n = (z->lat2 - gf->lat0) * gf->m_per_deg_lat + GEOFENCE_HYST_M;
+        w = (z->lon  - gf->lon0) * gf->m_per_deg_lon - GEOFENCE_HYST_M;
+        e = (z->lon2 - gf->lon0) * gf->m_per_deg_lon + GEOFENCE_HYST_M;
+    }
+
+    *x0 = to_cell(w);
+    *x1 = to_cell(e);
+    *y0 = to_cell(s);
+    *y1 = to_cell(n);
+}
+
+static void rebuild_active(struct geofence *gf)
+{
+    gf->n_active = 0;
+    gf->active_overflow = false;
+
+    for (uint16_t i = 0; i < gf->n_zones; i++) {
+        if (!gf->zones[i].inside) {
+            continue;
+        }
+        if (gf->n_active < GEOFENCE_MAX_ACTIVE) {
+            gf->active[gf->n_active++] = i;
+        } else {
+            gf->active_overflow = true;
+        }
+    }
+}
+
+static void rebuild(struct geofence *gf)
+{
+    uint16_t fill[GEOFENCE_BUCKETS];
+    bool is_big[GEOFENCE_MAX_ZONES];
+    size_t n_refs = 0;
+    uint16_t slab_used = 0, ref_used = 0;
+
+    gf->dirty = false;
+    gf->n_big = 0;
+    memset(gf->bucket_start, 0, sizeof(gf->bucket_start));
+    rebuild_active(gf);
+
+    if (gf->n_zones == 0) {
+        return;
+    }
+
+    for (uint16_t i = 0; i < gf->n_zones; i++) {
+        if (gf->zones[i].shape == GEOFENCE_POLY) {
+            build_slabs(gf, &gf->zones[i], &slab_used, &ref_used);
+        }
+    }
+
+    /* 原点：所有区域位置的外包矩形中心 */
+    double s = 90.0, n = -90.0, w = 180.0, e = -180.0;
+
+    for (uint16_t i = 0; i < gf->n_zones; i++) {
+        const struct geofence_zone *z = &gf->zones[i];
+
+        s = fmin(s, z->lat);
+        n = fmax(n, z->shape != GEOFENCE_CIRCLE ? z->lat2 : z->lat);
+        w = fmin(w, z->lon);
+        e = fmax(e, z->shape != GEOFENCE_CIRCLE ? z->lon2 : z->lon);
+    }
+    gf->lat0 = (s + n) / 2.0;
+    gf->lon0 = (w + e) / 2.0;
+    gf->m_per_deg_lat = M_PER_DEG_LAT;
+    gf->m_per_deg_lon = geofence_m_per_deg_lon(gf->lat0);
+
+    if (gf->no_index) {
+        return;
+    }
+
+    /* 第一遍：数每个桶的登记数；格子太多 / 登记表放不下的算大区域 */
+    for (uint16_t i = 0; i < gf->n_zones; i++) {
+        int16_t x0, y0, x1, y1;
+
+        zone_cells(gf, &gf->zones[i], &x0, &y0, &x1, &y1);
+
+        size_t cells = (size_t)(x1 - x0 + 1) * (size_t)(y1 - y0 + 1);
+
+        is_big[i] = (cells > GEOFENCE_MAX_CELLS_PER_ZONE ||
+                     n_refs + cells > GEOFENCE_MAX_REFS);
+        if (is_big[i]) {
+            gf->big[gf->n_big++] = i;
+            continue;
+        }
+        n_refs += cells;
+        for (int32_t iy = y0; iy <= y1; iy++) {
+            for (int32_t ix = x0; ix <= x1; ix++) {
+                gf->bucket_start[cell_hash(ix, iy) + 1]++;
+            }
+        }
+    }
+
+    for (int b = 0; b < GEOFENCE_BUCKETS; b++) {
+        gf->bucket_start[b + 1] += gf->bucket_start[b];
+        fill[b] = gf->bucket_start[b];
+    }
+
+    /* 第二遍：填登记表 */
+    for (uint16_t i = 0; i < gf->n_zones; i++) {
+        int16_t x0, y0, x1, y1;
+
+        if (is_big[i]) {
+            continue;
+        }
+        zone_cells(gf, &gf->zones[i], &x0, &y0, &x1, &y1);
+        for (int32_t iy = y0; iy <= y1; iy++) {
+            for (int32_t ix = x0; ix <= x1; ix++) {
+                struct geofence_cell_ref *r = &gf->refs[fill[cell_hash(ix, iy)]++];
+
+                r->ix = (int16_t)ix;
+                r->iy = (int16_t)iy;
+                r->zone = i;
+            }
+        }
+    }
+}
+
+/* ====================== 单区域状态 ====================== */
+
+static void emit(const struct geofence_zone *z, enum geofence_evt_type type,
+                 uint32_t inside_ms, geofence_cb_t cb, void *user)
+{
+    if (cb == NULL) {
+        return;
+    }
+
+    struct geofence_event evt = {
+        .type = type, .kind = z->kind, .id = z->id, .inside_ms = inside_ms,
+    };
+
+    cb(&evt, user);
+}
+
+static void active_remove(struct geofence *gf, uint16_t idx)
+{
+    if (gf->active_overflow) {
+        rebuild_active(gf);
+        return;
+    }
+    for (uint8_t k = 0; k < gf->n_active; k++) {
+        if (gf->active[k] == idx) {
+            gf->active[k] = gf->active[--gf->n_active];
+            return;
+        }
+    }
+}
+
+static int test_zone(struct geofence *gf, uint16_t idx, uint32_t now_ms,
+                     double lat, double lon, geofence_cb_t cb, void *user)
+{
+    struct geofence_zone *z = &gf->zones[idx];
+
+    if (z->seen == gf->seq) {
+        return 0;
+    }
+    z->seen = gf->seq;
+
+    bool in = zone_contains(gf, z, lat, lon);
+
+    if (in && !z->inside) {
+        z->inside = true;
+        z->dwell_sent = false;
+        z->enter_ms = now_ms;
+        if (gf->n_active < GEOFENCE_MAX_ACTIVE) {
+            gf->active[gf->n_active++] = idx;
+        } else {
+            gf->active_overflow = true;
+        }
+        emit(z, GEOFENCE_EVT_ENTER, 0, cb, user);
+    } else if (!in && z->inside) {
+        z->inside = false;
+        active_remove(gf, idx);
+        emit(z, GEOFENCE_EVT_EXIT, now_ms - z->enter_ms, cb, user);
+    } else if (in && !z->dwell_sent && z->dwell_ms > 0 &&
+               now_ms - z->enter_ms >= z->dwell_ms) {
+        z->dwell_sent = true;
+        emit(z, GEOFENCE_EVT_DWELL, now_ms - z->enter_ms, cb, user);
+    }
+
+    return 1;
+}
+
+/* ====================== 对外接口 ====================== */
+
+void geofence_init(struct geofence *gf)
+{
+    memset(gf, 0, sizeof(*gf));
+    gf->m_per_deg_lat = M_PER_DEG_LAT;
+    gf->m_per_deg_lon = M_PER_DEG_LAT;
+}
+
+static struct geofence_zone *zone_find(struct geofence *gf, uint16_t id)
+{
+    for (uint16_t i = 0; i < gf->n_zones; i++) {
+        if (gf->zones[i].id == id) {
+            return &gf->zones[i];
+        }
+    }
+    return NULL;
+}
+
+/* id 已存在时返回原来的位置（多边形的边先释放掉），否则占一个新位置 */
+static struct geofence_zone *zone_slot(struct geofence *gf, uint16_t id)
+{
+    struct geofence_zone *z = zone_find(gf, id);
+
+    if (z != NULL) {
+        if (z->shape == GEOFENCE_POLY) {
+            poly_free(gf, z);
+        }
+        return z;
+    }
+    if (gf->n_zones >= GEOFENCE_MAX_ZONES) {
+        return NULL;
+    }
+    return &gf->zones[gf->n_zones++];
+}
+
+int geofence_add_circle(struct geofence *gf, uint16_t id, enum geofence_kind kind,
+                        double lat, double lon, float radius_m, uint32_t dwell_ms)
+{
+    if (!(radius_m > 0.0f) || fabs(lat) > 90.0 || fabs(lon) > 180.0) {
+        return -EINVAL;
+    }
+
+    struct geofence_zone *z = zone_slot(gf, id);
+
+    if (z == NULL) {
+        return -ENOMEM;
+    }
+
+    float rh = radius_m + (float)GEOFENCE_HYST_M;
+
+    *z = (struct geofence_zone){
+        .id = id, .kind = kind, .shape = GEOFENCE_CIRCLE, .dwell_ms = dwell_ms,
+        .lat = lat, .lon = lon, .radius_m = radius_m,
+        .m_per_deg_lon = geofence_m_per_deg_lon(lat),
+        .r2 = radius_m * radius_m,
+        .r2_hyst = rh * rh,
+    };
+    gf->dirty = true;
+    return 0;
+}
+
+int geofence_add_rect(struct geofence *gf, uint16_t id, enum geofence_kind kind,
+                      double lat_s, double lon_w, double lat_n, double lon_e,
+                      uint32_t dwell_ms)
+{
+    if (!(lat_s < lat_n) || !(lon_w < lon_e) ||
+        fabs(lat_s) > 90.0 || fabs(lat_n) > 90.0 ||
+        fabs(lon_w) > 180.0 || fabs(lon_e) > 180.0) {
+        return -EINVAL;
+    }
+
+    struct geofence_zone *z = zone_slot(gf, id);
+
+    if (z == NULL) {
+        return -ENOMEM;
+    }
+
+    *z = (struct geofence_zone){
+        .id = id, .kind = kind, .shape = GEOFENCE_RECT, .dwell_ms = dwell_ms,
+        .lat = lat_s, .lon = lon_w, .lat2 = lat_n, .lon2 = lon_e,
+    };
+    gf->dirty = true;
+    return 0;
+}
+
+int geofence_add_polygon(struct geofence *gf, uint16_t id, enum geofence_kind kind,
+                         const struct geofence_vertex *v, size_t n, uint32_t dwell_ms)
+{
+    if (n < 3 || n > GEOFENCE_MAX_POLY_VERTS) {
+        return -EINVAL;
+    }
+
+    double s = 90.0, north = -90.0, w = 180.0, e = -180.0;
+
+    for (size_t k = 0; k < n; k++) {
+        if (fabs(v[k].lat) > 90.0 || fabs(v[k].lon) > 180.0) {
+            return -EINVAL;
+        }
+        s = fmin(s, v[k].lat);
+        north = fmax(north, v[k].lat);
+        w = fmin(w, v[k].lon);
+        e = fmax(e, v[k].lon);
+    }
+
+    float m_lon = geofence_m_per_deg_lon(s);
+
+    if (!(north > s) || !(e > w) ||
+        (north - s) * M_PER_DEG_LAT > GEOFENCE_PROJ_RANGE_M ||
+        (e - w) * m_lon > GEOFENCE_PROJ_RANGE_M) {
+        return -EINVAL;
+    }
+
+    /* 先确认放得下，再动原来的区域 */
+    struct geofence_zone *old = zone_find(gf, id);
+    size_t freed = (old != NULL && old->shape == GEOFENCE_POLY) ? old->n_edges : 0;
+
+    if ((old == NULL && gf->n_zones >= GEOFENCE_MAX_ZONES) ||
+        gf->n_edges - freed + n > GEOFENCE_MAX_EDGES) {
+        return -ENOMEM;
+    }
+
+    struct geofence_zone *z = zone_slot(gf, id);
+
+    *z = (struct geofence_zone){
+        .id = id, .kind = kind, .shape = GEOFENCE_POLY, .dwell_ms = dwell_ms,
+        .lat = s, .lon = w, .lat2 = north, .lon2 = e,
+        .m_per_deg_lon = m_lon,
+        .edge_off = gf->n_edges, .n_edges = n,
+    };
+
+    /* 边表：以西南角为原点的局部坐标，按 y 从小到大存端点 */
+    for (size_t k = 0; k < n; k++) {
+        const struct geofence_vertex *a = &v[k];
+        const struct geofence_vertex *b = &v[(k + 1) % n];
+        float ax = (float)(a->lon - w) * m_lon, ay = (float)(a->lat - s) * GEOFENCE_M_PER_DEG_LAT;
+        float bx = (float)(b->lon - w) * m_lon, by = (float)(b->lat - s) * GEOFENCE_M_PER_DEG_LAT;
+        struct geofence_edge *ed = &gf->edges[gf->n_edges++];
+
+        if (ay > by) {
+            *ed = (struct geofence_edge){ .x0 = bx, .y0 = by, .x1 = ax, .y1 = ay };
+        } else {
+            *ed = (struct geofence_edge){ .x0 = ax, .y0 = ay, .x1 = bx, .y1 = by };
+        }
+        ed->dxdy = (ed->y1 > ed->y0) ? (ed->x1 - ed->x0) / (ed->y1 - ed->y0) : 0.0f;
+    }
+
+    gf->dirty = true;
+    return 0;
+}
+
+int geofence_remove(struct geofence *gf, uint16_t id)
+{
+    for (uint16_t i = 0; i < gf->n_zones; i++) {
+        if (gf->zones[i].id == id) {
+            if (gf->zones[i].shape == GEOFENCE_POLY) {
+                poly_free(gf, &gf->zones[i]);
+            }
+            gf->zones[i] = gf->zones[--gf->n_zones];
+            gf->dirty = true;
+            return 0;
+        }
+    }
+    return -ENOENT;
+}
+
+bool geofence_is_inside(const struct geofence *gf, uint16_t id)
+{
+    for (uint16_t i = 0; i < gf->n_zones; i++) {
+        if (gf->zones[i].id == id) {
+            return gf->zones[i].inside;
+        }
+    }
+    return false;
+}
+
+int geofence_update(struct geofence *gf, uint32_t now_ms, double lat, double lon,
+                    geofence_cb_t cb, void *user)
+{
+    int tested = 0;
+
+    if (gf->dirty) {
+        rebuild(gf);
+    }
+
+    if (++gf->seq == 0) {
+        for (uint16_t i = 0; i < gf->n_zones; i++) {
+            gf->zones[i].seen = 0;
+        }
+        gf->seq = 1;
+    }
+
+    /* 当前在里面的区域先测，离开事件不会因为换了格子而漏掉 */
+    if (gf->active_overflow) {
+        for (uint16_t i = 0; i < gf->n_zones; i++) {
+            if (gf->zones[i].inside) {
+                tested += test_zone(gf, i, now_ms, lat, lon, cb, user);
+            }
+        }
+    } else {
+        uint16_t act[GEOFENCE_MAX_ACTIVE];
+        uint8_t n = gf->n_active;
+
+        /* 测的过程中可能有区域离开、从列表里删掉，先拷一份 */
+        memcpy(act, gf->active, n * sizeof(act[0]));
+        for (uint8_t k = 0; k < n; k++) {
+            tested += test_zone(gf, act[k], now_ms, lat, lon, cb, user);
+        }
+    }
+
+    if (gf->no_index) {
+        for (uint16_t i = 0; i < gf->n_zones; i++) {
+            tested += test_zone(gf, i, now_ms, lat, lon, cb, user);
+        }
+        return tested;
+    }
+
+    for (uint16_t k = 0; k < gf->n_big; k++) {
+        tested += test_zone(gf, gf->big[k], now_ms, lat, lon, cb, user);
+    }
+
+    int16_t ix = to_cell((lon - gf->lon0) * gf->m_per_deg_lon);
+    int16_t iy = to_cell((lat - gf->lat0) * gf->m_per_deg_lat);
+    uint32_t b = cell_hash(ix, iy);
+
+    for (uint16_t k = gf->bucket_start[b]; k < gf->bucket_start[b + 1]; k++) {
+        const struct geofence_cell_ref *r = &gf->refs[k];
+
+        if (r->ix == ix && r->iy == iy) {
+            tested += test_zone(gf, r->zone, now_ms, lat, lon, cb, user);
+        }
+    }
+
+    return tested;
+}
+
+float geofence_boundary_dist(struct geofence *gf, double lat, double lon, float max_m)
+{
+    float best = fminf(max_m, GEOFENCE_BOUNDARY_MAX_M);
+
+    if (gf->dirty) {
+        rebuild(gf);
+    }
+
+    if (!(best > 0.0f)) {
+        return 0.0f;
+    }
+    if (gf->no_index) {
+        for (uint16_t i = 0; i < gf->n_zones; i++) {
+            best = fminf(best, zone_boundary_dist(gf, &gf->zones[i], lat, lon));
+        }
+        return best;
+    }
+
+    /* 和 update 共用去重计数；这里不改 inside，不影响事件 */
+    if (++gf->seq == 0) {
+        for (uint16_t i = 0; i < gf->n_zones; i++) {
+            gf->zones[i].seen = 0;
+        }
+        gf->seq = 1;
+    }
+
+    /* 大区域和当前在里面的区域不一定登记在附近的格子里，逐个算 */
+    for (uint16_t k = 0; k < gf->n_big; k++) {
+        struct geofence_zone *z = &gf->zones[gf->big[k]];
+
+        z->seen = gf->seq;
+        best = fminf(best, zone_boundary_dist(gf, z, lat, lon));
+    }
+
+    uint16_t n_act = gf->active_overflow ? gf->n_zones : gf->n_active;
+
+    for (uint16_t k = 0; k < n_act; k++) {
+        struct geofence_zone *z = &gf->zones[gf->active_overflow ? k : gf->active[k]];
+
+        if (z->inside && z->seen != gf->seq) {
+            z->seen = gf->seq;
+            best = fminf(best, zone_boundary_dist(gf, z, lat, lon));
+        }
+    }
+
+    /*
+     * 边界离 fix 不到 max_m 的区域，外包矩形一定和 fix 周围 ±max_m 的方框相交，
+     * 所以登记在这个方框覆盖的格子里（max_m 截到 GEOFENCE_BOUNDARY_MAX_M，最多 5 x 5 个格子）。
+     */
+    double x = (lon - gf->lon0) * gf->m_per_deg_lon;
+    double y = (lat - gf->lat0) * gf->m_per_deg_lat;
+    double r = best;
+    int16_t x0 = to_cell(x - r), x1 = to_cell(x + r);
+    int16_t y0 = to_cell(y - r), y1 = to_cell(y + r);
+
+    for (int32_t iy = y0; iy <= y1; iy++) {
+        for (int32_t ix = x0; ix <= x1; ix++) {
+            uint32_t b = cell_hash(ix, iy);
+
+            for (uint16_t k = gf->bucket_start[b]; k < gf->bucket_start[b + 1]; k++) {
+                const struct geofence_cell_ref *ref = &gf->refs[k];
+                struct geofence_zone *z = &gf->zones[ref->zone];
+
+                if (ref->ix != ix || ref->iy != iy || z->seen == gf->seq) {
+                    continue;
+                }
+                z->seen = gf->seq;
+                best = fminf(best, zone_boundary_dist(gf, z, lat, lon));
+            }
+        }
+    }
+
+    return best;
+}
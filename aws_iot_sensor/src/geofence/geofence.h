@@ -0,0 +1,244 @@
+#ifndef GEOFENCE_H_
+#define GEOFENCE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 多区域电子围栏 —— 纯逻辑，不依赖内核，可以在 native_sim / qemu 上测试。
+ *
+ * 一个 struct geofence 装几百个圆形 / 矩形 / 多边形区域（水槽、料槽、棚、围场……），
+ * 每个 fix 调一次 geofence_update，逐区域产生 进入 / 离开 / 停留 事件。
+ *
+ * 空间索引：以所有区域的中心为原点做一个局部平面，按 GEOFENCE_CELL_M 划成
+ * 均匀网格，格子坐标哈希到 GEOFENCE_BUCKETS 个桶（CSR 数组，不限制农场范围）。
+ * 每个区域（外包矩形加上迟滞余量）登记到它覆盖的所有格子里；
+ * 一个 fix 只测它所在那个格子里登记的区域，加上：
+ *  - 覆盖格子太多的大区域（大围场），每次都测，先用外包矩形快速排除；
+ *  - 当前在里面的区域（离开事件不能漏，哪怕一个 fix 跳了好几个格子）。
+ * 区域增删之后索引标记为脏，下一次 update 时整体重建（区域很少变）。
+ *
+ * 不加锁：调用方保证同一个 struct geofence 不被并发访问。
+ */
+
+#ifndef GEOFENCE_MAX_ZONES
+#if defined(CONFIG_HORSE_GEOFENCE_MAX_ZONES)
+#define GEOFENCE_MAX_ZONES      CONFIG_HORSE_GEOFENCE_MAX_ZONES
+#else
+#define GEOFENCE_MAX_ZONES      256
+#endif
+#endif
+
+/* 网格边长（m）：比常见的小区域（水槽 10 m）大，比围场小 */
+#define GEOFENCE_CELL_M         50.0
+
+/* 桶数（2 的幂） */
+#define GEOFENCE_BUCKETS        256
+
+/* 格子登记表容量；一个区域覆盖的格子超过 GEOFENCE_MAX_CELLS_PER_ZONE 就算大区域 */
+#define GEOFENCE_MAX_REFS       (GEOFENCE_MAX_ZONES * 4)
+#define GEOFENCE_MAX_CELLS_PER_ZONE 16
+
+/* 多边形：所有多边形共用的边表容量、单个多边形最多几个顶点 */
+#ifndef GEOFENCE_MAX_EDGES
+#if defined(CONFIG_HORSE_GEOFENCE_MAX_EDGES)
+#define GEOFENCE_MAX_EDGES      CONFIG_HORSE_GEOFENCE_MAX_EDGES
+#else
+#define GEOFENCE_MAX_EDGES      512
+#endif
+#endif
+#define GEOFENCE_MAX_POLY_VERTS 64
+
+/* 边数不少于这个的多边形按顶点纬度切成水平条带，每条只登记穿过它的边 */
+#define GEOFENCE_SLAB_MIN_EDGES 12
+#define GEOFENCE_MAX_SLAB_REFS  (GEOFENCE_MAX_EDGES * 4)
+
+/* 同时在里面的区域最多跟踪几个（超了就退回全量扫描找离开） */
+#define GEOFENCE_MAX_ACTIVE     16
+
+/* geofence_boundary_dist 最多看多远（m） */
+#define GEOFENCE_BOUNDARY_MAX_M 100.0f
+
+/* 迟滞（m）：已经在里面时，边界往外放这么多才算离开，GNSS 抖动不会反复进出 */
+#define GEOFENCE_HYST_M         2.0
+
+/*
+ * 圆形区域的距离计算用以区域中心为原点的等距圆柱投影：
+ *   dy = dlat * 111195，dx = dlon * 111195 * cos(lat0)，比较 dx^2 + dy^2 和 r^2。
+ * cos(lat0) 和 r^2 在设置区域时算好，每个 fix 只有减法和单精度乘加（M33 的 FPU
+ * 只有单精度），不开方、不调三角函数。2 km 以内误差在厘米到分米级；
+ * 半径超过 GEOFENCE_PROJ_RANGE_M 的区域退回 haversine。
+ */
+#define GEOFENCE_PROJ_RANGE_M   2000.0f
+#define GEOFENCE_M_PER_DEG_LAT  111194.93f      /* 6371 km 球面，和 haversine 一致 */
+
+enum geofence_shape {
+    GEOFENCE_CIRCLE = 0,
+    GEOFENCE_RECT,
+    GEOFENCE_POLY,
+};
+
+enum geofence_kind {
+    GEOFENCE_KIND_TROUGH = 0,
+    GEOFENCE_KIND_FEEDER,
+    GEOFENCE_KIND_SHELTER,
+    GEOFENCE_KIND_PADDOCK,
+    GEOFENCE_KIND_OTHER,
+};
+
+enum geofence_evt_type {
+    GEOFENCE_EVT_ENTER = 0,
+    GEOFENCE_EVT_EXIT,
+    GEOFENCE_EVT_DWELL,       /* 进入后连续待满 dwell_ms，每次进入只报一次 */
+};
+
+struct geofence_event {
+    uint8_t  type;            /* enum geofence_evt_type */
+    uint8_t  kind;            /* enum geofence_kind */
+    uint16_t id;
+    uint32_t inside_ms;       /* EXIT / DWELL：到这个 fix 为止在里面待了多久 */
+};
+
+typedef void (*geofence_cb_t)(const struct geofence_event *evt, void *user);
+
+struct geofence_zone {
+    uint16_t id;              /* 调用方的编号，事件里原样带回 */
+    uint8_t  kind;
+    uint8_t  shape;
+    bool     inside;
+    bool     dwell_sent;
+    uint16_t seen;            /* 本次 update 已经测过（去重） */
+    uint32_t dwell_ms;        /* 0 = 不报停留 */
+    uint32_t enter_ms;
+
+    /*
+     * CIRCLE：(lat, lon) 圆心 + radius_m；
+     * RECT / POLY：(lat, lon) 西南角，(lat2, lon2) 东北角（POLY 是外包矩形，
+     * 也是多边形局部坐标系的原点）
+     */
+    double   lat, lon;
+    double   lat2, lon2;
+    float    radius_m;
+
+    /* 投影常数，设置区域时算好 */
+    float    m_per_deg_lon;   /* GEOFENCE_M_PER_DEG_LAT * cos(lat) */
+    union {
+        struct {              /* CIRCLE */
+            float r2;         /* radius_m^2 */
+            float r2_hyst;    /* (radius_m + GEOFENCE_HYST_M)^2 */
+        };
+        struct {              /* POLY：在 edges[] / slabs[] 里的位置 */
+            uint16_t edge_off, n_edges;
+            uint16_t slab_off, n_slabs;   /* n_slabs = 0：不分条，逐边测 */
+        };
+    };
+};
+
+/* 多边形的一条边，局部坐标（m，x 向东 y 向北），y0 <= y1 */
+struct geofence_edge {
+    float x0, y0;
+    float x1, y1;
+    float dxdy;               /* (x1 - x0) / (y1 - y0)，水平边为 0 */
+};
+
+/* 条带 [y, 下一条的 y)，穿过它的边是 slab_refs[start, 下一条的 start) */
+struct geofence_slab {
+    float    y;
+    uint16_t start;
+};
+
+struct geofence_vertex {
+    double lat, lon;
+};
+
+struct geofence_cell_ref {
+    int16_t  ix, iy;
+    uint16_t zone;
+};
+
+struct geofence {
+    struct geofence_zone zones[GEOFENCE_MAX_ZONES];
+    uint16_t n_zones;
+
+    /* 多边形边表（增删时压紧）和条带（索引重建时一起重建） */
+    struct geofence_edge edges[GEOFENCE_MAX_EDGES];
+    uint16_t n_edges;
+    struct geofence_slab slabs[GEOFENCE_MAX_EDGES];
+    uint16_t slab_refs[GEOFENCE_MAX_SLAB_REFS];
+
+    /* 基准测试用：不用网格，每个 fix 测所有区域 */
+    bool     no_index;
+
+    /* 索引 */
+    bool     dirty;
+    double   lat0, lon0;      /* 局部平面原点 */
+    double   m_per_deg_lat;
+    double   m_per_deg_lon;
+    uint16_t bucket_start[GEOFENCE_BUCKETS + 1];
+    struct geofence_cell_ref refs[GEOFENCE_MAX_REFS];
+    uint16_t big[GEOFENCE_MAX_ZONES];
+    uint16_t n_big;
+
+    uint16_t active[GEOFENCE_MAX_ACTIVE];
+    uint8_t  n_active;
+    bool     active_overflow;
+
+    uint16_t seq;
+};
+
+/* 以 (lat0, lon0) 为原点的局部投影，点到原点距离的平方（m^2） */
+static inline float geofence_proj_dist2(double lat, double lon,
+                                        double lat0, double lon0, float m_per_deg_lon)
+{
+    /* 先用双精度做减法（经纬度本身需要双精度），差值再转单精度 */
+    float dy = (float)(lat - lat0) * GEOFENCE_M_PER_DEG_LAT;
+    float dx = (float)(lon - lon0) * m_per_deg_lon;
+
+    return dx * dx + dy * dy;
+}
+
+/* GEOFENCE_M_PER_DEG_LAT * cos(lat)，设置区域时调用 */
+float geofence_m_per_deg_lon(double lat);
+
+/* 球面距离（m），大区域退回用 */
+double geofence_haversine_m(double lat1, double lon1, double lat2, double lon2);
+
+void geofence_init(struct geofence *gf);
+
+/* 增加区域；id 已存在时替换。满了返回 -ENOMEM，参数不对返回 -EINVAL */
+int geofence_add_circle(struct geofence *gf, uint16_t id, enum geofence_kind kind,
+                        double lat, double lon, float radius_m, uint32_t dwell_ms);
+int geofence_add_rect(struct geofence *gf, uint16_t id, enum geofence_kind kind,
+                      double lat_s, double lon_w, double lat_n, double lon_e,
+                      uint32_t dwell_ms);
+
+/*
+ * 多边形区域（围场），n 个顶点按顺序给出（顺 / 逆时针都行，不要求凸，自相交按
+ * 奇偶规则算），首尾不用重复。顶点数不对、跨度超过 GEOFENCE_PROJ_RANGE_M
+ * 返回 -EINVAL，区域或边表满了返回 -ENOMEM。
+ */
+int geofence_add_polygon(struct geofence *gf, uint16_t id, enum geofence_kind kind,
+                         const struct geofence_vertex *v, size_t n, uint32_t dwell_ms);
+
+/* 删掉一个区域（不报离开事件）；没有这个 id 返回 -ENOENT */
+int geofence_remove(struct geofence *gf, uint16_t id);
+
+/* 当前是否在 id 这个区域里 */
+bool geofence_is_inside(const struct geofence *gf, uint16_t id);
+
+/*
+ * 每个有效 fix 调一次。now_ms 是单调毫秒时间（回绕无妨）。
+ * 事件通过 cb 同步回调（可以为 NULL）。返回这次实际做了几何测试的区域数。
+ */
+int geofence_update(struct geofence *gf, uint32_t now_ms, double lat, double lon,
+                    geofence_cb_t cb, void *user);
+
+/*
+ * fix 到最近的区域边界的距离（m），在区域里面、外面都算；max_m（最大
+ * GEOFENCE_BOUNDARY_MAX_M）以内没有边界就返回 max_m。用网格只看附近的区域，
+ * 不改进出状态，不产生事件；GNSS 省电策略用它判断是否快到围栏了。
+ */
+float geofence_boundary_dist(struct geofence *gf, double lat, double lon, float max_m);
+
+#endif /* GEOFENCE_H_ */
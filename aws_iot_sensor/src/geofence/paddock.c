@@ -0,0 +1,290 @@
+/* paddock.c
+ *
+ * 围场电子围栏：shadow 下发、flash 保存、逃逸报警，见 paddock.h。
+ * 围场表在 shadow 处理和保存工作项之间共享，用互斥锁；
+ * 报警快照由 GNSS 线程写、系统工作队列读，用 spinlock。
+ */
+
+#include "paddock.h"
+#include "gnss_task.h"
+#include "app_fs.h"
+#include "mqtt_id.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <net/aws_iot.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(paddock, LOG_LEVEL_INF);
+
+/* ====================== 参数可调 ====================== */
+
+#define PADDOCK_PATH            APP_FS_MNT "/paddocks.bin"
+
+#define PADDOCK_MAGIC           0x5041444B /* "PADK" */
+#define PADDOCK_VERSION         1
+
+#define PADDOCK_ALERT_TOPIC     "horse_alert"
+
+/* 报警没发出去（还没连上）时的重试间隔 */
+#define PADDOCK_ALERT_RETRY_SEC 10
+
+/* ====================== 状态 ====================== */
+
+struct paddock_rec {
+    uint16_t id;              /* 0 = 空位 */
+    uint16_t n;               /* 顶点数 */
+    int32_t  lat_e6[GEOFENCE_MAX_POLY_VERTS];
+    int32_t  lon_e6[GEOFENCE_MAX_POLY_VERTS];
+};
+
+/* 持久化到 PADDOCK_PATH */
+struct paddock_file {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    struct paddock_rec rec[PADDOCK_MAX];
+};
+
+static K_MUTEX_DEFINE(paddock_lock);
+static struct paddock_file table = {
+    .magic = PADDOCK_MAGIC, .version = PADDOCK_VERSION,
+};
+static struct geofence_vertex verts[GEOFENCE_MAX_POLY_VERTS];
+
+static void save_work_fn(struct k_work *work);
+static K_WORK_DEFINE(save_work, save_work_fn);
+
+/* 待发的逃逸报警快照 */
+static struct k_spinlock alert_lock;
+static struct {
+    bool     pending;
+    uint32_t seq;           /* 每次新报警 +1：发送期间又来一次，发完不能把新的清掉 */
+    uint16_t id;
+    int32_t  lat_e6;
+    int32_t  lon_e6;
+    int64_t  utc_ms;
+} alert;
+
+static void alert_work_fn(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(alert_work, alert_work_fn);
+
+/* ====================== 保存 ====================== */
+
+static void save_work_fn(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    k_mutex_lock(&paddock_lock, K_FOREVER);
+    int err = app_fs_write_file(PADDOCK_PATH, &table, sizeof(table));
+    k_mutex_unlock(&paddock_lock);
+
+    if (err) {
+        LOG_ERR("Paddock save failed (%d)", err);
+    } else {
+        LOG_INF("Paddocks saved");
+    }
+}
+
+/* ====================== 登记 ====================== */
+
+/* 调用方持有 paddock_lock */
+static int apply(const struct paddock_rec *r)
+{
+    for (uint16_t k = 0; k < r->n; k++) {
+        verts[k].lat = r->lat_e6[k] / 1e6;
+        verts[k].lon = r->lon_e6[k] / 1e6;
+    }
+    return gnss_geofence_add_polygon(PADDOCK_ZONE_BASE + r->id, GEOFENCE_KIND_PADDOCK,
+                                     verts, r->n);
+}
+
+static struct paddock_rec *find(uint16_t id)
+{
+    for (int i = 0; i < PADDOCK_MAX; i++) {
+        if (table.rec[i].id == id) {
+            return &table.rec[i];
+        }
+    }
+    return NULL;
+}
+
+/* ====================== 报警发布 ====================== */
+
+static void alert_work_fn(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    char json[128];
+    struct aws_iot_data tx = { 0 };
+
+    k_spinlock_key_t key = k_spin_lock(&alert_lock);
+    bool pending = alert.pending;
+    uint32_t seq = alert.seq;
+    int n = snprintf(json, sizeof(json),
+                     "{\"type\":\"escape\",\"paddock\":%u,\"lat\":%d,\"lon\":%d,"
+                     "\"utc_ms\":%lld}",
+                     alert.id, alert.lat_e6, alert.lon_e6, (long long)alert.utc_ms);
+    k_spin_unlock(&alert_lock, key);
+
+    if (!pending) {
+        return;
+    }
+
+    tx.qos       = MQTT_QOS_1_AT_LEAST_ONCE;
+    tx.message_id = mqtt_id_next();
+    tx.ptr       = json;
+    tx.len       = n;
+    tx.topic.str = PADDOCK_ALERT_TOPIC;
+    tx.topic.len = strlen(PADDOCK_ALERT_TOPIC);
+
+    int err = aws_iot_send(&tx);
+    if (err) {
+        LOG_WRN("Escape alert publish failed (%d), retrying", err);
+        k_work_reschedule(&alert_work, K_SECONDS(PADDOCK_ALERT_RETRY_SEC));
+        return;
+    }
+
+    LOG_WRN("Escape alert sent: %s", json);
+
+    key = k_spin_lock(&alert_lock);
+    if (alert.seq == seq) {
+        alert.pending = false;
+    }
+    k_spin_unlock(&alert_lock, key);
+}
+
+/* ====================== 对外接口 ====================== */
+
+int paddock_init(void)
+{
+    if (!app_fs_ready()) {
+        return -ENODEV;
+    }
+
+    k_mutex_lock(&paddock_lock, K_FOREVER);
+
+    int err = app_fs_read_file(PADDOCK_PATH, &table, sizeof(table));
+
+    if (err || table.magic != PADDOCK_MAGIC || table.version != PADDOCK_VERSION) {
+        if (err != -ENOENT) {
+            LOG_WRN("Paddock file invalid (%d), starting empty", err);
+        }
+        memset(&table, 0, sizeof(table));
+        table.magic = PADDOCK_MAGIC;
+        table.version = PADDOCK_VERSION;
+        k_mutex_unlock(&paddock_lock);
+        return 0;
+    }
+
+    int loaded = 0;
+
+    for (int i = 0; i < PADDOCK_MAX; i++) {
+        struct paddock_rec *r = &table.rec[i];
+
+        if (r->id == 0) {
+            continue;
+        }
+        err = (r->id <= PADDOCK_ID_MAX && r->n <= GEOFENCE_MAX_POLY_VERTS) ? apply(r) : -EINVAL;
+        if (err) {
+            LOG_WRN("Paddock %u not restored (%d)", r->id, err);
+            r->id = 0;
+            continue;
+        }
+        loaded++;
+    }
+    k_mutex_unlock(&paddock_lock);
+
+    LOG_INF("%d paddock(s) restored", loaded);
+    return 0;
+}
+
+int paddock_set(uint16_t id, const int32_t *pts, size_t n_pts)
+{
+    size_t n = n_pts / 2;
+
+    if (id == 0 || id > PADDOCK_ID_MAX || (n_pts & 1) || n > GEOFENCE_MAX_POLY_VERTS) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&paddock_lock, K_FOREVER);
+
+    struct paddock_rec *r = find(id);
+    struct paddock_rec rec = { .id = id, .n = n };
+
+    for (size_t k = 0; k < n; k++) {
+        rec.lat_e6[k] = pts[2 * k];
+        rec.lon_e6[k] = pts[2 * k + 1];
+    }
+
+    /* shadow 每次重连都会把没消掉的 delta 再发一遍，内容一样就什么都不做 */
+    if (r != NULL && memcmp(r, &rec, sizeof(rec)) == 0) {
+        k_mutex_unlock(&paddock_lock);
+        return 0;
+    }
+    if (r == NULL) {
+        r = find(0);
+    }
+
+    int err = (r != NULL) ? apply(&rec) : -ENOMEM;
+
+    if (err == 0) {
+        *r = rec;
+        k_work_submit(&save_work);
+    }
+    k_mutex_unlock(&paddock_lock);
+
+    LOG_INF("Paddock %u (%u vertices) -> %d", id, (unsigned int)n, err);
+    return err;
+}
+
+int paddock_remove(uint16_t id)
+{
+    k_mutex_lock(&paddock_lock, K_FOREVER);
+
+    struct paddock_rec *r = (id != 0) ? find(id) : NULL;
+    int err = -ENOENT;
+
+    if (r != NULL) {
+        (void)gnss_geofence_remove(PADDOCK_ZONE_BASE + id);
+        r->id = 0;
+        k_work_submit(&save_work);
+        err = 0;
+    }
+    k_mutex_unlock(&paddock_lock);
+
+    LOG_INF("Paddock %u removed -> %d", id, err);
+    return err;
+}
+
+void paddock_on_event(const struct geofence_event *evt, double lat, double lon, tb_ts_t ts)
+{
+    uint16_t id = evt->id - PADDOCK_ZONE_BASE;
+
+    if (evt->type == GEOFENCE_EVT_ENTER) {
+        LOG_INF("Inside paddock %u", id);
+        return;
+    }
+    if (evt->type != GEOFENCE_EVT_EXIT) {
+        return;
+    }
+
+    int64_t utc_ms = 0;
+
+    (void)timebase_to_utc_ms(ts, &utc_ms);
+
+    k_spinlock_key_t key = k_spin_lock(&alert_lock);
+    alert.pending = true;
+    alert.seq++;
+    alert.id      = id;
+    alert.lat_e6  = (int32_t)(lat * 1e6);
+    alert.lon_e6  = (int32_t)(lon * 1e6);
+    alert.utc_ms  = utc_ms;
+    k_spin_unlock(&alert_lock, key);
+
+    LOG_WRN("Escaped paddock %u at (%f, %f) after %u s inside",
+            id, lat, lon, evt->inside_ms / 1000);
+    k_work_reschedule(&alert_work, K_NO_WAIT);
+}
@@ -0,0 +1,45 @@
+#ifndef PADDOCK_H_
+#define PADDOCK_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "timebase.h"
+#include "geofence.h"
+
+/*
+ * 围场（多边形电子围栏）：shadow 下发 → 存 flash → 登记到 GNSS 任务的电子围栏。
+ *
+ * shadow delta 里的 "fence": {"id": 1..255, "pts": [lat_e6, lon_e6, ...]}
+ * 增加 / 替换一个围场，"del": 1 删除。顶点是微度（和 horse_data 的经纬度一样）。
+ * 所有围场存在 /lfs/paddocks.bin，开机由 paddock_init 读回来重新登记。
+ *
+ * 马离开围场（超出边界加迟滞余量）的那个 fix 上立即排一条 QoS1 的
+ * horse_alert（"type": "escape"），没连上就定时重试；回到围场里只打 log。
+ */
+
+#ifndef PADDOCK_MAX
+#if defined(CONFIG_HORSE_PADDOCK_MAX)
+#define PADDOCK_MAX             CONFIG_HORSE_PADDOCK_MAX
+#else
+#define PADDOCK_MAX             4
+#endif
+#endif
+
+/* 围场在电子围栏里的区域编号 = PADDOCK_ZONE_BASE + shadow 里的 id */
+#define PADDOCK_ZONE_BASE       0x100
+#define PADDOCK_ID_MAX          255
+
+/* 从 flash 读回围场并登记（app_fs 和 GNSS 任务初始化之后调用） */
+int paddock_init(void);
+
+/* 增加 / 替换围场；pts 是 lat_e6, lon_e6 交替，n_pts 是数组长度（顶点数的两倍） */
+int paddock_set(uint16_t id, const int32_t *pts, size_t n_pts);
+
+int paddock_remove(uint16_t id);
+
+/* GNSS 任务的电子围栏回调里调用（kind == GEOFENCE_KIND_PADDOCK 的事件） */
+void paddock_on_event(const struct geofence_event *evt, double lat, double lon, tb_ts_t ts);
+
+#endif /* PADDOCK_H_ */
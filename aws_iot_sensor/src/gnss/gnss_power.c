@@ -0,0 +1,149 @@
+/* gnss_power.c
+ *
+ * GNSS 省电策略（连续 / 周期 / 单次定位切换 + 每小时统计），见 gnss_power.h。
+ */
+
+#include "gnss_power.h"
+
+#include <math.h>
+#include <string.h>
+
+#define HOUR_MS     3600000U
+
+void gnss_power_init(struct gnss_power *p, const struct gnss_power_cfg *cfg, uint32_t now_ms)
+{
+    memset(p, 0, sizeof(*p));
+    p->cfg = *cfg;
+    p->mode = GNSS_POWER_CONTINUOUS;
+    p->last_move_ms = now_ms;
+    p->last_poll_ms = now_ms;
+    p->hour_start_ms = now_ms;
+    p->last_fence_m = INFINITY;
+}
+
+void gnss_power_set_hold(struct gnss_power *p, bool hold, uint32_t now_ms)
+{
+    if (p->hold && !hold) {
+        p->last_move_ms = now_ms;
+    }
+    p->hold = hold;
+}
+
+void gnss_power_on_imu(struct gnss_power *p, uint32_t now_ms, float gyro_rms_dps)
+{
+    p->imu_seen = true;
+    p->last_imu_ms = now_ms;
+    if (gyro_rms_dps > p->cfg.move_dps) {
+        p->last_move_ms = now_ms;
+    }
+}
+
+/* 小时结算（中间停了好几个小时也只出一条） */
+static void hour_roll(struct gnss_power *p, uint32_t now_ms)
+{
+    if (now_ms - p->hour_start_ms < HOUR_MS) {
+        return;
+    }
+    p->last = p->cur;
+    p->last_ready = true;
+    memset(&p->cur, 0, sizeof(p->cur));
+    p->hour_start_ms += HOUR_MS;
+    if (now_ms - p->hour_start_ms >= HOUR_MS) {
+        p->hour_start_ms = now_ms;
+    }
+}
+
+void gnss_power_on_pvt(struct gnss_power *p, uint32_t now_ms, bool fix_valid,
+                       float speed_mps, float fence_dist_m)
+{
+    hour_roll(p, now_ms);
+
+    /* 接收机醒着才报 PVT，一个 PVT 算 1 s 开机时间 */
+    if (p->cur.pvts < UINT16_MAX) {
+        p->cur.pvts++;
+    }
+    p->cur.on_s++;
+
+    if (!fix_valid) {
+        return;
+    }
+    if (p->cur.fixes < UINT16_MAX) {
+        p->cur.fixes++;
+    }
+
+    bool approach = fence_dist_m < p->cfg.approach_m &&
+                    p->last_fence_m - fence_dist_m > p->cfg.approach_step_m;
+
+    p->last_fence_m = fence_dist_m;
+    if (speed_mps > p->cfg.move_mps || approach) {
+        p->last_move_ms = now_ms;
+    }
+}
+
+static enum gnss_power_mode wanted_mode(const struct gnss_power *p, uint32_t now_ms)
+{
+    if (p->hold) {
+        return GNSS_POWER_CONTINUOUS;
+    }
+
+    uint32_t still_ms = now_ms - p->last_move_ms;
+    bool imu_fresh = p->imu_seen &&
+                     now_ms - p->last_imu_ms <= (uint32_t)p->cfg.imu_stale_s * 1000U;
+
+    if (imu_fresh && still_ms >= (uint32_t)p->cfg.single_after_s * 1000U) {
+        return GNSS_POWER_SINGLE;
+    }
+    if (still_ms >= (uint32_t)p->cfg.periodic_after_s * 1000U) {
+        return GNSS_POWER_PERIODIC;
+    }
+    return GNSS_POWER_CONTINUOUS;
+}
+
+enum gnss_power_mode gnss_power_poll(struct gnss_power *p, uint32_t now_ms)
+{
+    uint32_t dt_s = (now_ms - p->last_poll_ms) / 1000U;
+
+    /* 按整秒累计，余数留到下一次（算在上一次 poll 给出的工作方式上） */
+    if (dt_s > 0) {
+        uint32_t s = p->cur.mode_s[p->mode] + dt_s;
+
+        p->cur.mode_s[p->mode] = (s > UINT16_MAX) ? UINT16_MAX : (uint16_t)s;
+        p->last_poll_ms += dt_s * 1000U;
+    }
+    hour_roll(p, now_ms);
+
+    enum gnss_power_mode m = wanted_mode(p, now_ms);
+
+    if (m != p->mode) {
+        p->mode = m;
+        if (p->cur.switches < UINT16_MAX) {
+            p->cur.switches++;
+        }
+    }
+
+    return p->mode;
+}
+
+bool gnss_power_take_hour(struct gnss_power *p, struct gnss_power_hour *out)
+{
+    if (!p->last_ready) {
+        return false;
+    }
+    *out = p->last;
+    p->last_ready = false;
+    return true;
+}
+
+const char *gnss_power_mode_str(enum gnss_power_mode mode)
+{
+    switch (mode) {
+    case GNSS_POWER_CONTINUOUS:
+        return "continuous";
+    case GNSS_POWER_PERIODIC:
+        return "periodic";
+    case GNSS_POWER_SINGLE:
+        return "single";
+    default:
+        return "?";
+    }
+}
@@ -0,0 +1,107 @@
+#ifndef GNSS_POWER_H_
+#define GNSS_POWER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * GNSS 省电策略 —— 纯逻辑，不依赖内核和 modem，可以在 native_sim / qemu 上测试。
+ *
+ * 三种工作方式：
+ *   CONTINUOUS  连续 1 Hz 定位（走动、快到围栏边界、还没标水槽、丢星恢复中）
+ *   PERIODIC    modem 周期定位，两次之间接收机睡眠
+ *   SINGLE      单次定位，GNSS 线程定时启动一次，定到就停
+ * 间隔由调用方决定（Kconfig），这里只决定用哪一种。
+ *
+ * 下面任一条满足就算“在动”，马上回到 CONTINUOUS：
+ *  - IMU：鬐甲陀螺仪 1 s 内的 RMS 角速度超过 move_dps；
+ *  - GNSS：有效 fix 的速度超过 move_mps；
+ *  - 电子围栏：离最近的区域边界不到 approach_m，而且比上一个 fix 又近了
+ *    approach_step_m 以上（正在往边界走，可能马上进出水槽 / 越界）。
+ *    只是站在边界附近（棚里、水槽边）不算，否则永远省不了电。
+ * 不动满 periodic_after_s 降到 PERIODIC，满 single_after_s 降到 SINGLE。
+ * SINGLE 两次定位之间只有 IMU 在看，所以 IMU 数据不新鲜（超过 imu_stale_s 没有
+ * 样本：流水线级关了、IMU 掉线）时最多只降到 PERIODIC。
+ *
+ * 统计：每小时的有效 fix 数和估计的 GNSS 开机时间。modem 搜星 / 跟踪时每秒报一次
+ * PVT，睡眠时不报，所以开机时间按收到的 PVT 个数 x 1 s 估计。
+ *
+ * 时间都是单调毫秒（uint32_t，回绕无妨）。不加锁，只在 GNSS 线程里用。
+ */
+
+enum gnss_power_mode {
+    GNSS_POWER_CONTINUOUS = 0,
+    GNSS_POWER_PERIODIC,
+    GNSS_POWER_SINGLE,
+};
+
+struct gnss_power_cfg {
+    uint16_t periodic_after_s;  /* 不动多久降到 PERIODIC */
+    uint16_t single_after_s;    /* 不动多久降到 SINGLE */
+    uint16_t imu_stale_s;       /* IMU 活动量多久没更新算不新鲜 */
+    float    move_dps;          /* 陀螺仪 RMS 超过这个算在动 */
+    float    move_mps;          /* GNSS 速度超过这个算在动 */
+    float    approach_m;        /* 离围栏边界不到这个算快到了 */
+    float    approach_step_m;   /* 而且比上一个 fix 近了这么多（滤掉 GNSS 抖动） */
+};
+
+/* 一个小时的统计 */
+struct gnss_power_hour {
+    uint16_t fixes;             /* 有效 fix 数 */
+    uint16_t pvts;              /* 收到的 PVT 数 */
+    uint32_t on_s;              /* 估计的 GNSS 开机秒数 */
+    uint16_t switches;          /* 工作方式切换次数 */
+    uint16_t mode_s[3];         /* 各工作方式的秒数（按 poll 之间的间隔累计） */
+};
+
+struct gnss_power {
+    struct gnss_power_cfg cfg;
+
+    enum gnss_power_mode mode;  /* 最近一次 poll 给出的工作方式 */
+    bool     hold;              /* 强制 CONTINUOUS */
+
+    uint32_t last_move_ms;      /* 最近一次判定在动的时间 */
+    uint32_t last_imu_ms;
+    bool     imu_seen;
+    float    last_fence_m;      /* 上一个有效 fix 到围栏边界的距离 */
+
+    uint32_t last_poll_ms;
+    uint32_t hour_start_ms;
+    struct gnss_power_hour cur;
+    struct gnss_power_hour last;
+    bool     last_ready;        /* last 还没被 gnss_power_take_hour 取走 */
+};
+
+/* 默认参数 */
+#define GNSS_POWER_MOVE_DPS         15.0f
+#define GNSS_POWER_MOVE_MPS         0.8f
+#define GNSS_POWER_APPROACH_M       25.0f
+#define GNSS_POWER_APPROACH_STEP_M  3.0f
+#define GNSS_POWER_PERIODIC_AFTER_S 120
+#define GNSS_POWER_SINGLE_AFTER_S   900
+#define GNSS_POWER_IMU_STALE_S      60
+
+void gnss_power_init(struct gnss_power *p, const struct gnss_power_cfg *cfg, uint32_t now_ms);
+
+/* 强制连续定位（搜星、等标水槽、丢星恢复）；取消后从现在开始重新计不动时间 */
+void gnss_power_set_hold(struct gnss_power *p, bool hold, uint32_t now_ms);
+
+/* IMU 每秒一个活动量：陀螺仪角速度模的 RMS（deg/s） */
+void gnss_power_on_imu(struct gnss_power *p, uint32_t now_ms, float gyro_rms_dps);
+
+/*
+ * 每个 PVT 调一次。fix 无效时后面几个参数不看；
+ * fence_dist_m 是 fix 到最近围栏边界的距离（没有区域时给个大数）。
+ */
+void gnss_power_on_pvt(struct gnss_power *p, uint32_t now_ms, bool fix_valid,
+                       float speed_mps, float fence_dist_m);
+
+/* 定期调用（每秒一次左右），返回现在应该用的工作方式 */
+enum gnss_power_mode gnss_power_poll(struct gnss_power *p, uint32_t now_ms);
+
+/* 有一个完整的小时统计还没取走时拷出来并返回 true */
+bool gnss_power_take_hour(struct gnss_power *p, struct gnss_power_hour *out);
+
+const char *gnss_power_mode_str(enum gnss_power_mode mode);
+
+#endif /* GNSS_POWER_H_ */
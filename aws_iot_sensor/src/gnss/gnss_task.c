@@ -2,14 +2,19 @@
  *
  * Implements GNSS + water-intake logic as a Zephyr thread.
  * - Uses GPS to track position, speed, heading.
- * - Button marks trough (water) position once.
- * - If horse stays near trough > 3s, counts as water visit (accumulates time).
- * - Every PVT event, this thread sends one gnss_status_msg to gnss_msgq:
+ * - Button marks trough (water) position once; it becomes zone 0 of the
+ *   geofence engine (geofence.c), which also holds the other farm zones.
+ * - If horse stays near trough > 3s, counts as water visit; visits go to the
+ *   flash water log (water_log.c), which also keeps the daily totals.
+ * - Every PVT event, this thread publishes one gnss_status_msg to the
+ *   latest-fix mailbox (seqlock) and the history ring:
  *      * if fix_valid == true: update latest_fix, then send.
  *      * if fix_valid == false: keep last valid latest_fix, still send.
  * - First time trough is marked, we send one message with is_water_gnss = true.
  * - If GNSS is considered lost (10 consecutive no-fix), status = SIGNAL_LOST,
  *   we keep sending last-known position until fix is restored.
+ * - GNSS runs at 1 Hz only while the horse moves or is near a fence; at rest
+ *   the power policy (gnss_power.c) switches to periodic / single-shot fixes.
  */
 
 #include <zephyr/kernel.h>
@@ -17,6 +22,7 @@
 LOG_MODULE_REGISTER(gnss_task, LOG_LEVEL_INF);
 
 #include <zephyr/drivers/gpio.h>
+#include <zephyr/sys/barrier.h>
 
 #include <stdbool.h>
 #include <stdint.h>
@@ -28,6 +34,13 @@ LOG_MODULE_REGISTER(gnss_task, LOG_LEVEL_INF);
 #include <modem/lte_lc.h>
 
 #include "gnss_task.h"
+#include "gnss_power.h"
+#include "sensor.h"
+#include "geofence.h"
+#include "paddock.h"
+#include "track_log.h"
+#include "colic_monitor.h"
+#include "water_log.h"
 
 /* ====================== 参数可调 ====================== */
 
@@ -37,12 +50,24 @@ LOG_MODULE_REGISTER(gnss_task, LOG_LEVEL_INF);
 /* 停留超过多少 ms 认为是一次喝水事件 */
 #define WATER_MIN_DURATION_MS        3000
 
+/* 水槽在电子围栏里的区域编号 */
+#define TROUGH_ZONE_ID               0
+
 /* 检测丢星：连续多少次没有 fix 判定为 GNSS 信号有问题 */
 #define NO_FIX_THRESHOLD             10
 
 /* 费城时区相对 GNSS UTC 的小时偏移（简单版：UTC-5） */
 #define PHILLY_TIME_OFFSET_HOURS     (-5)
 
+/* 周期 / 单次定位时每次最多搜多久（s）；马关在棚里收不到星时不至于一直开着 */
+#define GNSS_LOWPWR_RETRY_S          30
+
+/* 消息历史环形缓冲的条数（1 Hz 下约半分钟） */
+#define GNSS_HISTORY_LEN             32
+
+/* PVT 环形缓冲的帧数（2 的幂）：GNSS 线程晚醒几秒也不丢帧 */
+#define PVT_RING_LEN                 8
+
 /* GNSS 任务线程配置 */
 #define GNSS_TASK_STACK_SIZE         4096
 #define GNSS_TASK_PRIORITY           2
@@ -76,6 +101,66 @@ static const struct gpio_dt_spec led_blue  = GPIO_DT_SPEC_GET(LED_BLUE_NODE, gpi
 static const struct gpio_dt_spec button1   = GPIO_DT_SPEC_GET(BUTTON1_NODE, gpios);
 static struct gpio_callback button1_cb;
 
+/* ====================== GNSS 工作方式 ====================== */
+
+/* 省电策略：只在 GNSS 线程里用 */
+static struct gnss_power power;
+
+/* modem 的 GNSS 配置 / 启停，LTE 的 work 和 GNSS 线程都会动，用互斥锁 */
+static K_MUTEX_DEFINE(gnss_ctl_lock);
+static bool gnss_enabled;      /* LTE ready 之后打开过 GNSS 功能模式 */
+static bool gnss_running;
+static enum gnss_power_mode power_applied = GNSS_POWER_CONTINUOUS;
+
+/* SINGLE：下一次启动单次定位的时间（uptime ms） */
+static int64_t single_next_ms;
+
+/* 按工作方式配置 fix_retry / fix_interval 并启动，调用方持有 gnss_ctl_lock。
+ * modem 要求 GNSS 停着才能改 fix_interval。
+ */
+static int gnss_apply_mode(enum gnss_power_mode mode)
+{
+    uint16_t interval = 1;
+    uint16_t retry = 0;
+    int err;
+
+    if (mode == GNSS_POWER_PERIODIC) {
+        interval = CONFIG_HORSE_GNSS_PERIODIC_SEC;
+        retry = GNSS_LOWPWR_RETRY_S;
+    } else if (mode == GNSS_POWER_SINGLE) {
+        interval = 0;
+        retry = GNSS_LOWPWR_RETRY_S;
+    }
+
+    if (gnss_running) {
+        (void)nrf_modem_gnss_stop();
+        gnss_running = false;
+    }
+
+    err = nrf_modem_gnss_fix_retry_set(retry);
+    if (err) {
+        LOG_ERR("Failed to set fix retry: %d", err);
+        return err;
+    }
+
+    err = nrf_modem_gnss_fix_interval_set(interval);
+    if (err) {
+        LOG_ERR("Failed to set fix interval: %d", err);
+        return err;
+    }
+
+    /* 启动 GNSS 接收 (PVT) */
+    err = nrf_modem_gnss_start();
+    if (err) {
+        LOG_ERR("Failed to start GNSS: %d", err);
+        return err;
+    }
+
+    gnss_running = true;
+    power_applied = mode;
+    return 0;
+}
+
 /* ====================== 在 LTE ready 之后启动 GNSS ====================== */
 
 void gnss_start_after_lte_ready(void)
@@ -89,27 +174,21 @@ void gnss_start_after_lte_ready(void)
         return;
     }
 
-    /* 现在 GNSS 功能模式已打开，再配置 fix_retry / fix_interval */
-    err = nrf_modem_gnss_fix_retry_set(0);
-    if (err) {
-        printk("Failed to set fix retry: %d\n", err);
-        return;
-    }
-
-    err = nrf_modem_gnss_fix_interval_set(1);
-    if (err) {
-        printk("Failed to set fix interval: %d\n", err);
-        return;
+    /* 现在 GNSS 功能模式已打开，按当前工作方式配置并启动（第一次是连续 1 Hz） */
+    k_mutex_lock(&gnss_ctl_lock, K_FOREVER);
+    gnss_enabled = true;
+    err = gnss_apply_mode(power_applied);
+    if (power_applied == GNSS_POWER_SINGLE) {
+        single_next_ms = k_uptime_get() + CONFIG_HORSE_GNSS_SINGLE_SEC * 1000LL;
     }
+    k_mutex_unlock(&gnss_ctl_lock);
 
-    /* 启动 GNSS 接收 (PVT) */
-    err = nrf_modem_gnss_start();
     if (err) {
-        printk("Failed to start GNSS: %d\n", err);
         return;
     }
 
-    printk("=== GNSS started after LTE ready ===\n");
+    printk("=== GNSS started after LTE ready (%s) ===\n",
+           gnss_power_mode_str(power_applied));
 }
 
 /* ====================== GNSS & 状态机定义 ====================== */
@@ -117,17 +196,50 @@ void gnss_start_after_lte_ready(void)
 /* 当前 GNSS 状态（对外通过 message.status 告诉 LTE） */
 static enum gnss_status current_status = GNSS_STATUS_SEARCHING;
 
-/* 最近一次的原始 PVT 数据 */
-static struct nrf_modem_gnss_pvt_data_frame last_pvt;
+/*
+ * PVT 环形缓冲：单生产者（modem 事件回调，中断上下文）/ 单消费者（GNSS 线程），无锁。
+ * head 只有回调写，tail 只有线程写，都是自由增长的计数，下标取低位。
+ * 回调先把帧读进 head 指向的空槽，再推进 head；线程处理完一帧才推进 tail，
+ * 所以线程读的槽不会被同时写。atomic_set / atomic_get 自带内存屏障（发布 / 获取）。
+ * 满了回调不能动 tail，只能丢掉新来的这一帧并计数。
+ */
+BUILD_ASSERT((PVT_RING_LEN & (PVT_RING_LEN - 1)) == 0, "PVT_RING_LEN must be a power of 2");
+
+struct pvt_slot {
+    struct nrf_modem_gnss_pvt_data_frame pvt;
+    tb_ts_t ts;          /* PVT 到达时间戳 */
+};
 
-/* PVT 到达的信号量（在 GNSS 线程中处理） */
-static K_SEM_DEFINE(pvt_data_sem, 0, 1);
+static struct pvt_slot pvt_ring[PVT_RING_LEN];
+static atomic_t pvt_head;
+static atomic_t pvt_tail;
 
-/* 给 LTE 任务的消息队列定义 */
-K_MSGQ_DEFINE(gnss_msgq, sizeof(struct gnss_status_msg), 16, 4);
+static atomic_t pvt_frames;       /* 收到的 PVT 事件 */
+static atomic_t pvt_overruns;     /* 缓冲满丢掉的帧 */
+static atomic_t pvt_read_errors;  /* nrf_modem_gnss_read 失败 */
+static uint32_t pvt_max_depth;    /* 线程一次看到的最大积压（只有线程写） */
+
+/* 每来一帧 give 一次；线程每次醒来把缓冲清空，多出来的计数只是空转一圈 */
+static K_SEM_DEFINE(pvt_data_sem, 0, PVT_RING_LEN);
+
+/*
+ * 最新消息信箱（seqlock）：只有 GNSS 线程写，读的人拷一份，不用排队也不用加锁。
+ * 写之前 seq 变奇数、写完变偶数；读的人前后两次 seq 一样而且是偶数，拷到的就是完整的一条。
+ * 写的时候锁调度器，优先级更高的线程（系统工作队列是协作式的）不会在写到一半时
+ * 插进来读、然后一直等一个跑不了的写者。中断里不要读。
+ */
+static atomic_t latest_seq;
+static struct gnss_status_msg latest_msg;
+
+/* 消息历史：要完整轨迹的消费者各自拿游标按顺序读，慢了只丢自己的旧数据 */
+static struct gnss_status_msg history[GNSS_HISTORY_LEN];
+static uint32_t history_head;      /* 下一条的序号（自由增长） */
+static struct k_spinlock history_lock;
 
 /* 简化后的“当前 GNSS fix”结构（内部用） */
 struct gnss_fix_simple {
+    tb_ts_t ts;          /* PVT 到达时间戳 */
+
     double lat;
     double lon;
     double alt;
@@ -157,26 +269,22 @@ struct trough_position {
     double alt;
     float  accuracy;
     bool   valid;
+    bool   fenced;    /* 已经登记到电子围栏（按键在中断里，登记放到 GNSS 线程做） */
 };
 
 static struct trough_position trough_pos = { 0 };
 
-/* 用于检测“在水槽附近停留”的状态 */
+/* 电子围栏：GNSS 线程逐 fix 更新，shadow 下发的围场从别的线程增删，用互斥锁 */
+static struct geofence fences;
+static K_MUTEX_DEFINE(fence_lock);
+
+/* 用于记录“在水槽附近停留”的开始 */
 struct water_visit_state {
-    bool in_zone;                 /* 当前是否认为在水槽区域 */
-    int64_t enter_uptime_ms;      /* 进入区域时的本地 uptime (ms) */
     struct gnss_fix_simple enter_fix; /* 进入时的 GNSS 时间/位置（用于记录开始时间） */
 };
 
 static struct water_visit_state water_state = { 0 };
 
-/* 喝水统计：内部仍然用 ms 累计，发给外部用秒 */
-struct water_visit_stats {
-    int64_t total_duration_ms;
-};
-
-static struct water_visit_stats water_stats = { 0 };
-
 /* 丢星检测：记录连续 no-fix 次数 & 是否处于 GNSS lost 状态 */
 static int  no_fix_count = 0;
 static bool gnss_lost    = false;
@@ -222,27 +330,7 @@ static void gps_led_set(enum gps_led_color color)
 #endif
 }
 
-/* ====================== 工具函数：距离 & 时间偏移 ====================== */
-
-static double deg2rad(double deg)
-{
-    const double pi = 3.14159265358979323846;
-    return deg * pi / 180.0;
-}
-
-/* Haversine 公式计算两点之间距离 (米) */
-static double distance_meters(double lat1, double lon1, double lat2, double lon2)
-{
-    double R = 6371000.0; /* 地球半径 (m) */
-    double dlat = deg2rad(lat2 - lat1);
-    double dlon = deg2rad(lon2 - lon1);
-
-    double a = sin(dlat / 2.0) * sin(dlat / 2.0) +
-               cos(deg2rad(lat1)) * cos(deg2rad(lat2)) *
-               sin(dlon / 2.0) * sin(dlon / 2.0);
-    double c = 2.0 * atan2(sqrt(a), sqrt(1.0 - a));
-    return R * c;
-}
+/* ====================== 工具函数：时间偏移 ====================== */
 
 /* 把 GNSS UTC 小时转成“费城时间小时”（简单版：只做 hour + offset 的 0~23 wrap） */
 static uint16_t utc_hour_to_philly(uint16_t utc_hour)
@@ -266,6 +354,8 @@ static void gnss_restart(void)
 
     LOG_WRN("GNSS signal lost, restarting GNSS...");
 
+    k_mutex_lock(&gnss_ctl_lock, K_FOREVER);
+
     err = nrf_modem_gnss_stop();
     if (err) {
         LOG_ERR("nrf_modem_gnss_stop failed, err %d", err);
@@ -275,69 +365,66 @@ static void gnss_restart(void)
     if (err) {
         LOG_ERR("nrf_modem_gnss_start failed, err %d", err);
     }
+
+    k_mutex_unlock(&gnss_ctl_lock);
 }
 
 /* ====================== 喝水逻辑 ====================== */
 
-/* water_zone_update:
- *   根据当前位置更新 in_zone 状态，如果本次调用导致“离开水槽区域并且停留时间足够长”，
- *   则返回 true，并通过 out_duration_ms 返回停留时间。
- */
-static bool water_zone_update(const struct gnss_fix_simple *fix,
-                              int64_t *out_duration_ms)
+/* 处理喝水事件：记进 flash 里的喝水记录（每日统计也在那里）+ 打 log */
+static void handle_water_visit(const struct gnss_fix_simple *start_fix,
+                               uint16_t zone, int64_t duration_ms)
 {
-    if (!trough_pos.valid) {
-        return false;
-    }
-
-    double d = distance_meters(fix->lat, fix->lon, trough_pos.lat, trough_pos.lon);
-    bool now_in_zone = (d <= TROUGH_RADIUS_M);
-
-    int64_t now_ms = k_uptime_get();
+    uint32_t start_utc = 0;
 
-    if (!water_state.in_zone && now_in_zone) {
-        /* 刚进入水槽区域 */
-        water_state.in_zone = true;
-        water_state.enter_uptime_ms = now_ms;
-        water_state.enter_fix = *fix;
-
-        LOG_INF("Enter trough zone, distance = %.2f m", d);
-    } else if (water_state.in_zone && !now_in_zone) {
-        /* 刚离开水槽区域 */
-        int64_t duration_ms = now_ms - water_state.enter_uptime_ms;
-        water_state.in_zone = false;
-
-        LOG_INF("Leave trough zone, duration = %lld ms, distance at leave = %.2f m",
-                (long long)duration_ms, d);
-
-        if (duration_ms >= WATER_MIN_DURATION_MS) {
-            if (out_duration_ms) {
-                *out_duration_ms = duration_ms;
-            }
-            return true; /* 产生了一次喝水事件 */
-        }
+    if (start_fix->year >= 2020) {
+        start_utc = (uint32_t)(timebase_civil_to_utc_ms(start_fix->year, start_fix->month,
+                                                        start_fix->day, start_fix->hour,
+                                                        start_fix->minute, start_fix->seconds,
+                                                        0) / 1000);
     }
-
-    return false;
-}
-
-/* 处理喝水事件：累计总时间 + 打 log */
-static void handle_water_visit(const struct gnss_fix_simple *start_fix,
-                               int64_t duration_ms)
-{
-    water_stats.total_duration_ms += duration_ms;
+    (void)water_log_append(start_utc, (uint32_t)duration_ms, zone);
 
     uint16_t local_hour = utc_hour_to_philly(start_fix->hour);
 
-    LOG_INF("WATER VISIT: duration = %lld ms, total = %lld ms, "
+    LOG_INF("WATER VISIT: duration = %lld ms, today = %u s, "
             "pos = (%f, %f), local time = %04u-%02u-%02u %02u:%02u:%02u.%03u (Philly)",
             (long long)duration_ms,
-            (long long)water_stats.total_duration_ms,
+            water_log_today_s(),
             (double)start_fix->lat, (double)start_fix->lon,
             start_fix->year, start_fix->month, start_fix->day,
             local_hour, start_fix->minute, start_fix->seconds, start_fix->ms);
 }
 
+/* 电子围栏事件：水槽的进出算喝水，其它区域先只打 log */
+static void on_geofence_event(const struct geofence_event *evt, void *user)
+{
+    ARG_UNUSED(user);
+
+    if (evt->kind == GEOFENCE_KIND_TROUGH && evt->id == TROUGH_ZONE_ID) {
+        if (evt->type == GEOFENCE_EVT_ENTER) {
+            water_state.enter_fix = latest_fix;
+            LOG_INF("Enter trough zone");
+        } else if (evt->type == GEOFENCE_EVT_EXIT) {
+            LOG_INF("Leave trough zone, duration = %u ms", evt->inside_ms);
+            if (evt->inside_ms >= WATER_MIN_DURATION_MS) {
+                handle_water_visit(&water_state.enter_fix, evt->id, evt->inside_ms);
+            }
+        }
+        return;
+    }
+
+    if (evt->kind == GEOFENCE_KIND_PADDOCK) {
+        paddock_on_event(evt, latest_fix.lat, latest_fix.lon, latest_fix.ts);
+        return;
+    }
+
+    LOG_INF("Geofence zone %u (kind %u): %s, %u ms", evt->id, evt->kind,
+            evt->type == GEOFENCE_EVT_ENTER ? "enter" :
+            evt->type == GEOFENCE_EVT_EXIT ? "exit" : "dwell",
+            evt->inside_ms);
+}
+
 /* ====================== 按键：用于标记水槽位置 ====================== */
 
 static void on_button1_pressed(void)
@@ -360,6 +447,7 @@ static void on_button1_pressed(void)
     trough_pos.lon = latest_fix.lon;
     trough_pos.alt = latest_fix.alt;
     trough_pos.accuracy = latest_fix.accuracy;
+    trough_pos.fenced = false;
     trough_pos.valid = true;
 
     current_status = GNSS_STATUS_NORMAL;
@@ -395,48 +483,58 @@ static void button1_isr(const struct device *dev,
 
 /* ====================== 对 LTE 任务发 message ====================== */
 
-/* 把当前内部状态 + 标志，组织成一条 message 丢给 LTE 任务
+/* 把当前内部状态 + 标志，组织成一条 message 发布到信箱和历史
  * 注意：latest_fix 可能是“最后一次成功 fix”的值，在 fix_valid==false 时不会更新。
  */
 static void send_gnss_message(bool is_water_gnss)
 {
     struct gnss_status_msg msg = { 0 };
 
+    msg.ts  = latest_fix.ts;
     msg.lat = latest_fix.lat;
     msg.lon = latest_fix.lon;
     msg.alt = latest_fix.alt;
+    msg.accuracy_m = latest_fix.accuracy;
 
     msg.speed_mps   = latest_fix.speed_mps;
     msg.heading_deg = latest_fix.heading_deg;
 
-    msg.total_water_s = (double)water_stats.total_duration_ms / 1000.0;
+    msg.total_water_s = (double)water_log_today_s();
 
     msg.is_water_gnss = is_water_gnss;
     msg.status        = current_status;
 
-    /* 关键修改：
-     * 队列如果满了，先清空旧数据，再放入当前这条最新状态，
-     * 确保 GNSS 一旦拿到 valid fix，最新的经纬度不会被旧的 0,0 挡在外面。
-     */
-    int err = k_msgq_put(&gnss_msgq, &msg, K_NO_WAIT);
-    if (err != 0) {
-        /* 队列满：清空所有旧消息，只保留最新这一条 */
-        k_msgq_purge(&gnss_msgq);
-        (void)k_msgq_put(&gnss_msgq, &msg, K_NO_WAIT);
-    }
+    /* 信箱：seq 奇数期间的写不会被本核的其他线程看到一半 */
+    k_sched_lock();
+    atomic_inc(&latest_seq);
+    latest_msg = msg;
+    atomic_inc(&latest_seq);
+    k_sched_unlock();
+
+    /* 历史：满了覆盖最旧的，读得慢的游标自己往前跳 */
+    k_spinlock_key_t key = k_spin_lock(&history_lock);
+    history[history_head % GNSS_HISTORY_LEN] = msg;
+    history_head++;
+    k_spin_unlock(&history_lock, key);
 }
 
 /* ====================== PVT 处理（由 GNSS 线程调用） ====================== */
 
-static void handle_pvt(const struct nrf_modem_gnss_pvt_data_frame *pvt)
+static void handle_pvt(const struct nrf_modem_gnss_pvt_data_frame *pvt,
+                       tb_ts_t ts)
 {
     bool fix_valid = (pvt->flags & NRF_MODEM_GNSS_PVT_FLAG_FIX_VALID);
     bool is_water_gnss = false;
+    float fence_dist = GEOFENCE_BOUNDARY_MAX_M;
 
     if (!fix_valid) {
         /* 没有 fix 的情况 */
 
-        if (current_status == GNSS_STATUS_NORMAL && trough_pos.valid) {
+        /* 周期 / 单次定位每次醒来都要先搜一阵星，这时的 no-fix 不算丢星
+         * （搜不到由 fix_retry 限时）
+         */
+        if (current_status == GNSS_STATUS_NORMAL && trough_pos.valid &&
+            power_applied == GNSS_POWER_CONTINUOUS) {
             no_fix_count++;
 
             /* 正常 -> 丢星：达到阈值 */
@@ -477,6 +575,7 @@ static void handle_pvt(const struct nrf_modem_gnss_pvt_data_frame *pvt)
         }
 
         /* 更新 latest_fix（UTC 时间） */
+        latest_fix.ts       = ts;
         latest_fix.lat      = pvt->latitude;
         latest_fix.lon      = pvt->longitude;
         latest_fix.alt      = pvt->altitude;
@@ -495,6 +594,18 @@ static void handle_pvt(const struct nrf_modem_gnss_pvt_data_frame *pvt)
         latest_fix.speed_mps   = pvt->speed;   /* 单位：m/s */
         latest_fix.heading_deg = pvt->heading; /* 单位：度 */
 
+        /* 用 PVT 的 UTC 时间校准统一时间基准 */
+        timebase_gnss_sync(ts, timebase_civil_to_utc_ms(pvt->datetime.year,
+                                                        pvt->datetime.month,
+                                                        pvt->datetime.day,
+                                                        pvt->datetime.hour,
+                                                        pvt->datetime.minute,
+                                                        pvt->datetime.seconds,
+                                                        pvt->datetime.ms));
+
+        /* 完整轨迹：在线化简后攒着，定时上报 */
+        track_log_feed(ts, latest_fix.lat, latest_fix.lon);
+
         /* 第一次拿到 fix（从 SEARCHING 进来） -> 黄灯 + 等待用户设水槽 */
         if (current_status == GNSS_STATUS_SEARCHING) {
             current_status = GNSS_STATUS_WAIT_TROUGH_MARK;
@@ -503,16 +614,33 @@ static void handle_pvt(const struct nrf_modem_gnss_pvt_data_frame *pvt)
             LOG_INF("Got first valid GNSS fix, waiting for trough mark (Button1)");
         }
 
-        /* 喝水逻辑（只在 NORMAL 且已设水槽时） */
-        if (current_status == GNSS_STATUS_NORMAL && trough_pos.valid) {
-            int64_t visit_duration_ms = 0;
-            bool new_visit = water_zone_update(&latest_fix, &visit_duration_ms);
+        k_mutex_lock(&fence_lock, K_FOREVER);
 
-            if (new_visit) {
-                handle_water_visit(&water_state.enter_fix, visit_duration_ms);
+        /* 按键标记的水槽登记为 0 号区域（重新标记时替换） */
+        if (trough_pos.valid && !trough_pos.fenced) {
+            int err = geofence_add_circle(&fences, TROUGH_ZONE_ID, GEOFENCE_KIND_TROUGH,
+                                          trough_pos.lat, trough_pos.lon,
+                                          TROUGH_RADIUS_M, WATER_MIN_DURATION_MS);
+
+            if (err) {
+                LOG_ERR("Failed to add trough geofence, err %d", err);
             }
+            trough_pos.fenced = true;
         }
 
+        /* 电子围栏：只测附近格子里的区域，进出事件走 on_geofence_event */
+        int tested = geofence_update(&fences, (uint32_t)timebase_delta_ms(0, ts),
+                                     latest_fix.lat, latest_fix.lon,
+                                     on_geofence_event, NULL);
+
+        /* 离围栏边界多远（省电策略：快到边界就回到 1 Hz） */
+        fence_dist = geofence_boundary_dist(&fences, latest_fix.lat, latest_fix.lon,
+                                            GNSS_POWER_APPROACH_M);
+
+        k_mutex_unlock(&fence_lock);
+
+        LOG_DBG("Geofence: %d of %u zones tested", tested, fences.n_zones);
+
         /* 是否是“水槽位置 GNSS”这一帧 */
         if (trough_msg_pending) {
             is_water_gnss = true;
@@ -526,6 +654,59 @@ static void handle_pvt(const struct nrf_modem_gnss_pvt_data_frame *pvt)
      *   上层看到 status = SEARCHING / SIGNAL_LOST 等，就知道此时坐标不一定可信。
      */
     send_gnss_message(is_water_gnss);
+
+    gnss_power_on_pvt(&power, k_uptime_get_32(), fix_valid,
+                      fix_valid ? pvt->speed : 0.0f, fence_dist);
+}
+
+/* ====================== 省电策略（由 GNSS 线程每秒调用） ====================== */
+
+static void gnss_power_update(void)
+{
+    static tb_ts_t last_act_ts;
+    uint32_t now = k_uptime_get_32();
+    struct imu_activity act;
+    struct gnss_power_hour h;
+
+    sensor_get_activity(&act);
+    if (act.ts != 0 && act.ts != last_act_ts) {
+        last_act_ts = act.ts;
+        gnss_power_on_imu(&power, now, act.gyro_rms_dps);
+    }
+
+    /* 还没标水槽 / 丢星 / 疝痛报警高频上报期间一直连续定位 */
+    gnss_power_set_hold(&power,
+                        current_status != GNSS_STATUS_NORMAL || colic_monitor_boost_active(),
+                        now);
+
+    enum gnss_power_mode mode = gnss_power_poll(&power, now);
+
+    k_mutex_lock(&gnss_ctl_lock, K_FOREVER);
+    if (gnss_enabled && (mode != power_applied || !gnss_running)) {
+        /* 切换工作方式；上次启动失败的也在这里重试 */
+        LOG_INF("GNSS power: %s -> %s", gnss_power_mode_str(power_applied),
+                gnss_power_mode_str(mode));
+        if (gnss_apply_mode(mode) == 0 && mode == GNSS_POWER_SINGLE) {
+            single_next_ms = k_uptime_get() + CONFIG_HORSE_GNSS_SINGLE_SEC * 1000LL;
+        }
+    } else if (gnss_running && power_applied == GNSS_POWER_SINGLE &&
+               k_uptime_get() >= single_next_ms) {
+        /* 单次定位：定到（或 fix_retry 超时）之后 modem 自己停，到点再启动一次 */
+        (void)nrf_modem_gnss_stop();
+        if (nrf_modem_gnss_start() != 0) {
+            LOG_ERR("Failed to start single-shot fix");
+        }
+        single_next_ms += CONFIG_HORSE_GNSS_SINGLE_SEC * 1000LL;
+    }
+    k_mutex_unlock(&gnss_ctl_lock);
+
+    if (gnss_power_take_hour(&power, &h)) {
+        LOG_INF("GNSS last hour: %u fixes, on ~%u s (%u%%), %u mode switches, "
+                "continuous/periodic/single %u/%u/%u s",
+                h.fixes, h.on_s, h.on_s / 36U, h.switches,
+                h.mode_s[GNSS_POWER_CONTINUOUS], h.mode_s[GNSS_POWER_PERIODIC],
+                h.mode_s[GNSS_POWER_SINGLE]);
+    }
 }
 
 /* ====================== GNSS 事件回调（中断上下文） ====================== */
@@ -533,14 +714,61 @@ static void handle_pvt(const struct nrf_modem_gnss_pvt_data_frame *pvt)
 static void gnss_event_handler(int event)
 {
     if (event == NRF_MODEM_GNSS_EVT_PVT) {
-        if (nrf_modem_gnss_read(&last_pvt, sizeof(last_pvt),
-                                NRF_MODEM_GNSS_DATA_PVT) == 0) {
-            k_sem_give(&pvt_data_sem);
+        tb_ts_t ts = timebase_now();
+        uint32_t head = (uint32_t)atomic_get(&pvt_head);
+        uint32_t tail = (uint32_t)atomic_get(&pvt_tail);
+
+        atomic_inc(&pvt_frames);
+
+        if (head - tail >= PVT_RING_LEN) {
+            /* 满了：这一帧不读，留在 modem 里被下一帧覆盖 */
+            atomic_inc(&pvt_overruns);
+            return;
         }
+
+        struct pvt_slot *slot = &pvt_ring[head & (PVT_RING_LEN - 1)];
+
+        if (nrf_modem_gnss_read(&slot->pvt, sizeof(slot->pvt),
+                                NRF_MODEM_GNSS_DATA_PVT) != 0) {
+            atomic_inc(&pvt_read_errors);
+            return;
+        }
+        slot->ts = ts;
+
+        /* 槽写完再发布 */
+        atomic_set(&pvt_head, (atomic_val_t)(head + 1));
+        k_sem_give(&pvt_data_sem);
     }
     /* 如果以后需要 NMEA，可以在这里加 NRF_MODEM_GNSS_EVT_NMEA 处理 */
 }
 
+/* GNSS 线程：按到达顺序处理缓冲里所有的帧 */
+static void pvt_ring_drain(void)
+{
+    static atomic_val_t overruns_seen;
+    uint32_t tail = (uint32_t)atomic_get(&pvt_tail);
+    uint32_t head = (uint32_t)atomic_get(&pvt_head);
+
+    pvt_max_depth = MAX(pvt_max_depth, head - tail);
+
+    while (tail != head) {
+        const struct pvt_slot *slot = &pvt_ring[tail & (PVT_RING_LEN - 1)];
+
+        handle_pvt(&slot->pvt, slot->ts);
+
+        /* 处理完才把槽还给回调 */
+        atomic_set(&pvt_tail, (atomic_val_t)++tail);
+        head = (uint32_t)atomic_get(&pvt_head);
+    }
+
+    atomic_val_t ovr = atomic_get(&pvt_overruns);
+
+    if (ovr != overruns_seen) {
+        LOG_WRN("PVT ring overrun: %ld frame(s) dropped so far", (long)ovr);
+        overruns_seen = ovr;
+    }
+}
+
 /* ====================== GNSS 初始化 ====================== */
 
 /*
@@ -559,6 +787,8 @@ static int gnss_init_and_start(void)
         return err;
     }
 
+    geofence_init(&fences);
+
     LOG_INF("GNSS init done (event handler set). Waiting for LTE to start GNSS.");
     return 0;
 }
@@ -629,10 +859,24 @@ static void gnss_thread(void *p1, void *p2, void *p3)
 
     LOG_INF("GNSS task thread started");
 
+    struct gnss_power_cfg cfg = {
+        .periodic_after_s = GNSS_POWER_PERIODIC_AFTER_S,
+        .single_after_s = GNSS_POWER_SINGLE_AFTER_S,
+        .imu_stale_s = GNSS_POWER_IMU_STALE_S,
+        .move_dps = GNSS_POWER_MOVE_DPS,
+        .move_mps = GNSS_POWER_MOVE_MPS,
+        .approach_m = GNSS_POWER_APPROACH_M,
+        .approach_step_m = GNSS_POWER_APPROACH_STEP_M,
+    };
+
+    gnss_power_init(&power, &cfg, k_uptime_get_32());
+
     while (1) {
-        /* 等待新的 PVT 数据 */
-        k_sem_take(&pvt_data_sem, K_FOREVER);
-        handle_pvt(&last_pvt);
+        /* 等待新的 PVT 数据；周期 / 单次定位时 PVT 很稀，至少每秒醒一次跑省电策略 */
+        if (k_sem_take(&pvt_data_sem, K_SECONDS(1)) == 0) {
+            pvt_ring_drain();
+        }
+        gnss_power_update();
     }
 }
 
@@ -664,3 +908,84 @@ int gnss_system_init(void)
     LOG_INF("GNSS system initialized (handler set, waiting for LTE to start GNSS)");
     return 0;
 }
+
+int gnss_geofence_add_polygon(uint16_t id, enum geofence_kind kind,
+                              const struct geofence_vertex *v, size_t n)
+{
+    if (id == TROUGH_ZONE_ID) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&fence_lock, K_FOREVER);
+    int err = geofence_add_polygon(&fences, id, kind, v, n, 0);
+    k_mutex_unlock(&fence_lock);
+
+    return err;
+}
+
+int gnss_geofence_remove(uint16_t id)
+{
+    if (id == TROUGH_ZONE_ID) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&fence_lock, K_FOREVER);
+    int err = geofence_remove(&fences, id);
+    k_mutex_unlock(&fence_lock);
+
+    return err;
+}
+
+bool gnss_get_latest(struct gnss_status_msg *out)
+{
+    atomic_val_t s0, s1;
+
+    do {
+        s0 = atomic_get(&latest_seq);
+        *out = latest_msg;
+        /* 拷贝的读不能挪到第二次读 seq 之后 */
+        barrier_dmem_fence_full();
+        s1 = atomic_get(&latest_seq);
+    } while ((s0 & 1) || s0 != s1);
+
+    return out->ts != 0;
+}
+
+int gnss_history_read(uint32_t *cursor, struct gnss_status_msg *out)
+{
+    int lost = 0;
+
+    k_spinlock_key_t key = k_spin_lock(&history_lock);
+
+    if (history_head - *cursor > GNSS_HISTORY_LEN) {
+        /* 被覆盖了：跳到还在的最旧一条 */
+        lost = (int)(history_head - *cursor - GNSS_HISTORY_LEN);
+        *cursor = history_head - GNSS_HISTORY_LEN;
+    }
+    if (*cursor == history_head) {
+        k_spin_unlock(&history_lock, key);
+        return -EAGAIN;
+    }
+    *out = history[*cursor % GNSS_HISTORY_LEN];
+    (*cursor)++;
+
+    k_spin_unlock(&history_lock, key);
+    return lost;
+}
+
+uint32_t gnss_history_head(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&history_lock);
+    uint32_t head = history_head;
+
+    k_spin_unlock(&history_lock, key);
+    return head;
+}
+
+void gnss_get_pvt_stats(struct gnss_pvt_stats *out)
+{
+    out->frames = (uint32_t)atomic_get(&pvt_frames);
+    out->overruns = (uint32_t)atomic_get(&pvt_overruns);
+    out->read_errors = (uint32_t)atomic_get(&pvt_read_errors);
+    out->max_depth = pvt_max_depth;
+}
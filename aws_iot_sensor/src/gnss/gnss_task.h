@@ -5,6 +5,9 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "timebase.h"
+#include "geofence.h"
+
 /* 对外暴露的 GNSS 状态，用于 LTE 任务判断情况 */
 enum gnss_status {
     GNSS_STATUS_SEARCHING = 0,   /* 还在搜星 */
@@ -15,16 +18,20 @@ enum gnss_status {
 
 /* 给 LTE 任务发的消息结构体 */
 struct gnss_status_msg {
+    /* PVT 到达时的时间戳（和 IMU / BME 样本同一时间基准） */
+    tb_ts_t ts;
+
     /* 位置 */
     double lat;
     double lon;
     double alt;
+    float  accuracy_m;    /* 水平精度 (m) */
 
     /* 运动信息 */
     float  speed_mps;     /* 水平速度 (m/s) */
     float  heading_deg;   /* 航向角 (deg) */
 
-    /* 喝水累计时间（秒） */
+    /* 今天（UTC 日）的喝水时间（秒），重启后从 flash 里的喝水记录恢复 */
     double total_water_s;
 
     /* 标志：这一帧是否专门表示“水槽位置” */
@@ -34,8 +41,13 @@ struct gnss_status_msg {
     enum gnss_status status;
 };
 
-/* GNSS 任务对外导出的消息队列（LTE 任务从这里收消息） */
-extern struct k_msgq gnss_msgq;
+/* modem 事件回调 → GNSS 线程的 PVT 环形缓冲统计 */
+struct gnss_pvt_stats {
+    uint32_t frames;        /* 收到的 PVT 事件 */
+    uint32_t overruns;      /* 缓冲满丢掉的帧 */
+    uint32_t read_errors;   /* 从 modem 读帧失败 */
+    uint32_t max_depth;     /* GNSS 线程醒来时看到的最大积压帧数 */
+};
 
 /* 初始化 GNSS 子系统（硬件 + GNSS 参数），不真正 start GNSS。
  * 真正 start 放在 gnss_start_after_lte_ready() 里做。
@@ -45,4 +57,28 @@ int gnss_system_init(void);
 /* 在 LTE L4_CONNECTED 之后调用，真正启用 GNSS 功能模式并 start GNSS */
 void gnss_start_after_lte_ready(void);
 
+/* 取最近一条 GNSS 消息（seqlock 信箱，O(1)，线程里调，不要在中断里调）；
+ * 还没有过 fix 时返回 false
+ */
+bool gnss_get_latest(struct gnss_status_msg *out);
+
+/*
+ * 按顺序读消息历史（每个 PVT 一条，包括没 fix 的）。每个消费者自己保存一个游标，
+ * 从 gnss_history_head() 开始读就是只要以后的。
+ * 读到一条返回 0；游标太旧、中间被覆盖了返回丢掉的条数（> 0，out 里是还在的最旧一条）；
+ * 没有新消息返回 -EAGAIN。
+ */
+int gnss_history_read(uint32_t *cursor, struct gnss_status_msg *out);
+uint32_t gnss_history_head(void);
+
+/* 统计计数，任何线程都可以读 */
+void gnss_get_pvt_stats(struct gnss_pvt_stats *out);
+
+/* 往 GNSS 任务的电子围栏里增删多边形区域（围场等），线程安全；
+ * 0 号是按键标记的水槽，不能用。返回值同 geofence_add_polygon / geofence_remove。
+ */
+int gnss_geofence_add_polygon(uint16_t id, enum geofence_kind kind,
+                              const struct geofence_vertex *v, size_t n);
+int gnss_geofence_remove(uint16_t id);
+
 #endif /* GNSS_TASK_H_ */
@@ -3,7 +3,7 @@
  * Example "LTE task":
  * - initializes the modem,
  * - starts the GNSS task system,
- * - then receives gnss_status_msg from gnss_msgq and logs them.
+ * - then reads every gnss_status_msg from the GNSS history ring and logs them.
  *
  * 在真实项目里，你可以把这个 while(1) 换成：
  *   - 解析 msg，
@@ -39,14 +39,20 @@ int main(void)
 
     LOG_INF("Main(LTE): GNSS task initialized, now receiving GNSS messages");
 
+    uint32_t cursor = gnss_history_head();
+
     while (1) {
         struct gnss_status_msg msg;
 
-        /* 阻塞等待 GNSS task 的消息 */
-        err = k_msgq_get(&gnss_msgq, &msg, K_FOREVER);
-        if (err) {
+        /* 按顺序读 GNSS task 的消息历史，没有新的就等一会儿 */
+        err = gnss_history_read(&cursor, &msg);
+        if (err == -EAGAIN) {
+            k_sleep(K_MSEC(200));
             continue;
         }
+        if (err > 0) {
+            LOG_WRN("GNSS history: %d message(s) overwritten", err);
+        }
 
         const char *status_str = "UNKNOWN";
 
@@ -0,0 +1,878 @@
+/* gnss_sim.c
+ *
+ * native_sim 上的 nrf_modem_gnss / lte_lc 替身，回放 PVT 日志或 NMEA，见 gnss_sim.h。
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(gnss_sim, LOG_LEVEL_INF);
+
+#include <errno.h>
+#include <string.h>
+
+#include <nrf_modem_gnss.h>
+#include <modem/lte_lc.h>
+
+#include "gnss_sim.h"
+
+/* ====================== 参数可调 ====================== */
+
+/* 最多几段模拟遮挡 */
+#define SIM_MAX_OUTAGES         8
+
+/* 一行最多几个字段（NMEA GGA 有 15 个） */
+#define SIM_MAX_FIELDS          20
+
+/* NMEA 没有 GGA（没有 HDOP）时给的精度 (m) */
+#define SIM_DEFAULT_ACC_M       5.0f
+
+/* HDOP -> 水平精度 (m) */
+#define SIM_HDOP_TO_M           5.0f
+
+#define KNOT_TO_MPS             0.514444f
+
+/* ====================== 轨迹解析 ====================== */
+
+/* 一秒的记录 */
+struct sim_rec {
+    int64_t utc_ms;
+    double  lat;
+    double  lon;
+    float   alt;
+    float   acc;
+    float   speed;
+    float   heading;
+    bool    fix;
+};
+
+struct field {
+    const char *p;
+    size_t len;
+};
+
+struct sim_parser {
+    enum gnss_sim_format fmt;
+    const char *text;
+    const char *end;
+    const char *pos;
+    uint32_t bad_lines;
+
+    int64_t pvt_base_ms;     /* PVT 日志：start 行给的 UTC */
+    int32_t nmea_days;       /* NMEA：上一条记录的日期（1970 起的天数） */
+    uint32_t nmea_tod_ms;    /* NMEA：上一条记录的时刻 */
+};
+
+/* 1970-01-01 起的天数（Howard Hinnant 的 days_from_civil） */
+static int32_t days_from_civil(int32_t y, uint32_t m, uint32_t d)
+{
+    y -= m <= 2;
+    int32_t era = (y >= 0 ? y : y - 399) / 400;
+    uint32_t yoe = (uint32_t)(y - era * 400);
+    uint32_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return era * 146097 + (int32_t)doe - 719468;
+}
+
+static void civil_from_days(int32_t z, uint16_t *y, uint8_t *m, uint8_t *d)
+{
+    z += 719468;
+    int32_t era = (z >= 0 ? z : z - 146096) / 146097;
+    uint32_t doe = (uint32_t)(z - era * 146097);
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp = (5 * doy + 2) / 153;
+
+    *d = (uint8_t)(doy - (153 * mp + 2) / 5 + 1);
+    *m = (uint8_t)(mp < 10 ? mp + 3 : mp - 9);
+    *y = (uint16_t)((int32_t)yoe + era * 400 + (*m <= 2));
+}
+
+/* 取下一行（不含换行符），没有了返回 false */
+static bool line_next(struct sim_parser *ps, struct field *line)
+{
+    if (ps->pos >= ps->end) {
+        return false;
+    }
+
+    const char *p = ps->pos;
+    const char *e = p;
+
+    while (e < ps->end && *e != '\n') {
+        e++;
+    }
+    ps->pos = (e < ps->end) ? e + 1 : e;
+
+    line->p = p;
+    line->len = (size_t)(e - p);
+    if (line->len > 0 && p[line->len - 1] == '\r') {
+        line->len--;
+    }
+    return true;
+}
+
+/* 按分隔符切字段；sep 为 0 时按空白切并跳过连续空白 */
+static int split(struct field line, char sep, struct field *f, int max)
+{
+    const char *p = line.p;
+    const char *end = line.p + line.len;
+    int n = 0;
+
+    if (sep == 0) {
+        while (p < end && n < max) {
+            while (p < end && (*p == ' ' || *p == '\t')) {
+                p++;
+            }
+            if (p == end) {
+                break;
+            }
+            f[n].p = p;
+            while (p < end && *p != ' ' && *p != '\t') {
+                p++;
+            }
+            f[n].len = (size_t)(p - f[n].p);
+            n++;
+        }
+        return n;
+    }
+
+    f[n].p = p;
+    while (p < end) {
+        if (*p == sep) {
+            f[n].len = (size_t)(p - f[n].p);
+            if (++n == max) {
+                return n;
+            }
+            f[n].p = p + 1;
+        }
+        p++;
+    }
+    f[n].len = (size_t)(p - f[n].p);
+    return n + 1;
+}
+
+static bool field_is(struct field f, const char *s)
+{
+    return f.len == strlen(s) && memcmp(f.p, s, f.len) == 0;
+}
+
+/* 十进制小数（不要求 libc 的 strtod），整个字段都得是数字 */
+static bool field_num(struct field f, double *out)
+{
+    const char *p = f.p;
+    const char *end = f.p + f.len;
+    bool neg = false;
+    bool digits = false;
+    double v = 0.0;
+
+    if (p < end && (*p == '-' || *p == '+')) {
+        neg = (*p == '-');
+        p++;
+    }
+    while (p < end && *p >= '0' && *p <= '9') {
+        v = v * 10.0 + (*p++ - '0');
+        digits = true;
+    }
+    if (p < end && *p == '.') {
+        double scale = 0.1;
+
+        p++;
+        while (p < end && *p >= '0' && *p <= '9') {
+            v += (*p++ - '0') * scale;
+            scale *= 0.1;
+            digits = true;
+        }
+    }
+    if (!digits || p != end) {
+        return false;
+    }
+    *out = neg ? -v : v;
+    return true;
+}
+
+/* 定长数字，比如 "2025" / "06" */
+static bool digits_at(const char *p, int n, uint32_t *out)
+{
+    uint32_t v = 0;
+
+    for (int k = 0; k < n; k++) {
+        if (p[k] < '0' || p[k] > '9') {
+            return false;
+        }
+        v = v * 10 + (uint32_t)(p[k] - '0');
+    }
+    *out = v;
+    return true;
+}
+
+/* PVT 日志的 "start YYYY-MM-DD HH:MM:SS" */
+static bool pvt_parse_start(const struct field *f, int n, int64_t *out_ms)
+{
+    uint32_t y, mo, d, h, mi, s;
+
+    if (n != 3 || f[1].len != 10 || f[2].len != 8 ||
+        !digits_at(f[1].p, 4, &y) || !digits_at(f[1].p + 5, 2, &mo) ||
+        !digits_at(f[1].p + 8, 2, &d) || !digits_at(f[2].p, 2, &h) ||
+        !digits_at(f[2].p + 3, 2, &mi) || !digits_at(f[2].p + 6, 2, &s)) {
+        return false;
+    }
+    *out_ms = ((int64_t)days_from_civil((int32_t)y, mo, d) * 86400 +
+               h * 3600 + mi * 60 + s) * 1000;
+    return true;
+}
+
+static bool pvt_next(struct sim_parser *ps, struct sim_rec *r)
+{
+    struct field line;
+    struct field f[SIM_MAX_FIELDS];
+
+    while (line_next(ps, &line)) {
+        int n = split(line, 0, f, SIM_MAX_FIELDS);
+        double v[7];
+
+        if (n == 0 || f[0].p[0] == '#') {
+            continue;
+        }
+        if (field_is(f[0], "start")) {
+            if (!pvt_parse_start(f, n, &ps->pvt_base_ms)) {
+                ps->bad_lines++;
+            }
+            continue;
+        }
+
+        memset(r, 0, sizeof(*r));
+        if (n == 2 && field_num(f[0], &v[0]) && field_is(f[1], "-")) {
+            r->utc_ms = ps->pvt_base_ms + (int64_t)v[0] * 1000;
+            return true;
+        }
+
+        bool ok = (n == 7);
+
+        for (int k = 0; ok && k < 7; k++) {
+            ok = field_num(f[k], &v[k]);
+        }
+        if (!ok) {
+            ps->bad_lines++;
+            continue;
+        }
+        r->utc_ms = ps->pvt_base_ms + (int64_t)v[0] * 1000;
+        r->lat = v[1];
+        r->lon = v[2];
+        r->alt = (float)v[3];
+        r->acc = (float)v[4];
+        r->speed = (float)v[5];
+        r->heading = (float)v[6];
+        r->fix = true;
+        return true;
+    }
+    return false;
+}
+
+/* ---------- NMEA ---------- */
+
+/* 一条语句里要用的东西 */
+struct nmea_sentence {
+    bool     rmc;            /* 否则是 GGA */
+    uint32_t tod_ms;
+    bool     fix;
+    bool     has_pos;
+    double   lat;
+    double   lon;
+    float    alt;
+    float    hdop;
+    float    speed;
+    float    heading;
+    bool     has_date;
+    int32_t  days;
+};
+
+static int hex_val(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+/* "$...*HH"：校验和对了返回 '$' 和 '*' 之间的部分 */
+static bool nmea_body(struct field line, struct field *body)
+{
+    if (line.len < 4 || line.p[0] != '$') {
+        return false;
+    }
+
+    const char *star = memchr(line.p, '*', line.len);
+
+    if (star == NULL || star + 3 > line.p + line.len) {
+        return false;
+    }
+
+    uint8_t sum = 0;
+
+    for (const char *p = line.p + 1; p < star; p++) {
+        sum ^= (uint8_t)*p;
+    }
+
+    int hi = hex_val(star[1]);
+    int lo = hex_val(star[2]);
+
+    if (hi < 0 || lo < 0 || sum != (uint8_t)(hi * 16 + lo)) {
+        return false;
+    }
+    body->p = line.p + 1;
+    body->len = (size_t)(star - body->p);
+    return true;
+}
+
+static bool nmea_time(struct field f, uint32_t *tod_ms)
+{
+    uint32_t h, m;
+    double v;
+
+    /* hhmmss.sss */
+    if (f.len < 6 || !digits_at(f.p, 2, &h) || !digits_at(f.p + 2, 2, &m) ||
+        !field_num(f, &v)) {
+        return false;
+    }
+
+    double s = v - (double)(h * 10000 + m * 100);
+
+    if (h >= 24 || m >= 60 || s >= 61.0) {
+        return false;
+    }
+    *tod_ms = (h * 3600 + m * 60) * 1000 + (uint32_t)(s * 1000.0 + 0.5);
+    return true;
+}
+
+/* ddmm.mmmm,N / dddmm.mmmm,E */
+static bool nmea_coord(struct field v, struct field hemi, double *out)
+{
+    double x;
+
+    if (!field_num(v, &x) || hemi.len != 1) {
+        return false;
+    }
+
+    double deg = (double)(int32_t)(x / 100.0);
+
+    x = deg + (x - deg * 100.0) / 60.0;
+    if (hemi.p[0] == 'S' || hemi.p[0] == 'W') {
+        x = -x;
+    } else if (hemi.p[0] != 'N' && hemi.p[0] != 'E') {
+        return false;
+    }
+    *out = x;
+    return true;
+}
+
+static bool nmea_parse(struct field body, struct nmea_sentence *s)
+{
+    struct field f[SIM_MAX_FIELDS];
+    int n = split(body, ',', f, SIM_MAX_FIELDS);
+    double v;
+
+    if (n < 1 || f[0].len != 5) {
+        return false;
+    }
+
+    memset(s, 0, sizeof(*s));
+
+    if (memcmp(f[0].p + 2, "RMC", 3) == 0) {
+        if (n < 10 || !nmea_time(f[1], &s->tod_ms)) {
+            return false;
+        }
+        s->rmc = true;
+        s->fix = field_is(f[2], "A");
+        s->has_pos = nmea_coord(f[3], f[4], &s->lat) && nmea_coord(f[5], f[6], &s->lon);
+        if (field_num(f[7], &v)) {
+            s->speed = (float)v * KNOT_TO_MPS;
+        }
+        if (field_num(f[8], &v)) {
+            s->heading = (float)v;
+        }
+
+        uint32_t d, m, y;
+
+        if (f[9].len == 6 && digits_at(f[9].p, 2, &d) && digits_at(f[9].p + 2, 2, &m) &&
+            digits_at(f[9].p + 4, 2, &y)) {
+            s->days = days_from_civil(2000 + (int32_t)y, m, d);
+            s->has_date = true;
+        }
+        return true;
+    }
+
+    if (memcmp(f[0].p + 2, "GGA", 3) == 0) {
+        if (n < 10 || !nmea_time(f[1], &s->tod_ms)) {
+            return false;
+        }
+        s->has_pos = nmea_coord(f[2], f[3], &s->lat) && nmea_coord(f[4], f[5], &s->lon);
+        s->fix = field_num(f[6], &v) && v > 0.0;
+        s->hdop = field_num(f[8], &v) ? (float)v : 0.0f;
+        s->alt = field_num(f[9], &v) ? (float)v : 0.0f;
+        return true;
+    }
+
+    return false;
+}
+
+static bool nmea_next(struct sim_parser *ps, struct sim_rec *r)
+{
+    struct field line, body;
+    struct nmea_sentence s;
+    bool started = false;
+    bool have_rmc = false, have_gga = false;
+    bool rmc_fix = false, gga_fix = false;
+    bool has_date = false;
+    int32_t days = 0;
+    uint32_t tod = 0;
+    float hdop = 0.0f;
+
+    memset(r, 0, sizeof(*r));
+
+    for (;;) {
+        const char *line_start = ps->pos;
+
+        if (!line_next(ps, &line)) {
+            break;
+        }
+        if (line.len == 0) {
+            continue;
+        }
+        if (!nmea_body(line, &body)) {
+            ps->bad_lines++;
+            continue;
+        }
+        if (!nmea_parse(body, &s)) {
+            /* 别的语句（GSV、GSA...）不要 */
+            continue;
+        }
+
+        if (started && s.tod_ms != tod) {
+            /* 下一秒的，留给下一条记录 */
+            ps->pos = line_start;
+            break;
+        }
+        started = true;
+        tod = s.tod_ms;
+
+        if (s.has_pos) {
+            r->lat = s.lat;
+            r->lon = s.lon;
+        }
+        if (s.rmc) {
+            have_rmc = true;
+            rmc_fix = s.fix && s.has_pos;
+            r->speed = s.speed;
+            r->heading = s.heading;
+            if (s.has_date) {
+                has_date = true;
+                days = s.days;
+            }
+        } else {
+            have_gga = true;
+            gga_fix = s.fix && s.has_pos;
+            r->alt = s.alt;
+            hdop = s.hdop;
+        }
+    }
+
+    if (!started) {
+        return false;
+    }
+
+    /* 没有日期（只有 GGA）：沿用上一条的，过了午夜加一天 */
+    if (!has_date) {
+        days = ps->nmea_days;
+        if (tod < ps->nmea_tod_ms) {
+            days++;
+        }
+    }
+    ps->nmea_days = days;
+    ps->nmea_tod_ms = tod;
+
+    r->utc_ms = (int64_t)days * 86400000LL + tod;
+    r->fix = (!have_rmc || rmc_fix) && (!have_gga || gga_fix);
+    r->acc = have_gga && hdop > 0.0f ? hdop * SIM_HDOP_TO_M : SIM_DEFAULT_ACC_M;
+    return true;
+}
+
+static bool rec_next(struct sim_parser *ps, struct sim_rec *r)
+{
+    return (ps->fmt == GNSS_SIM_NMEA) ? nmea_next(ps, r) : pvt_next(ps, r);
+}
+
+static void parser_reset(struct sim_parser *ps, enum gnss_sim_format fmt,
+                         const char *text, size_t len)
+{
+    memset(ps, 0, sizeof(*ps));
+    ps->fmt = fmt;
+    ps->text = text;
+    ps->end = text + len;
+    ps->pos = text;
+    ps->pvt_base_ms = (int64_t)days_from_civil(2000, 1, 1) * 86400000LL;
+    ps->nmea_days = days_from_civil(2000, 1, 1);
+}
+
+/* ====================== 回放状态 ====================== */
+
+struct sim_outage {
+    uint32_t from_s;
+    uint32_t len_s;
+};
+
+static struct {
+    struct sim_parser parser;
+    struct sim_rec cur;          /* 下一条还没放过的记录 */
+    bool     have_cur;
+    int64_t  utc0_ms;            /* 第一条记录的 UTC = 轨迹第 0 秒 */
+    bool     loaded;
+
+    struct sim_outage outages[SIM_MAX_OUTAGES];
+    int      n_outages;
+
+    float    speed;              /* gnss_sim_set_speed 设的，下一次装入生效 */
+    float    play_speed;         /* 当前轨迹装入时锁定的回放速度 */
+    bool     clock_started;
+    uint32_t sec;                /* 下一次 tick 放轨迹的第几秒 */
+    uint16_t burst;
+
+    /* modem 状态 */
+    nrf_modem_gnss_event_handler_type_t handler;
+    bool     gnss_mode;          /* 功能模式里打开了 GNSS */
+    bool     running;
+    uint16_t interval;
+    uint16_t retry;
+    uint32_t wake_sec;           /* 周期 / 单次：这一轮从第几秒开始搜 */
+
+    struct nrf_modem_gnss_pvt_data_frame frame;   /* nrf_modem_gnss_read 读到的 */
+
+    struct gnss_sim_stats stats;
+} sim = {
+    .speed = 1.0f,
+    .play_speed = 1.0f,
+    .interval = 1,
+};
+
+static struct k_spinlock sim_lock;
+static K_SEM_DEFINE(sim_done_sem, 0, 1);
+
+static void sim_tick(struct k_timer *timer);
+static K_TIMER_DEFINE(sim_timer, sim_tick, NULL);
+
+static void sim_clock_start(void)
+{
+    uint32_t period_us = (uint32_t)(1000000.0f / sim.play_speed);
+
+    sim.clock_started = true;
+    k_timer_start(&sim_timer, K_USEC(period_us), K_USEC(period_us));
+}
+
+static bool in_outage(uint32_t sec)
+{
+    for (int k = 0; k < sim.n_outages; k++) {
+        if (sec - sim.outages[k].from_s < sim.outages[k].len_s) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* 轨迹第 sec 秒的 PVT 帧；缺的秒、遮挡时是没有 fix 的空帧 */
+static void frame_fill(uint32_t sec)
+{
+    struct nrf_modem_gnss_pvt_data_frame *f = &sim.frame;
+
+    memset(f, 0, sizeof(*f));
+
+    if (!sim.have_cur || (sim.cur.utc_ms - sim.utc0_ms) / 1000 != sec ||
+        !sim.cur.fix || in_outage(sec)) {
+        return;
+    }
+
+    const struct sim_rec *r = &sim.cur;
+    int64_t ms = r->utc_ms;
+    int32_t days = (int32_t)(ms / 86400000LL);
+    uint32_t tod = (uint32_t)(ms - (int64_t)days * 86400000LL);
+
+    f->latitude = r->lat;
+    f->longitude = r->lon;
+    f->altitude = r->alt;
+    f->accuracy = r->acc;
+    f->speed = r->speed;
+    f->heading = r->heading;
+    f->hdop = r->acc / SIM_HDOP_TO_M;
+    f->flags = NRF_MODEM_GNSS_PVT_FLAG_FIX_VALID;
+
+    civil_from_days(days, &f->datetime.year, &f->datetime.month, &f->datetime.day);
+    f->datetime.hour = (uint8_t)(tod / 3600000U);
+    f->datetime.minute = (uint8_t)(tod / 60000U % 60U);
+    f->datetime.seconds = (uint8_t)(tod / 1000U % 60U);
+    f->datetime.ms = (uint16_t)(tod % 1000U);
+}
+
+/* 每个轨迹秒一次（中断上下文） */
+static void sim_tick(struct k_timer *timer)
+{
+    ARG_UNUSED(timer);
+
+    k_spinlock_key_t key = k_spin_lock(&sim_lock);
+    uint32_t sec = sim.sec++;
+    int n = 0;
+
+    while (sim.have_cur && (sim.cur.utc_ms - sim.utc0_ms) / 1000 < sec) {
+        sim.have_cur = rec_next(&sim.parser, &sim.cur);
+    }
+
+    if (!sim.have_cur) {
+        /* 放完了 */
+        k_timer_stop(&sim_timer);
+        sim.stats.done = true;
+        k_spin_unlock(&sim_lock, key);
+        k_sem_give(&sim_done_sem);
+        return;
+    }
+
+    sim.stats.sec = sec;
+
+    if (sim.running && sec >= sim.wake_sec) {
+        frame_fill(sec);
+
+        bool fix = sim.frame.flags & NRF_MODEM_GNSS_PVT_FLAG_FIX_VALID;
+
+        n = 1 + sim.burst;
+        sim.burst = 0;
+        sim.stats.frames += n;
+        sim.stats.fixes += fix ? n : 0;
+
+        /* 周期 / 单次：定到或者 fix_retry 超时这一轮就结束 */
+        if (sim.interval != 1 &&
+            (fix || (sim.retry != 0 && sec - sim.wake_sec + 1 >= sim.retry))) {
+            if (sim.interval == 0) {
+                sim.running = false;
+            } else {
+                sim.wake_sec = sec - (sec - sim.wake_sec) % sim.interval + sim.interval;
+            }
+        }
+    }
+
+    nrf_modem_gnss_event_handler_type_t handler = sim.handler;
+
+    k_spin_unlock(&sim_lock, key);
+
+    for (int k = 0; k < n && handler != NULL; k++) {
+        handler(NRF_MODEM_GNSS_EVT_PVT);
+    }
+}
+
+/* ====================== 测试用接口 ====================== */
+
+int gnss_sim_load(enum gnss_sim_format fmt, const char *text, size_t len)
+{
+    struct sim_parser scan;
+    struct sim_rec r;
+    uint32_t records = 0;
+    int64_t utc0 = 0;
+
+    /* 先整个过一遍：数记录、找第 0 秒 */
+    parser_reset(&scan, fmt, text, len);
+    while (rec_next(&scan, &r)) {
+        if (records++ == 0) {
+            utc0 = r.utc_ms;
+        }
+    }
+    if (records == 0) {
+        return -EINVAL;
+    }
+
+    k_timer_stop(&sim_timer);
+    k_sem_reset(&sim_done_sem);
+
+    k_spinlock_key_t key = k_spin_lock(&sim_lock);
+
+    parser_reset(&sim.parser, fmt, text, len);
+    sim.have_cur = rec_next(&sim.parser, &sim.cur);
+    sim.utc0_ms = utc0;
+    sim.play_speed = sim.speed;
+    sim.loaded = true;
+    sim.n_outages = 0;
+    sim.sec = 0;
+    sim.burst = 0;
+    sim.wake_sec = 0;
+    sim.clock_started = false;
+
+    memset(&sim.stats, 0, sizeof(sim.stats));
+    sim.stats.records = records;
+    sim.stats.bad_lines = scan.bad_lines;
+
+    if (sim.running) {
+        sim_clock_start();
+    }
+
+    k_spin_unlock(&sim_lock, key);
+
+    LOG_INF("Trace loaded: %u records, %u bad lines, %s", records, scan.bad_lines,
+            fmt == GNSS_SIM_NMEA ? "NMEA" : "PVT log");
+    return (int)records;
+}
+
+void gnss_sim_set_speed(float speed)
+{
+    k_spinlock_key_t key = k_spin_lock(&sim_lock);
+
+    sim.speed = (speed > 0.0f) ? speed : 1.0f;
+    k_spin_unlock(&sim_lock, key);
+}
+
+int gnss_sim_add_outage(uint32_t from_s, uint32_t len_s)
+{
+    int err = 0;
+    k_spinlock_key_t key = k_spin_lock(&sim_lock);
+
+    if (sim.n_outages >= SIM_MAX_OUTAGES) {
+        err = -ENOMEM;
+    } else {
+        sim.outages[sim.n_outages].from_s = from_s;
+        sim.outages[sim.n_outages].len_s = len_s;
+        sim.n_outages++;
+    }
+    k_spin_unlock(&sim_lock, key);
+    return err;
+}
+
+void gnss_sim_burst(uint16_t n)
+{
+    k_spinlock_key_t key = k_spin_lock(&sim_lock);
+
+    sim.burst = n;
+    k_spin_unlock(&sim_lock, key);
+}
+
+int gnss_sim_wait_done(k_timeout_t timeout)
+{
+    return k_sem_take(&sim_done_sem, timeout);
+}
+
+void gnss_sim_get_stats(struct gnss_sim_stats *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&sim_lock);
+
+    *out = sim.stats;
+    out->interval = sim.interval;
+    out->retry = sim.retry;
+    out->running = sim.running;
+    k_spin_unlock(&sim_lock, key);
+}
+
+/* ====================== nrf_modem_gnss / lte_lc 替身 ====================== */
+
+int32_t nrf_modem_gnss_event_handler_set(nrf_modem_gnss_event_handler_type_t handler)
+{
+    k_spinlock_key_t key = k_spin_lock(&sim_lock);
+
+    sim.handler = handler;
+    k_spin_unlock(&sim_lock, key);
+    return 0;
+}
+
+int32_t nrf_modem_gnss_fix_retry_set(uint16_t fix_retry)
+{
+    k_spinlock_key_t key = k_spin_lock(&sim_lock);
+    int32_t err = 0;
+
+    if (sim.running) {
+        err = -EPERM;
+    } else {
+        sim.retry = fix_retry;
+    }
+    k_spin_unlock(&sim_lock, key);
+    return err;
+}
+
+int32_t nrf_modem_gnss_fix_interval_set(uint16_t fix_interval)
+{
+    k_spinlock_key_t key = k_spin_lock(&sim_lock);
+    int32_t err = 0;
+
+    /* 同真 modem：0 / 1 / 10..65535，运行中不能改 */
+    if (fix_interval > 1 && fix_interval < 10) {
+        err = -EINVAL;
+    } else if (sim.running) {
+        err = -EPERM;
+    } else {
+        sim.interval = fix_interval;
+    }
+    k_spin_unlock(&sim_lock, key);
+    return err;
+}
+
+int32_t nrf_modem_gnss_start(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&sim_lock);
+    int32_t err = 0;
+
+    if (!sim.gnss_mode || sim.running) {
+        err = -EPERM;
+    } else {
+        sim.running = true;
+        sim.wake_sec = sim.sec;
+        sim.stats.starts++;
+        if (sim.loaded && !sim.clock_started && !sim.stats.done) {
+            sim_clock_start();
+        }
+    }
+    k_spin_unlock(&sim_lock, key);
+    return err;
+}
+
+int32_t nrf_modem_gnss_stop(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&sim_lock);
+    int32_t err = 0;
+
+    if (!sim.running) {
+        err = -EPERM;
+    } else {
+        sim.running = false;
+        sim.stats.stops++;
+    }
+    k_spin_unlock(&sim_lock, key);
+    return err;
+}
+
+int32_t nrf_modem_gnss_read(void *buf, int32_t buf_len, int type)
+{
+    if (type != NRF_MODEM_GNSS_DATA_PVT || buf_len < (int32_t)sizeof(sim.frame)) {
+        return -EINVAL;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&sim_lock);
+
+    memcpy(buf, &sim.frame, sizeof(sim.frame));
+    k_spin_unlock(&sim_lock, key);
+    return 0;
+}
+
+int lte_lc_func_mode_set(enum lte_lc_func_mode mode)
+{
+    k_spinlock_key_t key = k_spin_lock(&sim_lock);
+
+    switch (mode) {
+    case LTE_LC_FUNC_MODE_NORMAL:
+    case LTE_LC_FUNC_MODE_ACTIVATE_GNSS:
+        sim.gnss_mode = true;
+        break;
+    default:
+        /* 关掉 GNSS 功能模式，接收机也跟着停 */
+        sim.gnss_mode = false;
+        sim.running = false;
+        break;
+    }
+    k_spin_unlock(&sim_lock, key);
+    return 0;
+}
@@ -0,0 +1,77 @@
+#ifndef GNSS_SIM_H_
+#define GNSS_SIM_H_
+
+#include <zephyr/kernel.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * native_sim 上的 GNSS 替身：实现 gnss_task.c 用到的 nrf_modem_gnss_* 和
+ * lte_lc_func_mode_set（头文件在 sim/include，名字和 NCS 一致），
+ * 把记录下来的轨迹按秒回放成 PVT 事件，gnss_task.c 本身不用改。
+ *
+ * - 轨迹每条记录 1 s，回放时钟从第一次 nrf_modem_gnss_start() 开始走，
+ *   GNSS 停着时轨迹照样往后走（马不会等接收机）。
+ * - PVT 事件在 k_timer 回调里发，和真 modem 一样是中断上下文。
+ * - 模仿 modem 的工作方式：fix_interval 1 每秒一帧；周期定位每 interval 秒醒来，
+ *   定到或者 fix_retry 超时就睡；interval 0 单次定位，定到就自己停。
+ * - 没打开 GNSS 功能模式时 start 失败，运行中不能改 fix_interval（同真 modem）。
+ *
+ * 回放速度是“每个模拟秒走几秒轨迹”。native_sim 默认不和墙上时间同步，
+ * 1 倍速回放一小时轨迹也只要很短的真实时间；固件里按 uptime 算的时长
+ * （喝水、丢星、省电）只有 1 倍速才和轨迹对得上，加速只用来压测 PVT 通路。
+ *
+ * 轨迹从内存里的文本读，文件可以用 generate_inc_file_for_target 编进测试。两种格式：
+ *
+ * GNSS_SIM_PVT_LOG，一行一条，空白分隔，'#' 开头是注释：
+ *     start 2025-06-01 12:00:00             第一条记录的 UTC 时间（可选）
+ *     <t> <lat> <lon> <alt> <acc> <speed> <heading>
+ *     <t> -                                 这一秒没有 fix
+ *   t 是整数秒，递增；中间缺的秒按没有 fix 处理。
+ *
+ * GNSS_SIM_NMEA：$--RMC / $--GGA 语句（校验和不对的行跳过并计数），
+ *   同一个 UTC 秒的语句合成一条记录。RMC 状态 A 且 GGA 质量 > 0 算 fix，
+ *   精度按 HDOP x 5 m 估计。
+ */
+
+enum gnss_sim_format {
+    GNSS_SIM_PVT_LOG = 0,
+    GNSS_SIM_NMEA,
+};
+
+struct gnss_sim_stats {
+    uint32_t records;       /* 轨迹里的记录数 */
+    uint32_t bad_lines;     /* 解析不了 / 校验和不对的行 */
+    uint32_t sec;           /* 回放走到轨迹的第几秒 */
+    uint32_t frames;        /* 发出的 PVT 事件 */
+    uint32_t fixes;         /* 其中 fix 有效的 */
+    uint32_t starts;        /* 成功的 nrf_modem_gnss_start */
+    uint32_t stops;         /* 成功的 nrf_modem_gnss_stop */
+    uint16_t interval;      /* 当前 fix_interval */
+    uint16_t retry;         /* 当前 fix_retry */
+    bool     running;
+    bool     done;          /* 轨迹放完了 */
+};
+
+/*
+ * 装入一段轨迹（text 在回放期间要一直有效），清掉遮挡和统计，回放时钟归零。
+ * GNSS 正在运行的话马上开始放。返回记录数，没有一条能用的记录返回 -EINVAL。
+ */
+int gnss_sim_load(enum gnss_sim_format fmt, const char *text, size_t len);
+
+/* 回放速度（轨迹秒 / 模拟秒），默认 1；下一次装入轨迹时生效 */
+void gnss_sim_set_speed(float speed);
+
+/* 模拟遮挡（进棚、树林）：轨迹第 from_s 秒起 len_s 秒没有 fix，最多 8 段 */
+int gnss_sim_add_outage(uint32_t from_s, uint32_t len_s);
+
+/* 下一秒在同一个中断里连发 n 帧（压测 PVT 环形缓冲） */
+void gnss_sim_burst(uint16_t n);
+
+/* 等轨迹放完；超时返回 -EAGAIN */
+int gnss_sim_wait_done(k_timeout_t timeout);
+
+void gnss_sim_get_stats(struct gnss_sim_stats *out);
+
+#endif /* GNSS_SIM_H_ */
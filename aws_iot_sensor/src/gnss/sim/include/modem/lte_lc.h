@@ -0,0 +1,19 @@
+#ifndef LTE_LC_SIM_H_
+#define LTE_LC_SIM_H_
+
+/*
+ * native_sim 替身：只有 GNSS 任务用到的功能模式切换，实现在 gnss_sim.c。
+ * 数值和 NCS 的 lte_lc.h 一致。
+ */
+
+enum lte_lc_func_mode {
+    LTE_LC_FUNC_MODE_POWER_OFF       = 0,
+    LTE_LC_FUNC_MODE_NORMAL          = 1,
+    LTE_LC_FUNC_MODE_OFFLINE         = 4,
+    LTE_LC_FUNC_MODE_DEACTIVATE_GNSS = 30,
+    LTE_LC_FUNC_MODE_ACTIVATE_GNSS   = 31,
+};
+
+int lte_lc_func_mode_set(enum lte_lc_func_mode mode);
+
+#endif /* LTE_LC_SIM_H_ */
@@ -0,0 +1,11 @@
+#ifndef NRF_MODEM_LIB_SIM_H_
+#define NRF_MODEM_LIB_SIM_H_
+
+/* native_sim 替身：gnss_task.c 只包含这个头，不调里面的函数 */
+
+static inline int nrf_modem_lib_init(void)
+{
+    return 0;
+}
+
+#endif /* NRF_MODEM_LIB_SIM_H_ */
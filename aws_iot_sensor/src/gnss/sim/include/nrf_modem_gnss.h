@@ -0,0 +1,57 @@
+#ifndef NRF_MODEM_GNSS_SIM_H_
+#define NRF_MODEM_GNSS_SIM_H_
+
+#include <stdint.h>
+
+/*
+ * native_sim 替身：nrf_modem_gnss.h 里 GNSS 任务用到的那一部分，
+ * 名字、字段和数值和 nrfxlib 一致，实现在 gnss_sim.c（回放记录的 PVT / NMEA）。
+ */
+
+#define NRF_MODEM_GNSS_EVT_PVT              0x01
+
+#define NRF_MODEM_GNSS_DATA_PVT             0x01
+
+#define NRF_MODEM_GNSS_PVT_FLAG_FIX_VALID   0x01
+
+struct nrf_modem_gnss_datetime {
+    uint16_t year;
+    uint8_t  month;
+    uint8_t  day;
+    uint8_t  hour;
+    uint8_t  minute;
+    uint8_t  seconds;
+    uint16_t ms;
+};
+
+struct nrf_modem_gnss_pvt_data_frame {
+    double   latitude;
+    double   longitude;
+    float    altitude;
+    float    accuracy;
+    float    altitude_accuracy;
+    float    speed;
+    float    speed_accuracy;
+    float    vertical_speed;
+    float    vertical_speed_accuracy;
+    float    heading;
+    float    heading_accuracy;
+    struct nrf_modem_gnss_datetime datetime;
+    float    pdop;
+    float    hdop;
+    float    vdop;
+    float    tdop;
+    uint8_t  flags;
+    uint32_t execution_time;
+};
+
+typedef void (*nrf_modem_gnss_event_handler_type_t)(int event);
+
+int32_t nrf_modem_gnss_event_handler_set(nrf_modem_gnss_event_handler_type_t handler);
+int32_t nrf_modem_gnss_fix_retry_set(uint16_t fix_retry);
+int32_t nrf_modem_gnss_fix_interval_set(uint16_t fix_interval);
+int32_t nrf_modem_gnss_start(void);
+int32_t nrf_modem_gnss_stop(void);
+int32_t nrf_modem_gnss_read(void *buf, int32_t buf_len, int type);
+
+#endif /* NRF_MODEM_GNSS_SIM_H_ */
@@ -12,6 +12,18 @@ static const struct json_obj_descr horse_desc[] = {
     JSON_OBJ_DESCR_PRIM(struct horse_payload, pitch,        JSON_TOK_NUMBER),
     JSON_OBJ_DESCR_PRIM(struct horse_payload, latitude,     JSON_TOK_NUMBER),
     JSON_OBJ_DESCR_PRIM(struct horse_payload, longitude,    JSON_TOK_NUMBER),
+    JSON_OBJ_DESCR_PRIM(struct horse_payload, pos_r,        JSON_TOK_NUMBER),
+    JSON_OBJ_DESCR_PRIM(struct horse_payload, limb_sym,     JSON_TOK_NUMBER),
+    JSON_OBJ_DESCR_PRIM(struct horse_payload, lying,        JSON_TOK_NUMBER),
+    JSON_OBJ_DESCR_PRIM(struct horse_payload, recumb,       JSON_TOK_NUMBER),
+    JSON_OBJ_DESCR_PRIM(struct horse_payload, resp_bpm,     JSON_TOK_NUMBER),
+    JSON_OBJ_DESCR_PRIM(struct horse_payload, resp_q,       JSON_TOK_NUMBER),
+    JSON_OBJ_DESCR_PRIM(struct horse_payload, graze_min,    JSON_TOK_NUMBER),
+    JSON_OBJ_DESCR_PRIM(struct horse_payload, graze_total,  JSON_TOK_NUMBER),
+    JSON_OBJ_DESCR_PRIM(struct horse_payload, trem,         JSON_TOK_NUMBER),
+    JSON_OBJ_DESCR_PRIM(struct horse_payload, trem_band,    JSON_TOK_NUMBER),
+    JSON_OBJ_DESCR_PRIM(struct horse_payload, trem_hz,      JSON_TOK_NUMBER),
+    JSON_OBJ_DESCR_PRIM(struct horse_payload, trem_pct,     JSON_TOK_NUMBER),
 };
 
 int horse_payload_construct(char *msg, size_t size, struct horse_payload *payload)
@@ -11,6 +11,18 @@ struct horse_payload {
     int32_t pitch;        // scaled by 100
     int32_t latitude;     // scaled by 1e6
     int32_t longitude;    // scaled by 1e6
+    int32_t pos_r;        // position uncertainty radius, m (0 = GNSS fix, >0 = dead reckoning)
+    int32_t limb_sym;     // left/right limb asymmetry, scaled by 100 (0 = symmetric)
+    int32_t lying;        // 1 = lying down (barometric posture)
+    int32_t recumb;       // lying-down episodes since boot
+    int32_t resp_bpm;     // resting respiration rate, scaled by 10 (0 = none yet)
+    int32_t resp_q;       // respiration estimate quality 0..100
+    int32_t graze_min;    // grazing minutes in the last full hour
+    int32_t graze_total;  // grazing minutes since boot (completed hours)
+    int32_t trem;         // 1 = tremor / shivering detected
+    int32_t trem_band;    // 5-15 Hz RMS acceleration, mm/s^2 (last analysed window)
+    int32_t trem_hz;      // 5-15 Hz spectral peak frequency, scaled by 10
+    int32_t trem_pct;     // share of 0.5-25 Hz energy in the 5-15 Hz band, percent
 };
 
 int horse_payload_construct(char *msg, size_t size, struct horse_payload *payload);
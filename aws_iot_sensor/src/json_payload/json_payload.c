@@ -7,6 +7,7 @@
 #include <zephyr/types.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/data/json.h>
+#include <string.h>
 
 #include "json_payload.h"
 
@@ -19,6 +20,8 @@ int json_payload_construct(char *message, size_t size, struct payload *payload)
 	const struct json_obj_descr parameters[] = {
 		JSON_OBJ_DESCR_PRIM_NAMED(struct payload, "uptime",
 					  state.reported.uptime, JSON_TOK_NUMBER),
+		JSON_OBJ_DESCR_PRIM_NAMED(struct payload, "health",
+					  state.reported.health, JSON_TOK_NUMBER),
 		JSON_OBJ_DESCR_PRIM_NAMED(struct payload, "app_version",
 					  state.reported.app_version, JSON_TOK_STRING),
 #if defined(CONFIG_MODEM_INFO)
@@ -42,3 +45,47 @@ int json_payload_construct(char *message, size_t size, struct payload *payload)
 
 	return 0;
 }
+
+int json_payload_parse_delta(const char *message, size_t len, struct shadow_delta *delta)
+{
+	/* json_obj_parse() works in place, so parse a private copy. */
+	static char buf[CONFIG_AWS_IOT_SAMPLE_JSON_MESSAGE_SIZE_MAX];
+	int ret;
+	const struct json_obj_descr fence[] = {
+		JSON_OBJ_DESCR_PRIM(struct shadow_fence, id, JSON_TOK_NUMBER),
+		JSON_OBJ_DESCR_PRIM(struct shadow_fence, del, JSON_TOK_NUMBER),
+		JSON_OBJ_DESCR_ARRAY(struct shadow_fence, pts, 2 * SHADOW_FENCE_MAX_VERTS,
+				     pts_len, JSON_TOK_NUMBER),
+	};
+	const struct json_obj_descr state[] = {
+		JSON_OBJ_DESCR_PRIM_NAMED(struct shadow_delta, "capture",
+					  state.capture, JSON_TOK_NUMBER),
+		JSON_OBJ_DESCR_PRIM_NAMED(struct shadow_delta, "tlog_from",
+					  state.tlog_from, JSON_TOK_NUMBER),
+		JSON_OBJ_DESCR_PRIM_NAMED(struct shadow_delta, "tlog_to",
+					  state.tlog_to, JSON_TOK_NUMBER),
+		JSON_OBJ_DESCR_OBJECT_NAMED(struct shadow_delta, "fence",
+					    state.fence, fence),
+	};
+	const struct json_obj_descr root[] = {
+		JSON_OBJ_DESCR_OBJECT(struct shadow_delta, state, state),
+	};
+
+	memset(delta, 0, sizeof(*delta));
+
+	if (len >= sizeof(buf)) {
+		LOG_ERR("Shadow delta too large: %d", (int)len);
+		return -ENOMEM;
+	}
+
+	memcpy(buf, message, len);
+	buf[len] = '\0';
+
+	ret = json_obj_parse(buf, len, root, ARRAY_SIZE(root), delta);
+	if (ret < 0) {
+		LOG_ERR("json_obj_parse, error: %d", ret);
+		return ret;
+	}
+
+	return 0;
+}
@@ -13,6 +13,7 @@ struct payload {
 			const char *app_version;
 			const char *modem_version;
 			uint32_t uptime;
+			uint32_t health;   /* Sensor health bitmap, see sensor_health.h. */
 		} reported;
 	} state;
 };
@@ -27,3 +28,38 @@ struct payload {
  * @return 0 on success, otherwise a negative value is returned.
  */
 int json_payload_construct(char *message, size_t size, struct payload *payload);
+
+/* Most vertices accepted in one paddock fence. */
+#define SHADOW_FENCE_MAX_VERTS 64
+
+/* A paddock fence in a shadow delta: "fence": {"id": 3, "pts": [lat, lon, ...]}
+ * with coordinates in microdegrees, or "fence": {"id": 3, "del": 1}.
+ */
+struct shadow_fence {
+	int32_t id;
+	int32_t del;
+	int32_t pts[2 * SHADOW_FENCE_MAX_VERTS];
+	size_t pts_len;
+};
+
+/* Fields the device understands in a shadow delta document.
+ * Absent fields are left at zero.
+ */
+struct shadow_delta {
+	struct {
+		int32_t capture;   /* Start a gait capture of this many seconds. */
+		int32_t tlog_from; /* Upload the telemetry log from this UTC second... */
+		int32_t tlog_to;   /* ...up to and including this one. */
+		struct shadow_fence fence; /* Add, replace or delete a paddock fence. */
+	} state;
+};
+
+/* @brief Parse a shadow delta document.
+ *
+ * @param[in]  message Pointer to the received JSON document.
+ * @param[in]  len     Length of the document.
+ * @param[out] delta   Parsed fields, zeroed before parsing.
+ *
+ * @return 0 on success, otherwise a negative value is returned.
+ */
+int json_payload_parse_delta(const char *message, size_t len, struct shadow_delta *delta);
@@ -19,6 +19,21 @@
 #include "horse_payload.h"
 #include "gnss_task.h"
 #include "sensor.h"
+#include "sensor_health.h"
+#include "imu_array.h"
+#include "baro_posture.h"
+#include "colic_monitor.h"
+#include "respiration.h"
+#include "grazing.h"
+#include "tremor.h"
+#include "dead_reckon.h"
+#include "mag_cal.h"
+#include "app_fs.h"
+#include "gait_capture.h"
+#include "telemetry_log.h"
+#include "water_log.h"
+#include "paddock.h"
+#include "mqtt_id.h"
 
 ////////////////////////// FOTA //////////////////////////////////
 #include <net/aws_fota.h>
@@ -44,6 +59,8 @@ static void aws_fota_evt_handler(struct aws_fota_event *evt)
 
     case AWS_FOTA_EVT_ERASE_DONE:
         LOG_INF("AWS FOTA: Flash erase complete, rebooting...");
+        tlog_flush_all();
+        water_log_flush();
         sys_reboot(SYS_REBOOT_COLD);
         break;
 
@@ -65,6 +82,8 @@ static void aws_fota_evt_handler(struct aws_fota_event *evt)
 
 /* 统一 horse_data 上报间隔（秒） */
 #define HORSE_DATA_INTERVAL_SEC 120
+/* 疝痛报警后的高频上报间隔（位置 + 姿态） */
+#define HORSE_DATA_BOOST_INTERVAL_SEC 10
 
 /*=============================== horse_data work ==========================*/
 static void horse_data_work_fn(struct k_work *work);
@@ -72,10 +91,10 @@ K_WORK_DELAYABLE_DEFINE(horse_data_work, horse_data_work_fn);
 
 /*========================================== horse_data =======================================*/
 void publish_horse_data(float temperature, float moisture, float pitch,
-                        float gps_lat, float gps_lon,
+                        float gps_lat, float gps_lon, float pos_r,
                         int water_flag, int water_time)
 {
-    char json_buf[256];
+    char json_buf[512];
     struct horse_payload hp;
 
     /* new fields */
@@ -88,6 +107,34 @@ void publish_horse_data(float temperature, float moisture, float pitch,
     hp.pitch       = (int32_t)(pitch * 100.0f);
     hp.latitude    = (int32_t)(gps_lat * 1000000.0f);
     hp.longitude   = (int32_t)(gps_lon * 1000000.0f);
+    hp.pos_r       = (int32_t)(pos_r + 0.5f);
+    hp.limb_sym    = (int32_t)(imu_array_symmetry() * 100.0f);
+
+    struct posture_status posture;
+
+    baro_posture_get(&posture);
+    hp.lying       = (posture.state == POSTURE_LYING);
+    hp.recumb      = posture.episodes;
+
+    struct resp_estimate resp;
+
+    respiration_get(&resp);
+    hp.resp_bpm    = resp.bpm_x10;
+    hp.resp_q      = resp.quality;
+
+    struct grazing_stats graze;
+
+    grazing_get(&graze);
+    hp.graze_min   = graze.last_hour_min;
+    hp.graze_total = graze.total_min;
+
+    struct tremor_status trem;
+
+    tremor_get(&trem);
+    hp.trem        = trem.active;
+    hp.trem_band   = trem.last.band_mms2;
+    hp.trem_hz     = trem.last.peak_hz_x10;
+    hp.trem_pct    = trem.last.band_pct;
 
     if (horse_payload_construct(json_buf, sizeof(json_buf), &hp)) {
         printk("horse_payload_construct failed\n");
@@ -96,6 +143,7 @@ void publish_horse_data(float temperature, float moisture, float pitch,
 
     struct aws_iot_data tx = { 0 };
     tx.qos       = MQTT_QOS_1_AT_LEAST_ONCE;
+    tx.message_id = mqtt_id_next();
     tx.ptr       = json_buf;
     tx.len       = strlen(json_buf);
     tx.topic.str = "horse_data";
@@ -117,33 +165,81 @@ static void horse_data_work_fn(struct k_work *work)
     struct gnss_status_msg msg;
     static struct gnss_status_msg last_msg = {0};
 
-    /* 把队列里累积的数据读到最后一条 */
-    int got_msg = 0;
-    while (k_msgq_get(&gnss_msgq, &msg, K_NO_WAIT) == 0) {
-        got_msg = 1;
+    /* 直接读 GNSS 信箱里最新的一条；
+     * 只在有过 fix、lat/lon 非 0 时覆盖，避免把 0 覆盖掉已有的有效坐标。
+     */
+    bool have = gnss_get_latest(&msg);
+
+    if (have && (msg.lat != 0.0 || msg.lon != 0.0)) {
+        last_msg = msg;
     }
 
-    /* 只有在真的从 GNSS 收到消息时才更新 last_msg；
-     * 并且只在 lat/lon 非 0 时覆盖，避免把 0 覆盖掉已有的有效坐标。
-     */
-    if (got_msg) {
-        if (msg.lat != 0.0f || msg.lon != 0.0f) {
-            last_msg = msg;
-        }
+    /* 丢星时用航位推算的位置，同时报不确定半径；有 fix 时 pos_r = 0 */
+    double lat = last_msg.lat;
+    double lon = last_msg.lon;
+    float pos_r = 0.0f;
+    struct dr_estimate dr;
+
+    dead_reckon_get(&dr);
+    if (have && msg.status == GNSS_STATUS_SIGNAL_LOST && dr.valid) {
+        lat = dr.lat;
+        lon = dr.lon;
+        pos_r = dr.radius_m;
     }
 
+    /* pitch 用分频链的两分钟均值，和上报周期对齐 */
+    struct imu_sample imu;
+
+    sensor_get_imu_2min(&imu);
+
     publish_horse_data(
         g_temperature,
         g_humidity,                          /* TODO: 替换成真实湿度 */
-        g_state,                          /* TODO: 替换成真实 pitch */
-        last_msg.lat,
-        last_msg.lon,
+        imu.pitch,
+        lat,
+        lon,
+        pos_r,
         last_msg.is_water_gnss ? 1 : 0,
         (int)last_msg.total_water_s
     );
 
     /* 下次上报 */
-    k_work_reschedule(&horse_data_work, K_SECONDS(HORSE_DATA_INTERVAL_SEC));
+    k_work_reschedule(&horse_data_work,
+                      K_SECONDS(colic_monitor_boost_active() ?
+                                HORSE_DATA_BOOST_INTERVAL_SEC : HORSE_DATA_INTERVAL_SEC));
+}
+
+/*========================= shadow delta 命令 =========================*/
+
+static void handle_shadow_delta(const char *msg, size_t len)
+{
+    /* 带一个围场的顶点数组，不放栈上（只在 AWS IoT 事件里调用，不会重入） */
+    static struct shadow_delta delta;
+
+    if (json_payload_parse_delta(msg, len, &delta)) {
+        return;
+    }
+
+    if (delta.state.capture > 0) {
+        int err = gait_capture_trigger(CAPTURE_TRIGGER_SHADOW, delta.state.capture);
+
+        LOG_INF("Shadow capture request %d s -> %d", delta.state.capture, err);
+    }
+
+    if (delta.state.tlog_to > 0 && delta.state.tlog_to >= delta.state.tlog_from) {
+        int err = tlog_upload_range(delta.state.tlog_from, delta.state.tlog_to);
+
+        LOG_INF("Shadow tlog request %d..%d -> %d",
+                delta.state.tlog_from, delta.state.tlog_to, err);
+    }
+
+    if (delta.state.fence.id > 0) {
+        const struct shadow_fence *f = &delta.state.fence;
+        int err = f->del ? paddock_remove(f->id) :
+                  paddock_set(f->id, f->pts, f->pts_len);
+
+        LOG_INF("Shadow fence %d (%s) -> %d", f->id, f->del ? "delete" : "set", err);
+    }
 }
 
 /*========================= NET / AWS 相关 =========================*/
@@ -251,9 +347,11 @@ static void shadow_update_work_fn(struct k_work *work)
     struct payload payload = {
         .state.reported.uptime = k_uptime_get(),
         .state.reported.app_version = CONFIG_AWS_IOT_SAMPLE_APP_VERSION,
+        .state.reported.health = sensor_health_bitmap(),
     };
     struct aws_iot_data tx_data = {
         .qos = MQTT_QOS_0_AT_MOST_ONCE,
+        .message_id = mqtt_id_next(),
         .topic.type = AWS_IOT_SHADOW_TOPIC_UPDATE,
     };
 
@@ -347,6 +445,12 @@ static void on_aws_iot_evt_connected(const struct aws_iot_evt *const evt)
     /* 启动 shadow 上报 & horse_data 定时上报 */
     (void)k_work_reschedule(&shadow_update_work, K_NO_WAIT);
     (void)k_work_reschedule(&horse_data_work, K_SECONDS(HORSE_DATA_INTERVAL_SEC));
+
+    /* 继续上传没传完的步态抓拍 */
+    gait_capture_resume_upload();
+
+    /* 继续上传没确认的喝水记录 */
+    water_log_resume_upload();
 }
 
 static void on_aws_iot_evt_disconnected(void)
@@ -374,9 +478,15 @@ static void aws_iot_event_handler(const struct aws_iot_evt *const evt)
         LOG_INF("Received: \"%.*s\" on \"%.*s\"",
             evt->data.msg.len, evt->data.msg.ptr,
             evt->data.msg.topic.len, evt->data.msg.topic.str);
+        if (evt->data.msg.topic.type == AWS_IOT_SHADOW_TOPIC_UPDATE_DELTA) {
+            handle_shadow_delta(evt->data.msg.ptr, evt->data.msg.len);
+        }
         break;
     case AWS_IOT_EVT_PUBACK:
         LOG_INF("AWS_IOT_EVT_PUBACK id=%d", evt->data.message_id);
+        /* id 都是 mqtt_id_next() 分的，各模块只认自己在途的那个 */
+        gait_capture_on_puback(evt->data.message_id);
+        water_log_on_puback(evt->data.message_id);
         break;
     case AWS_IOT_EVT_PINGRESP:
         LOG_INF("AWS_IOT_EVT_PINGRESP");
@@ -449,6 +559,35 @@ int main(void)
     LOG_INF("Sensor system started");
     sensor_init();
     int err;
+
+    /* littlefs：步态抓拍、遥测日志等离线数据 */
+    err = app_fs_init();
+    if (err) {
+        LOG_ERR("app_fs_init failed: %d", err);
+    } else {
+        err = tlog_init();
+        if (err) {
+            LOG_ERR("tlog_init failed: %d", err);
+        }
+
+        err = water_log_init();
+        if (err) {
+            LOG_ERR("water_log_init failed: %d", err);
+        }
+
+        err = gait_capture_init();
+        if (err) {
+            LOG_ERR("gait_capture_init failed: %d", err);
+        }
+
+        err = mag_cal_init();
+        if (err) {
+            LOG_ERR("mag_cal_init failed: %d", err);
+        }
+    }
+
+    (void)respiration_init();
+
     LOG_INF("Main(LTE) app starting...");
 
     /* Step 1: 初始化 Modem（但不启动 LTE） */
@@ -473,6 +612,12 @@ int main(void)
         LOG_ERR("gnss_system_init failed: %d", err);
     }
 
+    /* 围场电子围栏：从 flash 读回来登记到 GNSS 任务 */
+    err = paddock_init();
+    if (err) {
+        LOG_ERR("paddock_init failed: %d", err);
+    }
+
     /* Step 4: 注册 LTE 链路事件回调 */
     net_mgmt_init_event_callback(&l4_cb, l4_event_handler, L4_EVENT_MASK);
     net_mgmt_add_event_callback(&l4_cb);
@@ -0,0 +1,17 @@
+/* mqtt_id.c
+ *
+ * MQTT message ID 分配，见 mqtt_id.h。
+ */
+
+#include "mqtt_id.h"
+
+#include <zephyr/kernel.h>
+
+static atomic_t next_id;
+
+uint16_t mqtt_id_next(void)
+{
+    atomic_val_t n = atomic_inc(&next_id);
+
+    return (uint16_t)(MQTT_ID_FIRST | ((uint32_t)n & 0x7FFF));
+}
@@ -0,0 +1,22 @@
+#ifndef MQTT_ID_H_
+#define MQTT_ID_H_
+
+#include <stdint.h>
+
+/*
+ * 应用里所有 aws_iot_send 共用的 MQTT message ID 分配器。
+ *
+ * aws_iot 库在 tx.message_id == 0 时自己从 1 开始往上分配，模块各自手挑一个区间的话
+ * 迟早和它撞上：撞上以后别人的 PUBACK 会被当成自己的（gait_capture / water_log
+ * 按 id 推进上传进度）。所以应用的每一次发布都从这里拿 id，只用 0x8000~0xFFFF；
+ * 库的分配器只剩它自己连接时的订阅 / 影子请求在用，停在低半区。
+ * 回绕前要发 32768 条，同时在等 PUBACK 的只有几条，id 不会重复；
+ * PUBACK 统一在 main.c 的事件回调里分发，各模块只认自己在途的 id。
+ */
+
+#define MQTT_ID_FIRST   0x8000
+
+/* 下一个 id（0x8000~0xFFFF 循环），任意线程可调用 */
+uint16_t mqtt_id_next(void);
+
+#endif /* MQTT_ID_H_ */
@@ -0,0 +1,162 @@
+#include "baro_detector.h"
+
+#include <math.h>
+#include <string.h>
+
+/* ====================== 参数可调 ====================== */
+
+/* 快 IIR：平滑 1 Hz 气压噪声（BME280 16x 过采样 + 内部滤波后约 ±3 cm） */
+#define BARO_FAST_ALPHA        0.3f
+
+/*
+ * 站立参考高度：带趋势的二阶跟踪（alpha-beta），时间常数约 2 分钟。
+ * 一阶 IIR 跟斜坡的滞后 = 速度 x 时间常数：1 hPa/h（约 2.3 mm/s）、10 分钟要 1.4 m，
+ * 站着也会判成卧倒；带上趋势以后匀速斜坡没有稳态滞后。
+ * 真正卧倒几秒内就掉下去，这么短的时间里参考只跟过去几厘米。
+ */
+#define BARO_REF_ALPHA         (1.0f / 60.0f)
+#define BARO_REF_BETA          (BARO_REF_ALPHA * BARO_REF_ALPHA / 4.0f)   /* 临界阻尼 */
+
+/* 趋势上限（m / 样本）：约 3 hPa/h，比这快的不是天气 */
+#define BARO_REF_MAX_SLOPE     0.007f
+
+/* 上电后多少个样本参考才算收敛 */
+#define BARO_WARMUP_SAMPLES    60
+
+/* 吃草冻结参考最长多久，超过就用当前高度重置（1 hPa/h 下 10 分钟漂 1.4 m） */
+#define BARO_REF_FREEZE_MAX_S  600
+
+/* 比参考低多少算卧倒 / 高回多少算站起（项圈在颈部，卧倒约低 0.8~1.2 m） */
+#define BARO_LYING_DROP_M      0.5f
+#define BARO_STAND_DROP_M      0.25f
+
+/* 持续时间：有 IMU 辅助时短一点，纯气压时要更长才能排除吃草低头 */
+#define BARO_LYING_SUSTAIN_S       20
+#define BARO_LYING_SUSTAIN_BARO_S  60
+#define BARO_STAND_SUSTAIN_S       5
+
+/* 低头吃草的 pitch 阈值 */
+#define BARO_GRAZE_PITCH_DEG   35.0f
+
+/* 干空气 R / g，乘温度（K）得到 m；h = -(R*T/g) * ln(p / p0) */
+#define BARO_RT_OVER_G         29.27f
+
+/* ====================== 实现 ====================== */
+
+void baro_detector_init(baro_detector_t *bd)
+{
+    memset(bd, 0, sizeof(*bd));
+    bd->state = POSTURE_UNKNOWN;
+}
+
+/*
+ * 参考跟踪。有待定的切换、或者站着低头吃草时不拿高度修正，只按趋势往前推（天气照样在变），
+ * 吃草冻结太久直接重置；卧倒时按“卧倒高度 - 进入时的高度差”修正。
+ */
+static void track_ref(baro_detector_t *bd, uint32_t t_s, bool grazing)
+{
+    if (bd->n_samples < BARO_WARMUP_SAMPLES) {
+        bd->h_ref += 0.2f * (bd->h_fast - bd->h_ref);
+        return;
+    }
+
+    if (!bd->cond && bd->state != POSTURE_LYING && grazing) {
+        if (!bd->frozen) {
+            bd->frozen = true;
+            bd->frozen_since_s = t_s;
+        } else if (t_s - bd->frozen_since_s >= BARO_REF_FREEZE_MAX_S) {
+            bd->h_ref = bd->h_fast;
+            bd->frozen_since_s = t_s;
+            return;
+        }
+    } else {
+        bd->frozen = false;
+    }
+
+    bd->h_ref += bd->v_ref;
+    if (bd->cond || bd->frozen) {
+        return;
+    }
+
+    float target = (bd->state == POSTURE_LYING) ? bd->h_fast - bd->lie_offset
+                                                : bd->h_fast;
+    float e = target - bd->h_ref;
+
+    bd->h_ref += BARO_REF_ALPHA * e;
+    bd->v_ref += BARO_REF_BETA * e;
+    if (bd->v_ref > BARO_REF_MAX_SLOPE) {
+        bd->v_ref = BARO_REF_MAX_SLOPE;
+    } else if (bd->v_ref < -BARO_REF_MAX_SLOPE) {
+        bd->v_ref = -BARO_REF_MAX_SLOPE;
+    }
+}
+
+bool baro_detector_update(baro_detector_t *bd, uint32_t t_s, float pressure_pa,
+                          float temp_c, bool imu_valid, float pitch_deg)
+{
+    if (pressure_pa <= 0.0f) {
+        return false;
+    }
+
+    if (bd->n_samples == 0) {
+        bd->p_anchor = pressure_pa;
+    }
+
+    /* 相对 anchor 的高度（m），用当前温度修正 */
+    float h = -BARO_RT_OVER_G * (temp_c + 273.15f) * logf(pressure_pa / bd->p_anchor);
+
+    if (bd->n_samples == 0) {
+        bd->h_fast = h;
+        bd->h_ref = h;
+    } else {
+        bd->h_fast += BARO_FAST_ALPHA * (h - bd->h_fast);
+    }
+    bd->n_samples++;
+
+    bool grazing = imu_valid && fabsf(pitch_deg) > BARO_GRAZE_PITCH_DEG;
+
+    track_ref(bd, t_s, grazing);
+    bd->dh = bd->h_fast - bd->h_ref;
+
+    if (bd->n_samples < BARO_WARMUP_SAMPLES) {
+        return false;
+    }
+    if (bd->state == POSTURE_UNKNOWN) {
+        bd->state = POSTURE_STANDING;
+        return true;
+    }
+
+    bool want_switch;
+    uint32_t sustain_s;
+
+    if (bd->state == POSTURE_STANDING) {
+        /* 低头吃草也会让项圈变低，不是卧倒 */
+        want_switch = bd->dh < -BARO_LYING_DROP_M && !grazing;
+        sustain_s = imu_valid ? BARO_LYING_SUSTAIN_S : BARO_LYING_SUSTAIN_BARO_S;
+    } else {
+        want_switch = bd->dh > -BARO_STAND_DROP_M;
+        sustain_s = BARO_STAND_SUSTAIN_S;
+    }
+
+    if (!want_switch) {
+        bd->cond = false;
+        return false;
+    }
+    if (!bd->cond) {
+        bd->cond = true;
+        bd->cond_since_s = t_s;
+        return false;
+    }
+    if (t_s - bd->cond_since_s < sustain_s) {
+        return false;
+    }
+
+    bd->cond = false;
+    if (bd->state == POSTURE_STANDING) {
+        bd->state = POSTURE_LYING;
+        bd->lie_offset = bd->dh;
+    } else {
+        bd->state = POSTURE_STANDING;
+    }
+    return true;
+}
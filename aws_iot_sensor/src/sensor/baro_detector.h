@@ -0,0 +1,55 @@
+#ifndef BARO_DETECTOR_H_
+#define BARO_DETECTOR_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * 气压高度卧倒判定 —— 纯逻辑，不依赖内核，可以在 native_sim 上回放测试。
+ *
+ * 每秒一个气压 / 温度样本，换算成相对第一次样本的高度：
+ *  - 快 IIR 平滑出当前项圈高度；
+ *  - 带趋势的慢跟踪器给出“站立时”的参考高度，吃掉天气漂移。站着、没有待定的卧倒、
+ *    也没在低头吃草时一直修正，不管偏离多少（1 hPa/h 的锋面约 8 m/h，
+ *    只在参考附近才跟踪的话迟早被甩出去，然后一直冻结）；
+ *  - 待定切换的几十秒里、低头吃草时参考只按趋势外推；吃草超过
+ *    BARO_REF_FREEZE_MAX_S 直接用当前高度重置；
+ *  - 比参考低 BARO_LYING_DROP_M 并持续一段时间 → 卧倒；回到参考附近 → 站起。
+ *    卧倒期间记住进入时的高度差，参考跟着“卧倒高度 - 这个差”走，
+ *    卧半小时天气漂了几米也还能判出站起。
+ * IMU 在线时 pitch 明显朝下（低头吃草）不判卧倒；IMU 断电时只靠气压，持续时间要求更长。
+ */
+
+enum posture {
+    POSTURE_UNKNOWN = 0,   /* 参考高度还没收敛 */
+    POSTURE_STANDING,
+    POSTURE_LYING,
+};
+
+typedef struct {
+    float    p_anchor;      /* 第一次样本的气压（Pa），只用来把高度算成小数 */
+    float    h_fast;
+    float    h_ref;
+    float    v_ref;         /* 参考高度的趋势（m / 样本），天气斜坡 */
+    float    dh;            /* h_fast - h_ref（m），负数 = 比站着低 */
+    float    lie_offset;    /* 进入卧倒时的 dh */
+    uint32_t n_samples;
+
+    bool     cond;          /* “想切换”的条件正在满足 */
+    uint32_t cond_since_s;
+    bool     frozen;        /* 站着吃草，参考只在外推 */
+    uint32_t frozen_since_s;
+
+    enum posture state;
+} baro_detector_t;
+
+void baro_detector_init(baro_detector_t *bd);
+
+/*
+ * 喂一个样本：t_s 单调秒数，pressure 单位 Pa，temp 单位 degC；
+ * imu_valid == false 时忽略 pitch_deg。状态切换时返回 true，新状态在 bd->state。
+ */
+bool baro_detector_update(baro_detector_t *bd, uint32_t t_s, float pressure_pa,
+                          float temp_c, bool imu_valid, float pitch_deg);
+
+#endif /* BARO_DETECTOR_H_ */
@@ -0,0 +1,105 @@
+/* baro_posture.c
+ *
+ * 气压高度卧倒检测，见 baro_posture.h。
+ */
+
+#include "baro_posture.h"
+#include "baro_detector.h"
+#include "sensor.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(baro_posture, LOG_LEVEL_INF);
+
+/* ====================== 参数可调 ====================== */
+
+/* IMU 样本多新算“在线” */
+#define BARO_IMU_FRESH_MS      3000
+
+/* ====================== 状态 ====================== */
+
+static struct k_spinlock posture_lock;
+static struct posture_status status;
+
+/* 只有 BME 线程碰，不加锁 */
+static baro_detector_t detector;
+static bool detector_ready;
+
+static void set_state(enum posture st, tb_ts_t ts)
+{
+    k_spinlock_key_t key = k_spin_lock(&posture_lock);
+
+    if (st == POSTURE_STANDING && status.state == POSTURE_LYING) {
+        status.last_episode_s = timebase_delta_ms(status.since, ts) / 1000;
+    }
+    if (st == POSTURE_LYING) {
+        status.episodes++;
+    }
+    status.state = st;
+    status.since = ts;
+
+    k_spin_unlock(&posture_lock, key);
+}
+
+/* IMU 在线时返回 true 并给出 pitch */
+static bool imu_pitch(tb_ts_t now, float *pitch)
+{
+    struct imu_sample imu;
+
+    sensor_get_imu_1hz(&imu);
+    if (imu.ts == 0 || now < imu.ts ||
+        timebase_delta_ms(imu.ts, now) > BARO_IMU_FRESH_MS) {
+        return false;
+    }
+
+    *pitch = imu.pitch;
+    return true;
+}
+
+/* ====================== 对外接口 ====================== */
+
+void baro_posture_update(tb_ts_t ts, float pressure_kpa, float temp_c)
+{
+    if (!detector_ready) {
+        baro_detector_init(&detector);
+        detector_ready = true;
+    }
+
+    float pitch = 0.0f;
+    bool have_imu = imu_pitch(ts, &pitch);
+    uint32_t t_s = (uint32_t)(ts / TB_FREQ_HZ);
+
+    bool changed = baro_detector_update(&detector, t_s, pressure_kpa * 1000.0f,
+                                        temp_c, have_imu, pitch);
+
+    k_spinlock_key_t key = k_spin_lock(&posture_lock);
+    status.height_m = detector.dh;
+    k_spin_unlock(&posture_lock, key);
+
+    if (!changed) {
+        return;
+    }
+
+    enum posture prev = status.state;
+
+    set_state(detector.state, ts);
+    if (detector.state == POSTURE_LYING) {
+        LOG_INF("Lying down (dh=%.2f m, imu=%d), episode %u",
+                (double)detector.dh, have_imu, status.episodes);
+    } else if (prev == POSTURE_LYING) {
+        LOG_INF("Standing up after %u s", status.last_episode_s);
+    }
+}
+
+enum posture baro_posture_state(void)
+{
+    return status.state;
+}
+
+void baro_posture_get(struct posture_status *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&posture_lock);
+    *out = status;
+    k_spin_unlock(&posture_lock, key);
+}
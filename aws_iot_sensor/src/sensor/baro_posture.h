@@ -0,0 +1,33 @@
+#ifndef BARO_POSTURE_H_
+#define BARO_POSTURE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "timebase.h"
+#include "baro_detector.h"
+
+/*
+ * 气压高度 → 卧倒检测
+ *
+ * BME280 每秒一个气压样本，交给 baro_detector（纯逻辑，快 / 慢 IIR 高度和卧倒判定，
+ * 见 baro_detector.h）；这里是运行时外壳：拿 IMU 1 Hz 的 pitch（太旧就当 IMU 断电），
+ * 记录卧倒事件的次数和时长，给其他线程一个加锁的快照。
+ */
+
+struct posture_status {
+    enum posture state;
+    float    height_m;          /* 相对站立参考的高度（负数 = 比站着低） */
+    uint32_t episodes;          /* 上电以来的卧倒次数 */
+    tb_ts_t  since;             /* 进入当前状态的时间 */
+    uint32_t last_episode_s;    /* 上一次卧倒持续时间 */
+};
+
+/* BME 线程每个样本调用一次：pressure 单位 kPa，temp 单位 degC */
+void baro_posture_update(tb_ts_t ts, float pressure_kpa, float temp_c);
+
+enum posture baro_posture_state(void);
+
+void baro_posture_get(struct posture_status *out);
+
+#endif /* BARO_POSTURE_H_ */
@@ -0,0 +1,107 @@
+/* bme280_comp.c
+ *
+ * BME280 原始读数补偿，见 bme280_comp.h。公式照抄 Bosch 数据手册 4.2.3 节的整数版本。
+ */
+
+#include "bme280_comp.h"
+
+/* 测量被跳过时寄存器里的值 */
+#define BME280_SKIPPED_TP       0x80000
+#define BME280_SKIPPED_H        0x8000
+
+static uint16_t le16(const uint8_t *b)
+{
+    return (uint16_t)(b[0] | (b[1] << 8));
+}
+
+void bme280_comp_parse_calib(struct bme280_calib *c,
+                             const uint8_t tp[BME280_CALIB_TP_LEN],
+                             const uint8_t h[BME280_CALIB_H_LEN])
+{
+    c->t1 = le16(&tp[0]);
+    c->t2 = (int16_t)le16(&tp[2]);
+    c->t3 = (int16_t)le16(&tp[4]);
+    c->p1 = le16(&tp[6]);
+    c->p2 = (int16_t)le16(&tp[8]);
+    c->p3 = (int16_t)le16(&tp[10]);
+    c->p4 = (int16_t)le16(&tp[12]);
+    c->p5 = (int16_t)le16(&tp[14]);
+    c->p6 = (int16_t)le16(&tp[16]);
+    c->p7 = (int16_t)le16(&tp[18]);
+    c->p8 = (int16_t)le16(&tp[20]);
+    c->p9 = (int16_t)le16(&tp[22]);
+    c->h1 = tp[25];
+
+    c->h2 = (int16_t)le16(&h[0]);
+    c->h3 = h[2];
+    /* H4 / H5 是 12 位，共用 0xE5 的高低半字节 */
+    c->h4 = (int16_t)(((int8_t)h[3] * 16) | (h[4] & 0x0F));
+    c->h5 = (int16_t)(((int8_t)h[5] * 16) | (h[4] >> 4));
+    c->h6 = (int8_t)h[6];
+}
+
+int32_t bme280_comp_temp(const struct bme280_calib *c, int32_t adc_t, int32_t *t_fine)
+{
+    int32_t var1 = (((adc_t >> 3) - ((int32_t)c->t1 << 1)) * c->t2) >> 11;
+    int32_t d = (adc_t >> 4) - (int32_t)c->t1;
+    int32_t var2 = (((d * d) >> 12) * c->t3) >> 14;
+
+    *t_fine = var1 + var2;
+    return (*t_fine * 5 + 128) >> 8;
+}
+
+uint32_t bme280_comp_press(const struct bme280_calib *c, int32_t adc_p, int32_t t_fine)
+{
+    int64_t var1 = (int64_t)t_fine - 128000;
+    int64_t var2 = var1 * var1 * c->p6;
+
+    var2 += (var1 * c->p5) * 131072;
+    var2 += (int64_t)c->p4 * 34359738368LL;
+    var1 = ((var1 * var1 * c->p3) >> 8) + ((var1 * c->p2) * 4096);
+    var1 = ((((int64_t)1 << 47) + var1) * c->p1) >> 33;
+    if (var1 == 0) {
+        return 0;       /* 避免除零 */
+    }
+
+    int64_t p = 1048576 - adc_p;
+
+    p = ((p * 2147483648LL - var2) * 3125) / var1;
+    var1 = ((int64_t)c->p9 * (p >> 13) * (p >> 13)) >> 25;
+    var2 = ((int64_t)c->p8 * p) >> 19;
+    p = ((p + var1 + var2) >> 8) + ((int64_t)c->p7 * 16);
+
+    return (uint32_t)p;
+}
+
+uint32_t bme280_comp_hum(const struct bme280_calib *c, int32_t adc_h, int32_t t_fine)
+{
+    int32_t v = t_fine - 76800;
+
+    v = (((adc_h * 16384) - ((int32_t)c->h4 * 1048576) - ((int32_t)c->h5 * v) + 16384) >> 15) *
+        (((((((v * c->h6) >> 10) * (((v * (int32_t)c->h3) >> 11) + 32768)) >> 10) + 2097152) *
+          c->h2 + 8192) >> 14);
+    v -= ((((v >> 15) * (v >> 15)) >> 7) * (int32_t)c->h1) >> 4;
+    v = (v < 0) ? 0 : v;
+    v = (v > 419430400) ? 419430400 : v;
+
+    return (uint32_t)(v >> 12);
+}
+
+bool bme280_comp_convert(const struct bme280_calib *c, const uint8_t raw[BME280_DATA_LEN],
+                         float *temp_c, float *press_kpa, float *hum_pct)
+{
+    int32_t adc_p = (raw[0] << 12) | (raw[1] << 4) | (raw[2] >> 4);
+    int32_t adc_t = (raw[3] << 12) | (raw[4] << 4) | (raw[5] >> 4);
+    int32_t adc_h = (raw[6] << 8) | raw[7];
+
+    if (adc_t == BME280_SKIPPED_TP || adc_p == BME280_SKIPPED_TP || adc_h == BME280_SKIPPED_H) {
+        return false;
+    }
+
+    int32_t t_fine;
+
+    *temp_c    = bme280_comp_temp(c, adc_t, &t_fine) / 100.0f;
+    *press_kpa = bme280_comp_press(c, adc_p, t_fine) / 256000.0f;
+    *hum_pct   = bme280_comp_hum(c, adc_h, t_fine) / 1024.0f;
+    return true;
+}
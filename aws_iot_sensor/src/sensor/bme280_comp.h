@@ -0,0 +1,54 @@
+#ifndef BME280_COMP_H_
+#define BME280_COMP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * BME280 原始读数补偿 —— 纯逻辑，不依赖内核。
+ *
+ * 采集线程自己经共享总线读原始寄存器（不再在总线线程里调驱动的 sample_fetch），
+ * 这里按数据手册的整数公式换算：温度 0.01 °C，气压 Q24.8 Pa，湿度 Q22.10 %RH。
+ */
+
+/* 校准参数所在的两个寄存器块和测量数据块 */
+#define BME280_REG_CALIB_TP     0x88    /* 0x88..0xA1 */
+#define BME280_CALIB_TP_LEN     26
+#define BME280_REG_CALIB_H      0xE1    /* 0xE1..0xE7 */
+#define BME280_CALIB_H_LEN      7
+#define BME280_REG_STATUS       0xF3
+#define BME280_REG_CTRL_MEAS    0xF4
+#define BME280_REG_DATA         0xF7    /* press[3] temp[3] hum[2] */
+#define BME280_DATA_LEN         8
+
+#define BME280_STATUS_MEASURING 0x08
+#define BME280_MODE_MASK        0x03
+#define BME280_MODE_FORCED      0x01
+
+struct bme280_calib {
+    uint16_t t1;
+    int16_t  t2, t3;
+    uint16_t p1;
+    int16_t  p2, p3, p4, p5, p6, p7, p8, p9;
+    uint8_t  h1, h3;
+    int16_t  h2, h4, h5;
+    int8_t   h6;
+};
+
+void bme280_comp_parse_calib(struct bme280_calib *c,
+                             const uint8_t tp[BME280_CALIB_TP_LEN],
+                             const uint8_t h[BME280_CALIB_H_LEN]);
+
+/* 整数补偿；t_fine 由温度算出来，气压和湿度都要用 */
+int32_t bme280_comp_temp(const struct bme280_calib *c, int32_t adc_t, int32_t *t_fine);
+uint32_t bme280_comp_press(const struct bme280_calib *c, int32_t adc_p, int32_t t_fine);
+uint32_t bme280_comp_hum(const struct bme280_calib *c, int32_t adc_h, int32_t t_fine);
+
+/*
+ * 一次测量数据块 -> °C / kPa / %RH（和驱动 SENSOR_CHAN_* 的单位一样）。
+ * 某个量被跳过（未启用过采样 / 上电后还没测过）返回 false。
+ */
+bool bme280_comp_convert(const struct bme280_calib *c, const uint8_t raw[BME280_DATA_LEN],
+                         float *temp_c, float *press_kpa, float *hum_pct);
+
+#endif /* BME280_COMP_H_ */
@@ -0,0 +1,140 @@
+/* dead_reckon.c
+ *
+ * GNSS / IMU 航位推算，见 dead_reckon.h。
+ */
+
+#include "dead_reckon.h"
+#include "dr_ekf.h"
+#include "step_cadence.h"
+#include "heading_fusion.h"
+#include "gnss_task.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <math.h>
+
+LOG_MODULE_REGISTER(dead_reckon, LOG_LEVEL_INF);
+
+/* ====================== 参数可调 ====================== */
+
+/* IMU 航向的观测噪声 (deg)：残余磁干扰 + 项圈晃动 */
+#define DR_HEADING_SIGMA_DEG    8.0f
+
+/* 两个样本最多按多久预测（IMU 占空比断电 5 s） */
+#define DR_MAX_DT_MS            6000
+
+/* 定位和 IMU 样本相差多少以内才用 */
+#define DR_GNSS_FRESH_MS        2000
+
+/* 不确定半径超过这个就不再给位置（推算已经没有意义） */
+#define DR_MAX_RADIUS_M         500.0f
+
+/* 推算超过这么久（s）GNSS 回来时打一条 log，看推算的半径 */
+#define DR_LOG_OUTAGE_S         10
+
+/* ====================== 状态 ====================== */
+
+static struct dr_ekf ekf;
+static struct step_cadence steps;
+
+static tb_ts_t  last_ts;
+static tb_ts_t  last_fix_ts;
+static tb_ts_t  fix_used_ts;      /* 最近一次用上 fix 的 IMU 样本时间 */
+static bool     gave_up;          /* 半径超限的 log 打过了 */
+
+static struct k_spinlock dr_lock;
+static struct dr_estimate est;
+
+static float wrap360(float d)
+{
+    d = fmodf(d, 360.0f);
+    return (d < 0.0f) ? d + 360.0f : d;
+}
+
+/* GNSS 信箱里新的一个 fix（丢星时信箱里的时间戳不变，自然就不用了） */
+static bool gnss_new_fix(tb_ts_t now, struct gnss_status_msg *g)
+{
+    if (!gnss_get_latest(g) || g->ts == 0 || g->ts == last_fix_ts) {
+        return false;
+    }
+    last_fix_ts = g->ts;
+
+    /* 10 Hz 样本的时间戳已经按分频链群延迟往前挪过，定位可能比它还新 */
+    uint32_t age = (g->ts > now) ? timebase_delta_ms(now, g->ts) : timebase_delta_ms(g->ts, now);
+
+    return age <= DR_GNSS_FRESH_MS;
+}
+
+/* ====================== 对外接口 ====================== */
+
+void dead_reckon_feed(tb_ts_t ts, float imu_heading, float acc_mag)
+{
+    uint32_t dt_ms = 0;
+
+    if (last_ts != 0 && ts > last_ts) {
+        dt_ms = MIN(timebase_delta_ms(last_ts, ts), DR_MAX_DT_MS);
+    }
+    last_ts = ts;
+
+    float cadence = step_cadence_feed(&steps, (uint32_t)timebase_delta_ms(0, ts), acc_mag);
+
+    dr_ekf_predict(&ekf, dt_ms / 1000.0f);
+
+    /* IMU 航向：只用已经和 GNSS 对齐过的（相对真北） */
+    struct heading_est hdg;
+
+    heading_fusion_get(&hdg);
+    if (hdg.ts != 0 && hdg.aligned) {
+        dr_ekf_update_heading(&ekf, wrap360(imu_heading + hdg.offset_deg),
+                              DR_HEADING_SIGMA_DEG);
+    }
+
+    dr_ekf_update_cadence(&ekf, cadence);
+
+    struct gnss_status_msg g;
+
+    if (gnss_new_fix(ts, &g)) {
+        /* est 只有这个线程写，这里读不用锁 */
+        if (est.ts != 0 && est.since_fix_s >= DR_LOG_OUTAGE_S) {
+            LOG_INF("Dead reckoning: GNSS back after %u s, radius was %.0f m",
+                    est.since_fix_s, (double)est.radius_m);
+        }
+        dr_ekf_update_gnss(&ekf, g.lat, g.lon, g.accuracy_m, g.speed_mps, g.heading_deg);
+        fix_used_ts = ts;
+        gave_up = false;
+    }
+
+    if (!ekf.init) {
+        return;
+    }
+
+    struct dr_estimate e = {
+        .ts          = ts,
+        .radius_m    = dr_ekf_radius_m(&ekf),
+        .speed_mps   = ekf.x[DR_V],
+        .heading_deg = dr_ekf_heading_deg(&ekf),
+        .cadence_hz  = cadence,
+        .stride_m    = ekf.x[DR_S],
+        .since_fix_s = timebase_delta_ms(fix_used_ts, ts) / 1000U,
+    };
+
+    dr_ekf_position(&ekf, &e.lat, &e.lon);
+    e.valid = e.radius_m <= DR_MAX_RADIUS_M;
+
+    if (!e.valid && !gave_up) {
+        LOG_WRN("Dead reckoning: radius over %.0f m after %u s without GNSS",
+                (double)DR_MAX_RADIUS_M, e.since_fix_s);
+        gave_up = true;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&dr_lock);
+    est = e;
+    k_spin_unlock(&dr_lock, key);
+}
+
+void dead_reckon_get(struct dr_estimate *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&dr_lock);
+    *out = est;
+    k_spin_unlock(&dr_lock, key);
+}
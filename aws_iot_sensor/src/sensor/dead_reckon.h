@@ -0,0 +1,39 @@
+#ifndef DEAD_RECKON_H_
+#define DEAD_RECKON_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "timebase.h"
+
+/*
+ * GNSS 丢星时的航位推算
+ *
+ * 由 IMU 10 Hz 流水线的一个 AGGREGATE 级逐样本调用，跑一个 5 维 EKF（dr_ekf.h）：
+ * 每个样本预测一步，用 IMU 航向（heading_fusion 学到的偏移加上这个样本的航向）
+ * 和步频（step_cadence.h）更新；GNSS 信箱里有新的 fix 时再用位置 / 速度 / 航向更新。
+ * 丢星（棚里、树下）时只剩 IMU，位置按步频和航向往前推，不确定半径一直长；
+ * IMU 按占空比断电的几秒按断电前的速度和航向推过去。
+ *
+ * dead_reckon_feed 只在 BNO 采集线程里调用；结果快照用 spinlock 保护。
+ */
+
+struct dr_estimate {
+    tb_ts_t  ts;              /* 最近一次更新的 IMU 样本时间，0 = 还没有 */
+    double   lat;
+    double   lon;
+    float    radius_m;        /* 不确定半径（2DRMS，约 95%） */
+    float    speed_mps;
+    float    heading_deg;
+    float    cadence_hz;      /* 0 = 站着 */
+    float    stride_m;        /* 学到的每个步频周期的距离 */
+    uint32_t since_fix_s;     /* 离最近一次用上的 GNSS fix 多久 */
+    bool     valid;           /* 有过 fix，而且半径还没大到没有意义 */
+};
+
+/* IMU 10 Hz 样本：航向 (deg) 和加速度模 (m/s²) */
+void dead_reckon_feed(tb_ts_t ts, float imu_heading, float acc_mag);
+
+void dead_reckon_get(struct dr_estimate *out);
+
+#endif /* DEAD_RECKON_H_ */
@@ -0,0 +1,329 @@
+/* dr_ekf.c
+ *
+ * 航位推算 EKF，见 dr_ekf.h。
+ */
+
+#include "dr_ekf.h"
+
+#include <math.h>
+#include <string.h>
+
+/* ====================== 参数可调 ====================== */
+
+/* 过程噪声（每秒的方差增量） */
+#define DR_Q_POS            0.05f       /* m²/s，模型外的横移 */
+#define DR_Q_PSI_DPS        15.0f       /* deg/√s，转弯 */
+#define DR_Q_ACC            1.0f        /* m/s/√s，加减速 */
+#define DR_Q_STRIDE         0.01f       /* m/√s，步长慢变 */
+
+/* 观测噪声 */
+#define DR_R_SPEED          0.3f        /* GNSS 速度 (m/s) */
+#define DR_R_COURSE_DEG     10.0f       /* GNSS 对地航向 */
+#define DR_R_CADENCE        0.3f        /* 步频折算的速度 (m/s)，步态不规则 */
+#define DR_R_STAND          0.1f        /* 站着（步频 0）时速度 (m/s) */
+#define DR_MIN_ACC_M        2.0f        /* GNSS 给的精度再好也不低于这个 */
+
+/* GNSS 对地航向可用的最低速度 (m/s) */
+#define DR_COURSE_MIN_SPEED 1.0f
+
+/* 初始步长 (m / 步频周期) 和它的标准差 */
+#define DR_STRIDE_INIT      0.8f
+#define DR_STRIDE_SIGMA     0.3f
+#define DR_STRIDE_MIN       0.2f
+#define DR_STRIDE_MAX       3.0f
+
+/* 新息门限（归一化新息平方），超过的观测不用 */
+#define DR_GATE             25.0f
+
+/* GNSS 位置连续被拒绝几次就重置到 fix 上 */
+#define DR_MAX_POS_REJECTS  3
+
+/* 离参考点多远就把参考点挪过来（保持单精度的分辨率） */
+#define DR_REANCHOR_M       2000.0f
+
+#define M_PER_DEG_LAT       111320.0
+#define PI_F                3.14159265f
+#define DEG2RAD             (PI_F / 180.0f)
+#define RAD2DEG             (180.0f / PI_F)
+
+/* ====================== 工具 ====================== */
+
+static float wrap_pi(float a)
+{
+    while (a > PI_F) {
+        a -= 2.0f * PI_F;
+    }
+    while (a < -PI_F) {
+        a += 2.0f * PI_F;
+    }
+    return a;
+}
+
+static void set_anchor(struct dr_ekf *f, double lat, double lon)
+{
+    f->lat0 = lat;
+    f->lon0 = lon;
+    f->m_per_deg_lon = (float)(M_PER_DEG_LAT * cos(lat * (M_PI / 180.0)));
+}
+
+static void to_local(const struct dr_ekf *f, double lat, double lon, float *n, float *e)
+{
+    *n = (float)((lat - f->lat0) * M_PER_DEG_LAT);
+    *e = (float)((lon - f->lon0) * f->m_per_deg_lon);
+}
+
+/* 把参考点挪到当前位置：只动 n / e，协方差不变 */
+static void reanchor(struct dr_ekf *f)
+{
+    double lat, lon;
+
+    dr_ekf_position(f, &lat, &lon);
+    set_anchor(f, lat, lon);
+    f->x[DR_N] = 0.0f;
+    f->x[DR_E] = 0.0f;
+}
+
+static void constrain(struct dr_ekf *f)
+{
+    f->x[DR_PSI] = wrap_pi(f->x[DR_PSI]);
+    if (f->x[DR_V] < 0.0f) {
+        f->x[DR_V] = 0.0f;
+    }
+    if (f->x[DR_S] < DR_STRIDE_MIN) {
+        f->x[DR_S] = DR_STRIDE_MIN;
+    } else if (f->x[DR_S] > DR_STRIDE_MAX) {
+        f->x[DR_S] = DR_STRIDE_MAX;
+    }
+
+    /* 舍入误差会让 P 慢慢不对称 */
+    for (int i = 0; i < DR_NX; i++) {
+        for (int j = i + 1; j < DR_NX; j++) {
+            float m = 0.5f * (f->P[i][j] + f->P[j][i]);
+
+            f->P[i][j] = m;
+            f->P[j][i] = m;
+        }
+    }
+}
+
+/*
+ * 标量观测 z = h·x + 噪声(r)，innov = z - h(x)。
+ * gate 为 true 时新息超过门限返回 false，不更新。
+ */
+static bool update(struct dr_ekf *f, const float h[DR_NX], float innov, float r, bool gate)
+{
+    float ph[DR_NX];
+    float s = r;
+
+    for (int i = 0; i < DR_NX; i++) {
+        ph[i] = 0.0f;
+        for (int j = 0; j < DR_NX; j++) {
+            ph[i] += f->P[i][j] * h[j];
+        }
+        s += h[i] * ph[i];
+    }
+
+    if (s <= 0.0f || (gate && innov * innov > DR_GATE * s)) {
+        return false;
+    }
+
+    for (int i = 0; i < DR_NX; i++) {
+        float k = ph[i] / s;
+
+        f->x[i] += k * innov;
+        for (int j = 0; j < DR_NX; j++) {
+            f->P[i][j] -= k * ph[j];
+        }
+    }
+    constrain(f);
+    return true;
+}
+
+static void reset_to_fix(struct dr_ekf *f, double lat, double lon, float acc,
+                         float speed, float course_deg)
+{
+    bool moving = speed > DR_COURSE_MIN_SPEED;
+    float stride = f->init ? f->x[DR_S] : DR_STRIDE_INIT;
+    float stride_var = f->init ? f->P[DR_S][DR_S] : DR_STRIDE_SIGMA * DR_STRIDE_SIGMA;
+    float psi = f->init ? f->x[DR_PSI] : 0.0f;
+
+    set_anchor(f, lat, lon);
+    memset(f->x, 0, sizeof(f->x));
+    memset(f->P, 0, sizeof(f->P));
+
+    /* 航向：走动时用对地航向，否则保留原来的（IMU 马上会修） */
+    f->x[DR_PSI] = moving ? wrap_pi(course_deg * DEG2RAD) : psi;
+    f->x[DR_V] = speed;
+    f->x[DR_S] = stride;
+
+    f->P[DR_N][DR_N] = acc * acc;
+    f->P[DR_E][DR_E] = acc * acc;
+    f->P[DR_PSI][DR_PSI] = moving ? (DR_R_COURSE_DEG * DEG2RAD) * (DR_R_COURSE_DEG * DEG2RAD) :
+                                    PI_F * PI_F;
+    f->P[DR_V][DR_V] = DR_R_SPEED * DR_R_SPEED;
+    f->P[DR_S][DR_S] = stride_var;
+
+    f->init = true;
+    f->pos_rejects = 0;
+}
+
+/* ====================== 对外接口 ====================== */
+
+void dr_ekf_init(struct dr_ekf *f)
+{
+    memset(f, 0, sizeof(*f));
+}
+
+void dr_ekf_predict(struct dr_ekf *f, float dt_s)
+{
+    if (!f->init || dt_s <= 0.0f) {
+        return;
+    }
+
+    float c = cosf(f->x[DR_PSI]);
+    float s = sinf(f->x[DR_PSI]);
+    float v = f->x[DR_V];
+
+    f->x[DR_N] += v * c * dt_s;
+    f->x[DR_E] += v * s * dt_s;
+
+    /* F = I + A，A 只有 n / e 两行对 psi / v 的偏导 */
+    float F[DR_NX][DR_NX] = { 0 };
+
+    for (int i = 0; i < DR_NX; i++) {
+        F[i][i] = 1.0f;
+    }
+    F[DR_N][DR_PSI] = -v * s * dt_s;
+    F[DR_N][DR_V] = c * dt_s;
+    F[DR_E][DR_PSI] = v * c * dt_s;
+    F[DR_E][DR_V] = s * dt_s;
+
+    /* P = F P F' + Q */
+    float FP[DR_NX][DR_NX];
+
+    for (int i = 0; i < DR_NX; i++) {
+        for (int j = 0; j < DR_NX; j++) {
+            float acc = 0.0f;
+
+            for (int k = 0; k < DR_NX; k++) {
+                acc += F[i][k] * f->P[k][j];
+            }
+            FP[i][j] = acc;
+        }
+    }
+    for (int i = 0; i < DR_NX; i++) {
+        for (int j = 0; j < DR_NX; j++) {
+            float acc = 0.0f;
+
+            for (int k = 0; k < DR_NX; k++) {
+                acc += FP[i][k] * F[j][k];
+            }
+            f->P[i][j] = acc;
+        }
+    }
+
+    f->P[DR_N][DR_N] += DR_Q_POS * dt_s;
+    f->P[DR_E][DR_E] += DR_Q_POS * dt_s;
+    f->P[DR_PSI][DR_PSI] += (DR_Q_PSI_DPS * DEG2RAD) * (DR_Q_PSI_DPS * DEG2RAD) * dt_s;
+    f->P[DR_V][DR_V] += DR_Q_ACC * DR_Q_ACC * dt_s;
+    f->P[DR_S][DR_S] += DR_Q_STRIDE * DR_Q_STRIDE * dt_s;
+
+    constrain(f);
+
+    if (fabsf(f->x[DR_N]) > DR_REANCHOR_M || fabsf(f->x[DR_E]) > DR_REANCHOR_M) {
+        reanchor(f);
+    }
+}
+
+void dr_ekf_update_cadence(struct dr_ekf *f, float cadence_hz)
+{
+    if (!f->init) {
+        return;
+    }
+
+    /* v - s * cadence = 0 */
+    float h[DR_NX] = { 0 };
+    float r = (cadence_hz > 0.0f) ? DR_R_CADENCE : DR_R_STAND;
+
+    h[DR_V] = 1.0f;
+    h[DR_S] = -cadence_hz;
+    (void)update(f, h, -(f->x[DR_V] - f->x[DR_S] * cadence_hz), r * r, true);
+}
+
+void dr_ekf_update_heading(struct dr_ekf *f, float heading_deg, float sigma_deg)
+{
+    if (!f->init) {
+        return;
+    }
+
+    float h[DR_NX] = { 0 };
+    float r = sigma_deg * DEG2RAD;
+
+    h[DR_PSI] = 1.0f;
+    (void)update(f, h, wrap_pi(heading_deg * DEG2RAD - f->x[DR_PSI]), r * r, true);
+}
+
+void dr_ekf_update_gnss(struct dr_ekf *f, double lat, double lon, float acc_m,
+                        float speed_mps, float course_deg)
+{
+    float acc = fmaxf(acc_m, DR_MIN_ACC_M);
+
+    if (!f->init) {
+        reset_to_fix(f, lat, lon, acc, speed_mps, course_deg);
+        return;
+    }
+
+    float n, e;
+    float r = acc * acc;
+    float h[DR_NX] = { 0 };
+
+    to_local(f, lat, lon, &n, &e);
+
+    float dn = n - f->x[DR_N];
+    float de = e - f->x[DR_E];
+
+    /* 北、东一起过门限，不要只更新一半 */
+    if (dn * dn > DR_GATE * (f->P[DR_N][DR_N] + r) ||
+        de * de > DR_GATE * (f->P[DR_E][DR_E] + r)) {
+        /* 推算了很久、偏得太远：几个 fix 都对不上就直接相信 GNSS */
+        if (++f->pos_rejects >= DR_MAX_POS_REJECTS) {
+            reset_to_fix(f, lat, lon, acc, speed_mps, course_deg);
+        }
+        return;
+    }
+
+    h[DR_N] = 1.0f;
+    (void)update(f, h, dn, r, false);
+    h[DR_N] = 0.0f;
+    h[DR_E] = 1.0f;
+    (void)update(f, h, e - f->x[DR_E], r, false);
+    h[DR_E] = 0.0f;
+
+    f->pos_rejects = 0;
+
+    h[DR_V] = 1.0f;
+    (void)update(f, h, speed_mps - f->x[DR_V], DR_R_SPEED * DR_R_SPEED, true);
+    h[DR_V] = 0.0f;
+
+    if (speed_mps > DR_COURSE_MIN_SPEED) {
+        dr_ekf_update_heading(f, course_deg, DR_R_COURSE_DEG);
+    }
+}
+
+void dr_ekf_position(const struct dr_ekf *f, double *lat, double *lon)
+{
+    *lat = f->lat0 + f->x[DR_N] / M_PER_DEG_LAT;
+    *lon = f->lon0 + (f->m_per_deg_lon > 0.0f ? f->x[DR_E] / f->m_per_deg_lon : 0.0);
+}
+
+float dr_ekf_radius_m(const struct dr_ekf *f)
+{
+    return 2.0f * sqrtf(fmaxf(f->P[DR_N][DR_N] + f->P[DR_E][DR_E], 0.0f));
+}
+
+float dr_ekf_heading_deg(const struct dr_ekf *f)
+{
+    float d = f->x[DR_PSI] * RAD2DEG;
+
+    return (d < 0.0f) ? d + 360.0f : d;
+}
@@ -0,0 +1,71 @@
+#ifndef DR_EKF_H_
+#define DR_EKF_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * GNSS / IMU 航位推算的扩展卡尔曼滤波 —— 纯逻辑，不依赖内核，可以在 native_sim / qemu 上测试。
+ *
+ * 状态（5 维，固定大小，不用堆）：
+ *   n, e    相对参考点的北 / 东位移 (m)，参考点是第一个 fix，走远了自动挪
+ *   psi     航向 (rad)，0 = 北，顺时针
+ *   v       水平速度 (m/s)
+ *   s       每个步频周期走多远 (m)，走动时用 GNSS 速度在线学出来
+ *
+ * 预测：n += v cos(psi) dt，e += v sin(psi) dt，航向 / 速度 / 步长随机游走。
+ * 观测（都是标量顺序更新，不用求逆）：
+ *   - GNSS 位置（北、东各一次，R = 精度²），速度，走动时的对地航向；
+ *   - IMU 航向（已经和 GNSS 对齐过的那个）；
+ *   - 步频：v - s x cadence = 0，站着（步频 0）时把速度压到 0，航位推算不会飘走。
+ * GNSS 断了以后只剩 IMU：位置按航向和步频往前推，协方差一直长，
+ * 不确定半径 = 2 x sqrt(Pnn + Pee)（2DRMS，约 95%）。
+ *
+ * 只在一个线程里用，不加锁。单精度浮点（M33 的 FPU），一次预测 + 三次更新约 600 次乘加。
+ */
+
+enum dr_state {
+    DR_N = 0,
+    DR_E,
+    DR_PSI,
+    DR_V,
+    DR_S,
+    DR_NX,
+};
+
+struct dr_ekf {
+    float  x[DR_NX];
+    float  P[DR_NX][DR_NX];
+
+    double lat0;                /* 参考点 */
+    double lon0;
+    float  m_per_deg_lon;
+
+    bool   init;                /* 有过第一个 fix */
+    uint8_t pos_rejects;        /* GNSS 位置连续被门限拒绝的次数 */
+};
+
+void dr_ekf_init(struct dr_ekf *f);
+
+/* 时间往前走 dt_s 秒 */
+void dr_ekf_predict(struct dr_ekf *f, float dt_s);
+
+/* 步频 (Hz)，0 = 站着 */
+void dr_ekf_update_cadence(struct dr_ekf *f, float cadence_hz);
+
+/* 航向观测 (deg，0~360 顺时针)，sigma_deg 是观测噪声 */
+void dr_ekf_update_heading(struct dr_ekf *f, float heading_deg, float sigma_deg);
+
+/*
+ * 一个有效 fix。第一次调用时初始化滤波器；位置连续几次偏得离谱（比如长时间推算以后）
+ * 直接重置到 fix 上。
+ */
+void dr_ekf_update_gnss(struct dr_ekf *f, double lat, double lon, float acc_m,
+                        float speed_mps, float course_deg);
+
+/* 当前位置 / 不确定半径 (m) / 航向 (deg)，init 以前都没有意义 */
+void dr_ekf_position(const struct dr_ekf *f, double *lat, double *lon);
+float dr_ekf_radius_m(const struct dr_ekf *f);
+float dr_ekf_heading_deg(const struct dr_ekf *f);
+
+#endif /* DR_EKF_H_ */
@@ -0,0 +1,160 @@
+/* heading_fusion.c
+ *
+ * IMU / GNSS 航向融合，见 heading_fusion.h。
+ * heading_fusion_feed 只在 BNO 采集线程里调用；结果快照用 spinlock 保护。
+ */
+
+#include "heading_fusion.h"
+#include "mag_cal.h"
+#include "gnss_task.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <math.h>
+
+LOG_MODULE_REGISTER(heading_fusion, LOG_LEVEL_INF);
+
+/* ====================== 参数可调 ====================== */
+
+/* GNSS 航向可用的最低速度（m/s）：马慢走约 1.5 m/s，低于 1 m/s 的航向基本是噪声 */
+#define HDG_GNSS_MIN_SPEED      1.0f
+
+/* 定位和 IMU 样本相差多少以内才用（PVT 1 Hz） */
+#define HDG_GNSS_FRESH_MS       2000
+
+/* IMU 航向变化率超过这个（deg/s）认为在转弯，GNSS 航向滞后，不用 */
+#define HDG_MAX_TURN_DPS        10.0f
+
+/* 每次有效定位把偏移往 GNSS 拉的比例（约 20 次有效定位的时间常数） */
+#define HDG_GAIN                0.05f
+
+/* 单次修正的创新量限幅（deg），一次野值拉不动偏移 */
+#define HDG_MAX_INNOV           30.0f
+
+/* 第一次对齐用多少次有效定位做圆周平均 */
+#define HDG_ALIGN_FIXES         5
+
+/* 两个 1 Hz 样本间隔超过这个认为 IMU 断过电，变化率重新开始 */
+#define HDG_GAP_MS              3000
+
+#define DEG2RAD                 (3.14159265f / 180.0f)
+#define RAD2DEG                 (180.0f / 3.14159265f)
+
+/* ====================== 状态 ====================== */
+
+static float    offset;
+static bool     aligned;
+static float    align_s, align_c;
+static uint8_t  align_n;
+
+static tb_ts_t  last_ts;
+static float    last_imu;
+static tb_ts_t  last_fix_ts;
+
+static struct k_spinlock hdg_lock;
+static struct heading_est est;
+
+static float wrap180(float d)
+{
+    while (d > 180.0f) {
+        d -= 360.0f;
+    }
+    while (d < -180.0f) {
+        d += 360.0f;
+    }
+    return d;
+}
+
+static float wrap360(float d)
+{
+    d = fmodf(d, 360.0f);
+    return (d < 0.0f) ? d + 360.0f : d;
+}
+
+/* 新的一条可用的 GNSS 航向，返回 true 并写到 course */
+static bool gnss_course(tb_ts_t now, float *course)
+{
+    struct gnss_status_msg g;
+
+    if (!gnss_get_latest(&g) || g.ts == 0 || g.ts == last_fix_ts) {
+        return false;
+    }
+    /* 1 Hz 样本的时间戳已经按分频链群延迟往前挪过，定位可能比它还新 */
+    uint32_t age = (g.ts > now) ? timebase_delta_ms(now, g.ts) : timebase_delta_ms(g.ts, now);
+
+    if (age > HDG_GNSS_FRESH_MS) {
+        return false;
+    }
+    last_fix_ts = g.ts;
+
+    if (g.speed_mps < HDG_GNSS_MIN_SPEED) {
+        return false;       /* 站着 / 吃草：冻结偏移 */
+    }
+    *course = g.heading_deg;
+    return true;
+}
+
+/* ====================== 对外接口 ====================== */
+
+void heading_fusion_feed(tb_ts_t ts, float imu_heading)
+{
+    float rate = 0.0f;
+    bool gap = (last_ts == 0 || ts <= last_ts ||
+                timebase_delta_ms(last_ts, ts) > HDG_GAP_MS);
+
+    if (!gap) {
+        rate = wrap180(imu_heading - last_imu) * 1000.0f /
+               timebase_delta_ms(last_ts, ts);
+    }
+    last_ts = ts;
+    last_imu = imu_heading;
+
+    /* 以前对齐过的偏移（mag_cal_init 在开机后才读回来，所以在这里取） */
+    if (!aligned && mag_cal_get_heading_offset(&offset)) {
+        aligned = true;
+        LOG_INF("Heading offset restored: %.1f deg", (double)offset);
+    }
+
+    float course;
+
+    if (!gap && fabsf(rate) < HDG_MAX_TURN_DPS && gnss_course(ts, &course)) {
+        float innov = wrap180(course - (imu_heading + offset));
+
+        if (!aligned) {
+            /* 第一次对齐：偏移角的圆周平均（这时 offset 还是 0） */
+            align_s += sinf(innov * DEG2RAD);
+            align_c += cosf(innov * DEG2RAD);
+            if (++align_n >= HDG_ALIGN_FIXES) {
+                offset = atan2f(align_s, align_c) * RAD2DEG;
+                aligned = true;
+                LOG_INF("Heading aligned to GNSS course: offset %.1f deg",
+                        (double)offset);
+                mag_cal_set_heading_offset(offset);
+            }
+        } else {
+            offset = wrap180(offset + HDG_GAIN *
+                             CLAMP(innov, -HDG_MAX_INNOV, HDG_MAX_INNOV));
+            /* 保存有变化门限和最小间隔，这里每次都交给 mag_cal 判断 */
+            mag_cal_set_heading_offset(offset);
+        }
+    }
+
+    struct heading_est e = {
+        .ts          = ts,
+        .heading_deg = wrap360(imu_heading + offset),
+        .offset_deg  = offset,
+        .rate_dps    = rate,
+        .aligned     = aligned,
+    };
+
+    k_spinlock_key_t key = k_spin_lock(&hdg_lock);
+    est = e;
+    k_spin_unlock(&hdg_lock, key);
+}
+
+void heading_fusion_get(struct heading_est *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&hdg_lock);
+    *out = est;
+    k_spin_unlock(&hdg_lock, key);
+}
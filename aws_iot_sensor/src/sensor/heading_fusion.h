@@ -0,0 +1,39 @@
+#ifndef HEADING_FUSION_H_
+#define HEADING_FUSION_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "timebase.h"
+
+/*
+ * IMU 航向 + GNSS 对地航向的互补融合
+ *
+ * GNSS 的 heading_deg 只有在走动时才有意义，停下来就是噪声；
+ * IMU 的 heading 任何时候都稳，但相对的是磁北，还带着项圈的安装角和残余磁误差。
+ * 这里维护一个偏移：
+ *
+ *   heading = imu_heading + offset
+ *
+ * 有新鲜定位、速度够快、而且 IMU 航向在这一秒里没怎么转（直线走）时，
+ * 用 GNSS 航向和融合航向的差把偏移往回拉一点；其余时间（站着、吃草、原地转圈）
+ * 偏移冻结，航向完全跟 IMU 走。第一次对齐用前几次有效定位的圆周平均，
+ * 之后的偏移保存在 mag_cal 的文件里，重启后直接可用。
+ *
+ * 由 IMU 1 Hz 流水线的一个 DETECT 级调用；结果给航位推算做输入。
+ */
+
+struct heading_est {
+    tb_ts_t ts;               /* 最近一次 IMU 样本的时间，0 = 还没有 */
+    float   heading_deg;      /* 0~360 顺时针；aligned 时相对真北，否则相对磁北 */
+    float   offset_deg;       /* 当前偏移 */
+    float   rate_dps;         /* 航向变化率（1 Hz 差分） */
+    bool    aligned;          /* 偏移是否已经用 GNSS（这次或以前）对齐过 */
+};
+
+/* IMU 1 Hz 样本的 heading（deg） */
+void heading_fusion_feed(tb_ts_t ts, float imu_heading);
+
+void heading_fusion_get(struct heading_est *out);
+
+#endif /* HEADING_FUSION_H_ */
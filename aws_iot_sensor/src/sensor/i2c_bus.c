@@ -0,0 +1,340 @@
+/* i2c_bus.c
+ *
+ * 共享 I2C 总线调度器：
+ * - 各传感器线程把事务指针丢进 i2c_bus_q，由 i2c_bus_thread 串行执行；
+ * - 一次最多取 I2C_BUS_BATCH_MAX 个事务，同一设备、寄存器相邻的读合并成一次 burst；
+ * - 事务失败：i2c_recover_bus()（9 个时钟脉冲 + STOP）→ 仍失败则复位控制器 → 重试一次。
+ */
+
+#include "i2c_bus.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/pm/device.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(i2c_bus, LOG_LEVEL_INF);
+
+/* ====================== 参数可调 ====================== */
+
+/* 队列深度：最多同时挂起多少个事务 */
+#define I2C_BUS_QUEUE_DEPTH      16
+
+/* 总线线程一次最多处理多少个事务（合并窗口） */
+#define I2C_BUS_BATCH_MAX        8
+
+/* 合并后单次 burst read 的最大长度 */
+#define I2C_BUS_MERGE_MAX        32
+
+/* 总线线程配置：优先级要高于所有传感器客户端 */
+#define I2C_BUS_STACK_SIZE       1024
+#define I2C_BUS_PRIORITY         3
+
+K_MSGQ_DEFINE(i2c_bus_q, sizeof(struct i2c_bus_txn *), I2C_BUS_QUEUE_DEPTH, 4);
+
+static struct i2c_bus_stats stats;
+
+/* ====================== 总线恢复 ====================== */
+
+static int bus_reset(const struct device *bus)
+{
+    uint32_t cfg;
+
+    stats.resets++;
+
+#if defined(CONFIG_PM_DEVICE)
+    (void)pm_device_action_run(bus, PM_DEVICE_ACTION_SUSPEND);
+    (void)pm_device_action_run(bus, PM_DEVICE_ACTION_RESUME);
+#endif
+
+    if (i2c_get_config(bus, &cfg) != 0) {
+        cfg = I2C_MODE_CONTROLLER | I2C_SPEED_SET(I2C_SPEED_STANDARD);
+    }
+
+    return i2c_configure(bus, cfg);
+}
+
+static void bus_recover(const struct device *bus)
+{
+    int err;
+
+    /* 先用时钟脉冲把卡住 SDA 的从机释放掉 */
+    stats.recoveries++;
+    err = i2c_recover_bus(bus);
+    if (err == 0) {
+        return;
+    }
+
+    LOG_WRN("%s: bus recovery failed (%d), resetting controller",
+            bus->name, err);
+
+    err = bus_reset(bus);
+    if (err) {
+        LOG_ERR("%s: controller reset failed (%d)", bus->name, err);
+    }
+}
+
+static const struct device *txn_bus(const struct i2c_bus_txn *t)
+{
+    if (t->op == I2C_BUS_OP_CALL) {
+        return NULL;
+    }
+    return t->spec->bus;
+}
+
+/* ====================== 事务执行 ====================== */
+
+static int exec_once(const struct i2c_bus_txn *t, uint8_t *rd_buf, size_t rd_len)
+{
+    switch (t->op) {
+    case I2C_BUS_OP_READ:
+        return i2c_write_read_dt(t->spec, &t->reg, 1, rd_buf, rd_len);
+
+    case I2C_BUS_OP_WRITE: {
+        struct i2c_msg msgs[2] = {
+            {
+                .buf = (uint8_t *)&t->reg,
+                .len = 1,
+                .flags = I2C_MSG_WRITE,
+            },
+            {
+                .buf = t->buf,
+                .len = t->len,
+                .flags = I2C_MSG_WRITE | I2C_MSG_STOP,
+            },
+        };
+        return i2c_transfer_dt(t->spec, msgs, ARRAY_SIZE(msgs));
+    }
+
+    case I2C_BUS_OP_CALL:
+        return t->fn(t->dev);
+
+    default:
+        return -EINVAL;
+    }
+}
+
+/* 执行一次，失败则恢复总线后重试一次 */
+static int exec_with_recovery(struct i2c_bus_txn *t,
+                              uint8_t *rd_buf, size_t rd_len)
+{
+    int err = exec_once(t, rd_buf, rd_len);
+
+    stats.txns++;
+    if (err == 0) {
+        return 0;
+    }
+
+    stats.errors++;
+
+    const struct device *bus = txn_bus(t);
+
+    if (bus != NULL) {
+        LOG_WRN("I2C 0x%02x reg 0x%02x failed (%d), recovering bus",
+                t->spec->addr, t->reg, err);
+        bus_recover(bus);
+    }
+
+    stats.retries++;
+    t->retries++;
+    err = exec_once(t, rd_buf, rd_len);
+    if (err) {
+        stats.errors++;
+    }
+    return err;
+}
+
+static void txn_complete(struct i2c_bus_txn *t, int result)
+{
+    t->result = result;
+    k_sem_give(t->done);
+}
+
+/* 从 batch[i] 开始，能和后面多少个读事务合并（返回合并个数，至少 1） */
+static size_t merge_run(struct i2c_bus_txn **batch, size_t i, size_t n,
+                        size_t *out_len)
+{
+    const struct i2c_bus_txn *first = batch[i];
+    size_t len = first->len;
+    size_t cnt = 1;
+
+    if (first->op != I2C_BUS_OP_READ) {
+        *out_len = len;
+        return 1;
+    }
+
+    while (i + cnt < n) {
+        const struct i2c_bus_txn *next = batch[i + cnt];
+
+        if (next->op != I2C_BUS_OP_READ ||
+            next->spec->bus != first->spec->bus ||
+            next->spec->addr != first->spec->addr ||
+            next->reg != first->reg + len ||
+            len + next->len > I2C_BUS_MERGE_MAX) {
+            break;
+        }
+
+        len += next->len;
+        cnt++;
+    }
+
+    *out_len = len;
+    return cnt;
+}
+
+static void run_batch(struct i2c_bus_txn **batch, size_t n)
+{
+    size_t i = 0;
+
+    while (i < n) {
+        struct i2c_bus_txn *t = batch[i];
+        size_t len;
+        size_t cnt = merge_run(batch, i, n, &len);
+
+        if (cnt == 1) {
+            txn_complete(t, exec_with_recovery(t, t->buf, t->len));
+            i++;
+            continue;
+        }
+
+        /* 合并读：一次 burst 读到临时缓冲，再拆给各个事务 */
+        uint8_t scratch[I2C_BUS_MERGE_MAX];
+        int err = exec_with_recovery(t, scratch, len);
+        size_t off = 0;
+
+        stats.merged += cnt - 1;
+
+        for (size_t k = 0; k < cnt; k++) {
+            struct i2c_bus_txn *m = batch[i + k];
+
+            if (err == 0) {
+                memcpy(m->buf, &scratch[off], m->len);
+            }
+            m->retries = t->retries;
+            off += m->len;
+            txn_complete(m, err);
+        }
+
+        i += cnt;
+    }
+}
+
+/* ====================== 总线线程 ====================== */
+
+static void i2c_bus_thread(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    struct i2c_bus_txn *batch[I2C_BUS_BATCH_MAX];
+
+    while (1) {
+        size_t n = 0;
+
+        /* 第一个事务阻塞等待，后面的能取多少取多少，凑成一批 */
+        (void)k_msgq_get(&i2c_bus_q, &batch[n++], K_FOREVER);
+        while (n < I2C_BUS_BATCH_MAX &&
+               k_msgq_get(&i2c_bus_q, &batch[n], K_NO_WAIT) == 0) {
+            n++;
+        }
+
+        run_batch(batch, n);
+    }
+}
+
+K_THREAD_DEFINE(i2c_bus_thread_id, I2C_BUS_STACK_SIZE, i2c_bus_thread,
+                NULL, NULL, NULL, I2C_BUS_PRIORITY, 0, 0);
+
+/* ====================== 对外接口 ====================== */
+
+int i2c_bus_submit(struct i2c_bus_txn *txns, size_t n)
+{
+    struct k_sem done;
+    int first_err = 0;
+
+    if (n == 0) {
+        return 0;
+    }
+
+    k_sem_init(&done, 0, n);
+
+    for (size_t i = 0; i < n; i++) {
+        struct i2c_bus_txn *t = &txns[i];
+
+        t->done = &done;
+        t->result = -EINPROGRESS;
+        t->retries = 0;
+        (void)k_msgq_put(&i2c_bus_q, &t, K_FOREVER);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        (void)k_sem_take(&done, K_FOREVER);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        if (txns[i].result != 0) {
+            first_err = txns[i].result;
+            break;
+        }
+    }
+
+    return first_err;
+}
+
+int i2c_bus_read(const struct i2c_dt_spec *spec, uint8_t reg,
+                 uint8_t *buf, size_t len)
+{
+    /* 事务里的长度只有 8 位，更长的不截断，直接拒绝 */
+    if (len > UINT8_MAX) {
+        return -EINVAL;
+    }
+
+    struct i2c_bus_txn t = {
+        .op = I2C_BUS_OP_READ,
+        .spec = spec,
+        .reg = reg,
+        .buf = buf,
+        .len = (uint8_t)len,
+    };
+
+    return i2c_bus_submit(&t, 1);
+}
+
+int i2c_bus_write(const struct i2c_dt_spec *spec, uint8_t reg,
+                  const uint8_t *buf, size_t len)
+{
+    if (len > UINT8_MAX) {
+        return -EINVAL;
+    }
+
+    struct i2c_bus_txn t = {
+        .op = I2C_BUS_OP_WRITE,
+        .spec = spec,
+        .reg = reg,
+        .buf = (uint8_t *)buf,
+        .len = (uint8_t)len,
+    };
+
+    return i2c_bus_submit(&t, 1);
+}
+
+int i2c_bus_call(int (*fn)(const struct device *dev),
+                 const struct device *dev)
+{
+    struct i2c_bus_txn t = {
+        .op = I2C_BUS_OP_CALL,
+        .fn = fn,
+        .dev = dev,
+    };
+
+    return i2c_bus_submit(&t, 1);
+}
+
+void i2c_bus_get_stats(struct i2c_bus_stats *out)
+{
+    unsigned int key = irq_lock();
+
+    *out = stats;
+    irq_unlock(key);
+}
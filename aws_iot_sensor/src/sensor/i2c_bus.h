@@ -0,0 +1,77 @@
+#ifndef I2C_BUS_H_
+#define I2C_BUS_H_
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/i2c.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * 共享 I2C 总线调度器
+ *
+ * BNO055 / BME280 挂在同一个 I2C 控制器上，但由不同线程访问。
+ * 所有传感器客户端都把事务提交到这里，由一个总线线程按顺序执行：
+ *  - 同一设备、寄存器地址相邻的读事务会被合并成一次 burst read；
+ *  - 遇到 NAK / 超时 / SDA 卡死时，先发时钟脉冲恢复总线，
+ *    仍然失败就复位控制器，然后重试一次。
+ */
+
+/* 事务类型 */
+enum i2c_bus_op {
+    I2C_BUS_OP_READ = 0,   /* 从 reg 开始读 len 字节 */
+    I2C_BUS_OP_WRITE,      /* 往 reg 写 len 字节 */
+    I2C_BUS_OP_CALL,       /* 在总线线程里调用驱动函数；会占住总线线程，里面不能睡 */
+};
+
+struct i2c_bus_txn {
+    enum i2c_bus_op op;
+    const struct i2c_dt_spec *spec;   /* READ / WRITE 使用 */
+    uint8_t  reg;
+    uint8_t *buf;
+    uint8_t  len;
+
+    int (*fn)(const struct device *dev);  /* CALL 使用 */
+    const struct device *dev;
+
+    /* 以下由调度器填写 */
+    int result;
+    uint8_t retries;        /* 这次事务被重试的次数（健康统计用） */
+    struct k_sem *done;
+};
+
+/* 总线统计（所有客户端合计） */
+struct i2c_bus_stats {
+    uint32_t txns;          /* 执行的事务数 */
+    uint32_t merged;        /* 被合并掉的读事务数 */
+    uint32_t errors;        /* 失败次数（含重试前） */
+    uint32_t retries;       /* 重试次数 */
+    uint32_t recoveries;    /* 总线恢复（时钟脉冲）次数 */
+    uint32_t resets;        /* 控制器复位次数 */
+};
+
+/* 同步读 / 写：提交后阻塞等待总线线程执行完成；len 超过 255 返回 -EINVAL */
+int i2c_bus_read(const struct i2c_dt_spec *spec, uint8_t reg,
+                 uint8_t *buf, size_t len);
+int i2c_bus_write(const struct i2c_dt_spec *spec, uint8_t reg,
+                  const uint8_t *buf, size_t len);
+
+static inline int i2c_bus_write8(const struct i2c_dt_spec *spec,
+                                 uint8_t reg, uint8_t val)
+{
+    return i2c_bus_write(spec, reg, &val, 1);
+}
+
+/* 在总线线程中串行执行驱动调用，避免和其他客户端的裸 I2C 事务冲突 */
+int i2c_bus_call(int (*fn)(const struct device *dev),
+                 const struct device *dev);
+
+/*
+ * 一次提交多个事务（例如一个传感器的多个寄存器块），
+ * 相邻寄存器的读会被合并。返回第一个失败事务的错误码，全部成功返回 0。
+ */
+int i2c_bus_submit(struct i2c_bus_txn *txns, size_t n);
+
+void i2c_bus_get_stats(struct i2c_bus_stats *out);
+
+#endif /* I2C_BUS_H_ */
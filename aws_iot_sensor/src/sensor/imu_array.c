@@ -0,0 +1,173 @@
+/* imu_array.c
+ *
+ * 多 IMU 设备表、共享环形缓冲和左右肢对称性，见 imu_array.h。
+ */
+
+#include "imu_array.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <math.h>
+
+LOG_MODULE_REGISTER(imu_array, LOG_LEVEL_INF);
+
+/* ====================== 参数可调 ====================== */
+
+/* 环形缓冲帧数（10 Hz 下约 6 s） */
+#define IMU_RING_LEN        64
+
+/* 对称性窗口帧数，至少覆盖一个步幅周期 */
+#define SYM_WINDOW          20
+
+/* 摆幅太小（站着不动）不算对称性，单位 1/16 deg */
+#define SYM_MIN_SWING       (2 * 16)
+
+/* ====================== 设备表 ====================== */
+
+BUILD_ASSERT(DT_NODE_HAS_STATUS(IMU_PRIMARY_NODE, okay),
+             "bno055 node label is the withers IMU and must be enabled");
+BUILD_ASSERT(IMU_COUNT <= 8, "imu_frame.valid is an 8-bit mask");
+
+#define IMU_SPEC_IF_LEG(node)                                       \
+    COND_CODE_1(DT_SAME_NODE(node, IMU_PRIMARY_NODE), (),           \
+                (I2C_DT_SPEC_GET(node),))
+
+#define IMU_NAME_IF_LEG(node)                                       \
+    COND_CODE_1(DT_SAME_NODE(node, IMU_PRIMARY_NODE), (),           \
+                (DT_NODE_FULL_NAME(node),))
+
+const struct i2c_dt_spec imu_specs[IMU_COUNT] = {
+    I2C_DT_SPEC_GET(IMU_PRIMARY_NODE),
+    DT_FOREACH_STATUS_OKAY(bosch_bno055, IMU_SPEC_IF_LEG)
+};
+
+static const char *const imu_names[IMU_COUNT] = {
+    DT_NODE_FULL_NAME(IMU_PRIMARY_NODE),
+    DT_FOREACH_STATUS_OKAY(bosch_bno055, IMU_NAME_IF_LEG)
+};
+
+const char *imu_name(int idx)
+{
+    return (idx >= 0 && idx < IMU_COUNT) ? imu_names[idx] : "?";
+}
+
+/* ====================== 环形缓冲 ====================== */
+
+static struct k_spinlock ring_lock;
+static struct imu_frame ring[IMU_RING_LEN];
+static uint32_t ring_head;     /* 下一个写位置（单调递增） */
+static uint32_t ring_tail;     /* 下一个读位置（单调递增） */
+static uint32_t ring_overruns;
+
+/* ====================== 对称性 ====================== */
+
+#define LEG_COUNT   (IMU_COUNT - 1)
+#define PAIR_COUNT  (LEG_COUNT / 2)
+
+static int16_t sym_min[IMU_COUNT];
+static int16_t sym_max[IMU_COUNT];
+static uint16_t sym_n;
+static float sym_value;
+
+static void symmetry_update(const struct imu_frame *fr)
+{
+    if (PAIR_COUNT == 0) {
+        return;
+    }
+
+    if (sym_n == 0) {
+        for (int i = 1; i < IMU_COUNT; i++) {
+            sym_min[i] = INT16_MAX;
+            sym_max[i] = INT16_MIN;
+        }
+    }
+
+    /* 第二个分量是 roll，第三个是 pitch；腿部摆动看 pitch */
+    for (int i = 1; i < IMU_COUNT; i++) {
+        int16_t p = fr->eul[i][2];
+
+        if (fr->valid & BIT(i)) {
+            sym_min[i] = MIN(sym_min[i], p);
+            sym_max[i] = MAX(sym_max[i], p);
+        }
+    }
+
+    if (++sym_n < SYM_WINDOW) {
+        return;
+    }
+    sym_n = 0;
+
+    float worst = -1.0f;
+
+    for (int k = 0; k < PAIR_COUNT; k++) {
+        int l = 1 + 2 * k;
+        int r = l + 1;
+
+        if (sym_max[l] < sym_min[l] || sym_max[r] < sym_min[r]) {
+            continue;   /* 这个窗口里有一条腿没读到 */
+        }
+
+        float al = sym_max[l] - sym_min[l];
+        float ar = sym_max[r] - sym_min[r];
+
+        if (al < SYM_MIN_SWING && ar < SYM_MIN_SWING) {
+            continue;   /* 这一对都没怎么动 */
+        }
+
+        float si = fabsf(al - ar) / ((al + ar) * 0.5f);
+
+        worst = MAX(worst, si);
+    }
+
+    if (worst >= 0.0f) {
+        sym_value = (sym_value == 0.0f) ? worst : sym_value * 0.8f + worst * 0.2f;
+    }
+}
+
+/* ====================== 对外接口 ====================== */
+
+void imu_ring_put(const struct imu_frame *fr)
+{
+    k_spinlock_key_t key = k_spin_lock(&ring_lock);
+
+    if (ring_head - ring_tail >= IMU_RING_LEN) {
+        ring_tail++;
+        ring_overruns++;
+    }
+    ring[ring_head % IMU_RING_LEN] = *fr;
+    ring_head++;
+
+    symmetry_update(fr);
+
+    k_spin_unlock(&ring_lock, key);
+}
+
+bool imu_ring_get(struct imu_frame *fr)
+{
+    bool got = false;
+
+    k_spinlock_key_t key = k_spin_lock(&ring_lock);
+
+    if (ring_tail != ring_head) {
+        *fr = ring[ring_tail % IMU_RING_LEN];
+        ring_tail++;
+        got = true;
+    }
+
+    k_spin_unlock(&ring_lock, key);
+    return got;
+}
+
+uint32_t imu_ring_overruns(void)
+{
+    return ring_overruns;
+}
+
+float imu_array_symmetry(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&ring_lock);
+    float v = sym_value;
+
+    k_spin_unlock(&ring_lock, key);
+    return v;
+}
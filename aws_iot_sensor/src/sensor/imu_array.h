@@ -0,0 +1,59 @@
+#ifndef IMU_ARRAY_H_
+#define IMU_ARRAY_H_
+
+#include <zephyr/kernel.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/i2c.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "timebase.h"
+
+/*
+ * 多 IMU（鬐甲 + 四肢）
+ *
+ * 设备树里所有 status = "okay" 的 bosch,bno055 节点都会被采集：
+ *  - 节点标签 bno055 固定是 0 号（鬐甲），平衡判断 / 步态抓拍只看它；
+ *  - 其余节点按实例顺序排在后面，两两一组当作左右肢：
+ *    1/2 = 左前 / 右前，3/4 = 左后 / 右后。
+ * 可以挂在不同的 I2C 总线上，由 i2c_bus 调度器统一排队。
+ *
+ * 采集线程（sensor.c）把所有 IMU 一次性提交给总线调度器背靠背读完，整轮共用一个时间戳。
+ * 环形缓冲是 10 Hz：鬐甲 IMU 取分频链（decimator.h）10 Hz 级别的输出，
+ * 腿部 IMU 每 100 ms 读一次原值。
+ */
+
+#define IMU_PRIMARY_NODE DT_NODELABEL(bno055)
+
+#define IMU_COUNT DT_NUM_INST_STATUS_OKAY(bosch_bno055)
+
+/* 一帧：所有 IMU 同一轮读到的 heading / roll / pitch（1/16 deg 原始值） */
+struct imu_frame {
+    tb_ts_t  ts;          /* 本轮开始和结束的中点 */
+    uint16_t skew_us;     /* 本轮第一个到最后一个 IMU 的读耗时 */
+    uint8_t  valid;       /* 每个 IMU 一位：本轮是否读到 */
+    int16_t  eul[IMU_COUNT][3];
+};
+
+/* 按上面的顺序展开的 I2C 设备表 */
+extern const struct i2c_dt_spec imu_specs[IMU_COUNT];
+
+const char *imu_name(int idx);
+
+/* 采集线程调用：压入一帧（满了覆盖最旧的）并更新对称性指标 */
+void imu_ring_put(const struct imu_frame *fr);
+
+/* 消费者调用：按顺序取一帧，没有新帧返回 false */
+bool imu_ring_get(struct imu_frame *fr);
+
+/* 环形缓冲被覆盖掉的帧数 */
+uint32_t imu_ring_overruns(void);
+
+/*
+ * 左右肢对称性：每个窗口内各肢 pitch 摆幅 A，
+ * 每对算 |A_l - A_r| / ((A_l + A_r) / 2)，取最差的一对，再做指数平滑。
+ * 0 = 完全对称；没有成对的腿部 IMU 时返回 0。
+ */
+float imu_array_symmetry(void);
+
+#endif /* IMU_ARRAY_H_ */
@@ -0,0 +1,208 @@
+/* imu_fusion.c
+ *
+ * 采集线程用的原始数据换算 / Mahony 更新 / 统计，见 imu_fusion.h；滤波器本身在 mahony.c。
+ * imu_fusion_run / imu_fusion_compare 只在 BNO 采集线程里调用；
+ * 统计快照用 spinlock 保护，给其他线程读。
+ */
+
+#include "imu_fusion.h"
+#include "mag_cal.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <math.h>
+#include <string.h>
+
+#if defined(CONFIG_TIMING_FUNCTIONS)
+#include <zephyr/timing/timing.h>
+#endif
+
+LOG_MODULE_REGISTER(imu_fusion, LOG_LEVEL_INF);
+
+/* ====================== 参数可调 ====================== */
+
+/* 比例 / 积分增益：Kp 越大越信加速度计（收敛快、抖动大），Ki 吃掉陀螺零偏 */
+#define MAHONY_KP           1.0f
+#define MAHONY_KI           0.02f
+
+/* 两次更新间隔超过这个（s）认为 IMU 断过电，滤波器重新收敛 */
+#define FUSION_GAP_S        1.0f
+
+/* 统计窗口：每这么多个样本打印一次并更新快照 */
+#define FUSION_LOG_EVERY    600
+
+/* BNO055 默认单位下的 LSB：加速度 1 m/s2 = 100，磁场 1 uT = 16，角速度 1 dps = 16 */
+#define BNO_GYR_LSB_PER_RAD (16.0f * 180.0f / 3.14159265f)
+
+/* ====================== 采集线程接口 ====================== */
+
+static struct mahony filt[IMU_COUNT];
+static tb_ts_t last_ts[IMU_COUNT];
+
+/* 当前统计窗口的累计值 */
+static uint32_t win_samples;
+static uint64_t win_cyc;
+static uint32_t win_cyc_max;
+static uint32_t win_cmp;
+static float    win_err2[3];
+
+static uint32_t total_samples;
+
+static struct k_spinlock stats_lock;
+static struct imu_fusion_stats stats;
+
+static int16_t le16(const uint8_t *p)
+{
+    return (int16_t)((p[1] << 8) | p[0]);
+}
+
+void imu_fusion_reset(void)
+{
+    for (int i = 0; i < IMU_COUNT; i++) {
+        mahony_init(&filt[i], MAHONY_KP, MAHONY_KI);
+        last_ts[i] = 0;
+    }
+
+#if defined(CONFIG_TIMING_FUNCTIONS)
+    static bool timing_ready;
+
+    if (!timing_ready) {
+        timing_init();
+        timing_start();
+        timing_ready = true;
+    }
+#endif
+}
+
+static void publish_window(void)
+{
+    struct imu_fusion_stats s = { 0 };
+
+    s.samples  = total_samples;
+    s.cyc_avg  = win_samples ? (uint32_t)(win_cyc / win_samples) : 0;
+    s.cyc_max  = win_cyc_max;
+    s.compared = win_cmp;
+#if defined(CONFIG_TIMING_FUNCTIONS)
+    s.ns_avg   = (uint32_t)timing_cycles_to_ns(s.cyc_avg);
+#else
+    s.ns_avg   = (uint32_t)k_cyc_to_ns_floor64(s.cyc_avg);
+#endif
+    if (win_cmp > 0) {
+        s.rms_heading = sqrtf(win_err2[0] / win_cmp);
+        s.rms_roll    = sqrtf(win_err2[1] / win_cmp);
+        s.rms_pitch   = sqrtf(win_err2[2] / win_cmp);
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+    stats = s;
+    k_spin_unlock(&stats_lock, key);
+
+    if (win_cmp > 0) {
+        LOG_INF("Mahony vs NDOF RMS h=%.2f r=%.2f p=%.2f deg, %u cyc/sample (max %u, %u ns)",
+                (double)s.rms_heading, (double)s.rms_roll, (double)s.rms_pitch,
+                s.cyc_avg, s.cyc_max, s.ns_avg);
+    } else {
+        LOG_INF("Mahony %u cyc/sample (max %u, %u ns)", s.cyc_avg, s.cyc_max, s.ns_avg);
+    }
+
+    win_samples = 0;
+    win_cyc = 0;
+    win_cyc_max = 0;
+    win_cmp = 0;
+    memset(win_err2, 0, sizeof(win_err2));
+}
+
+void imu_fusion_run(int idx, const uint8_t raw[IMU_RAW_LEN], tb_ts_t ts,
+                    int16_t eul_out[3])
+{
+    struct mahony *m = &filt[idx];
+    float dt = 0.0f;
+
+    if (last_ts[idx] != 0 && ts > last_ts[idx]) {
+        dt = timebase_delta_us(last_ts[idx], ts) / 1e6f;
+    }
+    if (dt <= 0.0f || dt > FUSION_GAP_S) {
+        /* 第一帧或断过电：滤波器重新按第一个样本对齐重力 / 磁北 */
+        if (dt > FUSION_GAP_S) {
+            mahony_init(m, MAHONY_KP, MAHONY_KI);
+        }
+        dt = 0.01f;
+    }
+    last_ts[idx] = ts;
+
+    /* 寄存器顺序 ACC x y z, MAG x y z, GYR x y z */
+    int16_t mag_raw[3] = { le16(&raw[6]), le16(&raw[8]), le16(&raw[10]) };
+    float mag[3] = { mag_raw[0], mag_raw[1], mag_raw[2] };
+
+    /* AMG 模式下鬐甲 IMU 的磁场先过在线硬铁 / 软铁校准（NDOF 对比时芯片自己在校准） */
+    if (idx == 0 && IS_ENABLED(CONFIG_HORSE_IMU_MAHONY_MAG)) {
+        mag_cal_feed(mag_raw);
+        mag_cal_apply(mag_raw, mag);
+    }
+
+#if defined(CONFIG_TIMING_FUNCTIONS)
+    timing_t c0 = timing_counter_get();
+#else
+    uint32_t c0 = k_cycle_get_32();
+#endif
+
+    mahony_update(m,
+                  le16(&raw[12]) / BNO_GYR_LSB_PER_RAD,
+                  le16(&raw[14]) / BNO_GYR_LSB_PER_RAD,
+                  le16(&raw[16]) / BNO_GYR_LSB_PER_RAD,
+                  le16(&raw[0]), le16(&raw[2]), le16(&raw[4]),
+                  mag[0], mag[1], mag[2], dt);
+
+    float h, r, p;
+
+    mahony_euler(m, &h, &r, &p);
+
+#if defined(CONFIG_TIMING_FUNCTIONS)
+    timing_t c1 = timing_counter_get();
+    uint32_t cyc = (uint32_t)timing_cycles_get(&c0, &c1);
+#else
+    uint32_t cyc = k_cycle_get_32() - c0;
+#endif
+
+    eul_out[0] = (int16_t)lroundf(h * 16.0f);
+    eul_out[1] = (int16_t)lroundf(r * 16.0f);
+    eul_out[2] = (int16_t)lroundf(p * 16.0f);
+
+    total_samples++;
+    win_samples++;
+    win_cyc += cyc;
+    win_cyc_max = MAX(win_cyc_max, cyc);
+
+    if (win_samples >= FUSION_LOG_EVERY) {
+        publish_window();
+    }
+}
+
+/* 角度差折到 ±180（heading 跨 0/360、pitch 跨 ±180） */
+static float wrap180(float d)
+{
+    while (d > 180.0f) {
+        d -= 360.0f;
+    }
+    while (d < -180.0f) {
+        d += 360.0f;
+    }
+    return d;
+}
+
+void imu_fusion_compare(const int16_t mcu[3], const int16_t ndof[3])
+{
+    for (int c = 0; c < 3; c++) {
+        float d = wrap180((mcu[c] - ndof[c]) / 16.0f);
+
+        win_err2[c] += d * d;
+    }
+    win_cmp++;
+}
+
+void imu_fusion_get_stats(struct imu_fusion_stats *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+    *out = stats;
+    k_spin_unlock(&stats_lock, key);
+}
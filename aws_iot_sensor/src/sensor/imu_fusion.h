@@ -0,0 +1,54 @@
+#ifndef IMU_FUSION_H_
+#define IMU_FUSION_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "timebase.h"
+#include "imu_array.h"
+#include "mahony.h"
+
+/*
+ * MCU 端姿态融合（Mahony 互补滤波）
+ *
+ * NDOF 模式下 BNO055 内部的融合 MCU + 高速磁力计一直在跑，是项圈电流的大头。
+ * CONFIG_HORSE_IMU_FUSION_MAHONY 时 BNO055 只出原始数据（AMG 或 ACCGYRO 模式，
+ * 磁力计低功耗），由这里在 nRF91 应用核上算姿态，输出和 NDOF 一样的
+ * 1/16 deg 欧拉角，下游（平衡、疝痛、呼吸、抓拍）不用改。
+ *
+ * 欧拉角按 BNO055 Windows 方向约定换算：heading 0~360 顺时针，
+ * roll 绕 Y 轴 ±90，pitch 绕 X 轴 ±180。
+ *
+ * CONFIG_HORSE_IMU_FUSION_COMPARE（只在 NDOF 下）：鬐甲 IMU 同时读原始数据跑一遍
+ * Mahony，和 NDOF 输出比较，定期打印各角 RMS 误差和每样本 CPU 周期数。
+ */
+
+/* ====================== 采集线程接口 ====================== */
+
+/* BNO055 ACC / MAG / GYR 数据寄存器连续 18 字节 */
+#define IMU_RAW_LEN 18
+
+/* IMU 上电重新初始化后调用，所有滤波器从头收敛 */
+void imu_fusion_reset(void);
+
+/* 用一块原始数据更新 idx 号 IMU 的滤波器，输出 1/16 deg 欧拉角 */
+void imu_fusion_run(int idx, const uint8_t raw[IMU_RAW_LEN], tb_ts_t ts,
+                    int16_t eul_out[3]);
+
+/* 对比模式：累计 MCU 结果和 NDOF 结果的误差 */
+void imu_fusion_compare(const int16_t mcu[3], const int16_t ndof[3]);
+
+struct imu_fusion_stats {
+    uint32_t samples;     /* imu_fusion_run 调用次数 */
+    uint32_t cyc_avg;     /* 每样本平均 CPU 周期 */
+    uint32_t cyc_max;
+    uint32_t ns_avg;      /* 换算成 ns */
+    uint32_t compared;    /* 参与对比的样本数 */
+    float rms_heading;    /* 对 NDOF 的 RMS 误差（deg） */
+    float rms_roll;
+    float rms_pitch;
+};
+
+void imu_fusion_get_stats(struct imu_fusion_stats *out);
+
+#endif /* IMU_FUSION_H_ */
@@ -0,0 +1,351 @@
+/* mag_cal.c
+ *
+ * 磁力计校准 + 持久化，见 mag_cal.h。
+ * 校准状态（cal）在 BNO 采集线程里改，保存工作项在系统工作队列里读，
+ * 两边用 spinlock 拷贝；偏移 / 比例模型只在采集线程里用，不加锁。
+ */
+
+#include "mag_cal.h"
+#include "app_fs.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(mag_cal, LOG_LEVEL_INF);
+
+/* ====================== 参数可调 ====================== */
+
+#define MAG_CAL_PATH            APP_FS_MNT "/mag_cal.bin"
+
+#define MAG_CAL_MAGIC           0x4D43414C /* "MCAL" */
+#define MAG_CAL_VERSION         1
+
+/* 地磁场 25~65 uT；超过 200 uT 的读数是磁铁 / 电机贴近，不进包络 */
+#define MAG_CAL_MAX_LSB         (200 * 16)
+
+/* 一个轴的包络跨度至少这么大（20 uT）才算转过足够的角度，偏移可信 */
+#define MAG_CAL_MIN_SPAN        (20 * 16)
+
+/* 包络收缩：每这么多个样本两端各收 1 LSB（100 Hz 下约每分钟一次） */
+#define MAG_CAL_DECAY_EVERY     6000
+
+/* 包络和上次保存相比变化超过这个（1 uT）才重新保存 */
+#define MAG_CAL_SAVE_DELTA      16
+
+/* 两次写 flash 的最小间隔 */
+#define MAG_CAL_SAVE_MIN_MS     (10 * 60 * 1000)
+
+/* BNO 偏移配置：已经有一份时，隔这么久才再读一次 */
+#define MAG_CAL_BNO_REFRESH_MS  (60 * 60 * 1000)
+
+/* 航向偏移变化超过这个（deg）才重新保存 */
+#define MAG_CAL_HEADING_DELTA   1.0f
+
+/* ====================== 状态 ====================== */
+
+#define CAL_F_BNO       BIT(0)
+#define CAL_F_ENV       BIT(1)
+#define CAL_F_HEADING   BIT(2)
+
+/* 持久化到 MAG_CAL_PATH */
+struct mag_cal_file {
+    uint32_t magic;
+    uint16_t version;
+    uint8_t  flags;
+    uint8_t  reserved;
+    uint8_t  bno_profile[MAG_CAL_BNO_PROFILE_LEN];
+    int16_t  env_min[3];
+    int16_t  env_max[3];
+    float    heading_offset;
+};
+
+static struct k_spinlock cal_lock;
+static struct mag_cal_file cal = {
+    .magic = MAG_CAL_MAGIC, .version = MAG_CAL_VERSION,
+};
+
+/* mag_cal_init 装入新校准后置位，采集线程下一次 feed 时重算模型 */
+static atomic_t reload;
+
+/* 以下只在采集线程里用 */
+static float    off[3];
+static float    scale[3] = { 1.0f, 1.0f, 1.0f };
+static uint8_t  axis_ok;
+static uint32_t decay_cnt;
+static int16_t  saved_min[3];
+static int16_t  saved_max[3];
+static int64_t  bno_saved_ms;
+static int64_t  next_save_ms;
+
+static void save_work_fn(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(save_work, save_work_fn);
+
+/* ====================== 保存 ====================== */
+
+static void save_work_fn(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    struct mag_cal_file f;
+
+    k_spinlock_key_t key = k_spin_lock(&cal_lock);
+    f = cal;
+    k_spin_unlock(&cal_lock, key);
+
+    int err = app_fs_write_file(MAG_CAL_PATH, &f, sizeof(f));
+
+    if (err) {
+        LOG_ERR("mag cal save failed (%d)", err);
+    } else {
+        LOG_INF("Mag cal saved (flags 0x%02x)", f.flags);
+    }
+}
+
+/* 排一次保存，和上一次至少隔 MAG_CAL_SAVE_MIN_MS；已经排上的不重复排 */
+static void request_save(void)
+{
+    if (!app_fs_ready()) {
+        return;
+    }
+
+    int64_t now = k_uptime_get();
+    int64_t due = MAX(next_save_ms, now);
+
+    if (k_work_schedule(&save_work, K_MSEC(due - now)) == 1) {
+        next_save_ms = due + MAG_CAL_SAVE_MIN_MS;
+    }
+}
+
+/* ====================== 包络 → 偏移 / 比例 ====================== */
+
+static void update_model(const int16_t *mn, const int16_t *mx)
+{
+    float r[3];
+
+    axis_ok = 0;
+    for (int c = 0; c < 3; c++) {
+        int32_t span = mx[c] - mn[c];
+
+        off[c] = (mx[c] + mn[c]) * 0.5f;
+        r[c] = span * 0.5f;
+        if (span >= MAG_CAL_MIN_SPAN) {
+            axis_ok |= BIT(c);
+        }
+    }
+
+    /* 软铁比例要三个轴都转够了才算（竖直轴在马身上往往转不全，这时只做硬铁） */
+    float avg = (r[0] + r[1] + r[2]) / 3.0f;
+
+    for (int c = 0; c < 3; c++) {
+        scale[c] = (axis_ok == 0x7) ? avg / r[c] : 1.0f;
+    }
+}
+
+static bool env_moved(const int16_t *mn, const int16_t *mx)
+{
+    for (int c = 0; c < 3; c++) {
+        if (abs(mn[c] - saved_min[c]) > MAG_CAL_SAVE_DELTA ||
+            abs(mx[c] - saved_max[c]) > MAG_CAL_SAVE_DELTA) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* ====================== 对外接口 ====================== */
+
+int mag_cal_init(void)
+{
+    struct mag_cal_file f;
+
+    if (!app_fs_ready()) {
+        return -ENODEV;
+    }
+
+    int err = app_fs_read_file(MAG_CAL_PATH, &f, sizeof(f));
+
+    if (err == -ENOENT) {
+        return 0;           /* 第一次上电 */
+    }
+    if (err || f.magic != MAG_CAL_MAGIC || f.version != MAG_CAL_VERSION) {
+        LOG_WRN("Mag cal file invalid (%d), starting over", err);
+        return 0;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&cal_lock);
+    cal = f;
+    k_spin_unlock(&cal_lock, key);
+    atomic_set(&reload, 1);
+
+    LOG_INF("Mag cal loaded (flags 0x%02x, heading offset %.1f deg)",
+            f.flags, (double)f.heading_offset);
+    return 0;
+}
+
+void mag_cal_feed(const int16_t raw[3])
+{
+    int16_t mn[3], mx[3];
+    bool changed = false;
+
+    if (atomic_cas(&reload, 1, 0)) {
+        k_spinlock_key_t key = k_spin_lock(&cal_lock);
+        memcpy(mn, cal.env_min, sizeof(mn));
+        memcpy(mx, cal.env_max, sizeof(mx));
+        bool have = (cal.flags & CAL_F_ENV) != 0;
+        k_spin_unlock(&cal_lock, key);
+
+        if (have) {
+            memcpy(saved_min, mn, sizeof(mn));
+            memcpy(saved_max, mx, sizeof(mx));
+            update_model(mn, mx);
+        }
+    }
+
+    if (raw[0] == 0 && raw[1] == 0 && raw[2] == 0) {
+        return;
+    }
+    for (int c = 0; c < 3; c++) {
+        if (abs(raw[c]) > MAG_CAL_MAX_LSB) {
+            return;
+        }
+    }
+
+    bool decay = (++decay_cnt >= MAG_CAL_DECAY_EVERY);
+
+    if (decay) {
+        decay_cnt = 0;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&cal_lock);
+    if (!(cal.flags & CAL_F_ENV)) {
+        memcpy(cal.env_min, raw, sizeof(cal.env_min));
+        memcpy(cal.env_max, raw, sizeof(cal.env_max));
+        cal.flags |= CAL_F_ENV;
+    }
+    for (int c = 0; c < 3; c++) {
+        if (raw[c] < cal.env_min[c]) {
+            cal.env_min[c] = raw[c];
+            changed = true;
+        }
+        if (raw[c] > cal.env_max[c]) {
+            cal.env_max[c] = raw[c];
+            changed = true;
+        }
+        /* 收缩到最小跨度为止，长时间不动也不会把包络收没 */
+        if (decay && cal.env_max[c] - cal.env_min[c] > MAG_CAL_MIN_SPAN + 2) {
+            cal.env_min[c]++;
+            cal.env_max[c]--;
+            changed = true;
+        }
+    }
+    memcpy(mn, cal.env_min, sizeof(mn));
+    memcpy(mx, cal.env_max, sizeof(mx));
+    k_spin_unlock(&cal_lock, key);
+
+    if (!changed) {
+        return;
+    }
+
+    uint8_t was_ok = axis_ok;
+
+    update_model(mn, mx);
+    if (axis_ok != was_ok) {
+        LOG_INF("Mag cal axes 0x%x (off %d %d %d)",
+                axis_ok, (int)off[0], (int)off[1], (int)off[2]);
+    }
+
+    if (axis_ok && env_moved(mn, mx)) {
+        memcpy(saved_min, mn, sizeof(mn));
+        memcpy(saved_max, mx, sizeof(mx));
+        request_save();
+    }
+}
+
+void mag_cal_apply(const int16_t raw[3], float out[3])
+{
+    for (int c = 0; c < 3; c++) {
+        out[c] = (axis_ok & BIT(c)) ? (raw[c] - off[c]) * scale[c] : (float)raw[c];
+    }
+}
+
+bool mag_cal_get_bno_profile(uint8_t prof[MAG_CAL_BNO_PROFILE_LEN])
+{
+    bool have;
+
+    k_spinlock_key_t key = k_spin_lock(&cal_lock);
+    have = (cal.flags & CAL_F_BNO) != 0;
+    if (have) {
+        memcpy(prof, cal.bno_profile, MAG_CAL_BNO_PROFILE_LEN);
+    }
+    k_spin_unlock(&cal_lock, key);
+
+    return have;
+}
+
+bool mag_cal_bno_profile_wanted(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&cal_lock);
+    bool have = (cal.flags & CAL_F_BNO) != 0;
+    k_spin_unlock(&cal_lock, key);
+
+    return !have || k_uptime_get() - bno_saved_ms >= MAG_CAL_BNO_REFRESH_MS;
+}
+
+void mag_cal_set_bno_profile(const uint8_t prof[MAG_CAL_BNO_PROFILE_LEN])
+{
+    bool same;
+
+    bno_saved_ms = k_uptime_get();
+
+    k_spinlock_key_t key = k_spin_lock(&cal_lock);
+    same = (cal.flags & CAL_F_BNO) &&
+           memcmp(cal.bno_profile, prof, MAG_CAL_BNO_PROFILE_LEN) == 0;
+    memcpy(cal.bno_profile, prof, MAG_CAL_BNO_PROFILE_LEN);
+    cal.flags |= CAL_F_BNO;
+    k_spin_unlock(&cal_lock, key);
+
+    if (!same) {
+        LOG_INF("BNO055 calibration profile captured");
+        request_save();
+    }
+}
+
+bool mag_cal_get_heading_offset(float *deg)
+{
+    bool have;
+
+    k_spinlock_key_t key = k_spin_lock(&cal_lock);
+    have = (cal.flags & CAL_F_HEADING) != 0;
+    *deg = cal.heading_offset;
+    k_spin_unlock(&cal_lock, key);
+
+    return have;
+}
+
+void mag_cal_set_heading_offset(float deg)
+{
+    bool moved;
+
+    k_spinlock_key_t key = k_spin_lock(&cal_lock);
+    float d = deg - cal.heading_offset;
+
+    if (d > 180.0f) {
+        d -= 360.0f;
+    } else if (d < -180.0f) {
+        d += 360.0f;
+    }
+    moved = !(cal.flags & CAL_F_HEADING) ||
+            d > MAG_CAL_HEADING_DELTA || d < -MAG_CAL_HEADING_DELTA;
+    if (moved) {
+        cal.heading_offset = deg;
+        cal.flags |= CAL_F_HEADING;
+    }
+    k_spin_unlock(&cal_lock, key);
+
+    if (moved) {
+        request_save();
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef MAG_CAL_H_
+#define MAG_CAL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * 磁力计校准（鬐甲 IMU）
+ *
+ * BNO 按占空比每 15 s 断电一次，芯片自己学到的校准断电就丢，
+ * 所以校准状态保存在 littlefs 里，每次上电恢复：
+ *
+ *  - NDOF：BNO055 内部做硬铁 / 软铁校准。CALIB_STAT 的磁力计位到 3 之后，
+ *    在一段采集结束时切 CONFIG 模式读出 22 字节偏移配置（ACC / MAG / GYR 偏移
+ *    + 半径），下次上电在 CONFIG 模式下写回去，芯片不用每次重新画 8 字。
+ *  - Mahony AMG：在线校准在这里做。每轴跟踪原始读数的最小 / 最大包络，
+ *    偏移 = 包络中点（硬铁），比例 = 平均半径 / 本轴半径（对角软铁）。
+ *    包络缓慢向内收缩，旧的极值（附近有过铁器）会慢慢淡出。
+ *
+ * 同一个文件里还存着 heading_fusion 学到的航向偏移（安装角 + 磁偏角 +
+ * 残余磁误差），都算“校准参数”。
+ *
+ * mag_cal_feed / mag_cal_apply / *_bno_* 只在 BNO 采集线程里调用；
+ * 写 flash 放到系统工作队列里做，而且有最小间隔，不会卡住 100 Hz 采集。
+ */
+
+/* BNO055 0x55~0x6A 偏移配置 */
+#define MAG_CAL_BNO_PROFILE_LEN 22
+
+/* 从 flash 读回上次保存的校准，app_fs_init 之后调用 */
+int mag_cal_init(void);
+
+/* ---- Mahony AMG：原始磁力计（BNO LSB，16 LSB = 1 uT） ---- */
+
+/* 更新包络，全 0（ACCGYRO 模式 / 读数无效）忽略 */
+void mag_cal_feed(const int16_t raw[3]);
+
+/* 校准后的磁场，没有可用校准的轴原样输出 */
+void mag_cal_apply(const int16_t raw[3], float out[3]);
+
+/* ---- NDOF：BNO055 偏移配置 ---- */
+
+/* 有保存的配置时拷出来，返回 true */
+bool mag_cal_get_bno_profile(uint8_t prof[MAG_CAL_BNO_PROFILE_LEN]);
+
+/* 是否值得读一份新的配置（还没有，或者上次保存已经很久） */
+bool mag_cal_bno_profile_wanted(void);
+
+/* 芯片报告磁力计校准完成后读出的配置 */
+void mag_cal_set_bno_profile(const uint8_t prof[MAG_CAL_BNO_PROFILE_LEN]);
+
+/* ---- 航向偏移（heading_fusion 用） ---- */
+
+bool mag_cal_get_heading_offset(float *deg);
+void mag_cal_set_heading_offset(float deg);
+
+#endif /* MAG_CAL_H_ */
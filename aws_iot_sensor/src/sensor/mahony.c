@@ -0,0 +1,230 @@
+/* mahony.c
+ *
+ * Mahony 互补滤波，见 mahony.h。
+ */
+
+#include "mahony.h"
+
+#include <math.h>
+#include <string.h>
+
+/* ====================== 参数可调 ====================== */
+
+/* 复位后前这么多个样本用 MAHONY_KP_BOOT，几秒内对齐重力 / 磁北 */
+#define MAHONY_KP_BOOT      10.0f
+#define MAHONY_WARMUP       30
+
+#define RAD2DEG             (180.0f / 3.14159265f)
+
+/* ====================== Mahony ====================== */
+
+void mahony_init(struct mahony *m, float kp, float ki)
+{
+    memset(m, 0, sizeof(*m));
+    m->q[0] = 1.0f;
+    m->kp = kp;
+    m->ki = ki;
+    m->warmup = MAHONY_WARMUP;
+}
+
+static float inv_norm3(float x, float y, float z)
+{
+    float n = x * x + y * y + z * z;
+
+    return (n > 0.0f) ? 1.0f / sqrtf(n) : 0.0f;
+}
+
+/*
+ * 第一个有效样本直接对齐：机体系下的"上"是加速度方向，"北"是磁场的水平分量
+ * （没有磁力计就取机体 x 轴的水平投影，heading 从 0 开始）。
+ * 从单位四元数靠反馈慢慢拉过去要几十秒，积分项还会在大误差下积出假的零偏；
+ * BNO 一个采集段只有 10 s，等不起。
+ */
+static void align(struct mahony *m, float ax, float ay, float az, float mx, float my, float mz)
+{
+    float z[3] = { ax, ay, az };
+    float x[3] = { mx, my, mz };
+
+    if (mx == 0.0f && my == 0.0f && mz == 0.0f) {
+        x[0] = 1.0f;
+        x[1] = 0.0f;
+        x[2] = 0.0f;
+    }
+
+    /* x 去掉竖直分量；和"上"平行时换机体 y 轴 */
+    float d = x[0] * z[0] + x[1] * z[1] + x[2] * z[2];
+    float rx = inv_norm3(x[0] - d * z[0], x[1] - d * z[1], x[2] - d * z[2]);
+
+    if (rx == 0.0f || rx > 1e3f) {
+        x[0] = 0.0f;
+        x[1] = 1.0f;
+        x[2] = 0.0f;
+        d = z[1];
+        rx = inv_norm3(-d * z[0], 1.0f - d * z[1], -d * z[2]);
+    }
+    for (int i = 0; i < 3; i++) {
+        x[i] = (x[i] - d * z[i]) * rx;
+    }
+
+    /* y = z × x；R（机体到世界）的三行就是世界 x / y / z 轴在机体系下的坐标 */
+    float y[3] = {
+        z[1] * x[2] - z[2] * x[1],
+        z[2] * x[0] - z[0] * x[2],
+        z[0] * x[1] - z[1] * x[0],
+    };
+    float tr = x[0] + y[1] + z[2];
+    float q0, q1, q2, q3;
+
+    if (tr > 0.0f) {
+        float k = 2.0f * sqrtf(tr + 1.0f);
+
+        q0 = 0.25f * k;
+        q1 = (z[1] - y[2]) / k;
+        q2 = (x[2] - z[0]) / k;
+        q3 = (y[0] - x[1]) / k;
+    } else if (x[0] > y[1] && x[0] > z[2]) {
+        float k = 2.0f * sqrtf(1.0f + x[0] - y[1] - z[2]);
+
+        q0 = (z[1] - y[2]) / k;
+        q1 = 0.25f * k;
+        q2 = (x[1] + y[0]) / k;
+        q3 = (x[2] + z[0]) / k;
+    } else if (y[1] > z[2]) {
+        float k = 2.0f * sqrtf(1.0f + y[1] - x[0] - z[2]);
+
+        q0 = (x[2] - z[0]) / k;
+        q1 = (x[1] + y[0]) / k;
+        q2 = 0.25f * k;
+        q3 = (y[2] + z[1]) / k;
+    } else {
+        float k = 2.0f * sqrtf(1.0f + z[2] - x[0] - y[1]);
+
+        q0 = (y[0] - x[1]) / k;
+        q1 = (x[2] + z[0]) / k;
+        q2 = (y[2] + z[1]) / k;
+        q3 = 0.25f * k;
+    }
+
+    float rn = 1.0f / sqrtf(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+
+    m->q[0] = q0 * rn;
+    m->q[1] = q1 * rn;
+    m->q[2] = q2 * rn;
+    m->q[3] = q3 * rn;
+    m->aligned = true;
+}
+
+void mahony_update(struct mahony *m,
+                   float gx, float gy, float gz,
+                   float ax, float ay, float az,
+                   float mx, float my, float mz, float dt)
+{
+    float q0 = m->q[0], q1 = m->q[1], q2 = m->q[2], q3 = m->q[3];
+    float ex = 0.0f, ey = 0.0f, ez = 0.0f;
+    float r = inv_norm3(ax, ay, az);
+
+    /* 加速度全 0（自由落体 / 读数无效）时只积分陀螺 */
+    if (r > 0.0f) {
+        ax *= r; ay *= r; az *= r;
+
+        if (!m->aligned) {
+            align(m, ax, ay, az, mx, my, mz);
+            return;
+        }
+
+        /* 当前姿态下估计的重力方向 */
+        float vx = 2.0f * (q1 * q3 - q0 * q2);
+        float vy = 2.0f * (q0 * q1 + q2 * q3);
+        float vz = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+
+        ex = ay * vz - az * vy;
+        ey = az * vx - ax * vz;
+        ez = ax * vy - ay * vx;
+
+        float rm = inv_norm3(mx, my, mz);
+
+        if (rm > 0.0f) {
+            mx *= rm; my *= rm; mz *= rm;
+
+            /* 磁场转到地理系，水平分量合成到 x 轴作为参考磁北 */
+            float hx = 2.0f * (mx * (0.5f - q2 * q2 - q3 * q3) +
+                               my * (q1 * q2 - q0 * q3) + mz * (q1 * q3 + q0 * q2));
+            float hy = 2.0f * (mx * (q1 * q2 + q0 * q3) +
+                               my * (0.5f - q1 * q1 - q3 * q3) + mz * (q2 * q3 - q0 * q1));
+            float bx = sqrtf(hx * hx + hy * hy);
+            float bz = 2.0f * (mx * (q1 * q3 - q0 * q2) + my * (q2 * q3 + q0 * q1) +
+                               mz * (0.5f - q1 * q1 - q2 * q2));
+
+            float wx = 2.0f * (bx * (0.5f - q2 * q2 - q3 * q3) + bz * (q1 * q3 - q0 * q2));
+            float wy = 2.0f * (bx * (q1 * q2 - q0 * q3) + bz * (q0 * q1 + q2 * q3));
+            float wz = 2.0f * (bx * (q0 * q2 + q1 * q3) + bz * (0.5f - q1 * q1 - q2 * q2));
+
+            ex += my * wz - mz * wy;
+            ey += mz * wx - mx * wz;
+            ez += mx * wy - my * wx;
+        }
+
+        /* 收敛期间误差还大，不积分，免得积出假的零偏 */
+        if (m->ki > 0.0f && m->warmup == 0) {
+            m->ix += m->ki * ex * dt;
+            m->iy += m->ki * ey * dt;
+            m->iz += m->ki * ez * dt;
+            gx += m->ix;
+            gy += m->iy;
+            gz += m->iz;
+        }
+
+        float kp = m->kp;
+
+        if (m->warmup > 0) {
+            kp = MAHONY_KP_BOOT;
+            m->warmup--;
+        }
+
+        gx += kp * ex;
+        gy += kp * ey;
+        gz += kp * ez;
+    }
+
+    /* 四元数积分 */
+    gx *= 0.5f * dt;
+    gy *= 0.5f * dt;
+    gz *= 0.5f * dt;
+
+    m->q[0] = q0 + (-q1 * gx - q2 * gy - q3 * gz);
+    m->q[1] = q1 + ( q0 * gx + q2 * gz - q3 * gy);
+    m->q[2] = q2 + ( q0 * gy - q1 * gz + q3 * gx);
+    m->q[3] = q3 + ( q0 * gz + q1 * gy - q2 * gx);
+
+    float n = m->q[0] * m->q[0] + m->q[1] * m->q[1] +
+              m->q[2] * m->q[2] + m->q[3] * m->q[3];
+    float rn = 1.0f / sqrtf(n);
+
+    for (int i = 0; i < 4; i++) {
+        m->q[i] *= rn;
+    }
+}
+
+void mahony_euler(const struct mahony *m, float *heading, float *roll, float *pitch)
+{
+    float q0 = m->q[0], q1 = m->q[1], q2 = m->q[2], q3 = m->q[3];
+
+    /* 航空约定：绕 X 的 phi（±180）、绕 Y 的 theta（±90）、绕 Z 的 psi（逆时针） */
+    float phi   = atan2f(2.0f * (q0 * q1 + q2 * q3), 1.0f - 2.0f * (q1 * q1 + q2 * q2));
+    float s     = 2.0f * (q0 * q2 - q3 * q1);
+
+    s = (s > 1.0f) ? 1.0f : (s < -1.0f) ? -1.0f : s;
+    float theta = asinf(s);
+    float psi   = atan2f(2.0f * (q0 * q3 + q1 * q2), 1.0f - 2.0f * (q2 * q2 + q3 * q3));
+
+    /* BNO055 Windows 约定：heading 顺时针，pitch 是绕 X（±180），roll 是绕 Y（±90） */
+    float h = -psi * RAD2DEG;
+
+    if (h < 0.0f) {
+        h += 360.0f;
+    }
+
+    *heading = h;
+    *pitch   = phi * RAD2DEG;
+    *roll    = theta * RAD2DEG;
+}
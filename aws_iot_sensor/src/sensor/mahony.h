@@ -0,0 +1,39 @@
+#ifndef MAHONY_H_
+#define MAHONY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Mahony 互补滤波 —— 纯逻辑，不依赖内核。
+ *
+ * 陀螺积分出姿态四元数，加速度计（重力方向）和磁力计（磁北）的误差叉积
+ * 经 PI 反馈修正陀螺，积分项顺带估计陀螺零偏。复位后第一个有效样本直接按重力 / 磁北对齐，
+ * 前几十个样本再用大增益、不积分收敛。
+ * imu_fusion.c 每个 IMU 一个实例，只在 BNO 采集线程里用，不加锁。
+ */
+
+/* 单个滤波器状态 */
+struct mahony {
+    float q[4];           /* 四元数 w x y z */
+    float ix, iy, iz;     /* 积分项（陀螺零偏估计） */
+    float kp, ki;
+    uint16_t warmup;      /* 复位后还剩多少个样本用大增益快速收敛 */
+    bool aligned;         /* 已经按第一个有效样本对齐过 */
+};
+
+void mahony_init(struct mahony *m, float kp, float ki);
+
+/*
+ * gx/gy/gz：rad/s；ax/ay/az：任意单位；mx/my/mz：任意单位，全 0 = 不用磁力计。
+ * dt：秒。
+ */
+void mahony_update(struct mahony *m,
+                   float gx, float gy, float gz,
+                   float ax, float ay, float az,
+                   float mx, float my, float mz, float dt);
+
+/* BNO055 约定的欧拉角（deg） */
+void mahony_euler(const struct mahony *m, float *heading, float *roll, float *pitch);
+
+#endif /* MAHONY_H_ */
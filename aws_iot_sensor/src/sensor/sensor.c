@@ -1,4 +1,20 @@
 #include "sensor.h"
+#include "i2c_bus.h"
+#include "bme280_comp.h"
+#include "sensor_health.h"
+#include "imu_array.h"
+#include "imu_fusion.h"
+#include "mag_cal.h"
+#include "heading_fusion.h"
+#include "dead_reckon.h"
+#include "decimator.h"
+#include "pipeline.h"
+#include "baro_posture.h"
+#include "colic_monitor.h"
+#include "respiration.h"
+#include "grazing.h"
+#include "tremor.h"
+#include "gait_capture.h"
 
 #include <zephyr/device.h>
 #include <zephyr/devicetree.h>
@@ -7,6 +23,7 @@
 #include <zephyr/drivers/i2c.h>
 #include <zephyr/logging/log.h>
 #include <math.h>
+#include <string.h>
 
 LOG_MODULE_REGISTER(sensor_module, LOG_LEVEL_INF);
 
@@ -18,6 +35,17 @@ float g_roll        = 0;
 float g_pitch       = 0;
 balance_state_t g_state = STATE_NORMAL;
 
+/* 最近一次带时间戳的样本，整体读写用 sample_lock 保护 */
+static struct k_spinlock sample_lock;
+static struct imu_sample last_imu;        /* 10 Hz 级别 */
+static struct imu_sample last_imu_1hz;
+static struct imu_sample last_imu_2min;
+static struct imu_activity last_activity;
+static struct env_sample last_env;
+
+/* BNO 供电占空比：BME 阶段 BNO 断电省电，BNO 阶段上电采样。
+ * BME280 在两个阶段都采样（总线由 i2c_bus 调度器仲裁）。
+ */
 typedef enum {
     HB_PHASE_BME_ONLY = 0,
     HB_PHASE_BNO_ONLY = 1,
@@ -30,27 +58,387 @@ static volatile hb_phase_t g_phase = HB_PHASE_BME_ONLY;
 #define REG_CHIP_ID     0x00
 #define REG_OPR_MODE    0x3D
 #define REG_PWR_MODE    0x3E
+#define REG_PAGE_ID     0x07
 #define MODE_CONFIG     0x00
+#define MODE_ACCGYRO    0x05
+#define MODE_AMG        0x07
 #define MODE_NDOF       0x0C
+#define REG_ACC_X_L     0x08
+#define REG_GYR_X_L     0x14
 #define REG_EUL_H_L     0x1A
+#define REG_CALIB_STAT  0x35
+#define REG_ACC_OFF_X_L 0x55    /* 0x55~0x6A 偏移配置，只能在 CONFIG 模式下读写 */
+
+/* CALIB_STAT 低两位：磁力计校准等级 0~3 */
+#define CALIB_MAG_MASK  0x03
+
+/* 第 1 页传感器配置寄存器（只在非融合模式下生效） */
+#define REG_P1_ACC_CFG  0x08
+#define REG_P1_MAG_CFG  0x09
+#define REG_P1_GYR_CFG0 0x0A
+#define REG_P1_GYR_CFG1 0x0B
+
+/* 原始数据模式的传感器配置：
+ *  ACC ±4 g、带宽 31.25 Hz、normal；
+ *  MAG 10 Hz、低功耗工作模式；
+ *  GYR ±500 dps、带宽 32 Hz、normal。
+ */
+#define RAW_ACC_CFG     0x09
+#define RAW_MAG_CFG     0x03
+#define RAW_GYR_CFG0    0x3A
+#define RAW_GYR_CFG1    0x00
+
+#if defined(CONFIG_HORSE_IMU_FUSION_MAHONY)
+#define IMU_MCU_FUSION  1
+#if defined(CONFIG_HORSE_IMU_MAHONY_MAG)
+#define BNO_RUN_MODE    MODE_AMG
+#else
+#define BNO_RUN_MODE    MODE_ACCGYRO
+#endif
+#else
+#define IMU_MCU_FUSION  0
+#define BNO_RUN_MODE    MODE_NDOF
+#endif
+
+#define IMU_COMPARE     IS_ENABLED(CONFIG_HORSE_IMU_FUSION_COMPARE)
+
+/* 采集周期：BNO 上电期间固定按分频链的输入速率读鬐甲 IMU */
+#define BNO_BASE_MS     (1000 / DECIM_BASE_HZ)
+
+/* 腿部 IMU 只有 10 Hz 的消费者（对称性 / 环形缓冲），每 10 轮读一次 */
+#define IMU_LEG_DIV     (DECIM_BASE_HZ / 10)
+
+/* 步态抓拍直接订阅分频链里同速率的那一级 */
+#if CONFIG_HORSE_CAPTURE_RATE_HZ == 100
+#define CAPTURE_TIER    DECIM_TIER_100HZ
+#elif CONFIG_HORSE_CAPTURE_RATE_HZ == 50
+#define CAPTURE_TIER    DECIM_TIER_50HZ
+#elif CONFIG_HORSE_CAPTURE_RATE_HZ == 10
+#define CAPTURE_TIER    DECIM_TIER_10HZ
+#else
+#error "CONFIG_HORSE_CAPTURE_RATE_HZ must be 100, 50 or 10 (a decimator tier)"
+#endif
+
+#define BNO_CHIP_ID     0xA0
+
+/* 0 号是鬐甲 IMU，其余是腿部 IMU，见 imu_array.h */
+#define BNO_PRIMARY (&imu_specs[0])
+
+/* 提交一组事务并记入健康统计（耗时、错误、总线重试） */
+static int health_submit(enum health_dev dev, struct i2c_bus_txn *txns, size_t n)
+{
+    tb_ts_t t0 = timebase_now();
+    int ret = i2c_bus_submit(txns, n);
+    uint8_t retries = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        retries = MAX(retries, txns[i].retries);
+    }
+
+    sensor_health_record(dev, ret, retries,
+                         (uint32_t)timebase_delta_us(t0, timebase_now()));
+    return ret;
+}
+
+/*
+ * HEALTH_DEV_BNO055 只统计鬐甲 IMU：它的降级会退避整个 IMU 线程，
+ * 腿部 IMU 出错只影响它自己的 valid 位，不记健康统计。
+ */
+static int bno_submit(struct i2c_bus_txn *t)
+{
+    if (t->spec != BNO_PRIMARY) {
+        return i2c_bus_submit(t, 1);
+    }
+    return health_submit(HEALTH_DEV_BNO055, t, 1);
+}
+
+/* 所有 BNO 访问都走共享总线调度器，和 BME280 并发也不会冲突 */
+static int bno_wr8(const struct i2c_dt_spec *spec, uint8_t reg, uint8_t val)
+{
+    struct i2c_bus_txn t = {
+        .op = I2C_BUS_OP_WRITE, .spec = spec, .reg = reg, .buf = &val, .len = 1,
+    };
+
+    return bno_submit(&t);
+}
+
+static int bno_wr(const struct i2c_dt_spec *spec, uint8_t reg, const uint8_t *buf, size_t len)
+{
+    /* 事务长度是 uint8_t，超长不能静默截断 */
+    if (len > UINT8_MAX) {
+        return -EINVAL;
+    }
+
+    struct i2c_bus_txn t = {
+        .op = I2C_BUS_OP_WRITE, .spec = spec, .reg = reg,
+        .buf = (uint8_t *)buf, .len = (uint8_t)len,
+    };
+
+    return bno_submit(&t);
+}
+
+static int bno_rd(const struct i2c_dt_spec *spec, uint8_t reg, uint8_t *buf, size_t len)
+{
+    if (len > UINT8_MAX) {
+        return -EINVAL;
+    }
+
+    struct i2c_bus_txn t = {
+        .op = I2C_BUS_OP_READ, .spec = spec, .reg = reg, .buf = buf, .len = (uint8_t)len,
+    };
+
+    return bno_submit(&t);
+}
+
+static int16_t le16(const uint8_t *p)
+{
+    return (int16_t)((p[1] << 8) | p[0]);
+}
+
+/* 最近一次腿部 IMU 读数，10 Hz 回调里和分频后的鬐甲 IMU 拼成一帧 */
+static struct imu_frame leg_fr;
+
+/*
+ * 读一轮，一次提交给总线调度器背靠背执行，每个 IMU 只有一个事务：
+ *  - 鬐甲 IMU 每轮读 ACC..EUL 连续 24 字节（MCU 融合时 ACC..GYR 18 字节），
+ *    九个通道都进分频链；
+ *  - with_legs 时腿部 IMU 也在这一轮里读：NDOF 只读 EUL，MCU 融合读原始数据。
+ * 鬐甲 IMU 的结果写到 s，腿部写到 leg_fr。返回鬐甲 IMU 的读结果。
+ */
+static int imu_read_round(uint8_t present, bool with_legs, struct decim_sample *s)
+{
+    uint8_t blk[IMU_COUNT][IMU_RAW_LEN + 6];
+    struct i2c_bus_txn txns[IMU_COUNT];
+    int8_t owner[IMU_COUNT];
+    size_t n = 0;
+
+    for (int i = 0; i < IMU_COUNT; i++) {
+        if (!(present & BIT(i)) || (i > 0 && !with_legs)) {
+            continue;
+        }
+
+        bool raw = (i == 0) || IMU_MCU_FUSION;
+        uint8_t len = (raw ? IMU_RAW_LEN : 0) + (IMU_MCU_FUSION ? 0 : 6);
+
+        txns[n] = (struct i2c_bus_txn){ .op = I2C_BUS_OP_READ, .spec = &imu_specs[i],
+                                        .reg = raw ? REG_ACC_X_L : REG_EUL_H_L,
+                                        .buf = blk[i], .len = len };
+        owner[n++] = i;
+    }
+
+    tb_ts_t t0 = timebase_now();
+    (void)i2c_bus_submit(txns, n);
+    tb_ts_t t1 = timebase_now();
+
+    /* 健康统计只记鬐甲 IMU 自己那个事务（耗时按整轮算）；腿部 IMU 失败在下面只清它的 valid 位 */
+    if (n > 0 && owner[0] == 0) {
+        sensor_health_record(HEALTH_DEV_BNO055, txns[0].result, txns[0].retries,
+                             (uint32_t)timebase_delta_us(t0, t1));
+    }
 
-static const struct i2c_dt_spec bno = I2C_DT_SPEC_GET(DT_NODELABEL(bno055));
+    /* 整轮共用一个时间戳（中点），读耗时记成 skew */
+    tb_ts_t ts = t0 + (t1 - t0) / 2;
 
-static int bno_wr8(uint8_t reg, uint8_t val)
+    if (with_legs) {
+        leg_fr.ts = ts;
+        leg_fr.skew_us = (uint16_t)MIN(timebase_delta_us(t0, t1), UINT16_MAX);
+        leg_fr.valid = present & ~BIT(0);
+    }
+
+    int primary_err = 0;
+
+    for (size_t k = 0; k < n; k++) {
+        int i = owner[k];
+        int16_t eul[3];
+
+        if (txns[k].result != 0) {
+            if (i == 0) {
+                primary_err = txns[k].result;
+            } else {
+                leg_fr.valid &= ~BIT(i);
+            }
+            continue;
+        }
+
+        if (IMU_MCU_FUSION) {
+            imu_fusion_run(i, blk[i], ts, eul);
+        } else {
+            const uint8_t *e = &blk[i][(i == 0) ? IMU_RAW_LEN : 0];
+
+            for (int c = 0; c < 3; c++) {
+                eul[c] = le16(&e[2 * c]);
+            }
+
+            if (IMU_COMPARE && i == 0) {
+                int16_t mcu[3];
+
+                imu_fusion_run(0, blk[0], ts, mcu);
+                imu_fusion_compare(mcu, eul);
+            }
+        }
+
+        if (i == 0) {
+            s->ts = ts;
+            for (int c = 0; c < 3; c++) {
+                s->v[DECIM_CH_ACC + c] = le16(&blk[0][2 * c]);
+                s->v[DECIM_CH_GYR + c] = le16(&blk[0][12 + 2 * c]);
+                s->v[DECIM_CH_EUL + c] = eul[c];
+            }
+        } else {
+            memcpy(leg_fr.eul[i], eul, sizeof(eul));
+        }
+    }
+
+    return primary_err;
+}
+
+/* 上电后逐个检查 CHIP ID 并切到工作模式（NDOF / AMG / ACCGYRO），返回在线 IMU 的位图 */
+static uint8_t imu_init_all(void)
 {
-    uint8_t buf[2] = { reg, val };
-    return i2c_write_dt(&bno, buf, sizeof(buf));
+    uint8_t present = 0;
+
+    for (int i = 0; i < IMU_COUNT; i++) {
+        const struct i2c_dt_spec *spec = &imu_specs[i];
+        uint8_t id = 0;
+        int ret = bno_rd(spec, REG_CHIP_ID, &id, 1);
+
+        if (ret || id != BNO_CHIP_ID) {
+            LOG_ERR("IMU %s CHIP_ID error ret=%d id=0x%02X", imu_name(i), ret, id);
+            if (ret == 0 && i == 0) {
+                /* 鬐甲 IMU 总线通了但 ID 不对，也算一次设备故障（腿部的不记，同 bno_submit） */
+                sensor_health_record(HEALTH_DEV_BNO055, -ENODEV, 0, 0);
+            }
+            continue;
+        }
+        present |= BIT(i);
+    }
+
+    /* 模式切换各 IMU 交错进行，等待时间只花一次 */
+    for (int i = 0; i < IMU_COUNT; i++) {
+        if (present & BIT(i)) {
+            bno_wr8(&imu_specs[i], REG_OPR_MODE, MODE_CONFIG);
+        }
+    }
+    k_msleep(20);
+    for (int i = 0; i < IMU_COUNT; i++) {
+        if (present & BIT(i)) {
+            bno_wr8(&imu_specs[i], REG_PWR_MODE, 0x00);
+        }
+    }
+    k_msleep(10);
+
+    /* NDOF：写回上次保存的鬐甲 IMU 偏移配置，断电重启后不用重新校准 */
+    uint8_t prof[MAG_CAL_BNO_PROFILE_LEN];
+
+    if (!IMU_MCU_FUSION && (present & BIT(0)) && mag_cal_get_bno_profile(prof)) {
+        (void)bno_wr(BNO_PRIMARY, REG_ACC_OFF_X_L, prof, sizeof(prof));
+    }
+
+    for (int i = 0; i < IMU_COUNT && IMU_MCU_FUSION; i++) {
+        if (present & BIT(i)) {
+            const struct i2c_dt_spec *spec = &imu_specs[i];
+
+            /* 原始数据模式下传感器配置由我们定，省掉 NDOF 的高速磁力计 */
+            bno_wr8(spec, REG_PAGE_ID, 1);
+            bno_wr8(spec, REG_P1_ACC_CFG, RAW_ACC_CFG);
+            bno_wr8(spec, REG_P1_MAG_CFG, RAW_MAG_CFG);
+            bno_wr8(spec, REG_P1_GYR_CFG0, RAW_GYR_CFG0);
+            bno_wr8(spec, REG_P1_GYR_CFG1, RAW_GYR_CFG1);
+            bno_wr8(spec, REG_PAGE_ID, 0);
+        }
+    }
+    for (int i = 0; i < IMU_COUNT; i++) {
+        if (present & BIT(i)) {
+            bno_wr8(&imu_specs[i], REG_OPR_MODE, BNO_RUN_MODE);
+        }
+    }
+    k_msleep(50);
+
+    if (IMU_MCU_FUSION || IMU_COMPARE) {
+        imu_fusion_reset();
+    }
+
+    return present;
 }
 
-static int bno_rd(uint8_t reg, uint8_t *buf, size_t len)
+/*
+ * NDOF：一段采集结束、断电之前，鬐甲 IMU 的磁力计已经校准好（等级 3）时
+ * 切到 CONFIG 模式读出偏移配置交给 mag_cal 保存。多花约 30 ms，
+ * 只在还没有配置或者上次读已经很久时做。
+ */
+static void imu_capture_profile(void)
 {
-    return i2c_write_read_dt(&bno, &reg, 1, buf, len);
+    uint8_t calib = 0;
+    uint8_t prof[MAG_CAL_BNO_PROFILE_LEN];
+
+    if (IMU_MCU_FUSION || !mag_cal_bno_profile_wanted()) {
+        return;
+    }
+    if (bno_rd(BNO_PRIMARY, REG_CALIB_STAT, &calib, 1) ||
+        (calib & CALIB_MAG_MASK) != CALIB_MAG_MASK) {
+        return;
+    }
+
+    bno_wr8(BNO_PRIMARY, REG_OPR_MODE, MODE_CONFIG);
+    k_msleep(20);
+    if (bno_rd(BNO_PRIMARY, REG_ACC_OFF_X_L, prof, sizeof(prof)) == 0) {
+        LOG_INF("BNO055 CALIB_STAT 0x%02X, saving offsets", calib);
+        mag_cal_set_bno_profile(prof);
+    }
 }
 
 /* ====================== BME280 ====================== */
 
+/*
+ * 驱动只在启动时初始化芯片（复位、过采样 / 滤波 / 模式）。采样不走 sensor_sample_fetch：
+ * 它在总线线程里轮询 STATUS、每次至少睡 3 ms，碰上正在转换要等几十 ms，BNO 的读全被堵住。
+ * 现在分成两步：触发转换（normal 模式芯片自己按 standby 周期转，forced 模式写一次 ctrl_meas），
+ * 本线程等转换做完，再经总线 burst 读原始数据块，补偿在本线程算。
+ */
 #define BME280_NODE DT_NODELABEL(bme280)
 static const struct device *const bme280_dev = DEVICE_DT_GET(BME280_NODE);
+static const struct i2c_dt_spec bme280_spec = I2C_DT_SPEC_GET(BME280_NODE);
+
+/* forced 模式一次转换的最长时间：T 2x + P 16x + H 1x 约 46 ms */
+#define BME280_MEAS_MS      50
+
+static struct bme280_calib bme_cal;
+static uint8_t bme_ctrl_meas;
+
+/* 校准参数和驱动配好的 ctrl_meas（过采样位）只读一次 */
+static int bme280_load_calib(void)
+{
+    uint8_t tp[BME280_CALIB_TP_LEN];
+    uint8_t h[BME280_CALIB_H_LEN];
+    int err = i2c_bus_read(&bme280_spec, BME280_REG_CALIB_TP, tp, sizeof(tp));
+
+    if (err == 0) {
+        err = i2c_bus_read(&bme280_spec, BME280_REG_CALIB_H, h, sizeof(h));
+    }
+    if (err == 0) {
+        err = i2c_bus_read(&bme280_spec, BME280_REG_CTRL_MEAS, &bme_ctrl_meas, 1);
+    }
+    if (err == 0) {
+        bme280_comp_parse_calib(&bme_cal, tp, h);
+    }
+    return err;
+}
+
+/* 触发一次转换；normal 模式芯片一直在转，数据寄存器有影子锁存，随时读都是完整的一组 */
+static int bme280_trigger(void)
+{
+#if defined(CONFIG_BME280_MODE_FORCED)
+    int err = i2c_bus_write8(&bme280_spec, BME280_REG_CTRL_MEAS,
+                             (bme_ctrl_meas & ~BME280_MODE_MASK) | BME280_MODE_FORCED);
+
+    if (err == 0) {
+        k_msleep(BME280_MEAS_MS);
+    }
+    return err;
+#else
+    return 0;
+#endif
+}
 
 /* ====================== 电源控制 ====================== */
 
@@ -67,33 +455,399 @@ static void bno_power(bool on)
 
 static void bme280_thread(void *p1, void *p2, void *p3)
 {
-    struct sensor_value temp, hum, press;
+    uint8_t raw[BME280_DATA_LEN];
+    struct i2c_bus_txn fetch = {
+        .op = I2C_BUS_OP_READ, .spec = &bme280_spec,
+        .reg = BME280_REG_DATA, .buf = raw, .len = sizeof(raw),
+    };
     int ret;
 
+    if (!device_is_ready(bme280_dev)) {
+        LOG_ERR("BME280 not ready");
+        return;
+    }
+
+    while ((ret = bme280_load_calib()) != 0) {
+        LOG_WRN("BME280 calibration read failed (%d)", ret);
+        k_msleep(1000);
+    }
+
+    /* 总线由 i2c_bus 调度，BME 不再需要等 BME-only 阶段，和 BNO 并发采样 */
     while (1) {
 
-        if (g_phase != HB_PHASE_BME_ONLY) {
-            k_sleep(K_MSEC(100));
-            continue;
+        ret = bme280_trigger();
+
+        tb_ts_t ts = timebase_now();
+
+        if (ret == 0) {
+            ret = health_submit(HEALTH_DEV_BME280, &fetch, 1);
         }
 
-        ret = sensor_sample_fetch(bme280_dev);
+        float t, h, p;
+
+        if (ret == 0 && !bme280_comp_convert(&bme_cal, raw, &t, &p, &h)) {
+            ret = -EAGAIN;      /* 上电后还没转换完第一组 */
+        }
 
         if (ret == 0) {
 
-            sensor_channel_get(bme280_dev, SENSOR_CHAN_AMBIENT_TEMP, &temp);
-            sensor_channel_get(bme280_dev, SENSOR_CHAN_HUMIDITY, &hum);
-            sensor_channel_get(bme280_dev, SENSOR_CHAN_PRESS, &press);
+            /* 三个通道都要检查（不能短路），超量程的读数不往外发 */
+            bool ok = sensor_health_check(HEALTH_CH_TEMP, t);
+            ok &= sensor_health_check(HEALTH_CH_HUMIDITY, h);
+            ok &= sensor_health_check(HEALTH_CH_PRESSURE, p);
+            if (!ok) {
+                k_msleep(sensor_health_period_ms(HEALTH_DEV_BME280, 1000));
+                continue;
+            }
 
-            g_temperature = temp.val1 + temp.val2 / 1e6;
-            g_humidity    = hum.val1  + hum.val2  / 1e6;
-            g_pressure    = press.val1 + press.val2 / 1e6;
+            g_temperature = t;
+            g_humidity    = h;
+            g_pressure    = p;
+
+            k_spinlock_key_t key = k_spin_lock(&sample_lock);
+            last_env.ts          = ts;
+            last_env.temperature = g_temperature;
+            last_env.humidity    = g_humidity;
+            last_env.pressure    = g_pressure;
+            k_spin_unlock(&sample_lock, key);
+
+            /* 气压高度 → 卧倒检测（IMU 断电时也能工作） */
+            baro_posture_update(ts, p, t);
+            colic_monitor_feed_posture(ts);
+        } else {
+            LOG_WRN("BME280 fetch failed (%d)", ret);
         }
 
-        k_sleep(K_SECONDS(1));
+        /* 连续失败时退避，坏掉的 BME 不会每秒都卡在总线重试里 */
+        k_msleep(sensor_health_period_ms(HEALTH_DEV_BME280, 1000));
     }
 }
 
+/* ====================== 分频链订阅者 ====================== */
+
+/* 马背平衡监测状态，每段采集重新取基线 */
+static struct {
+    bool first_sample;
+    balance_state_t last_state;
+    float roll0;
+    float pitch0;
+    uint8_t lr_over_cnt;
+    uint8_t fh_over_cnt;
+    int lr_dir;
+    int fh_dir;
+} bal;
+
+static void balance_reset(void)
+{
+    memset(&bal, 0, sizeof(bal));
+    bal.first_sample = true;
+    bal.last_state = STATE_NORMAL;
+}
+
+static void to_imu_sample(const struct decim_sample *s, struct imu_sample *out)
+{
+    out->ts      = s->ts;
+    out->heading = s->v[DECIM_CH_EUL] / 16.0f;
+    out->roll    = s->v[DECIM_CH_EUL + 1] / 16.0f;
+    out->pitch   = s->v[DECIM_CH_EUL + 2] / 16.0f;
+}
+
+/* 步态抓拍：只在采集状态下转发 */
+static void on_capture_tier(const struct decim_sample *s, void *user)
+{
+    ARG_UNUSED(user);
+
+    if (!gait_capture_active()) {
+        return;
+    }
+
+    struct capture_frame cap = { .ts = s->ts };
+
+    memcpy(cap.v, s->v, sizeof(cap.v));
+    gait_capture_push(&cap);
+}
+
+/*
+ * 50 Hz / 10 Hz / 1 Hz 三条处理流水线，级别在编译期由 Kconfig 决定（见 pipeline.h），
+ * 关掉的级别不占代码也没有调用开销。
+ */
+struct imu_pipe_ctx {
+    const struct decim_sample *s;
+    struct imu_sample imu;
+    balance_state_t prev_state;
+    balance_state_t state;
+    bool tremor_onset;
+};
+
+/* ACQUIRE：分频链输出 → 物理量 */
+static enum pipe_rc stage_acquire(struct imu_pipe_ctx *c)
+{
+    to_imu_sample(c->s, &c->imu);
+    c->prev_state = g_state;
+    c->state = g_state;
+    return PIPE_CONTINUE;
+}
+
+/* FILTER：量程检查，超量程的样本不往下走（三个通道都要检查，不能短路） */
+static enum pipe_rc stage_range_check(struct imu_pipe_ctx *c)
+{
+    bool ok = sensor_health_check(HEALTH_CH_HEADING, c->imu.heading);
+    ok &= sensor_health_check(HEALTH_CH_ROLL, c->imu.roll);
+    ok &= sensor_health_check(HEALTH_CH_PITCH, c->imu.pitch);
+
+    return ok ? PIPE_CONTINUE : PIPE_STOP;
+}
+
+/* DETECT：马背平衡（相对基线的偏移 + 连续超限去抖） */
+static enum pipe_rc stage_balance(struct imu_pipe_ctx *c)
+{
+    const float LR_THRESH     = SENSOR_LR_THRESH_DEG;
+    const float FH_THRESH     = SENSOR_FH_THRESH_DEG;
+    const uint8_t MIN_SAMPLES = 10;
+
+    float roll  = c->imu.roll;
+    float pitch = c->imu.pitch;
+
+    if (bal.first_sample) {
+        /* 新一段采集：重新取基线，状态回到正常 */
+        bal.roll0  = roll;
+        bal.pitch0 = pitch;
+        bal.first_sample = false;
+        c->prev_state = STATE_NORMAL;
+        c->state = STATE_NORMAL;
+        return PIPE_CONTINUE;
+    }
+
+    float d_roll  = roll  - bal.roll0;
+    float d_pitch = pitch - bal.pitch0;
+
+    bool lr_over = fabsf(d_roll)  > LR_THRESH;
+    bool fh_over = fabsf(d_pitch) > FH_THRESH;
+
+    if (lr_over) {
+        bal.lr_dir = (d_roll < 0.0f) ? -1 : +1;
+        if (bal.lr_over_cnt < 255) bal.lr_over_cnt++;
+    } else bal.lr_over_cnt = 0;
+
+    if (fh_over) {
+        bal.fh_dir = (d_pitch < 0.0f) ? -1 : +1;
+        if (bal.fh_over_cnt < 255) bal.fh_over_cnt++;
+    } else bal.fh_over_cnt = 0;
+
+    balance_state_t cur_state = STATE_NORMAL;
+
+    if (bal.lr_over_cnt >= MIN_SAMPLES &&
+        bal.lr_over_cnt >= bal.fh_over_cnt) {
+        cur_state = (bal.lr_dir < 0) ? STATE_LEFT : STATE_RIGHT;
+    }
+    else if (bal.fh_over_cnt >= MIN_SAMPLES) {
+        cur_state = (bal.fh_dir < 0) ? STATE_FRONT : STATE_HIND;
+    }
+
+    c->prev_state = bal.last_state;
+    c->state = cur_state;
+    bal.last_state = cur_state;
+    return PIPE_CONTINUE;
+}
+
+/* AGGREGATE：10 Hz 环形缓冲（呼吸估计 / 四肢对称性的输入） */
+static enum pipe_rc stage_imu_ring(struct imu_pipe_ctx *c)
+{
+    struct imu_frame fr = leg_fr;
+
+    /* 鬐甲 IMU 用分频后的值，腿部 IMU 用最近一次读数 */
+    fr.ts = c->s->ts;
+    fr.valid |= BIT(0);
+    memcpy(fr.eul[0], &c->s->v[DECIM_CH_EUL], sizeof(fr.eul[0]));
+    imu_ring_put(&fr);
+    return PIPE_CONTINUE;
+}
+
+/* AGGREGATE：每 10 个样本（1 s）出一个陀螺仪 RMS 活动量，给 GNSS 省电策略 */
+static enum pipe_rc stage_activity(struct imu_pipe_ctx *c)
+{
+    static float acc2;
+    static uint8_t n;
+
+    /* BNO055 陀螺仪 16 LSB/dps */
+    float gx = c->s->v[DECIM_CH_GYR] / 16.0f;
+    float gy = c->s->v[DECIM_CH_GYR + 1] / 16.0f;
+    float gz = c->s->v[DECIM_CH_GYR + 2] / 16.0f;
+
+    acc2 += gx * gx + gy * gy + gz * gz;
+    if (++n < 10) {
+        return PIPE_CONTINUE;
+    }
+
+    struct imu_activity a = { .ts = c->s->ts, .gyro_rms_dps = sqrtf(acc2 / n) };
+
+    acc2 = 0.0f;
+    n = 0;
+
+    k_spinlock_key_t key = k_spin_lock(&sample_lock);
+    last_activity = a;
+    k_spin_unlock(&sample_lock, key);
+    return PIPE_CONTINUE;
+}
+
+/* AGGREGATE：航位推算（EKF 每个样本预测一步，用航向 / 步频 / GNSS 更新） */
+static enum pipe_rc stage_dead_reckon(struct imu_pipe_ctx *c)
+{
+    /* BNO055 加速度 100 LSB = 1 m/s² */
+    float ax = c->s->v[DECIM_CH_ACC] / 100.0f;
+    float ay = c->s->v[DECIM_CH_ACC + 1] / 100.0f;
+    float az = c->s->v[DECIM_CH_ACC + 2] / 100.0f;
+
+    dead_reckon_feed(c->s->ts, c->imu.heading, sqrtf(ax * ax + ay * ay + az * az));
+    return PIPE_CONTINUE;
+}
+
+/* SINK：最新样本 / 平衡状态给 getter 和上报 */
+static enum pipe_rc stage_latest(struct imu_pipe_ctx *c)
+{
+    g_roll  = c->imu.roll;
+    g_pitch = c->imu.pitch;
+    g_state = c->state;
+
+    k_spinlock_key_t key = k_spin_lock(&sample_lock);
+    last_imu = c->imu;
+    k_spin_unlock(&sample_lock, key);
+    return PIPE_CONTINUE;
+}
+
+/* SINK：从正常进入异常时触发一次步态抓拍（抓拍模块自己做冷却） */
+static enum pipe_rc stage_capture_trigger(struct imu_pipe_ctx *c)
+{
+    if (c->state != STATE_NORMAL && c->prev_state == STATE_NORMAL) {
+        (void)gait_capture_trigger(CAPTURE_TRIGGER_ANOMALY,
+                                   CONFIG_HORSE_CAPTURE_DEFAULT_SECONDS);
+    }
+    return PIPE_CONTINUE;
+}
+
+/* SINK：平衡状态变化打日志（调试 / 台架用） */
+static enum pipe_rc stage_balance_log(struct imu_pipe_ctx *c)
+{
+    static const char *const names[] = { "normal", "left", "right", "front", "hind" };
+
+    if (c->state != c->prev_state) {
+        LOG_WRN("Balance %s -> %s (roll %.1f pitch %.1f)",
+                names[c->prev_state], names[c->state],
+                (double)c->imu.roll, (double)c->imu.pitch);
+    }
+    return PIPE_CONTINUE;
+}
+
+/* DETECT：低头吃草时间 */
+static enum pipe_rc stage_grazing(struct imu_pipe_ctx *c)
+{
+    grazing_feed(c->imu.ts, c->imu.pitch);
+    return PIPE_CONTINUE;
+}
+
+/* DETECT：疝痛打滚统计 */
+static enum pipe_rc stage_colic(struct imu_pipe_ctx *c)
+{
+    colic_monitor_feed_imu(c->imu.ts, c->imu.roll);
+    return PIPE_CONTINUE;
+}
+
+/* DETECT：IMU 航向和 GNSS 对地航向融合（航位推算输入） */
+static enum pipe_rc stage_heading(struct imu_pipe_ctx *c)
+{
+    heading_fusion_feed(c->imu.ts, c->imu.heading);
+    return PIPE_CONTINUE;
+}
+
+/* DETECT：5~15 Hz 颤抖 / 寒战（运动门控的实数 FFT） */
+static enum pipe_rc stage_tremor(struct imu_pipe_ctx *c)
+{
+    c->tremor_onset = tremor_feed(c->s);
+    return PIPE_CONTINUE;
+}
+
+/* SINK：进入震颤状态时触发一次步态抓拍（和平衡异常共用冷却） */
+static enum pipe_rc stage_tremor_trigger(struct imu_pipe_ctx *c)
+{
+    if (c->tremor_onset) {
+        (void)gait_capture_trigger(CAPTURE_TRIGGER_ANOMALY,
+                                   CONFIG_HORSE_CAPTURE_DEFAULT_SECONDS);
+    }
+    return PIPE_CONTINUE;
+}
+
+/* SINK：1 Hz 样本（卧倒判断的 pitch 否决、telemetry log） */
+static enum pipe_rc stage_latest_1hz(struct imu_pipe_ctx *c)
+{
+    k_spinlock_key_t key = k_spin_lock(&sample_lock);
+    last_imu_1hz = c->imu;
+    k_spin_unlock(&sample_lock, key);
+    return PIPE_CONTINUE;
+}
+
+#define IMU_PIPELINE_10HZ(X)                                                \
+    X(ACQUIRE,   stage_acquire,          1)                                 \
+    X(FILTER,    stage_range_check,      CONFIG_HORSE_PIPE_RANGE_CHECK)     \
+    X(DETECT,    stage_balance,          CONFIG_HORSE_PIPE_BALANCE)         \
+    X(DETECT,    stage_grazing,          CONFIG_HORSE_PIPE_GRAZING)         \
+    X(AGGREGATE, stage_imu_ring,         CONFIG_HORSE_PIPE_IMU_RING)        \
+    X(AGGREGATE, stage_activity,         CONFIG_HORSE_PIPE_ACTIVITY)        \
+    X(AGGREGATE, stage_dead_reckon,      CONFIG_HORSE_PIPE_DEAD_RECKON)     \
+    X(SINK,      stage_latest,           1)                                 \
+    X(SINK,      stage_capture_trigger,  CONFIG_HORSE_PIPE_CAPTURE_TRIGGER) \
+    X(SINK,      stage_balance_log,      CONFIG_HORSE_PIPE_BALANCE_LOG)
+
+#define IMU_PIPELINE_50HZ(X)                                                \
+    X(DETECT,    stage_tremor,           CONFIG_HORSE_PIPE_TREMOR)          \
+    X(SINK,      stage_tremor_trigger,   CONFIG_HORSE_PIPE_TREMOR_TRIGGER)
+
+#define IMU_PIPELINE_1HZ(X)                                                 \
+    X(ACQUIRE,   stage_acquire,          1)                                 \
+    X(DETECT,    stage_colic,            CONFIG_HORSE_PIPE_COLIC)           \
+    X(DETECT,    stage_heading,          CONFIG_HORSE_PIPE_HEADING)         \
+    X(SINK,      stage_latest_1hz,       1)
+
+static void on_10hz(const struct decim_sample *s, void *user)
+{
+    ARG_UNUSED(user);
+
+    struct imu_pipe_ctx c = { .s = s };
+
+    PIPELINE_RUN(IMU_PIPELINE_10HZ, &c);
+}
+
+static void on_50hz(const struct decim_sample *s, void *user)
+{
+    ARG_UNUSED(user);
+
+    struct imu_pipe_ctx c = { .s = s };
+
+    PIPELINE_RUN(IMU_PIPELINE_50HZ, &c);
+}
+
+static void on_1hz(const struct decim_sample *s, void *user)
+{
+    ARG_UNUSED(user);
+
+    struct imu_pipe_ctx c = { .s = s };
+
+    PIPELINE_RUN(IMU_PIPELINE_1HZ, &c);
+}
+
+/* 1/120 Hz：上报用的两分钟均值 */
+static void on_2min(const struct decim_sample *s, void *user)
+{
+    ARG_UNUSED(user);
+
+    struct imu_sample imu;
+
+    to_imu_sample(s, &imu);
+
+    k_spinlock_key_t key = k_spin_lock(&sample_lock);
+    last_imu_2min = imu;
+    k_spin_unlock(&sample_lock, key);
+}
+
 /* ====================== BNO线程 ====================== */
 
 static void bno055_thread(void *p1, void *p2, void *p3)
@@ -102,110 +856,67 @@ static void bno055_thread(void *p1, void *p2, void *p3)
     ARG_UNUSED(p2);
     ARG_UNUSED(p3);
 
-    LOG_INF("BNO055 thread start");
+    LOG_INF("IMU thread start (%d IMU)", IMU_COUNT);
+    PIPELINE_LOG("imu 50 Hz", IMU_PIPELINE_50HZ);
+    PIPELINE_LOG("imu 10 Hz", IMU_PIPELINE_10HZ);
+    PIPELINE_LOG("imu 1 Hz", IMU_PIPELINE_1HZ);
+
+    (void)decimator_subscribe(CAPTURE_TIER, on_capture_tier, NULL);
+    if (PIPELINE_STAGES(IMU_PIPELINE_50HZ) > 0) {
+        (void)decimator_subscribe(DECIM_TIER_50HZ, on_50hz, NULL);
+    }
+    (void)decimator_subscribe(DECIM_TIER_10HZ, on_10hz, NULL);
+    (void)decimator_subscribe(DECIM_TIER_1HZ, on_1hz, NULL);
+    (void)decimator_subscribe(DECIM_TIER_120S, on_2min, NULL);
 
     while (1) {
 
-        /* 需要使用 BNO → 上电 */
+        /* 需要使用 BNO → 上电（所有 IMU 共用一路电源） */
         bno_power(true);
         k_msleep(700);
 
-        /* 读 CHIP ID */
-        uint8_t id = 0;
-        int ret = bno_rd(REG_CHIP_ID, &id, 1);
-        if (ret || id != 0xA0) {
-            LOG_ERR("BNO055 CHIP_ID error ret=%d id=0x%02X", ret, id);
+        /* 鬐甲 IMU 必须在；腿部 IMU 不在就跳过 */
+        uint8_t present = imu_init_all();
+        if (!(present & BIT(0))) {
             bno_power(false);
-            k_sleep(K_SECONDS(2));
+            k_msleep(sensor_health_period_ms(HEALTH_DEV_BNO055, 2000));
             continue;
         }
 
-        /* 初始化模式 */
-        bno_wr8(REG_OPR_MODE, MODE_CONFIG);
-        k_msleep(20);
-        bno_wr8(REG_PWR_MODE, 0x00);
-        k_msleep(10);
-        bno_wr8(REG_OPR_MODE, MODE_NDOF);
-        k_msleep(50);
-
-        /* ====== 马背平衡监测逻辑 ====== */
-        const float LR_THRESH     = 15.0f;
-        const float FH_THRESH     = 15.0f;
-        const uint8_t MIN_SAMPLES = 10;
-
-        bool first_sample = true;
-        balance_state_t last_state = STATE_NORMAL;
-
-        float roll0  = 0.0f;
-        float pitch0 = 0.0f;
+        decimator_restart();
+        balance_reset();
 
-        uint8_t lr_over_cnt = 0;
-        uint8_t fh_over_cnt = 0;
-        int lr_dir = 0;
-        int fh_dir = 0;
+        int ret = 0;
+        uint32_t tick = 0;
+        int64_t next = k_uptime_get();
 
-        /* 开始采样 */
+        /* 开始采样：固定 DECIM_BASE_HZ，各消费者的速率由分频链给出 */
         while (g_phase == HB_PHASE_BNO_ONLY) {
-            uint8_t raw[6];
+            struct decim_sample s;
+            bool with_legs = (tick++ % IMU_LEG_DIV) == 0;
 
-            ret = bno_rd(REG_EUL_H_L, raw, sizeof(raw));
+            ret = imu_read_round(present, with_legs, &s);
             if (ret) {
-                LOG_ERR("BNO055 read EUL failed (%d), break", ret);
+                LOG_ERR("BNO055 read failed (%d), break", ret);
                 break;
             }
 
-            int16_t roll_raw  = (int16_t)((raw[3] << 8) | raw[2]);
-            int16_t pitch_raw = (int16_t)((raw[5] << 8) | raw[4]);
+            decimator_push(&s);
 
-            float roll  = roll_raw  / 16.0f;
-            float pitch = pitch_raw / 16.0f;
-
-            g_roll  = roll;
-            g_pitch = pitch;
-
-            if (first_sample) {
-                roll0  = roll;
-                pitch0 = pitch;
-                first_sample = false;
-                last_state = STATE_NORMAL;
-            } else {
-                float d_roll  = roll  - roll0;
-                float d_pitch = pitch - pitch0;
-
-                bool lr_over = fabsf(d_roll)  > LR_THRESH;
-                bool fh_over = fabsf(d_pitch) > FH_THRESH;
-
-                if (lr_over) {
-                    lr_dir = (d_roll < 0.0f) ? -1 : +1;
-                    if (lr_over_cnt < 255) lr_over_cnt++;
-                } else lr_over_cnt = 0;
-
-                if (fh_over) {
-                    fh_dir = (d_pitch < 0.0f) ? -1 : +1;
-                    if (fh_over_cnt < 255) fh_over_cnt++;
-                } else fh_over_cnt = 0;
-
-                balance_state_t cur_state = STATE_NORMAL;
-
-                if (lr_over_cnt >= MIN_SAMPLES &&
-                    lr_over_cnt >= fh_over_cnt) {
-                    cur_state = (lr_dir < 0) ? STATE_LEFT : STATE_RIGHT;
-                }
-                else if (fh_over_cnt >= MIN_SAMPLES) {
-                    cur_state = (fh_dir < 0) ? STATE_FRONT : STATE_HIND;
-                }
-
-                g_state = cur_state;
-                last_state = cur_state;
-            }
+            /* 按绝对时间排下一轮，读耗时不累积成漂移；落后了不追 */
+            next += BNO_BASE_MS;
+            next = MAX(next, k_uptime_get());
+            k_sleep(K_TIMEOUT_ABS_MS(next));
+        }
 
-            k_msleep(100);
+        if (ret == 0) {
+            imu_capture_profile();
         }
 
         LOG_INF("BNO session done, powering off...");
         bno_power(false);
 
-        k_msleep(500);
+        k_msleep(sensor_health_period_ms(HEALTH_DEV_BNO055, 500));
     }
 }
 
@@ -216,13 +927,26 @@ static void scheduler_thread(void *p1, void *p2, void *p3)
 {
     while (1) {
 
+        /* 抓拍期间 / 疝痛报警后 / 呼吸估计正在攒静止窗口时 BNO 一直保持上电采样 */
+        if (gait_capture_active() || colic_monitor_boost_active() ||
+            respiration_window_active()) {
+            bno_power(true);
+            g_phase = HB_PHASE_BNO_ONLY;
+            k_sleep(K_SECONDS(1));
+            continue;
+        }
+
         g_phase = HB_PHASE_BME_ONLY;
         bno_power(false);
         k_sleep(K_SECONDS(5));
 
         bno_power(true);
         g_phase = HB_PHASE_BNO_ONLY;
-        k_sleep(K_SECONDS(10));
+
+        /* 每秒看一眼：马一静下来就转成常开，别让 10 s 到点把刚开始的呼吸窗口掐掉 */
+        for (int i = 0; i < 10 && !respiration_window_active(); i++) {
+            k_sleep(K_SECONDS(1));
+        }
     }
 }
 
@@ -245,3 +969,38 @@ float sensor_get_pressure(void)    { return g_pressure; }
 float sensor_get_roll(void)        { return g_roll; }
 float sensor_get_pitch(void)       { return g_pitch; }
 balance_state_t sensor_get_state(void) { return g_state; }
+
+void sensor_get_imu_sample(struct imu_sample *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&sample_lock);
+    *out = last_imu;
+    k_spin_unlock(&sample_lock, key);
+}
+
+void sensor_get_imu_1hz(struct imu_sample *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&sample_lock);
+    *out = last_imu_1hz;
+    k_spin_unlock(&sample_lock, key);
+}
+
+void sensor_get_imu_2min(struct imu_sample *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&sample_lock);
+    *out = last_imu_2min;
+    k_spin_unlock(&sample_lock, key);
+}
+
+void sensor_get_env_sample(struct env_sample *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&sample_lock);
+    *out = last_env;
+    k_spin_unlock(&sample_lock, key);
+}
+
+void sensor_get_activity(struct imu_activity *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&sample_lock);
+    *out = last_activity;
+    k_spin_unlock(&sample_lock, key);
+}
@@ -1,6 +1,8 @@
 #ifndef SENSOR_H
 #define SENSOR_H
 
+#include "timebase.h"
+
 typedef enum {
     STATE_NORMAL = 0,
     STATE_LEFT,
@@ -8,6 +10,32 @@ typedef enum {
     STATE_FRONT,
     STATE_HIND
 } balance_state_t;
+
+/* 平衡检测的左右 / 前后阈值（度），疝痛检测的打滚判定也用它 */
+#define SENSOR_LR_THRESH_DEG  15.0f
+#define SENSOR_FH_THRESH_DEG  15.0f
+
+/* 带采集时间戳的样本（时间戳在 I2C 读之前打） */
+struct imu_sample {
+    tb_ts_t ts;
+    float heading;
+    float roll;
+    float pitch;
+};
+
+/* 1 s 活动量（10 Hz 陀螺仪样本的角速度模 RMS），GNSS 省电策略用来判断在不在动 */
+struct imu_activity {
+    tb_ts_t ts;               /* 这一秒最后一个样本的时间，0 = 还没有 */
+    float gyro_rms_dps;
+};
+
+struct env_sample {
+    tb_ts_t ts;
+    float temperature;
+    float humidity;
+    float pressure;
+};
+
 extern float g_temperature;
 extern float g_humidity;
 extern float g_pressure;
@@ -25,4 +53,13 @@ float sensor_get_roll(void);
 float sensor_get_pitch(void);
 balance_state_t sensor_get_state(void);
 
+/* 最近一次带时间戳的样本（整体拷贝，字段之间一致） */
+void sensor_get_imu_sample(struct imu_sample *out);   /* 10 Hz */
+
+/* 分频链更慢两级的最近输出：1 Hz 低通，和上报用的两分钟均值 */
+void sensor_get_imu_1hz(struct imu_sample *out);
+void sensor_get_imu_2min(struct imu_sample *out);
+void sensor_get_env_sample(struct env_sample *out);
+void sensor_get_activity(struct imu_activity *out);
+
 #endif /* SENSOR_H */
@@ -0,0 +1,194 @@
+/* sensor_health.c
+ *
+ * 传感器健康监测，见 sensor_health.h。
+ * 所有状态在一个 spinlock 下更新，调用方是传感器线程，开销是几次比较。
+ */
+
+#include "sensor_health.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <math.h>
+
+LOG_MODULE_REGISTER(sensor_health, LOG_LEVEL_INF);
+
+/* ====================== 参数可调 ====================== */
+
+/* 连续失败多少次进入降级 */
+#define HEALTH_DEGRADE_ERRORS   5
+
+/* 降级后周期最多放大 2^6 = 64 倍，且不超过 60 s */
+#define HEALTH_BACKOFF_MAX_LVL  6
+#define HEALTH_BACKOFF_MAX_MS   60000
+
+/* 各通道量程和卡死判定次数（连续完全相同的读数） */
+struct chan_limit {
+    const char *name;
+    float min;
+    float max;
+    uint16_t stuck_n;
+};
+
+static const struct chan_limit limits[HEALTH_CH_COUNT] = {
+    /* BME280 1 Hz：温湿压同时 2 分钟纹丝不动基本就是卡死了 */
+    [HEALTH_CH_TEMP]     = { "temp",     -40.0f,  85.0f,  120 },
+    [HEALTH_CH_HUMIDITY] = { "hum",        0.0f, 100.0f,  120 },
+    [HEALTH_CH_PRESSURE] = { "press",     30.0f, 110.0f,  120 },  /* kPa */
+    /* BNO055 10 Hz：马背上的融合姿态不可能 1 分钟一点不抖 */
+    [HEALTH_CH_HEADING]  = { "heading",    0.0f, 360.0f,  600 },
+    [HEALTH_CH_ROLL]     = { "roll",    -180.0f, 180.0f,  600 },
+    [HEALTH_CH_PITCH]    = { "pitch",    -90.0f,  90.0f,  600 },
+};
+
+static const char *const dev_names[HEALTH_DEV_COUNT] = {
+    [HEALTH_DEV_BNO055] = "BNO055",
+    [HEALTH_DEV_BME280] = "BME280",
+};
+
+/* ====================== 状态 ====================== */
+
+struct chan_state {
+    float    last;
+    uint16_t same_cnt;
+    bool     stuck;
+    bool     out_of_range;
+};
+
+static struct k_spinlock health_lock;
+static struct health_dev_stats devs[HEALTH_DEV_COUNT];
+static struct chan_state chans[HEALTH_CH_COUNT];
+
+/* ====================== 对外接口 ====================== */
+
+void sensor_health_record(enum health_dev dev, int ret, uint8_t retries,
+                          uint32_t latency_us)
+{
+    struct health_dev_stats *d = &devs[dev];
+    int log_change = 0;
+
+    k_spinlock_key_t key = k_spin_lock(&health_lock);
+
+    d->reads++;
+    d->retries += retries;
+    d->latency_last_us = latency_us;
+    d->latency_max_us = MAX(d->latency_max_us, latency_us);
+    d->latency_avg_us = (d->latency_avg_us == 0) ? latency_us :
+                        d->latency_avg_us - d->latency_avg_us / 8 + latency_us / 8;
+
+    if (ret == 0) {
+        if (d->backoff_level) {
+            log_change = -1;
+        }
+        d->consec_errors = 0;
+        d->backoff_level = 0;
+    } else {
+        d->errors++;
+        d->consec_errors++;
+
+        /* 每多失败 HEALTH_DEGRADE_ERRORS 次升一级 */
+        if ((d->consec_errors % HEALTH_DEGRADE_ERRORS) == 0 &&
+            d->backoff_level < HEALTH_BACKOFF_MAX_LVL) {
+            d->backoff_level++;
+            log_change = d->backoff_level;
+        }
+    }
+
+    k_spin_unlock(&health_lock, key);
+
+    if (log_change > 0) {
+        LOG_WRN("%s degraded (level %d, %u consecutive errors)",
+                dev_names[dev], log_change, d->consec_errors);
+    } else if (log_change < 0) {
+        LOG_INF("%s recovered", dev_names[dev]);
+    }
+}
+
+bool sensor_health_check(enum health_chan ch, float value)
+{
+    const struct chan_limit *l = &limits[ch];
+    struct chan_state *c = &chans[ch];
+    bool was_stuck, was_oor;
+
+    k_spinlock_key_t key = k_spin_lock(&health_lock);
+
+    was_stuck = c->stuck;
+    was_oor = c->out_of_range;
+
+    if (value == c->last) {
+        if (c->same_cnt < UINT16_MAX) {
+            c->same_cnt++;
+        }
+    } else {
+        c->same_cnt = 0;
+        c->last = value;
+    }
+
+    c->stuck = (c->same_cnt >= l->stuck_n);
+    c->out_of_range = (value < l->min || value > l->max || isnan(value));
+
+    bool ok = !c->out_of_range;
+    bool stuck = c->stuck, oor = c->out_of_range;
+
+    k_spin_unlock(&health_lock, key);
+
+    if (stuck != was_stuck) {
+        LOG_WRN("%s %s", l->name, stuck ? "stuck" : "unstuck");
+    }
+    if (oor != was_oor) {
+        LOG_WRN("%s %s range", l->name, oor ? "out of" : "back in");
+    }
+
+    return ok;
+}
+
+uint32_t sensor_health_period_ms(enum health_dev dev, uint32_t base_ms)
+{
+    uint8_t lvl = devs[dev].backoff_level;
+
+    if (lvl == 0) {
+        return base_ms;
+    }
+
+    return MIN(base_ms << lvl, MAX(base_ms, HEALTH_BACKOFF_MAX_MS));
+}
+
+bool sensor_health_degraded(enum health_dev dev)
+{
+    return devs[dev].backoff_level > 0;
+}
+
+uint32_t sensor_health_bitmap(void)
+{
+    uint32_t bits = 0;
+
+    k_spinlock_key_t key = k_spin_lock(&health_lock);
+
+    for (int i = 0; i < HEALTH_DEV_COUNT; i++) {
+        if (devs[i].consec_errors) {
+            bits |= HEALTH_BIT_FAULT(i);
+        }
+        if (devs[i].backoff_level) {
+            bits |= HEALTH_BIT_DEGRADED(i);
+        }
+    }
+
+    for (int i = 0; i < HEALTH_CH_COUNT; i++) {
+        if (chans[i].stuck) {
+            bits |= HEALTH_BIT_STUCK(i);
+        }
+        if (chans[i].out_of_range) {
+            bits |= HEALTH_BIT_RANGE(i);
+        }
+    }
+
+    k_spin_unlock(&health_lock, key);
+
+    return bits;
+}
+
+void sensor_health_get(enum health_dev dev, struct health_dev_stats *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&health_lock);
+    *out = devs[dev];
+    k_spin_unlock(&health_lock, key);
+}
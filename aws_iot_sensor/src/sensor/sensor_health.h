@@ -0,0 +1,73 @@
+#ifndef SENSOR_HEALTH_H_
+#define SENSOR_HEALTH_H_
+
+#include <zephyr/kernel.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * 传感器健康监测
+ *
+ * - 每个设备统计 I2C 读次数 / 错误 / 重试 / 读耗时；
+ * - 每个通道检测卡死（连续 N 次完全相同）和超量程；
+ * - 连续失败的设备进入降级模式，采样周期指数退避，
+ *   避免坏掉的硬件让线程一直在重试循环里空转；
+ * - 汇总成一个 32 位 bitmap，随 shadow reported 上报。
+ */
+
+enum health_dev {
+    HEALTH_DEV_BNO055 = 0,
+    HEALTH_DEV_BME280,
+    HEALTH_DEV_COUNT,
+};
+
+enum health_chan {
+    HEALTH_CH_TEMP = 0,
+    HEALTH_CH_HUMIDITY,
+    HEALTH_CH_PRESSURE,
+    HEALTH_CH_HEADING,
+    HEALTH_CH_ROLL,
+    HEALTH_CH_PITCH,
+    HEALTH_CH_COUNT,
+};
+
+/* bitmap 布局：
+ *   bit  0..7  每设备两位：FAULT（最近一次读失败）/ DEGRADED（降级采样中）
+ *   bit  8..15 每通道一位：STUCK
+ *   bit 16..23 每通道一位：RANGE（超量程）
+ */
+#define HEALTH_BIT_FAULT(dev)     BIT(2 * (dev))
+#define HEALTH_BIT_DEGRADED(dev)  BIT(2 * (dev) + 1)
+#define HEALTH_BIT_STUCK(ch)      BIT(8 + (ch))
+#define HEALTH_BIT_RANGE(ch)      BIT(16 + (ch))
+
+struct health_dev_stats {
+    uint32_t reads;
+    uint32_t errors;
+    uint32_t retries;          /* 总线调度器为这个设备做的重试 */
+    uint32_t consec_errors;
+    uint32_t latency_last_us;
+    uint32_t latency_max_us;
+    uint32_t latency_avg_us;   /* 1/8 指数平均 */
+    uint8_t  backoff_level;    /* 0 = 正常，>0 = 降级，周期 x 2^level */
+};
+
+/* 记录一次设备访问：ret 为 I2C 返回值，retries 为总线层重试次数 */
+void sensor_health_record(enum health_dev dev, int ret, uint8_t retries,
+                          uint32_t latency_us);
+
+/* 喂一个通道读数，做卡死 / 量程检查。
+ * 返回 false 表示超量程，这个值不要用；卡死只记进 bitmap，值照常返回 true。
+ */
+bool sensor_health_check(enum health_chan ch, float value);
+
+/* 设备当前应使用的采样周期：正常返回 base_ms，降级时按退避等级放大 */
+uint32_t sensor_health_period_ms(enum health_dev dev, uint32_t base_ms);
+
+bool sensor_health_degraded(enum health_dev dev);
+
+uint32_t sensor_health_bitmap(void);
+
+void sensor_health_get(enum health_dev dev, struct health_dev_stats *out);
+
+#endif /* SENSOR_HEALTH_H_ */
@@ -0,0 +1,89 @@
+/* step_cadence.c
+ *
+ * 加速度模穿零的步频检测，见 step_cadence.h。
+ */
+
+#include "step_cadence.h"
+
+#include <string.h>
+
+/* ====================== 参数可调 ====================== */
+
+/* 重力 EMA 系数（10 Hz 下时间常数约 2 s） */
+#define STEP_MEAN_ALPHA     0.05f
+
+/* 穿零前至少要掉到多低 (m/s²)：慢走时鬐甲起伏约 ±1.5 m/s² */
+#define STEP_THRESH         0.6f
+
+/* 合理的步态周期 (ms)：快跑约 0.3 s 一个起伏，慢走约 1 s */
+#define STEP_MIN_PERIOD_MS  250
+#define STEP_MAX_PERIOD_MS  2000
+
+/* 这么久没有穿零算站着 */
+#define STEP_TIMEOUT_MS     2500
+
+/* 周期平滑系数 */
+#define STEP_PERIOD_ALPHA   0.3f
+
+/* 样本间隔超过这个认为 IMU 断过电（占空比），重新开始检测 */
+#define STEP_GAP_MS         500
+
+void step_cadence_init(struct step_cadence *sc)
+{
+    memset(sc, 0, sizeof(*sc));
+}
+
+float step_cadence_feed(struct step_cadence *sc, uint32_t now_ms, float acc_mag)
+{
+    if (!sc->have_prev || now_ms - sc->prev_ms > STEP_GAP_MS) {
+        /* 第一个样本 / IMU 刚上电：重力从这个样本开始估，步频先保持，等超时或新的穿零 */
+        if (sc->mean == 0.0f) {
+            sc->mean = acc_mag;
+        }
+        sc->prev = acc_mag - sc->mean;
+        sc->prev_ms = now_ms;
+        sc->have_prev = true;
+        sc->have_cross = false;
+        sc->armed = false;
+        sc->idle_ms = now_ms;
+        return sc->cadence_hz;
+    }
+
+    sc->mean += STEP_MEAN_ALPHA * (acc_mag - sc->mean);
+
+    float d = acc_mag - sc->mean;
+
+    if (d < -STEP_THRESH) {
+        sc->armed = true;
+    }
+
+    if (sc->armed && sc->prev < 0.0f && d >= 0.0f) {
+        /* 向上穿零，插值到两个样本之间 */
+        uint32_t t = sc->prev_ms + (uint32_t)((float)(now_ms - sc->prev_ms) *
+                                              (-sc->prev) / (d - sc->prev));
+
+        if (sc->have_cross) {
+            uint32_t period = t - sc->cross_ms;
+
+            if (period >= STEP_MIN_PERIOD_MS && period <= STEP_MAX_PERIOD_MS) {
+                sc->period_ms = (sc->period_ms == 0.0f) ? (float)period :
+                                sc->period_ms + STEP_PERIOD_ALPHA * ((float)period - sc->period_ms);
+                sc->cadence_hz = 1000.0f / sc->period_ms;
+            }
+        }
+        sc->cross_ms = t;
+        sc->idle_ms = t;
+        sc->have_cross = true;
+        sc->armed = false;
+    }
+
+    if (now_ms - sc->idle_ms > STEP_TIMEOUT_MS) {
+        sc->period_ms = 0.0f;
+        sc->cadence_hz = 0.0f;
+        sc->have_cross = false;
+    }
+
+    sc->prev = d;
+    sc->prev_ms = now_ms;
+    return sc->cadence_hz;
+}
@@ -0,0 +1,36 @@
+#ifndef STEP_CADENCE_H_
+#define STEP_CADENCE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * 步频检测 —— 纯逻辑，不依赖内核。
+ *
+ * 输入 10 Hz 的鬐甲加速度模（m/s²，和 IMU 的安装方向无关）。走动时躯干每个步态周期
+ * 上下起伏，加速度模去掉重力（慢 EMA）以后是一个振荡：先掉到 -STEP_THRESH 以下
+ * 再向上穿过 0 算一次，两次穿零的间隔（线性插值到样本之间）平滑后就是步频。
+ * 咀嚼、甩尾这种小动作过不了幅度门限；超过 STEP_TIMEOUT_MS 没有穿零算站着，步频 0。
+ *
+ * 只在一个线程里用，不加锁。时间是单调毫秒（uint32_t，回绕无妨）。
+ */
+
+struct step_cadence {
+    float    mean;              /* 重力（加速度模的慢均值） */
+    float    prev;              /* 上一个去掉重力的样本 */
+    uint32_t prev_ms;
+    bool     have_prev;
+    bool     armed;             /* 上次穿零以后掉到过 -STEP_THRESH 以下 */
+    bool     have_cross;
+    uint32_t cross_ms;          /* 上一次向上穿零的时间（插值） */
+    uint32_t idle_ms;           /* 超时从这个时间算起（最近一次穿零或者重新开始） */
+    float    period_ms;         /* 平滑后的周期，0 = 还没有 */
+    float    cadence_hz;
+};
+
+void step_cadence_init(struct step_cadence *sc);
+
+/* 一个 10 Hz 样本，返回当前步频 (Hz)，0 = 站着 */
+float step_cadence_feed(struct step_cadence *sc, uint32_t now_ms, float acc_mag);
+
+#endif /* STEP_CADENCE_H_ */
@@ -0,0 +1,111 @@
+/* app_fs.c
+ *
+ * littlefs 挂载在 partition manager 分配的 littlefs_storage 分区上
+ * （nRF9151 DK 上放在外部 SPI flash，见 boards/nrf9151dk_nrf9151_ns.conf）。
+ */
+
+#include "app_fs.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/fs/littlefs.h>
+#include <zephyr/storage/flash_map.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(app_fs, LOG_LEVEL_INF);
+
+FS_LITTLEFS_DECLARE_DEFAULT_CONFIG(lfs_data);
+
+static struct fs_mount_t lfs_mnt = {
+    .type = FS_LITTLEFS,
+    .fs_data = &lfs_data,
+    .storage_dev = (void *)FIXED_PARTITION_ID(littlefs_storage),
+    .mnt_point = APP_FS_MNT,
+};
+
+static bool mounted;
+
+int app_fs_init(void)
+{
+    int err;
+
+    if (mounted) {
+        return 0;
+    }
+
+    err = fs_mount(&lfs_mnt);
+    if (err) {
+        LOG_ERR("littlefs mount failed (%d)", err);
+        return err;
+    }
+
+    mounted = true;
+
+    struct fs_statvfs st;
+
+    if (fs_statvfs(APP_FS_MNT, &st) == 0) {
+        LOG_INF("littlefs mounted at %s: %lu/%lu blocks free",
+                APP_FS_MNT, (unsigned long)st.f_bfree,
+                (unsigned long)st.f_blocks);
+    }
+
+    return 0;
+}
+
+bool app_fs_ready(void)
+{
+    return mounted;
+}
+
+int app_fs_mkdir(const char *path)
+{
+    int err = fs_mkdir(path);
+
+    return (err == -EEXIST) ? 0 : err;
+}
+
+int app_fs_read_file(const char *path, void *buf, size_t len)
+{
+    struct fs_file_t f;
+    ssize_t n;
+    int err;
+
+    fs_file_t_init(&f);
+
+    err = fs_open(&f, path, FS_O_READ);
+    if (err) {
+        return err;
+    }
+
+    n = fs_read(&f, buf, len);
+    (void)fs_close(&f);
+
+    if (n < 0) {
+        return (int)n;
+    }
+    return (n == (ssize_t)len) ? 0 : -ENODATA;
+}
+
+int app_fs_write_file(const char *path, const void *buf, size_t len)
+{
+    struct fs_file_t f;
+    ssize_t n;
+    int err;
+
+    fs_file_t_init(&f);
+
+    err = fs_open(&f, path, FS_O_CREATE | FS_O_WRITE | FS_O_TRUNC);
+    if (err) {
+        return err;
+    }
+
+    n = fs_write(&f, buf, len);
+    err = fs_close(&f);
+
+    if (n < 0) {
+        return (int)n;
+    }
+    if (n != (ssize_t)len) {
+        return -ENOSPC;
+    }
+    return err;
+}
@@ -0,0 +1,23 @@
+#ifndef APP_FS_H_
+#define APP_FS_H_
+
+#include <zephyr/fs/fs.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* littlefs 挂载点（抓拍数据、遥测日志、校准参数都放这里） */
+#define APP_FS_MNT "/lfs"
+
+/* 挂载 littlefs，挂载失败时 littlefs 会自动格式化 */
+int app_fs_init(void);
+
+bool app_fs_ready(void);
+
+/* 建目录，已存在不算错误 */
+int app_fs_mkdir(const char *path);
+
+/* 读 / 写一个小文件（整文件覆盖），用于保存状态结构体 */
+int app_fs_read_file(const char *path, void *buf, size_t len);
+int app_fs_write_file(const char *path, const void *buf, size_t len);
+
+#endif /* APP_FS_H_ */
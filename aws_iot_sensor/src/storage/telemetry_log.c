@@ -0,0 +1,657 @@
+/* telemetry_log.c
+ *
+ * 列式遥测日志，格式见 telemetry_log.h。
+ * - 每个通道在 RAM 里攒一个块，满了（或时间基准变了）才 append 到 .col；
+ * - .col 超过 CONFIG_HORSE_TLOG_MAX_BLOCKS 块就轮换成 .old（只保留两代）；
+ * - .idx 每 TLOG_INDEX_STRIDE 块记一条 (t_first, block_no)，只索引 UTC 块；
+ * - tlog_sample_work 每 CONFIG_HORSE_TLOG_INTERVAL_SEC 秒从传感器 / GNSS 取一次样本。
+ */
+
+#include "telemetry_log.h"
+#include "app_fs.h"
+#include "timebase.h"
+#include "sensor.h"
+#include "gnss_task.h"
+#include "mqtt_id.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/fs/fs.h>
+#include <net/aws_iot.h>
+#include <stdio.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(telemetry_log, LOG_LEVEL_INF);
+
+/* ====================== 参数可调 ====================== */
+
+#define TLOG_DIR            APP_FS_MNT "/tlog"
+#define TLOG_BOOT_PATH      TLOG_DIR "/boot"
+#define TLOG_TOPIC          "horse_tlog"
+
+/* 稀疏索引步长（块） */
+#define TLOG_INDEX_STRIDE   8
+
+/* 上传时两条消息之间的间隔，别把 MQTT 发送队列塞满 */
+#define TLOG_UPLOAD_GAP_MS  200
+
+#define TLOG_PATH_MAX       32
+
+/* ====================== 状态 ====================== */
+
+struct tlog_index_entry {
+    uint32_t t_first;
+    uint32_t block_no;
+};
+
+/* 两代文件：0 = .old，1 = 当前 .col */
+enum tlog_gen {
+    TLOG_GEN_OLD = 0,
+    TLOG_GEN_CUR,
+    TLOG_GEN_COUNT,
+};
+
+struct tlog_chan {
+    uint8_t  block[TLOG_BLOCK_SIZE];   /* 正在攒的块 */
+    uint32_t nblocks;                  /* 当前 .col 里的块数 */
+};
+
+static const char *const ch_names[TLOG_CH_COUNT] = {
+    [TLOG_CH_TEMP]     = "temp",
+    [TLOG_CH_HUMIDITY] = "hum",
+    [TLOG_CH_PRESSURE] = "press",
+    [TLOG_CH_ROLL]     = "roll",
+    [TLOG_CH_PITCH]    = "pitch",
+    [TLOG_CH_LAT]      = "lat",
+    [TLOG_CH_LON]      = "lon",
+    [TLOG_CH_WATER]    = "water",
+};
+
+static struct tlog_chan chans[TLOG_CH_COUNT];
+static uint16_t boot_count;
+static bool ready;
+
+K_MUTEX_DEFINE(tlog_lock);
+
+/* 上传游标 */
+static struct {
+    bool     active;
+    uint32_t from;
+    uint32_t to;
+    uint8_t  ch;
+    uint8_t  gen;
+    uint32_t blk;       /* UINT32_MAX: 需要先查索引 */
+    uint32_t sent;
+} up;
+
+static void tlog_sample_work_fn(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(tlog_sample_work, tlog_sample_work_fn);
+
+static void tlog_upload_work_fn(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(tlog_upload_work, tlog_upload_work_fn);
+
+/* ====================== 工具函数 ====================== */
+
+static struct tlog_block_hdr *blk_hdr(enum tlog_channel ch)
+{
+    return (struct tlog_block_hdr *)chans[ch].block;
+}
+
+static struct tlog_record *blk_rec(uint8_t *block)
+{
+    return (struct tlog_record *)(block + sizeof(struct tlog_block_hdr));
+}
+
+static void col_path(char *buf, enum tlog_channel ch, enum tlog_gen gen)
+{
+    snprintf(buf, TLOG_PATH_MAX, TLOG_DIR "/%s.%s", ch_names[ch],
+             gen == TLOG_GEN_CUR ? "col" : "old");
+}
+
+static void idx_path(char *buf, enum tlog_channel ch, enum tlog_gen gen)
+{
+    snprintf(buf, TLOG_PATH_MAX, TLOG_DIR "/%s.%s", ch_names[ch],
+             gen == TLOG_GEN_CUR ? "idx" : "oidx");
+}
+
+static int append_file(const char *path, const void *buf, size_t len)
+{
+    struct fs_file_t f;
+    ssize_t n;
+    int err;
+
+    fs_file_t_init(&f);
+    err = fs_open(&f, path, FS_O_CREATE | FS_O_WRITE | FS_O_APPEND);
+    if (err) {
+        return err;
+    }
+
+    n = fs_write(&f, buf, len);
+    err = fs_close(&f);
+
+    return (n == (ssize_t)len) ? err : -EIO;
+}
+
+static uint32_t file_blocks(const char *path)
+{
+    struct fs_dirent ent;
+
+    if (fs_stat(path, &ent) != 0) {
+        return 0;
+    }
+    return ent.size / TLOG_BLOCK_SIZE;
+}
+
+/* .col 写满了：当前代变成 .old，旧的 .old 丢掉 */
+static void rotate(enum tlog_channel ch)
+{
+    char col[TLOG_PATH_MAX], old[TLOG_PATH_MAX];
+    char idx[TLOG_PATH_MAX], oidx[TLOG_PATH_MAX];
+
+    col_path(col, ch, TLOG_GEN_CUR);
+    col_path(old, ch, TLOG_GEN_OLD);
+    idx_path(idx, ch, TLOG_GEN_CUR);
+    idx_path(oidx, ch, TLOG_GEN_OLD);
+
+    (void)fs_unlink(old);
+    (void)fs_unlink(oidx);
+    (void)fs_rename(col, old);
+    (void)fs_rename(idx, oidx);
+
+    chans[ch].nblocks = 0;
+    LOG_INF("tlog %s rotated", ch_names[ch]);
+}
+
+/* 调用方持 tlog_lock */
+static void flush_block(enum tlog_channel ch)
+{
+    struct tlog_block_hdr *h = blk_hdr(ch);
+    char path[TLOG_PATH_MAX];
+    int err;
+
+    if (h->count == 0) {
+        return;
+    }
+
+    if (chans[ch].nblocks >= CONFIG_HORSE_TLOG_MAX_BLOCKS) {
+        rotate(ch);
+    }
+
+    col_path(path, ch, TLOG_GEN_CUR);
+    err = append_file(path, chans[ch].block, TLOG_BLOCK_SIZE);
+    if (err) {
+        LOG_ERR("tlog %s block write failed (%d)", ch_names[ch], err);
+    } else {
+        if ((chans[ch].nblocks % TLOG_INDEX_STRIDE) == 0 && (h->flags & TLOG_F_UTC)) {
+            struct tlog_index_entry e = {
+                .t_first = h->t_first,
+                .block_no = chans[ch].nblocks,
+            };
+
+            idx_path(path, ch, TLOG_GEN_CUR);
+            (void)append_file(path, &e, sizeof(e));
+        }
+        chans[ch].nblocks++;
+    }
+
+    memset(chans[ch].block, 0, TLOG_BLOCK_SIZE);
+}
+
+/* ====================== 读路径 ====================== */
+
+/* 用稀疏索引找第一个可能包含 from 的块 */
+static uint32_t index_lookup(enum tlog_channel ch, enum tlog_gen gen, uint32_t from)
+{
+    char path[TLOG_PATH_MAX];
+    struct fs_file_t f;
+    struct tlog_index_entry e;
+    uint32_t start = 0;
+
+    idx_path(path, ch, gen);
+    fs_file_t_init(&f);
+    if (fs_open(&f, path, FS_O_READ) != 0) {
+        return 0;
+    }
+
+    while (fs_read(&f, &e, sizeof(e)) == sizeof(e)) {
+        if (e.t_first > from) {
+            break;
+        }
+        start = e.block_no;
+    }
+
+    (void)fs_close(&f);
+    return start;
+}
+
+static bool hdr_overlaps(const struct tlog_block_hdr *h, uint32_t from, uint32_t to)
+{
+    return h->magic == TLOG_BLOCK_MAGIC && (h->flags & TLOG_F_UTC) &&
+           h->count > 0 && h->t_last >= from && h->t_first <= to;
+}
+
+/*
+ * 扫描一代文件中和 [from, to] 相交的块，每块调一次 fn（数据区读到 block 里）。
+ * want_data == false 且块完全落在区间内时只读块头。
+ */
+typedef void (*block_fn_t)(const uint8_t *block, bool has_data, uint32_t from,
+                           uint32_t to, void *user);
+
+static void scan_gen(enum tlog_channel ch, enum tlog_gen gen, uint32_t from,
+                     uint32_t to, bool want_data, block_fn_t fn, void *user)
+{
+    static uint8_t block[TLOG_BLOCK_SIZE];
+    struct tlog_block_hdr *h = (struct tlog_block_hdr *)block;
+    char path[TLOG_PATH_MAX];
+    struct fs_file_t f;
+
+    col_path(path, ch, gen);
+    uint32_t nblk = file_blocks(path);
+    uint32_t b = index_lookup(ch, gen, from);
+
+    fs_file_t_init(&f);
+    if (fs_open(&f, path, FS_O_READ) != 0) {
+        return;
+    }
+
+    for (; b < nblk; b++) {
+        (void)fs_seek(&f, (off_t)b * TLOG_BLOCK_SIZE, FS_SEEK_SET);
+        if (fs_read(&f, block, sizeof(*h)) != sizeof(*h)) {
+            break;
+        }
+
+        if (h->magic == TLOG_BLOCK_MAGIC && (h->flags & TLOG_F_UTC) &&
+            h->t_first > to) {
+            break;  /* 之后的块都更晚 */
+        }
+        if (!hdr_overlaps(h, from, to)) {
+            continue;
+        }
+
+        bool inside = h->t_first >= from && h->t_last <= to;
+        bool has_data = want_data || !inside;
+
+        if (has_data) {
+            size_t len = MIN(h->count, TLOG_RECORDS_PER_BLOCK) *
+                         sizeof(struct tlog_record);
+
+            if (fs_read(&f, block + sizeof(*h), len) != (ssize_t)len) {
+                break;
+            }
+        }
+
+        fn(block, has_data, from, to, user);
+    }
+
+    (void)fs_close(&f);
+}
+
+static void scan_all(enum tlog_channel ch, uint32_t from, uint32_t to,
+                     bool want_data, block_fn_t fn, void *user)
+{
+    scan_gen(ch, TLOG_GEN_OLD, from, to, want_data, fn, user);
+    scan_gen(ch, TLOG_GEN_CUR, from, to, want_data, fn, user);
+
+    /* 还在 RAM 里的块 */
+    if (hdr_overlaps(blk_hdr(ch), from, to)) {
+        fn(chans[ch].block, true, from, to, user);
+    }
+}
+
+struct query_ctx {
+    enum tlog_channel ch;
+    tlog_sample_cb_t cb;
+    void *user;
+    int n;
+};
+
+static void query_block(const uint8_t *block, bool has_data, uint32_t from,
+                        uint32_t to, void *user)
+{
+    const struct tlog_block_hdr *h = (const struct tlog_block_hdr *)block;
+    const struct tlog_record *r = blk_rec((uint8_t *)block);
+    struct query_ctx *q = user;
+
+    ARG_UNUSED(has_data);
+
+    for (uint16_t i = 0; i < h->count && i < TLOG_RECORDS_PER_BLOCK; i++) {
+        uint32_t t = h->t_first + r[i].dt;
+
+        if (t >= from && t <= to) {
+            if (q->cb) {
+                q->cb(q->ch, t, r[i].value, q->user);
+            }
+            q->n++;
+        }
+    }
+}
+
+struct stats_ctx {
+    int32_t  min;
+    int32_t  max;
+    uint32_t count;
+};
+
+static void stats_block(const uint8_t *block, bool has_data, uint32_t from,
+                        uint32_t to, void *user)
+{
+    const struct tlog_block_hdr *h = (const struct tlog_block_hdr *)block;
+    const struct tlog_record *r = blk_rec((uint8_t *)block);
+    struct stats_ctx *s = user;
+
+    if (!has_data) {
+        /* 整块在区间内：直接用块头 */
+        s->min = MIN(s->min, h->min);
+        s->max = MAX(s->max, h->max);
+        s->count += h->count;
+        return;
+    }
+
+    for (uint16_t i = 0; i < h->count && i < TLOG_RECORDS_PER_BLOCK; i++) {
+        uint32_t t = h->t_first + r[i].dt;
+
+        if (t >= from && t <= to) {
+            s->min = MIN(s->min, r[i].value);
+            s->max = MAX(s->max, r[i].value);
+            s->count++;
+        }
+    }
+}
+
+/* ====================== 采样 ====================== */
+
+static void tlog_sample_work_fn(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    static tb_ts_t last_env_ts, last_imu_ts, last_gnss_ts;
+    struct env_sample env;
+    struct imu_sample imu;
+    struct gnss_status_msg gnss;
+
+    sensor_get_env_sample(&env);
+    if (env.ts != 0 && env.ts != last_env_ts) {
+        last_env_ts = env.ts;
+        (void)tlog_append(TLOG_CH_TEMP,     env.ts, (int32_t)(env.temperature * 100.0f));
+        (void)tlog_append(TLOG_CH_HUMIDITY, env.ts, (int32_t)(env.humidity * 100.0f));
+        (void)tlog_append(TLOG_CH_PRESSURE, env.ts, (int32_t)(env.pressure * 1000.0f));
+    }
+
+    sensor_get_imu_1hz(&imu);
+    if (imu.ts != 0 && imu.ts != last_imu_ts) {
+        last_imu_ts = imu.ts;
+        (void)tlog_append(TLOG_CH_ROLL,  imu.ts, (int32_t)(imu.roll * 100.0f));
+        (void)tlog_append(TLOG_CH_PITCH, imu.ts, (int32_t)(imu.pitch * 100.0f));
+    }
+
+    if (gnss_get_latest(&gnss) && gnss.ts != last_gnss_ts) {
+        last_gnss_ts = gnss.ts;
+        (void)tlog_append(TLOG_CH_LAT,   gnss.ts, (int32_t)(gnss.lat * 1000000.0));
+        (void)tlog_append(TLOG_CH_LON,   gnss.ts, (int32_t)(gnss.lon * 1000000.0));
+        (void)tlog_append(TLOG_CH_WATER, gnss.ts, (int32_t)gnss.total_water_s);
+    }
+
+    k_work_reschedule(&tlog_sample_work, K_SECONDS(CONFIG_HORSE_TLOG_INTERVAL_SEC));
+}
+
+/* ====================== 上传 ====================== */
+
+/* 在当前 (ch, gen) 文件里从 up.blk 开始找下一个相交的块，找到读进 block 返回 true */
+static bool upload_next_block(uint8_t *block)
+{
+    struct tlog_block_hdr *h = (struct tlog_block_hdr *)block;
+    char path[TLOG_PATH_MAX];
+    struct fs_file_t f;
+    bool found = false;
+
+    if (up.blk == UINT32_MAX) {
+        up.blk = index_lookup(up.ch, up.gen, up.from);
+    }
+
+    col_path(path, up.ch, up.gen);
+    uint32_t nblk = file_blocks(path);
+
+    fs_file_t_init(&f);
+    if (up.blk >= nblk || fs_open(&f, path, FS_O_READ) != 0) {
+        return false;
+    }
+
+    for (; up.blk < nblk; up.blk++) {
+        (void)fs_seek(&f, (off_t)up.blk * TLOG_BLOCK_SIZE, FS_SEEK_SET);
+        if (fs_read(&f, block, TLOG_BLOCK_SIZE) != TLOG_BLOCK_SIZE) {
+            break;
+        }
+        if (h->magic == TLOG_BLOCK_MAGIC && (h->flags & TLOG_F_UTC) &&
+            h->t_first > up.to) {
+            break;
+        }
+        if (hdr_overlaps(h, up.from, up.to)) {
+            found = true;
+            break;
+        }
+    }
+
+    (void)fs_close(&f);
+    return found;
+}
+
+static void tlog_upload_work_fn(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    static uint8_t block[TLOG_BLOCK_SIZE];
+    struct tlog_block_hdr *h = (struct tlog_block_hdr *)block;
+    k_timeout_t next = K_MSEC(TLOG_UPLOAD_GAP_MS);
+
+    k_mutex_lock(&tlog_lock, K_FOREVER);
+
+    /* 每次只发一块，发完交还工作队列 */
+    while (up.active) {
+        if (up.ch >= TLOG_CH_COUNT) {
+            LOG_INF("tlog upload done: %u blocks", up.sent);
+            up.active = false;
+            break;
+        }
+
+        if (!upload_next_block(block)) {
+            /* 这个文件没有了，换下一代 / 下一个通道 */
+            up.blk = UINT32_MAX;
+            if (++up.gen >= TLOG_GEN_COUNT) {
+                up.gen = TLOG_GEN_OLD;
+                up.ch++;
+            }
+            continue;
+        }
+
+        struct aws_iot_data tx = { 0 };
+
+        tx.qos       = MQTT_QOS_1_AT_LEAST_ONCE;
+        tx.message_id = mqtt_id_next();
+        tx.ptr       = (char *)block;
+        tx.len       = sizeof(*h) + h->count * sizeof(struct tlog_record);
+        tx.topic.str = TLOG_TOPIC;
+        tx.topic.len = strlen(TLOG_TOPIC);
+
+        if (aws_iot_send(&tx) != 0) {
+            /* 没连上：游标不动，过一会儿重试同一块 */
+            LOG_WRN("tlog upload paused at %s blk %u", ch_names[up.ch], up.blk);
+            next = K_SECONDS(CONFIG_HORSE_TLOG_INTERVAL_SEC);
+        } else {
+            up.sent++;
+            up.blk++;
+        }
+        break;
+    }
+
+    bool more = up.active;
+
+    k_mutex_unlock(&tlog_lock);
+
+    if (more) {
+        k_work_reschedule(&tlog_upload_work, next);
+    }
+}
+
+/* ====================== 对外接口 ====================== */
+
+int tlog_init(void)
+{
+    char path[TLOG_PATH_MAX];
+    int err;
+
+    if (!app_fs_ready()) {
+        return -ENODEV;
+    }
+
+    err = app_fs_mkdir(TLOG_DIR);
+    if (err) {
+        return err;
+    }
+
+    (void)app_fs_read_file(TLOG_BOOT_PATH, &boot_count, sizeof(boot_count));
+    boot_count++;
+    (void)app_fs_write_file(TLOG_BOOT_PATH, &boot_count, sizeof(boot_count));
+
+    for (int ch = 0; ch < TLOG_CH_COUNT; ch++) {
+        col_path(path, ch, TLOG_GEN_CUR);
+        chans[ch].nblocks = file_blocks(path);
+    }
+
+    ready = true;
+    k_work_reschedule(&tlog_sample_work, K_SECONDS(CONFIG_HORSE_TLOG_INTERVAL_SEC));
+
+    LOG_INF("tlog ready (boot %u, %u records/block)", boot_count,
+            (unsigned int)TLOG_RECORDS_PER_BLOCK);
+    return 0;
+}
+
+int tlog_append(enum tlog_channel ch, uint64_t ts, int32_t value)
+{
+    int64_t utc_ms;
+    uint32_t t;
+    uint8_t flags;
+
+    if (!ready || ch >= TLOG_CH_COUNT) {
+        return -ENODEV;
+    }
+
+    if (timebase_to_utc_ms(ts, &utc_ms)) {
+        t = (uint32_t)(utc_ms / 1000);
+        flags = TLOG_F_UTC;
+    } else {
+        t = (uint32_t)(ts / TB_FREQ_HZ);
+        flags = 0;
+    }
+
+    k_mutex_lock(&tlog_lock, K_FOREVER);
+
+    struct tlog_block_hdr *h = blk_hdr(ch);
+
+    /* 时间基准变了 / 时间回退 / dt 溢出：先把当前块写掉 */
+    if (h->count > 0 &&
+        (h->flags != flags || t < h->t_first || t - h->t_first > UINT16_MAX)) {
+        flush_block(ch);
+    }
+
+    if (h->count == 0) {
+        h->magic   = TLOG_BLOCK_MAGIC;
+        h->channel = ch;
+        h->flags   = flags;
+        h->boot    = boot_count;
+        h->t_first = t;
+        h->min     = value;
+        h->max     = value;
+    }
+
+    struct tlog_record *r = &blk_rec(chans[ch].block)[h->count];
+
+    r->dt    = (uint16_t)(t - h->t_first);
+    r->value = value;
+    h->count++;
+    h->t_last = t;
+    h->min = MIN(h->min, value);
+    h->max = MAX(h->max, value);
+
+    if (h->count >= TLOG_RECORDS_PER_BLOCK) {
+        flush_block(ch);
+    }
+
+    k_mutex_unlock(&tlog_lock);
+    return 0;
+}
+
+void tlog_flush_all(void)
+{
+    if (!ready) {
+        return;
+    }
+
+    k_mutex_lock(&tlog_lock, K_FOREVER);
+    for (int ch = 0; ch < TLOG_CH_COUNT; ch++) {
+        flush_block(ch);
+    }
+    k_mutex_unlock(&tlog_lock);
+}
+
+int tlog_query(enum tlog_channel ch, uint32_t from, uint32_t to,
+               tlog_sample_cb_t cb, void *user)
+{
+    struct query_ctx q = { .ch = ch, .cb = cb, .user = user };
+
+    if (!ready || ch >= TLOG_CH_COUNT) {
+        return -ENODEV;
+    }
+
+    k_mutex_lock(&tlog_lock, K_FOREVER);
+    scan_all(ch, from, to, true, query_block, &q);
+    k_mutex_unlock(&tlog_lock);
+
+    return q.n;
+}
+
+int tlog_range_stats(enum tlog_channel ch, uint32_t from, uint32_t to,
+                     int32_t *min, int32_t *max, uint32_t *count)
+{
+    struct stats_ctx s = { .min = INT32_MAX, .max = INT32_MIN };
+
+    if (!ready || ch >= TLOG_CH_COUNT) {
+        return -ENODEV;
+    }
+
+    k_mutex_lock(&tlog_lock, K_FOREVER);
+    scan_all(ch, from, to, false, stats_block, &s);
+    k_mutex_unlock(&tlog_lock);
+
+    *min = s.min;
+    *max = s.max;
+    *count = s.count;
+    return 0;
+}
+
+int tlog_upload_range(uint32_t from, uint32_t to)
+{
+    if (!ready) {
+        return -ENODEV;
+    }
+
+    k_mutex_lock(&tlog_lock, K_FOREVER);
+
+    if (up.active) {
+        k_mutex_unlock(&tlog_lock);
+        return -EBUSY;
+    }
+
+    up.active = true;
+    up.from = from;
+    up.to = to;
+    up.ch = 0;
+    up.gen = TLOG_GEN_OLD;
+    up.blk = UINT32_MAX;
+    up.sent = 0;
+
+    k_mutex_unlock(&tlog_lock);
+
+    LOG_INF("tlog upload %u..%u", from, to);
+    k_work_reschedule(&tlog_upload_work, K_NO_WAIT);
+    return 0;
+}
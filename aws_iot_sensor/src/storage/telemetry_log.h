@@ -0,0 +1,77 @@
+#ifndef TELEMETRY_LOG_H_
+#define TELEMETRY_LOG_H_
+
+#include <zephyr/kernel.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * 列式遥测日志（littlefs）
+ *
+ * 每个通道一个只追加的列文件 /lfs/tlog/<name>.col，由固定大小的块组成：
+ *   块头（通道、条数、时间范围、min/max）+ 若干 (dt, value) 记录。
+ * 每 TLOG_INDEX_STRIDE 块往 <name>.idx 追加一条稀疏时间索引。
+ * 区间查询 / 上传先查索引定位起始块，再只读块头跳过不相关的块。
+ * 样本先攒在 RAM 里，整块满了才写一次 flash。
+ */
+
+enum tlog_channel {
+    TLOG_CH_TEMP = 0,    /* 温度 x100 (degC) */
+    TLOG_CH_HUMIDITY,    /* 湿度 x100 (%) */
+    TLOG_CH_PRESSURE,    /* 气压 (Pa) */
+    TLOG_CH_ROLL,        /* roll x100 (deg) */
+    TLOG_CH_PITCH,       /* pitch x100 (deg) */
+    TLOG_CH_LAT,         /* 纬度 x1e6 */
+    TLOG_CH_LON,         /* 经度 x1e6 */
+    TLOG_CH_WATER,       /* 当天喝水时间 (s) */
+    TLOG_CH_COUNT,
+};
+
+#define TLOG_BLOCK_SIZE    256
+#define TLOG_BLOCK_MAGIC   0x7B10
+
+/* 块头标志：时间是 UTC 秒；否则是本次启动后的秒数（见 boot） */
+#define TLOG_F_UTC         BIT(0)
+
+struct tlog_block_hdr {
+    uint16_t magic;
+    uint8_t  channel;
+    uint8_t  flags;
+    uint16_t count;
+    uint16_t boot;       /* 启动计数，非 UTC 块用来区分时间轴 */
+    uint32_t t_first;
+    uint32_t t_last;
+    int32_t  min;
+    int32_t  max;
+} __packed;
+
+struct tlog_record {
+    uint16_t dt;         /* 相对 t_first 的秒数 */
+    int32_t  value;
+} __packed;
+
+#define TLOG_RECORDS_PER_BLOCK \
+    ((TLOG_BLOCK_SIZE - sizeof(struct tlog_block_hdr)) / sizeof(struct tlog_record))
+
+int tlog_init(void);
+
+/* 追加一个样本（ts 是 timebase 时间戳） */
+int tlog_append(enum tlog_channel ch, uint64_t ts, int32_t value);
+
+/* 把 RAM 里没写满的块也写下去（重启 / FOTA 前调用） */
+void tlog_flush_all(void);
+
+/* 区间查询（UTC 秒，闭区间），每个落在区间内的样本调一次 cb；返回样本数 */
+typedef void (*tlog_sample_cb_t)(enum tlog_channel ch, uint32_t t,
+                                 int32_t value, void *user);
+int tlog_query(enum tlog_channel ch, uint32_t from, uint32_t to,
+               tlog_sample_cb_t cb, void *user);
+
+/* 只用块头统计区间内的 min / max / 条数（块完全落在区间内时不读数据） */
+int tlog_range_stats(enum tlog_channel ch, uint32_t from, uint32_t to,
+                     int32_t *min, int32_t *max, uint32_t *count);
+
+/* 后台上传区间内的所有块（原始块字节，发到 horse_tlog） */
+int tlog_upload_range(uint32_t from, uint32_t to);
+
+#endif /* TELEMETRY_LOG_H_ */
@@ -0,0 +1,647 @@
+/* water_log.c
+ *
+ * 喝水记录，格式见 water_log.h。
+ * - visits.log / visits.old：文件头 + 定长记录，第 i 条的 seq 是 first_seq + i；
+ * - 新记录的 seq 接着当前文件往后编，两个文件都没有时从已确认的 seq 往后编，
+ *   格式化过的 flash 上也不会和云端已有的编号撞；
+ * - 上传游标 acked（下一条没确认的 seq）PUBACK 以后往前走，下一次上传 / flush 时写进 /lfs/water/ack；
+ * - 每天的喝水时间只在 RAM 里（WATER_LOG_DAYS 天），启动时从文件重放出来。
+ *
+ * 锁：GNSS 线程（append / today）和 MQTT 回调（PUBACK）只拿 ram_lock（spinlock），
+ * 只碰 RAM 里的待写记录、每日统计和上传游标；water_lock 只在工作队列 / init / flush 里
+ * 用来串行化文件读写，aws_iot_send 在它外面。
+ */
+
+#include "water_log.h"
+#include "app_fs.h"
+#include "timebase.h"
+#include "mqtt_id.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/fs/fs.h>
+#include <net/aws_iot.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(water_log, LOG_LEVEL_INF);
+
+/* ====================== 参数可调 ====================== */
+
+#define WATER_DIR               APP_FS_MNT "/water"
+#define WATER_CUR_PATH          WATER_DIR "/visits.log"
+#define WATER_OLD_PATH          WATER_DIR "/visits.old"
+#define WATER_ACK_PATH          WATER_DIR "/ack"
+#define WATER_TOPIC             "horse_water"
+
+/* 攒够这么多条才写一次 flash（一匹马一天喝十几到二十次水） */
+#define WATER_LOG_BATCH         8
+
+/* RAM 里最多攒几条（写 flash 的工作还没跑到时 GNSS 线程接着往里放） */
+#define WATER_LOG_PENDING_MAX   (2 * WATER_LOG_BATCH)
+
+/* 攒着的最老一条放了这么久（min）也写下去 */
+#define WATER_LOG_FLUSH_MIN     60
+
+/* RAM 里保留几天的每日统计 */
+#define WATER_LOG_DAYS          7
+
+/* 一条上传消息最多带几条记录 */
+#define WATER_UPLOAD_MAX        32
+
+/* 写完一批等一会儿再传；等 PUBACK 超时重发；发不出去过一会儿重试 */
+#define WATER_UPLOAD_DELAY_SEC  5
+#define WATER_ACK_TIMEOUT_SEC   30
+#define WATER_RETRY_SEC         60
+
+#define SEC_PER_DAY             86400U
+
+/* ====================== 状态 ====================== */
+
+/* 两代文件：0 = .old，1 = 当前 .log */
+enum water_gen {
+    WATER_GEN_OLD = 0,
+    WATER_GEN_CUR,
+    WATER_GEN_COUNT,
+};
+
+struct water_file {
+    uint32_t first;     /* 第一条的 seq */
+    uint32_t count;     /* 记录条数 */
+};
+
+struct water_day {
+    uint32_t day;       /* UTC 天数（Unix 秒 / 86400），0 = 空 */
+    uint32_t total_s;
+    uint16_t visits;
+};
+
+static const char *const gen_path[WATER_GEN_COUNT] = {
+    [WATER_GEN_OLD] = WATER_OLD_PATH,
+    [WATER_GEN_CUR] = WATER_CUR_PATH,
+};
+
+/* water_lock：文件和文件状态 */
+static struct water_file files[WATER_GEN_COUNT];
+static uint32_t saved_ack;      /* /lfs/water/ack 里的值 */
+static bool ready;
+
+static K_MUTEX_DEFINE(water_lock);
+
+/* ram_lock：待写记录、每日统计、上传游标和 in-flight 状态（只有一条消息在途） */
+static struct k_spinlock ram_lock;
+static struct water_visit_rec pending[WATER_LOG_PENDING_MAX];
+static uint8_t n_pending;
+static struct water_day days[WATER_LOG_DAYS];
+static uint32_t acked;          /* 下一条没确认的 seq */
+static uint16_t inflight_id;
+static uint32_t inflight_first;
+static uint16_t inflight_n;
+
+static void flush_work_fn(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(flush_work, flush_work_fn);
+
+static void upload_work_fn(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(upload_work, upload_work_fn);
+
+/* ====================== 工具函数 ====================== */
+
+static uint32_t file_end(enum water_gen gen)
+{
+    return files[gen].first + files[gen].count;
+}
+
+/* 还在 flash 上的最老一条 */
+static uint32_t oldest_seq(void)
+{
+    return files[WATER_GEN_OLD].count ? files[WATER_GEN_OLD].first :
+                                        files[WATER_GEN_CUR].first;
+}
+
+static int append_file(const char *path, const void *buf, size_t len)
+{
+    struct fs_file_t f;
+    ssize_t n;
+    int err;
+
+    fs_file_t_init(&f);
+    err = fs_open(&f, path, FS_O_CREATE | FS_O_WRITE | FS_O_APPEND);
+    if (err) {
+        return err;
+    }
+
+    n = fs_write(&f, buf, len);
+    err = fs_close(&f);
+
+    return (n == (ssize_t)len) ? err : -EIO;
+}
+
+/* 读文件头和条数；文件不存在 / 头不对返回 false */
+static bool file_load(enum water_gen gen)
+{
+    struct water_log_file_hdr hdr;
+    struct fs_dirent ent;
+    struct fs_file_t f;
+    ssize_t n;
+
+    files[gen].first = 0;
+    files[gen].count = 0;
+
+    if (fs_stat(gen_path[gen], &ent) != 0) {
+        return false;
+    }
+
+    fs_file_t_init(&f);
+    if (fs_open(&f, gen_path[gen], FS_O_READ) != 0) {
+        return false;
+    }
+    n = fs_read(&f, &hdr, sizeof(hdr));
+    (void)fs_close(&f);
+
+    if (n != sizeof(hdr) || hdr.magic != WATER_LOG_MAGIC ||
+        hdr.rec_size != sizeof(struct water_visit_rec)) {
+        LOG_WRN("%s: bad header, discarded", gen_path[gen]);
+        (void)fs_unlink(gen_path[gen]);
+        return false;
+    }
+
+    files[gen].first = hdr.first_seq;
+    files[gen].count = (ent.size - sizeof(hdr)) / sizeof(struct water_visit_rec);
+    return true;
+}
+
+/* 从 seq 开始读最多 max 条（只在一个文件里读，不跨文件），返回条数 */
+static int read_recs(uint32_t seq, struct water_visit_rec *out, uint32_t max)
+{
+    for (int gen = 0; gen < WATER_GEN_COUNT; gen++) {
+        const struct water_file *w = &files[gen];
+        struct fs_file_t f;
+        ssize_t n;
+
+        if (w->count == 0 || seq < w->first || seq >= file_end(gen)) {
+            continue;
+        }
+
+        max = MIN(max, file_end(gen) - seq);
+
+        fs_file_t_init(&f);
+        if (fs_open(&f, gen_path[gen], FS_O_READ) != 0) {
+            return -EIO;
+        }
+        (void)fs_seek(&f, sizeof(struct water_log_file_hdr) +
+                          (off_t)(seq - w->first) * sizeof(*out), FS_SEEK_SET);
+        n = fs_read(&f, out, max * sizeof(*out));
+        (void)fs_close(&f);
+
+        return (n < 0) ? (int)n : (int)(n / sizeof(*out));
+    }
+    return 0;
+}
+
+/* ====================== 每日统计 ====================== */
+
+/* 调用方持 ram_lock */
+static void day_add(const struct water_visit_rec *r)
+{
+    int slot = -1;
+    int oldest = 0;
+
+    if (r->start == 0) {
+        return;  /* 没有时间的记录不知道算哪天 */
+    }
+
+    uint32_t d = r->start / SEC_PER_DAY;
+
+    for (int i = 0; i < WATER_LOG_DAYS; i++) {
+        if (days[i].day == d) {
+            slot = i;
+            break;
+        }
+        if (days[i].day < days[oldest].day) {
+            oldest = i;
+        }
+    }
+
+    if (slot < 0) {
+        if (days[oldest].day > d) {
+            return;  /* 比表里每一天都早 */
+        }
+        slot = oldest;
+        days[slot].day = d;
+        days[slot].total_s = 0;
+        days[slot].visits = 0;
+    }
+
+    days[slot].total_s += r->dur_s;
+    days[slot].visits++;
+}
+
+/* 启动时把两代文件重放一遍（调用方持 water_lock） */
+static void replay(void)
+{
+    static struct water_visit_rec buf[WATER_UPLOAD_MAX];
+    k_spinlock_key_t key = k_spin_lock(&ram_lock);
+
+    memset(days, 0, sizeof(days));
+
+    /* 挂载以前就记下的 */
+    for (int i = 0; i < n_pending; i++) {
+        day_add(&pending[i]);
+    }
+    k_spin_unlock(&ram_lock, key);
+
+    for (int gen = 0; gen < WATER_GEN_COUNT; gen++) {
+        uint32_t seq = files[gen].first;
+
+        while (seq < file_end(gen)) {
+            int n = read_recs(seq, buf, ARRAY_SIZE(buf));
+
+            if (n <= 0) {
+                LOG_ERR("water log replay stopped at seq %u (%d)", seq, n);
+                break;
+            }
+
+            key = k_spin_lock(&ram_lock);
+            for (int i = 0; i < n; i++) {
+                day_add(&buf[i]);
+            }
+            k_spin_unlock(&ram_lock, key);
+            seq += n;
+        }
+    }
+}
+
+/* ====================== 写路径 ====================== */
+
+/* visits.log 满了：当前代变成 .old，旧的 .old 丢掉（调用方持 water_lock） */
+static void rotate(void)
+{
+    uint32_t cur_first = files[WATER_GEN_CUR].first;
+    uint32_t dropped = 0;
+    k_spinlock_key_t key = k_spin_lock(&ram_lock);
+
+    if (files[WATER_GEN_OLD].count > 0 && acked < cur_first) {
+        dropped = cur_first - MAX(acked, files[WATER_GEN_OLD].first);
+        acked = cur_first;
+    }
+    k_spin_unlock(&ram_lock, key);
+
+    if (dropped > 0) {
+        LOG_WRN("water log: %u unacked records dropped", dropped);
+    }
+
+    (void)fs_unlink(WATER_OLD_PATH);
+    (void)fs_rename(WATER_CUR_PATH, WATER_OLD_PATH);
+
+    files[WATER_GEN_OLD] = files[WATER_GEN_CUR];
+    files[WATER_GEN_CUR].first = file_end(WATER_GEN_OLD);
+    files[WATER_GEN_CUR].count = 0;
+
+    LOG_INF("water log rotated at seq %u", files[WATER_GEN_CUR].first);
+}
+
+/* 确认游标落盘（调用方持 water_lock） */
+static void save_ack(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&ram_lock);
+    uint32_t a = acked;
+
+    k_spin_unlock(&ram_lock, key);
+
+    if (a != saved_ack) {
+        int err = app_fs_write_file(WATER_ACK_PATH, &a, sizeof(a));
+
+        if (err) {
+            LOG_ERR("water log ack save failed (%d)", err);
+        } else {
+            saved_ack = a;
+        }
+    }
+}
+
+/* 把 RAM 里攒着的记录写下去（调用方持 water_lock，GNSS 线程同时还能往里放） */
+static int flush_pending(void)
+{
+    static struct water_visit_rec buf[WATER_LOG_PENDING_MAX];
+    struct water_file *cur = &files[WATER_GEN_CUR];
+    k_spinlock_key_t key;
+    uint8_t n, left;
+    bool idle;
+    int err;
+
+    if (!ready) {
+        return 0;
+    }
+
+    key = k_spin_lock(&ram_lock);
+    n = n_pending;
+    memcpy(buf, pending, n * sizeof(buf[0]));
+    k_spin_unlock(&ram_lock, key);
+
+    if (n == 0) {
+        return 0;
+    }
+
+    if (cur->count + n > CONFIG_HORSE_WATER_LOG_MAX_RECORDS) {
+        rotate();
+    }
+
+    if (cur->count == 0) {
+        struct water_log_file_hdr hdr = {
+            .magic = WATER_LOG_MAGIC,
+            .rec_size = sizeof(struct water_visit_rec),
+            .first_seq = cur->first,
+        };
+
+        err = app_fs_write_file(WATER_CUR_PATH, &hdr, sizeof(hdr));
+        if (err) {
+            LOG_ERR("water log create failed (%d)", err);
+            return err;
+        }
+    }
+
+    err = append_file(WATER_CUR_PATH, buf, n * sizeof(buf[0]));
+    if (err) {
+        /* 记录留在 RAM 里，下一批再试 */
+        LOG_ERR("water log write failed (%d)", err);
+        return err;
+    }
+
+    cur->count += n;
+
+    /* 写的时候新来的留在 pending 里 */
+    key = k_spin_lock(&ram_lock);
+    left = n_pending - n;
+    memmove(pending, &pending[n], left * sizeof(pending[0]));
+    n_pending = left;
+    idle = (inflight_id == 0);
+    k_spin_unlock(&ram_lock, key);
+
+    if (left == 0) {
+        (void)k_work_cancel_delayable(&flush_work);
+    } else {
+        k_work_reschedule(&flush_work, (left >= WATER_LOG_BATCH) ? K_NO_WAIT :
+                                       K_MINUTES(WATER_LOG_FLUSH_MIN));
+    }
+
+    if (idle) {
+        k_work_reschedule(&upload_work, K_SECONDS(WATER_UPLOAD_DELAY_SEC));
+    }
+    return 0;
+}
+
+static void flush_work_fn(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    k_mutex_lock(&water_lock, K_FOREVER);
+    (void)flush_pending();
+    k_mutex_unlock(&water_lock);
+}
+
+/* ====================== 上传 ====================== */
+
+static void upload_work_fn(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    static uint8_t msg[sizeof(struct water_log_upload_hdr) +
+                       WATER_UPLOAD_MAX * sizeof(struct water_visit_rec)];
+    struct water_log_upload_hdr *h = (struct water_log_upload_hdr *)msg;
+    k_spinlock_key_t key;
+    uint32_t from;
+    int n = 0;
+
+    /* 文件里的记录拷到 msg 里，确认游标顺便落盘；发送在锁外面 */
+    k_mutex_lock(&water_lock, K_FOREVER);
+
+    if (ready) {
+        save_ack();
+
+        key = k_spin_lock(&ram_lock);
+        from = acked;
+        k_spin_unlock(&ram_lock, key);
+
+        if (from < file_end(WATER_GEN_CUR)) {
+            n = read_recs(from, (struct water_visit_rec *)(msg + sizeof(*h)),
+                          WATER_UPLOAD_MAX);
+            if (n <= 0) {
+                LOG_ERR("water log read failed at seq %u (%d)", from, n);
+                k_work_reschedule(&upload_work, K_SECONDS(WATER_RETRY_SEC));
+                n = -1;
+            }
+        }
+    }
+
+    k_mutex_unlock(&water_lock);
+
+    if (n <= 0) {
+        if (n == 0) {
+            /* 都确认了 */
+            key = k_spin_lock(&ram_lock);
+            inflight_id = 0;
+            k_spin_unlock(&ram_lock, key);
+        }
+        return;
+    }
+
+    h->first_seq = from;
+    h->count     = (uint16_t)n;
+    h->rec_size  = sizeof(struct water_visit_rec);
+
+    uint16_t id = mqtt_id_next();
+
+    key = k_spin_lock(&ram_lock);
+    inflight_id    = id;
+    inflight_first = from;
+    inflight_n     = (uint16_t)n;
+    k_spin_unlock(&ram_lock, key);
+
+    struct aws_iot_data tx = { 0 };
+
+    tx.qos        = MQTT_QOS_1_AT_LEAST_ONCE;
+    tx.ptr        = (char *)msg;
+    tx.len        = sizeof(*h) + n * sizeof(struct water_visit_rec);
+    tx.message_id = id;
+    tx.topic.str  = WATER_TOPIC;
+    tx.topic.len  = strlen(WATER_TOPIC);
+
+    int err = aws_iot_send(&tx);
+
+    if (err) {
+        /* 多半是断线了，重连后 water_log_resume_upload() 会再触发 */
+        LOG_WRN("water log upload at seq %u failed (%d)", from, err);
+        key = k_spin_lock(&ram_lock);
+        if (inflight_id == id) {
+            inflight_id = 0;
+        }
+        k_spin_unlock(&ram_lock, key);
+        k_work_reschedule(&upload_work, K_SECONDS(WATER_RETRY_SEC));
+        return;
+    }
+
+    /* 等 PUBACK；超时重发同一段（云端按 seq 去重） */
+    k_work_reschedule(&upload_work, K_SECONDS(WATER_ACK_TIMEOUT_SEC));
+}
+
+/* ====================== 对外接口 ====================== */
+
+int water_log_init(void)
+{
+    int err;
+
+    if (!app_fs_ready()) {
+        return -ENODEV;
+    }
+
+    err = app_fs_mkdir(WATER_DIR);
+    if (err) {
+        return err;
+    }
+
+    k_mutex_lock(&water_lock, K_FOREVER);
+
+    uint32_t ack = 0;
+
+    if (app_fs_read_file(WATER_ACK_PATH, &ack, sizeof(ack)) != 0) {
+        ack = 0;
+    }
+    saved_ack = ack;
+
+    bool have_old = file_load(WATER_GEN_OLD);
+
+    if (!file_load(WATER_GEN_CUR)) {
+        /* 只剩 .old（轮换到一半断电）或者什么都没有：seq 接着往后编，
+         * 也不能比已经确认过的小 */
+        files[WATER_GEN_CUR].first = have_old ? MAX(file_end(WATER_GEN_OLD), ack) : ack;
+    }
+
+    /* 确认游标落在 flash 上有的范围里 */
+    ack = CLAMP(ack, oldest_seq(), file_end(WATER_GEN_CUR));
+
+    k_spinlock_key_t key = k_spin_lock(&ram_lock);
+    acked = ack;
+    bool have_pending = n_pending > 0;
+    k_spin_unlock(&ram_lock, key);
+
+    replay();
+    ready = true;
+
+    uint32_t total = file_end(WATER_GEN_CUR) - oldest_seq();
+    uint32_t unacked = file_end(WATER_GEN_CUR) - ack;
+
+    if (have_pending) {
+        k_work_reschedule(&flush_work, K_MINUTES(WATER_LOG_FLUSH_MIN));
+    }
+    if (unacked > 0) {
+        k_work_reschedule(&upload_work, K_SECONDS(WATER_UPLOAD_DELAY_SEC));
+    }
+
+    k_mutex_unlock(&water_lock);
+
+    LOG_INF("water log ready: %u records, next seq %u, %u to upload, today %u s",
+            total, file_end(WATER_GEN_CUR), unacked, water_log_today_s());
+    return 0;
+}
+
+int water_log_append(uint32_t start_utc, uint32_t dur_ms, uint16_t zone)
+{
+    struct water_visit_rec r = {
+        .start = start_utc,
+        .dur_s = (uint16_t)MIN((dur_ms + 500U) / 1000U, UINT16_MAX),
+        .zone  = zone,
+    };
+    bool full = false;
+    uint8_t n;
+
+    /* GNSS 线程：只动 RAM，写 flash 交给工作队列 */
+    k_spinlock_key_t key = k_spin_lock(&ram_lock);
+
+    /* 每日统计先记上，写 flash 失败也不影响今天的数 */
+    day_add(&r);
+
+    if (n_pending < WATER_LOG_PENDING_MAX) {
+        pending[n_pending++] = r;
+    } else {
+        full = true;
+    }
+    n = n_pending;
+    k_spin_unlock(&ram_lock, key);
+
+    if (full) {
+        /* 没挂载 / flash 写不进去：RAM 也满了，这条只算进统计 */
+        LOG_WRN("water log full, record dropped");
+        return -ENOMEM;
+    }
+
+    if (n >= WATER_LOG_BATCH) {
+        k_work_reschedule(&flush_work, K_NO_WAIT);
+    } else if (n == 1) {
+        k_work_reschedule(&flush_work, K_MINUTES(WATER_LOG_FLUSH_MIN));
+    }
+    return 0;
+}
+
+void water_log_flush(void)
+{
+    k_mutex_lock(&water_lock, K_FOREVER);
+    (void)flush_pending();
+    if (ready) {
+        save_ack();
+    }
+    k_mutex_unlock(&water_lock);
+}
+
+uint32_t water_log_today_s(void)
+{
+    int64_t utc_ms;
+    uint32_t today = 0;
+    uint32_t total = 0;
+
+    bool synced = timebase_to_utc_ms(timebase_now(), &utc_ms);
+    k_spinlock_key_t key = k_spin_lock(&ram_lock);
+
+    if (synced) {
+        today = (uint32_t)(utc_ms / 1000 / SEC_PER_DAY);
+    } else {
+        for (int i = 0; i < WATER_LOG_DAYS; i++) {
+            today = MAX(today, days[i].day);
+        }
+    }
+
+    for (int i = 0; i < WATER_LOG_DAYS; i++) {
+        if (days[i].day != 0 && days[i].day == today) {
+            total = days[i].total_s;
+            break;
+        }
+    }
+
+    k_spin_unlock(&ram_lock, key);
+    return total;
+}
+
+void water_log_resume_upload(void)
+{
+    if (ready) {
+        k_work_reschedule(&upload_work, K_SECONDS(1));
+    }
+}
+
+void water_log_on_puback(uint16_t message_id)
+{
+    bool hit = false;
+
+    /* MQTT 回调里只推进游标，落盘留给上传工作 */
+    k_spinlock_key_t key = k_spin_lock(&ram_lock);
+
+    if (inflight_id != 0 && message_id == inflight_id) {
+        inflight_id = 0;
+        acked = MAX(acked, inflight_first + inflight_n);
+        hit = true;
+    }
+
+    k_spin_unlock(&ram_lock, key);
+
+    if (hit) {
+        k_work_reschedule(&upload_work, K_NO_WAIT);
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef WATER_LOG_H_
+#define WATER_LOG_H_
+
+#include <zephyr/kernel.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * 喝水记录（littlefs，只追加）
+ *
+ * 每次喝水一条 8 字节记录：开始时间、时长、水槽区域号。记录按追加顺序编号（seq），
+ * 编号跨重启、跨文件轮换一直递增，不会重复使用。
+ * - 记录先攒在 RAM 里，攒满 WATER_LOG_BATCH 条或者最老的一条放了一个小时
+ *   才一次写进 /lfs/water/visits.log，少磨 flash；重启 / FOTA 前 water_log_flush()；
+ * - visits.log 满 CONFIG_HORSE_WATER_LOG_MAX_RECORDS 条轮换成 visits.old（保留两代）；
+ * - 启动时把两代文件重放一遍，恢复最近几天（UTC 日）每天的喝水时间和次数；
+ * - 写进 flash 的记录按 seq 增量上传到 horse_water，PUBACK 以后确认到的 seq 落盘，
+ *   断线 / 重启以后从没确认的那条接着传。云端按 seq 去重。
+ */
+
+/* 文件头：每个文件一个，first_seq 是文件里第一条记录的编号 */
+#define WATER_LOG_MAGIC     0x5756 /* "WV" */
+
+struct water_log_file_hdr {
+    uint16_t magic;
+    uint16_t rec_size;
+    uint32_t first_seq;
+} __packed;
+
+struct water_visit_rec {
+    uint32_t start;      /* UTC 秒，0 = 时间未知 */
+    uint16_t dur_s;      /* 时长 (s)，超过 18 小时截断 */
+    uint16_t zone;       /* 电子围栏区域号 */
+} __packed;
+
+/*
+ * 上传消息（horse_water，二进制，小端）：
+ *   first_seq u32 | count u16 | rec_size u16 | count 条 water_visit_rec
+ */
+struct water_log_upload_hdr {
+    uint32_t first_seq;
+    uint16_t count;
+    uint16_t rec_size;
+} __packed;
+
+/* 挂载 littlefs 以后调用：恢复 seq 和上传进度，重放出每天的喝水时间 */
+int water_log_init(void);
+
+/* 一次喝水：start_utc 是开始的 UTC 秒（0 = 未知），GNSS 线程调用 */
+int water_log_append(uint32_t start_utc, uint32_t dur_ms, uint16_t zone);
+
+/* 把 RAM 里攒着的记录写下去（重启 / FOTA 前调用） */
+void water_log_flush(void);
+
+/* 今天（UTC 日）的喝水时间 (s)；时间还没校准时给最近一天的 */
+uint32_t water_log_today_s(void);
+
+/* 连上 AWS 以后继续上传没确认的记录 */
+void water_log_resume_upload(void);
+
+void water_log_on_puback(uint16_t message_id);
+
+#endif /* WATER_LOG_H_ */
@@ -0,0 +1,164 @@
+/* timebase.c
+ *
+ * 硬件计数器 -> GNSS UTC 的映射：
+ *   utc = ref_utc + elapsed_ms + elapsed_ms * drift_ppb / 1e9
+ * ref_* 是最近一次 GNSS 校准点，每次 fix 都挪过来；
+ * drift_ppb 另用一个基线点 base_* 测：PVT 的 UTC 只到 1 ms，基线短了量化噪声比晶振频偏还大
+ * （10 s 上 1 ms 就是 100 ppm），所以至少隔 TB_DRIFT_BASELINE_MS 才测一次，再做一阶 IIR 平滑。
+ */
+
+#include "timebase.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(timebase, LOG_LEVEL_INF);
+
+/* ====================== 参数可调 ====================== */
+
+/* 频偏测量的最短基线：10 min 上 1 ms 量化约 1.7 ppm */
+#define TB_DRIFT_BASELINE_MS       600000
+
+/* 频偏 IIR 平滑系数：new = old + (meas - old) / 2^N */
+#define TB_DRIFT_IIR_SHIFT         3
+
+/* 频偏合理范围（RTC 晶振一般 < 100 ppm），超出认为是跳变 */
+#define TB_DRIFT_MAX_PPB           200000
+
+/* 误差超过这个值直接重新对齐，不做频偏估计（比如 GNSS 冷启动后时间跳变） */
+#define TB_STEP_THRESHOLD_MS       2000
+
+static struct k_spinlock tb_lock;
+
+static bool    synced;
+static tb_ts_t ref_ts;
+static int64_t ref_utc_ms;
+static int32_t drift_ppb;
+static bool    drift_valid;     /* 第一次测出来直接用，之后才平滑 */
+static tb_ts_t base_ts;         /* 频偏基线起点 */
+static int64_t base_utc_ms;
+
+/* ====================== 日期换算 ====================== */
+
+/* Howard Hinnant 的 days_from_civil，1970-01-01 = 0 */
+static int64_t days_from_civil(int32_t y, uint32_t m, uint32_t d)
+{
+    y -= (m <= 2) ? 1 : 0;
+
+    const int32_t era = (y >= 0 ? y : y - 399) / 400;
+    const uint32_t yoe = (uint32_t)(y - era * 400);
+    const uint32_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return (int64_t)era * 146097 + (int64_t)doe - 719468;
+}
+
+int64_t timebase_civil_to_utc_ms(uint16_t year, uint8_t month, uint8_t day,
+                                 uint8_t hour, uint8_t minute, uint8_t second,
+                                 uint16_t ms)
+{
+    int64_t days = days_from_civil(year, month, day);
+    int64_t secs = days * 86400 + hour * 3600 + minute * 60 + second;
+
+    return secs * 1000 + ms;
+}
+
+/* ====================== 换算（调用方持锁） ====================== */
+
+static int64_t to_utc_locked(tb_ts_t ts)
+{
+    int64_t elapsed_ms = (int64_t)timebase_delta_ms(ref_ts, ts);
+
+    if (ts < ref_ts) {
+        /* 校准点之前的样本（比如 GNSS 处理比 IMU 晚）往回推 */
+        elapsed_ms = -(int64_t)timebase_delta_ms(ts, ref_ts);
+    }
+
+    return ref_utc_ms + elapsed_ms + (elapsed_ms * drift_ppb) / 1000000000LL;
+}
+
+/* ====================== 对外接口 ====================== */
+
+void timebase_gnss_sync(tb_ts_t ts, int64_t utc_ms)
+{
+    k_spinlock_key_t key = k_spin_lock(&tb_lock);
+
+    if (!synced) {
+        ref_ts = base_ts = ts;
+        ref_utc_ms = base_utc_ms = utc_ms;
+        synced = true;
+        k_spin_unlock(&tb_lock, key);
+
+        LOG_INF("Timebase synced to GNSS UTC (%lld ms)", (long long)utc_ms);
+        return;
+    }
+
+    int64_t err_ms = utc_ms - to_utc_locked(ts);
+
+    if (err_ms > TB_STEP_THRESHOLD_MS || err_ms < -TB_STEP_THRESHOLD_MS) {
+        /* 时间跳变：重新对齐，频偏清零 */
+        ref_ts = base_ts = ts;
+        ref_utc_ms = base_utc_ms = utc_ms;
+        drift_ppb = 0;
+        drift_valid = false;
+        k_spin_unlock(&tb_lock, key);
+
+        LOG_WRN("Timebase step %lld ms, re-anchored", (long long)err_ms);
+        return;
+    }
+
+    if (ts < ref_ts) {
+        /* PVT 比上一个校准点还早（乱序），不挪校准点 */
+        k_spin_unlock(&tb_lock, key);
+        return;
+    }
+
+    ref_ts = ts;
+    ref_utc_ms = utc_ms;
+
+    /* 本地时间用 us 算，量化只剩 PVT 那 1 ms */
+    int64_t local_us = (int64_t)timebase_delta_us(base_ts, ts);
+
+    if (local_us >= (int64_t)TB_DRIFT_BASELINE_MS * 1000) {
+        int64_t meas = ((utc_ms - base_utc_ms) * 1000 - local_us) * 1000000000LL / local_us;
+
+        if (meas > -TB_DRIFT_MAX_PPB && meas < TB_DRIFT_MAX_PPB) {
+            if (drift_valid) {
+                drift_ppb += (int32_t)((meas - drift_ppb) / (1 << TB_DRIFT_IIR_SHIFT));
+            } else {
+                drift_ppb = (int32_t)meas;
+                drift_valid = true;
+            }
+        }
+
+        base_ts = ts;
+        base_utc_ms = utc_ms;
+    }
+
+    k_spin_unlock(&tb_lock, key);
+}
+
+bool timebase_is_synced(void)
+{
+    return synced;
+}
+
+bool timebase_to_utc_ms(tb_ts_t ts, int64_t *utc_ms)
+{
+    k_spinlock_key_t key = k_spin_lock(&tb_lock);
+
+    if (!synced) {
+        k_spin_unlock(&tb_lock, key);
+        return false;
+    }
+
+    *utc_ms = to_utc_locked(ts);
+    k_spin_unlock(&tb_lock, key);
+
+    return true;
+}
+
+int32_t timebase_drift_ppb(void)
+{
+    return drift_ppb;
+}
@@ -0,0 +1,66 @@
+#ifndef TIMEBASE_H_
+#define TIMEBASE_H_
+
+#include <zephyr/kernel.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * 统一时间基准
+ *
+ * 所有样本（IMU / BME280 / GNSS）在采集时打一个 tb_ts_t 时间戳：
+ * 一次 64 位硬件计数器读取，不做任何换算。
+ * GNSS 有效 fix 时用 PVT 的 UTC 时间校准，下游（融合 / 打包上传）
+ * 需要绝对时间时再用 timebase_to_utc_ms() 换算。
+ */
+
+typedef uint64_t tb_ts_t;
+
+#if defined(CONFIG_TIMER_HAS_64BIT_CYCLE_COUNTER)
+#define TB_FREQ_HZ ((uint64_t)sys_clock_hw_cycles_per_sec())
+#else
+#define TB_FREQ_HZ ((uint64_t)CONFIG_SYS_CLOCK_TICKS_PER_SEC)
+#endif
+
+/* 采样时调用：只读一次 64 位计数器 */
+static inline tb_ts_t timebase_now(void)
+{
+#if defined(CONFIG_TIMER_HAS_64BIT_CYCLE_COUNTER)
+    return k_cycle_get_64();
+#else
+    return (tb_ts_t)k_uptime_ticks();
+#endif
+}
+
+/* 两个时间戳之间的间隔（ms / us），b 晚于 a；64 位，开机几个月也不回绕 */
+static inline uint64_t timebase_delta_ms(tb_ts_t a, tb_ts_t b)
+{
+    return ((b - a) * 1000U) / TB_FREQ_HZ;
+}
+
+static inline uint64_t timebase_delta_us(tb_ts_t a, tb_ts_t b)
+{
+    return ((b - a) * 1000000U) / TB_FREQ_HZ;
+}
+
+/* GNSS UTC 日期时间 -> Unix 毫秒 */
+int64_t timebase_civil_to_utc_ms(uint16_t year, uint8_t month, uint8_t day,
+                                 uint8_t hour, uint8_t minute, uint8_t second,
+                                 uint16_t ms);
+
+/*
+ * 用一次有效 GNSS fix 校准：ts 是 PVT 到达时打的时间戳，utc_ms 是 PVT 的 UTC 时间。
+ * 两次校准之间会估计本地晶振相对 GNSS 的频偏（ppb）。
+ */
+void timebase_gnss_sync(tb_ts_t ts, int64_t utc_ms);
+
+/* 是否已经被 GNSS 校准过 */
+bool timebase_is_synced(void);
+
+/* 时间戳 -> UTC 毫秒；还没校准时返回 false（*utc_ms 不变） */
+bool timebase_to_utc_ms(tb_ts_t ts, int64_t *utc_ms);
+
+/* 当前估计的频偏（ppb），给调试 / 上报用 */
+int32_t timebase_drift_ppb(void);
+
+#endif /* TIMEBASE_H_ */
@@ -0,0 +1,238 @@
+/* track_compress.c
+ *
+ * 轨迹在线化简 + 差分 varint 编码，见 track_compress.h。
+ */
+
+#include "track_compress.h"
+#include "delta_codec.h"
+
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+
+/* 1 微度纬度的米数（6371 km 球面） */
+#define M_PER_E6_LAT        0.11119493f
+#define PI_F                3.14159265f
+#define E6_TO_RAD           (3.14159265358979323846 / 180.0 / 1e6)
+
+/* ====================== 化简 ====================== */
+
+static void set_anchor(struct track_compressor *tc, const struct track_point *p)
+{
+    tc->anchor = *p;
+    tc->m_per_e6_lon = M_PER_E6_LAT * (float)cos(p->lat_e6 * E6_TO_RAD);
+    tc->cone_open = true;
+    tc->max_d = 0.0f;
+    tc->n_out++;
+}
+
+static float wrap_pi(float a)
+{
+    while (a > PI_F) {
+        a -= 2.0f * PI_F;
+    }
+    while (a < -PI_F) {
+        a += 2.0f * PI_F;
+    }
+    return a;
+}
+
+/* p 还能不能并进从锚点出发的这一段；能的话收窄扇区 */
+static bool extend(struct track_compressor *tc, const struct track_point *p)
+{
+    float dx = (float)(p->lon_e6 - tc->anchor.lon_e6) * tc->m_per_e6_lon;
+    float dy = (float)(p->lat_e6 - tc->anchor.lat_e6) * M_PER_E6_LAT;
+    float d = sqrtf(dx * dx + dy * dy);
+
+    /* 往回走：之前最远的点会越过这一段的端点 */
+    if (d < tc->max_d - tc->tol_m) {
+        return false;
+    }
+    if (d <= tc->tol_m) {
+        /* 还在锚点附近，不约束方向。它当端点时这一段的方向是任意的，
+         * 之前的点离这一段最远 max_d，所以走远超过 tol 之后回来就算折返
+         */
+        if (!tc->cone_open && tc->max_d > tc->tol_m * 1.41421356f) {
+            return false;
+        }
+        tc->max_d = fmaxf(tc->max_d, d);
+        return true;
+    }
+
+    float theta = atan2f(dy, dx);
+    float half = asinf(tc->tol_m / d);
+
+    if (tc->cone_open) {
+        tc->ref = theta;
+        tc->lo = -half;
+        tc->hi = half;
+        tc->cone_open = false;
+    } else {
+        float rel = wrap_pi(theta - tc->ref);
+        float lo = fmaxf(tc->lo, rel - half);
+        float hi = fminf(tc->hi, rel + half);
+
+        /* 这个点要能当端点：它自己的方向得满足之前所有点的约束 */
+        if (rel < tc->lo || rel > tc->hi || lo > hi) {
+            return false;
+        }
+        tc->lo = lo;
+        tc->hi = hi;
+    }
+    tc->max_d = fmaxf(tc->max_d, d);
+    return true;
+}
+
+void track_init(struct track_compressor *tc, float tol_m, uint32_t max_gap_s)
+{
+    memset(tc, 0, sizeof(*tc));
+    tc->tol_m = tol_m * 0.70710678f;
+    tc->max_gap_s = max_gap_s;
+}
+
+size_t track_feed(struct track_compressor *tc, const struct track_point *p,
+                  struct track_point out[2])
+{
+    size_t n = 0;
+
+    tc->n_in++;
+
+    if (!tc->started) {
+        tc->started = true;
+        set_anchor(tc, p);
+        out[n++] = *p;
+        return n;
+    }
+
+    if (!extend(tc, p)) {
+        /* 上一个点成为新锚点；新锚点出发的第一个点总能并进去 */
+        set_anchor(tc, &tc->last);
+        out[n++] = tc->last;
+        (void)extend(tc, p);
+    }
+    tc->last = *p;
+    tc->have_last = true;
+
+    if (p->t - tc->anchor.t >= tc->max_gap_s) {
+        set_anchor(tc, p);
+        out[n++] = *p;
+        tc->have_last = false;
+    }
+
+    return n;
+}
+
+size_t track_flush(struct track_compressor *tc, struct track_point *out)
+{
+    if (!tc->have_last) {
+        return 0;
+    }
+    set_anchor(tc, &tc->last);
+    *out = tc->last;
+    tc->have_last = false;
+    return 1;
+}
+
+/* ====================== 编码 ====================== */
+
+static void put_le16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    put_le16(p, (uint16_t)v);
+    put_le16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint16_t get_le16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return get_le16(p) | ((uint32_t)get_le16(p + 2) << 16);
+}
+
+size_t track_encode(const struct track_point *pts, size_t n, uint8_t *buf, size_t cap,
+                    size_t *len)
+{
+    if (n == 0 || cap < TRACK_HDR_SIZE) {
+        return 0;
+    }
+
+    size_t pos = TRACK_HDR_SIZE;
+    size_t k = 1;
+
+    for (; k < n && k < UINT16_MAX; k++) {
+        if (pos + TRACK_POINT_MAX > cap) {
+            break;
+        }
+        pos += dc_varint_put(&buf[pos], pts[k].t - pts[k - 1].t);
+        pos += dc_varint_put(&buf[pos], dc_zigzag32(pts[k].lat_e6 - pts[k - 1].lat_e6));
+        pos += dc_varint_put(&buf[pos], dc_zigzag32(pts[k].lon_e6 - pts[k - 1].lon_e6));
+    }
+
+    put_le16(&buf[0], TRACK_MSG_MAGIC);
+    buf[2] = TRACK_MSG_VERSION;
+    buf[3] = 0;
+    put_le16(&buf[4], (uint16_t)k);
+    put_le16(&buf[6], 0);
+    put_le32(&buf[8], pts[0].t);
+    put_le32(&buf[12], (uint32_t)pts[0].lat_e6);
+    put_le32(&buf[16], (uint32_t)pts[0].lon_e6);
+
+    *len = pos;
+    return k;
+}
+
+int track_decode(const uint8_t *buf, size_t len, struct track_point *out, size_t max)
+{
+    if (len < TRACK_HDR_SIZE || get_le16(&buf[0]) != TRACK_MSG_MAGIC ||
+        buf[2] != TRACK_MSG_VERSION) {
+        return -EBADMSG;
+    }
+
+    uint16_t n = get_le16(&buf[4]);
+
+    if (n == 0) {
+        return -EBADMSG;
+    }
+    if (n > max) {
+        return -ENOMEM;
+    }
+
+    out[0].t = get_le32(&buf[8]);
+    out[0].lat_e6 = (int32_t)get_le32(&buf[12]);
+    out[0].lon_e6 = (int32_t)get_le32(&buf[16]);
+
+    size_t pos = TRACK_HDR_SIZE;
+
+    for (uint16_t k = 1; k < n; k++) {
+        uint32_t dt, dlat, dlon;
+        size_t a, b, c;
+
+        a = dc_varint_get(&buf[pos], len - pos, &dt);
+        if (a == 0) {
+            return -EBADMSG;
+        }
+        b = dc_varint_get(&buf[pos + a], len - pos - a, &dlat);
+        if (b == 0) {
+            return -EBADMSG;
+        }
+        c = dc_varint_get(&buf[pos + a + b], len - pos - a - b, &dlon);
+        if (c == 0) {
+            return -EBADMSG;
+        }
+        pos += a + b + c;
+
+        out[k].t = out[k - 1].t + dt;
+        out[k].lat_e6 = out[k - 1].lat_e6 + dc_unzigzag32(dlat);
+        out[k].lon_e6 = out[k - 1].lon_e6 + dc_unzigzag32(dlon);
+    }
+
+    return (pos == len) ? n : -EBADMSG;
+}
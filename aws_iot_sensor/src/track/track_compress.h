@@ -0,0 +1,76 @@
+#ifndef TRACK_COMPRESS_H_
+#define TRACK_COMPRESS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * GNSS 轨迹在线化简 + 紧凑编码 —— 纯逻辑，不依赖内核。
+ *
+ * 化简用“开窗 / 扇区相交”算法：从上一个输出点（锚点）出发，每个新点把
+ * 允许的方向收窄到一个扇区（离锚点 d 米的点给出 ±asin(tol' / d)），
+ * 扇区变空、新点方向不在扇区里、或者往回走超过 tol' 时，把上一个点输出成
+ * 新锚点。只存锚点和上一个点，每个 fix O(1)。
+ * tol' = tol / sqrt(2)，所以每个输入点到对应的那段折线的距离不超过 tol
+ * （垂直方向和越过端点的部分各不超过 tol'）。
+ * 站着不动时所有点都在锚点 tol' 以内，不输出，只在超过 max_gap_s 时补一个点。
+ *
+ * 编码（horse_track 消息，小端）：
+ *   头: magic(2) | version(1) | rsv(1) | n(2) | rsv(2) | t0(4) | lat0_e6(4) | lon0_e6(4)
+ *   第 2 个点起: varint(dt) + varint(zigzag(dlat_e6)) + varint(zigzag(dlon_e6))
+ * 1 微度约 0.11 m；十几米的线段每个点 4~6 字节，原始 12 字节。
+ */
+
+#define TRACK_MSG_MAGIC     0x4B54  /* "TK" */
+#define TRACK_MSG_VERSION   1
+#define TRACK_HDR_SIZE      20
+
+/* 一个点编码后最多几个字节 */
+#define TRACK_POINT_MAX     15
+
+struct track_point {
+    uint32_t t;               /* 秒（UTC） */
+    int32_t  lat_e6;
+    int32_t  lon_e6;
+};
+
+struct track_compressor {
+    float    tol_m;           /* tol / sqrt(2) */
+    uint32_t max_gap_s;
+
+    bool     started;
+    struct track_point anchor;
+    struct track_point last;  /* 上一个输入点，还没输出 */
+    bool     have_last;
+    float    m_per_e6_lon;    /* 锚点纬度上 1 微度经度的米数 */
+
+    /* 方向扇区（相对 ref 的弧度）和到锚点的最远距离 */
+    bool     cone_open;
+    float    ref, lo, hi;
+    float    max_d;
+
+    uint32_t n_in;
+    uint32_t n_out;
+};
+
+/* tol_m：允许的最大偏差（m）；max_gap_s：至少隔多久输出一个点 */
+void track_init(struct track_compressor *tc, float tol_m, uint32_t max_gap_s);
+
+/* 喂一个点，输出 0~2 个化简后的点到 out，返回个数 */
+size_t track_feed(struct track_compressor *tc, const struct track_point *p,
+                  struct track_point out[2]);
+
+/* 把还没输出的最后一个点输出（上传前收尾），返回 0 或 1 */
+size_t track_flush(struct track_compressor *tc, struct track_point *out);
+
+/* 编码尽可能多的点（至少 1 个），返回用掉的点数，*len 是消息字节数；
+ * buf 放不下头和 1 个点时返回 0
+ */
+size_t track_encode(const struct track_point *pts, size_t n, uint8_t *buf, size_t cap,
+                    size_t *len);
+
+/* 解码一条消息，返回点数，格式错误返回 -EBADMSG，out 不够返回 -ENOMEM */
+int track_decode(const uint8_t *buf, size_t len, struct track_point *out, size_t max);
+
+#endif /* TRACK_COMPRESS_H_ */
@@ -0,0 +1,176 @@
+/* track_log.c
+ *
+ * 轨迹化简 + 上报，见 track_log.h。
+ * 化简器和点缓冲由 GNSS 线程写、上报工作项读，用互斥锁保护；
+ * 上报时只在锁里编码，发送在锁外，GNSS 线程不会等 MQTT。
+ */
+
+#include "track_log.h"
+#include "track_compress.h"
+#include "mqtt_id.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <net/aws_iot.h>
+#include <math.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(track_log, LOG_LEVEL_INF);
+
+/* ====================== 参数可调 ====================== */
+
+#define TRACK_TOPIC             "horse_track"
+
+/* RAM 里最多攒多少个化简后的点 */
+#define TRACK_BUF_PTS           256
+
+/* 攒到这么多就提前上报 */
+#define TRACK_KICK_PTS          (TRACK_BUF_PTS * 3 / 4)
+
+/* 站着不动时至少隔多久记一个点（s） */
+#define TRACK_MAX_GAP_S         300
+
+/* 一条消息最多多少字节 */
+#define TRACK_MSG_MAX           1024
+
+/* 没连上时的重试间隔 */
+#define TRACK_RETRY_SEC         30
+
+/* ====================== 状态 ====================== */
+
+static K_MUTEX_DEFINE(track_lock);
+static struct track_compressor comp;
+static bool comp_ready;
+static struct track_point pts[TRACK_BUF_PTS];
+static uint16_t n_pts;
+static uint32_t pts_base;       /* pts[0] 是第几个点（从头上移走的点数，发出去的和丢掉的） */
+static struct track_log_stats stats;
+
+static void upload_work_fn(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(upload_work, upload_work_fn);
+
+/* 调用方持有 track_lock */
+static void push(const struct track_point *p)
+{
+    if (n_pts >= TRACK_BUF_PTS) {
+        /* 一直没连上：丢最旧的一半 */
+        memmove(pts, &pts[TRACK_BUF_PTS / 2],
+                (TRACK_BUF_PTS - TRACK_BUF_PTS / 2) * sizeof(pts[0]));
+        n_pts -= TRACK_BUF_PTS / 2;
+        pts_base += TRACK_BUF_PTS / 2;
+        stats.dropped += TRACK_BUF_PTS / 2;
+    }
+    pts[n_pts++] = *p;
+    stats.points++;
+}
+
+/* ====================== 上报（系统工作队列） ====================== */
+
+static void upload_work_fn(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    static uint8_t msg[TRACK_MSG_MAX];
+    k_timeout_t next = K_MINUTES(CONFIG_HORSE_TRACK_UPLOAD_MIN);
+
+    k_mutex_lock(&track_lock, K_FOREVER);
+
+    /* 收尾：把当前位置也带上，折线画到最新的 fix */
+    struct track_point last;
+
+    if (track_flush(&comp, &last)) {
+        push(&last);
+    }
+
+    while (n_pts > 0) {
+        size_t len = 0;
+        size_t k = track_encode(pts, n_pts, msg, sizeof(msg), &len);
+        uint32_t base = pts_base;
+
+        /* 发送时不持锁：这期间 GNSS 线程可能追加，缓冲满了也可能丢掉头上的点 */
+        k_mutex_unlock(&track_lock);
+
+        struct aws_iot_data tx = { 0 };
+
+        tx.qos       = MQTT_QOS_1_AT_LEAST_ONCE;
+        tx.message_id = mqtt_id_next();
+        tx.ptr       = (char *)msg;
+        tx.len       = len;
+        tx.topic.str = TRACK_TOPIC;
+        tx.topic.len = strlen(TRACK_TOPIC);
+
+        int err = aws_iot_send(&tx);
+
+        k_mutex_lock(&track_lock, K_FOREVER);
+
+        if (err != 0) {
+            LOG_WRN("Track upload paused, %u points waiting", n_pts);
+            next = K_SECONDS(TRACK_RETRY_SEC);
+            break;
+        }
+
+        /* 发出去的 [base, base + k) 里还留在缓冲里的部分移走 */
+        if (base + k > pts_base) {
+            size_t rm = MIN(base + k - pts_base, n_pts);
+
+            memmove(pts, &pts[rm], (n_pts - rm) * sizeof(pts[0]));
+            n_pts -= rm;
+            pts_base += rm;
+        }
+        stats.sent_points += k;
+        stats.sent_bytes += len;
+        LOG_INF("Track sent: %u points in %u bytes", (unsigned int)k, (unsigned int)len);
+    }
+
+    k_mutex_unlock(&track_lock);
+
+    k_work_reschedule(&upload_work, next);
+}
+
+/* ====================== 对外接口 ====================== */
+
+void track_log_feed(tb_ts_t ts, double lat, double lon)
+{
+    int64_t utc_ms;
+
+    if (!timebase_to_utc_ms(ts, &utc_ms)) {
+        return;
+    }
+
+    struct track_point p = {
+        .t      = (uint32_t)(utc_ms / 1000),
+        .lat_e6 = (int32_t)lround(lat * 1e6),
+        .lon_e6 = (int32_t)lround(lon * 1e6),
+    };
+    struct track_point out[2];
+
+    k_mutex_lock(&track_lock, K_FOREVER);
+
+    if (!comp_ready) {
+        track_init(&comp, (float)CONFIG_HORSE_TRACK_TOL_M, TRACK_MAX_GAP_S);
+        comp_ready = true;
+        k_work_reschedule(&upload_work, K_MINUTES(CONFIG_HORSE_TRACK_UPLOAD_MIN));
+    }
+
+    size_t n = track_feed(&comp, &p, out);
+
+    for (size_t i = 0; i < n; i++) {
+        push(&out[i]);
+    }
+    stats.fixes++;
+    bool kick = (n_pts >= TRACK_KICK_PTS);
+
+    k_mutex_unlock(&track_lock);
+
+    if (kick) {
+        /* 已经排着（比如没连上在等重试）就不提前 */
+        k_work_schedule(&upload_work, K_NO_WAIT);
+    }
+}
+
+void track_log_get_stats(struct track_log_stats *out)
+{
+    k_mutex_lock(&track_lock, K_FOREVER);
+    *out = stats;
+    k_mutex_unlock(&track_lock);
+}
@@ -0,0 +1,28 @@
+#ifndef TRACK_LOG_H_
+#define TRACK_LOG_H_
+
+#include <stdint.h>
+
+#include "timebase.h"
+
+/*
+ * 完整轨迹上报：每个有效 fix 进在线化简（track_compress.h，容差
+ * CONFIG_HORSE_TRACK_TOL_M），化简后的点攒在 RAM 里，每
+ * CONFIG_HORSE_TRACK_UPLOAD_MIN 分钟（或缓冲快满时）编码成差分 varint
+ * 发到 horse_track。没连上时点留在缓冲里，满了丢最旧的一半并计数。
+ */
+
+struct track_log_stats {
+    uint32_t fixes;           /* 喂进来的 fix */
+    uint32_t points;          /* 化简后留下的点 */
+    uint32_t sent_points;
+    uint32_t sent_bytes;
+    uint32_t dropped;         /* 缓冲满丢掉的点 */
+};
+
+/* GNSS 线程每个有效 fix 调用（时间基准已经和 GNSS 同步之后） */
+void track_log_feed(tb_ts_t ts, double lat, double lon);
+
+void track_log_get_stats(struct track_log_stats *out);
+
+#endif /* TRACK_LOG_H_ */
@@ -0,0 +1,182 @@
+/* grazing.c
+ *
+ * 低头吃草时间估计，见 grazing.h。
+ * grazing_feed 只在 BNO 采集线程里调用；统计快照用 spinlock 保护。
+ */
+
+#include "grazing.h"
+#include "gnss_task.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <math.h>
+
+LOG_MODULE_REGISTER(grazing, LOG_LEVEL_INF);
+
+/* ====================== 参数可调 ====================== */
+
+/* 低头：1 s 平均 |pitch|（deg），和 baro_detector 的吃草否决阈值一致 */
+#define GRAZE_PITCH_DEG        35.0f
+
+/* 相邻 10 Hz 样本 pitch 差的 RMS（deg）：咀嚼 / 慢走的范围 */
+#define GRAZE_MOTION_MIN_DEG   0.05f
+#define GRAZE_MOTION_MAX_DEG   2.0f
+
+/* GNSS：速度低于这个才算边吃边走；定位多新才用 */
+#define GRAZE_SPEED_MAX_MPS    0.8f
+#define GRAZE_GNSS_FRESH_MS    5000
+
+/* 漏桶迟滞：候选秒 +1、否则 -1，到 ENTER 进入吃草，降到 EXIT 退出 */
+#define GRAZE_SCORE_MAX        30
+#define GRAZE_SCORE_ENTER      20
+#define GRAZE_SCORE_EXIT       10
+
+/* 两个样本间隔超过这个认为 IMU 断过电，差分重新开始 */
+#define GRAZE_GAP_MS           300
+
+#define GRAZE_BLOCK_MS         1000
+
+/* ====================== 状态 ====================== */
+
+/* 1 s 块 */
+static tb_ts_t  blk_t0;
+static uint16_t blk_n;
+static float    blk_abs_pitch;
+static float    blk_d2;
+static uint16_t blk_nd;
+
+static tb_ts_t  last_ts;
+static float    last_pitch;
+
+static uint8_t  score;
+static bool     grazing;
+
+/* 当前小时 */
+static uint32_t hour_idx;
+static uint32_t hour_observed_s;
+static uint32_t hour_graze_s;
+
+static struct k_spinlock graze_lock;
+static struct grazing_stats stats;
+
+/* ====================== 每秒判定 ====================== */
+
+static bool gnss_slow(tb_ts_t now)
+{
+    struct gnss_status_msg g;
+
+    if (!gnss_get_latest(&g) || g.ts == 0 || g.ts > now ||
+        timebase_delta_ms(g.ts, now) > GRAZE_GNSS_FRESH_MS) {
+        return true;        /* 没有新鲜定位：不看这一条 */
+    }
+    return g.speed_mps < GRAZE_SPEED_MAX_MPS;
+}
+
+static uint16_t scaled_min(uint32_t graze_s, uint32_t observed_s)
+{
+    return observed_s ? (uint16_t)((graze_s * 60U + observed_s / 2) / observed_s) : 0;
+}
+
+static void close_hour(uint32_t new_idx)
+{
+    uint16_t min = scaled_min(hour_graze_s, hour_observed_s);
+
+    k_spinlock_key_t key = k_spin_lock(&graze_lock);
+    if (hour_observed_s > 0) {
+        stats.last_hour_min = min;
+        stats.total_min += min;
+    }
+    stats.this_hour_min = 0;
+    k_spin_unlock(&graze_lock, key);
+
+    if (hour_observed_s > 0) {
+        LOG_INF("Grazing %u min in hour %u (observed %u s)",
+                min, hour_idx, hour_observed_s);
+    }
+
+    hour_idx = new_idx;
+    hour_observed_s = 0;
+    hour_graze_s = 0;
+}
+
+static void close_block(tb_ts_t ts)
+{
+    float mean_abs = blk_abs_pitch / blk_n;
+    float motion = blk_nd ? sqrtf(blk_d2 / blk_nd) : 0.0f;
+
+    bool cand = mean_abs > GRAZE_PITCH_DEG &&
+                motion > GRAZE_MOTION_MIN_DEG && motion < GRAZE_MOTION_MAX_DEG &&
+                gnss_slow(ts);
+
+    if (cand) {
+        score = MIN(score + 1, GRAZE_SCORE_MAX);
+    } else if (score > 0) {
+        score--;
+    }
+
+    if (!grazing && score >= GRAZE_SCORE_ENTER) {
+        grazing = true;
+    } else if (grazing && score <= GRAZE_SCORE_EXIT) {
+        grazing = false;
+    }
+
+    uint32_t idx = (uint32_t)(ts / TB_FREQ_HZ / 3600U);
+
+    if (idx != hour_idx) {
+        close_hour(idx);
+    }
+
+    hour_observed_s++;
+    if (grazing) {
+        hour_graze_s++;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&graze_lock);
+    stats.this_hour_min = scaled_min(hour_graze_s, hour_observed_s);
+    stats.active = grazing;
+    k_spin_unlock(&graze_lock, key);
+}
+
+/* ====================== 对外接口 ====================== */
+
+void grazing_feed(tb_ts_t ts, float pitch)
+{
+    bool gap = (last_ts == 0 || ts < last_ts ||
+                timebase_delta_ms(last_ts, ts) > GRAZE_GAP_MS);
+
+    if (gap) {
+        blk_n = 0;          /* 断过电：丢掉不完整的块 */
+    } else if (timebase_delta_ms(blk_t0, ts) >= GRAZE_BLOCK_MS) {
+        /* 这个样本属于下一秒：先结算上一块，块边界按整秒往后推 */
+        close_block(ts);
+        blk_t0 += TB_FREQ_HZ * GRAZE_BLOCK_MS / 1000U;
+        blk_abs_pitch = 0.0f;
+        blk_d2 = 0.0f;
+        blk_nd = 0;
+        blk_n = 0;
+    }
+
+    if (gap) {
+        blk_t0 = ts;
+        blk_abs_pitch = 0.0f;
+        blk_d2 = 0.0f;
+        blk_nd = 0;
+    } else {
+        float d = pitch - last_pitch;
+
+        blk_d2 += d * d;
+        blk_nd++;
+    }
+    last_ts = ts;
+    last_pitch = pitch;
+
+    blk_abs_pitch += fabsf(pitch);
+    blk_n++;
+}
+
+void grazing_get(struct grazing_stats *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&graze_lock);
+    *out = stats;
+    k_spin_unlock(&graze_lock, key);
+}
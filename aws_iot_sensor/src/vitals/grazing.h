@@ -0,0 +1,35 @@
+#ifndef GRAZING_H_
+#define GRAZING_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "timebase.h"
+
+/*
+ * 低头吃草时间估计
+ *
+ * 由 IMU 10 Hz 流水线的一个 DETECT 级逐样本调用（每样本几次加法），每秒判定一次：
+ *  - 持续低头：1 s 平均 |pitch| 超过阈值；
+ *  - 小幅运动：相邻样本 pitch 差的 RMS 在“咀嚼 / 边吃边走”的范围内，
+ *    完全静止（低头睡觉）和大幅动作（甩头、走动）都不算；
+ *  - GNSS 慢速：有新鲜定位时速度要低于步行速度，没有定位时不看这一条。
+ * 候选秒数用一个漏桶计分做迟滞，进入吃草状态后的秒数计入当前小时。
+ *
+ * IMU 按占空比上电，只有一部分时间在看，所以每小时的吃草分钟数按
+ * “吃草秒数 / IMU 观察秒数 x 60” 折算。
+ */
+
+struct grazing_stats {
+    uint16_t last_hour_min;   /* 上一个完整小时的吃草分钟数（折算后） */
+    uint16_t this_hour_min;   /* 当前小时到目前为止（按已观察部分折算） */
+    uint32_t total_min;       /* 上电以来累计（已完成的小时） */
+    bool     active;          /* 当前是否在吃草 */
+};
+
+/* IMU 10 Hz 样本 */
+void grazing_feed(tb_ts_t ts, float pitch);
+
+void grazing_get(struct grazing_stats *out);
+
+#endif /* GRAZING_H_ */
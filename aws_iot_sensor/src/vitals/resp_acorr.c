@@ -0,0 +1,126 @@
+/* resp_acorr.c
+ *
+ * 呼吸频率的自相关估计，见 resp_acorr.h。
+ */
+
+#include "resp_acorr.h"
+
+/* ====================== 参数可调 ====================== */
+
+/* 0.1~1 Hz → 2 Hz 下滞后 2~20 个样本（60~6 次/分钟） */
+#define RESP_LAG_MIN        2
+#define RESP_LAG_MAX        20
+
+/* 去趋势后的均方根 (deg) 比这个还小就没有可测的起伏（BNO055 欧拉角 1/16° 一格，桶平均以后） */
+#define RESP_MIN_RMS_DEG    0.01f
+
+/* 周期整数倍处也有差不多高的峰：插值后不低于最高峰的这个比例就取最前面那个 */
+#define RESP_PEAK_RATIO     0.7f
+
+/* ====================== 自相关 ====================== */
+
+/* 去均值 + 去线性趋势（慢漂移 / 低于 0.1 Hz 的成分） */
+static void detrend(float *x, int n)
+{
+    float sx = 0.0f, sxy = 0.0f;
+    float mid = (n - 1) * 0.5f;
+    float sxx = 0.0f;
+
+    for (int i = 0; i < n; i++) {
+        sx += x[i];
+    }
+    float mean = sx / n;
+
+    for (int i = 0; i < n; i++) {
+        float d = i - mid;
+
+        sxy += d * (x[i] - mean);
+        sxx += d * d;
+    }
+    float slope = sxy / sxx;
+
+    for (int i = 0; i < n; i++) {
+        x[i] -= mean + slope * (i - mid);
+    }
+}
+
+static float acorr(const float *x, int n, int lag)
+{
+    float s = 0.0f;
+
+    for (int i = 0; i + lag < n; i++) {
+        s += x[i] * x[i + lag];
+    }
+    return s;
+}
+
+static bool is_peak(const float *r, int lag)
+{
+    return r[lag] > r[lag - 1] && r[lag] >= r[lag + 1];
+}
+
+/*
+ * 抛物线插值：峰的小数偏移和插值后的高度。
+ * 2 Hz 下快呼吸（30 次/分钟以上）一个周期只有 3~4 个样本，整数滞后上的值比真峰低不少，
+ * 不插值就比不过周期整数倍处正好落在整数滞后上的峰，会报成一半 / 三分之一的频率。
+ */
+static float interp_peak(const float *r, int lag, float *frac)
+{
+    float a = r[lag - 1], b = r[lag], c = r[lag + 1];
+    float den = a - 2.0f * b + c;
+    float d = (den != 0.0f) ? 0.5f * (a - c) / den : 0.0f;
+
+    d = (d < -0.5f) ? -0.5f : (d > 0.5f) ? 0.5f : d;
+    *frac = d;
+    return b - 0.25f * (a - c) * d;
+}
+
+bool resp_acorr_estimate(float *x, int n, float fs_hz, uint16_t *bpm_x10, uint8_t *quality)
+{
+    float r[RESP_LAG_MAX + 2];
+
+    if (n <= 2 * (RESP_LAG_MAX + 1)) {
+        return false;
+    }
+
+    detrend(x, n);
+
+    float r0 = acorr(x, n, 0);
+
+    if (r0 <= RESP_MIN_RMS_DEG * RESP_MIN_RMS_DEG * n) {
+        return false;
+    }
+
+    for (int lag = RESP_LAG_MIN - 1; lag <= RESP_LAG_MAX + 1; lag++) {
+        /* 除以重叠长度，长滞后不吃亏 */
+        r[lag] = acorr(x, n, lag) * n / (float)(n - lag) / r0;
+    }
+
+    float peak = 0.0f, frac;
+
+    for (int lag = RESP_LAG_MIN; lag <= RESP_LAG_MAX; lag++) {
+        if (is_peak(r, lag)) {
+            float h = interp_peak(r, lag, &frac);
+
+            peak = (h > peak) ? h : peak;
+        }
+    }
+
+    for (int lag = RESP_LAG_MIN; lag <= RESP_LAG_MAX && peak > 0.0f; lag++) {
+        if (!is_peak(r, lag)) {
+            continue;
+        }
+
+        float h = interp_peak(r, lag, &frac);
+
+        if (h >= RESP_PEAK_RATIO * peak) {
+            float q = h * 100.0f;
+
+            *bpm_x10 = (uint16_t)(600.0f * fs_hz / (lag + frac) + 0.5f);
+            *quality = (uint8_t)((q < 0.0f) ? 0.0f : (q > 100.0f) ? 100.0f : q);
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,18 @@
+#ifndef RESP_ACORR_H_
+#define RESP_ACORR_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * 呼吸频率的自相关估计 —— 纯逻辑，不依赖内核。
+ *
+ * 输入一段静止时的鬐甲 pitch（2 Hz 抽取后的样本），去均值、去线性趋势以后
+ * 在 0.1~1 Hz 对应的滞后范围内做自相关，取第一个够高的峰（避免报成一半的频率），
+ * 抛物线插值出小数滞后。x 会被原地去趋势。
+ */
+
+/* 找到峰返回 true：bpm_x10 是每分钟呼吸次数 x10，quality 是归一化自相关峰值 (0~100) */
+bool resp_acorr_estimate(float *x, int n, float fs_hz, uint16_t *bpm_x10, uint8_t *quality);
+
+#endif /* RESP_ACORR_H_ */
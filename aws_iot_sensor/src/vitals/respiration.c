@@ -0,0 +1,184 @@
+/* respiration.c
+ *
+ * 静息呼吸频率估计，见 respiration.h。
+ * 在系统工作队列里每秒跑一次，把 IMU 环形缓冲里的新帧取空。
+ */
+
+#include "respiration.h"
+#include "resp_acorr.h"
+#include "imu_array.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <math.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(respiration, LOG_LEVEL_INF);
+
+/* ====================== 参数可调 ====================== */
+
+/* 抽取后的采样率：每 500 ms 一个样本 */
+#define RESP_BUCKET_MS      500
+#define RESP_FS_HZ          2.0f
+
+/* 窗口长度：128 个样本 = 64 s，10 次/分钟时约 10 个周期 */
+#define RESP_WIN            128
+
+/* 静止判断：最近 8 s 内 pitch 的峰峰值（deg），以及相邻样本最大跳变 */
+#define RESP_STILL_SPAN     16
+#define RESP_STILL_PP_DEG   1.5f
+#define RESP_STILL_STEP_DEG 0.5f
+
+/* 连续静止这么多个样本（2 s）就让调度线程把 IMU 留着，别等满 8 s 的峰峰值判断 */
+#define RESP_HOLD_MIN       4
+
+/* 两帧之间超过这个间隔认为 IMU 断过电，窗口作废 */
+#define RESP_GAP_MS         300
+
+/* 出一次结果之后隔多久再尝试（省电：静止窗口要 IMU 常开 64 s） */
+#define RESP_HOLDOFF_S      300
+
+/* 质量分低于这个不更新结果 */
+#define RESP_MIN_QUALITY    30
+
+#define RESP_POLL_MS        1000
+
+/* ====================== 状态 ====================== */
+
+/* 抽取桶 */
+static tb_ts_t  bucket_t0;
+static int32_t  bucket_sum;
+static uint16_t bucket_n;
+static tb_ts_t  last_frame_ts;
+
+/* 静止窗口 */
+static float    win[RESP_WIN];
+static uint16_t win_n;
+static int64_t  holdoff_until_s;
+
+static struct k_spinlock resp_lock;
+static struct resp_estimate result;
+
+static void resp_work_fn(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(resp_work, resp_work_fn);
+
+/* ====================== 抽取 + 静止窗口 ====================== */
+
+static bool window_still(void)
+{
+    if (win_n < RESP_STILL_SPAN) {
+        return true;
+    }
+
+    float lo = win[win_n - 1], hi = lo;
+
+    for (int i = win_n - RESP_STILL_SPAN; i < win_n; i++) {
+        lo = MIN(lo, win[i]);
+        hi = MAX(hi, win[i]);
+    }
+
+    return (hi - lo) < RESP_STILL_PP_DEG;
+}
+
+static void push_sample(tb_ts_t ts, float pitch)
+{
+    if (win_n > 0 && fabsf(pitch - win[win_n - 1]) > RESP_STILL_STEP_DEG) {
+        win_n = 0;      /* 动了，重新攒 */
+    }
+
+    win[win_n++] = pitch;
+
+    if (!window_still()) {
+        win_n = 0;
+        return;
+    }
+
+    if (win_n < RESP_WIN) {
+        return;
+    }
+
+    uint16_t bpm_x10;
+    uint8_t q;
+    bool ok = resp_acorr_estimate(win, RESP_WIN, RESP_FS_HZ, &bpm_x10, &q);
+
+    win_n = 0;
+    holdoff_until_s = k_uptime_get() / 1000 + RESP_HOLDOFF_S;
+
+    if (!ok || q < RESP_MIN_QUALITY) {
+        LOG_INF("Respiration: no clear peak (q=%u)", ok ? q : 0);
+        return;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&resp_lock);
+    result.ts = ts;
+    result.bpm_x10 = bpm_x10;
+    result.quality = q;
+    k_spin_unlock(&resp_lock, key);
+
+    LOG_INF("Respiration %u.%u bpm (q=%u)", bpm_x10 / 10, bpm_x10 % 10, q);
+}
+
+static void feed_frame(const struct imu_frame *fr)
+{
+    if (!(fr->valid & BIT(0))) {
+        return;
+    }
+
+    /* IMU 断过电：窗口和当前桶都作废 */
+    if (last_frame_ts != 0 &&
+        (fr->ts < last_frame_ts || timebase_delta_ms(last_frame_ts, fr->ts) > RESP_GAP_MS)) {
+        win_n = 0;
+        bucket_n = 0;
+    }
+    last_frame_ts = fr->ts;
+
+    if (bucket_n == 0) {
+        bucket_t0 = fr->ts;
+        bucket_sum = 0;
+    }
+    bucket_sum += fr->eul[0][2];
+    bucket_n++;
+
+    if (timebase_delta_ms(bucket_t0, fr->ts) >= RESP_BUCKET_MS) {
+        float pitch = (float)bucket_sum / bucket_n / 16.0f;
+
+        bucket_n = 0;
+        if (k_uptime_get() / 1000 >= holdoff_until_s) {
+            push_sample(fr->ts, pitch);
+        }
+    }
+}
+
+static void resp_work_fn(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    struct imu_frame fr;
+
+    while (imu_ring_get(&fr)) {
+        feed_frame(&fr);
+    }
+
+    k_work_reschedule(&resp_work, K_MSEC(RESP_POLL_MS));
+}
+
+/* ====================== 对外接口 ====================== */
+
+int respiration_init(void)
+{
+    k_work_reschedule(&resp_work, K_MSEC(RESP_POLL_MS));
+    return 0;
+}
+
+bool respiration_window_active(void)
+{
+    /* 已经静止了一小段才值得让 IMU 继续开着 */
+    return win_n >= RESP_HOLD_MIN && win_n < RESP_WIN;
+}
+
+void respiration_get(struct resp_estimate *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&resp_lock);
+    *out = result;
+    k_spin_unlock(&resp_lock, key);
+}
@@ -0,0 +1,32 @@
+#ifndef RESPIRATION_H_
+#define RESPIRATION_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "timebase.h"
+
+/*
+ * 静息呼吸频率估计
+ *
+ * 从 IMU 环形缓冲取鬐甲 IMU 的 pitch，按时间分桶平均抽取到 2 Hz，
+ * 只有马站着 / 卧着不动时才攒窗口（64 s），窗口攒满后交给 resp_acorr 去趋势、
+ * 在 0.1~1 Hz 对应的滞后范围内做自相关找峰，得到每分钟呼吸次数和质量分。
+ * 运动期间只做抽取和静止判断（每个 2 Hz 样本几次加法），不做自相关。
+ */
+
+struct resp_estimate {
+    tb_ts_t  ts;          /* 窗口结束时间，0 = 还没有估计 */
+    uint16_t bpm_x10;     /* 呼吸频率 x10（次 / 分钟） */
+    uint8_t  quality;     /* 0~100：归一化自相关峰值 */
+};
+
+/* 启动后台估计（消费 IMU 环形缓冲） */
+int respiration_init(void);
+
+/* 是否正在攒静止窗口（调度线程据此让 IMU 保持上电直到窗口攒满） */
+bool respiration_window_active(void);
+
+void respiration_get(struct resp_estimate *out);
+
+#endif /* RESPIRATION_H_ */
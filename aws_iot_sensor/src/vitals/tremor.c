@@ -0,0 +1,159 @@
+/* tremor.c
+ *
+ * 颤抖 / 寒战检测，见 tremor.h。
+ * tremor_feed 只在 BNO 采集线程里调用；状态快照用 spinlock 保护。
+ */
+
+#include "tremor.h"
+#include "tremor_spectrum.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(tremor, LOG_LEVEL_INF);
+
+/* ====================== 参数可调 ====================== */
+
+/* 窗口：50 Hz 下 128 点 = 2.56 s，半窗滑动 */
+#define TREM_HOP            (TREMOR_N / 2)
+
+/* 漏桶迟滞（单位：窗口，约 1.3 s 一个），跨采集段保留 */
+#define TREM_SCORE_MAX      10
+#define TREM_SCORE_ENTER    5
+#define TREM_SCORE_EXIT     2
+
+/* 两个样本间隔超过这个认为 IMU 断过电，窗口重新攒 */
+#define TREM_GAP_MS         60
+
+/* ====================== 状态 ====================== */
+
+static int16_t  acc_mag[TREMOR_N];    /* 加速度模长（LSB） */
+static uint16_t gyr_mag[TREMOR_N];    /* 陀螺模长（LSB） */
+static uint16_t win_n;
+static tb_ts_t  last_ts;
+
+static uint8_t  score;
+static bool     active;
+
+static struct k_spinlock trem_lock;
+static struct tremor_status status;
+
+/* ====================== 每窗分析 ====================== */
+
+/* 三轴模长，整数开方四舍五入：round(sqrt(x)) = (isqrt(4x) + 1) / 2 */
+static uint32_t mag3(const int16_t *v)
+{
+    uint64_t s = (uint64_t)(v[0] * v[0]) + (uint64_t)(v[1] * v[1]) +
+                 (uint64_t)(v[2] * v[2]);
+
+    return (tremor_isqrt(4 * s) + 1) / 2;
+}
+
+/* 返回：1 阳性，0 阴性，-1 运动太大不计分 */
+static int analyse(tb_ts_t ts)
+{
+    struct tremor_bands b;
+    enum tremor_win r = tremor_spectrum_analyse(acc_mag, gyr_mag, &b);
+    k_spinlock_key_t key = k_spin_lock(&trem_lock);
+
+    switch (r) {
+    case TREMOR_WIN_MOTION:
+        status.gated_motion++;
+        break;
+    case TREMOR_WIN_QUIET:
+        status.gated_quiet++;
+        break;
+    default:
+        status.last = (struct tremor_features){
+            .ts             = ts,
+            .low_mms2       = b.low_mms2,
+            .band_mms2      = b.band_mms2,
+            .high_mms2      = b.high_mms2,
+            .peak_hz_x10    = b.peak_hz_x10,
+            .peak_ratio_x10 = b.peak_ratio_x10,
+            .band_pct       = b.band_pct,
+        };
+        status.analysed++;
+        break;
+    }
+    k_spin_unlock(&trem_lock, key);
+
+    if (r == TREMOR_WIN_MOTION) {
+        return -1;
+    }
+    if (r == TREMOR_WIN_QUIET) {
+        return 0;
+    }
+
+    LOG_DBG("band %u low %u high %u mm/s2, peak %u.%u Hz x%u.%u, %u%%",
+            b.band_mms2, b.low_mms2, b.high_mms2,
+            b.peak_hz_x10 / 10, b.peak_hz_x10 % 10,
+            b.peak_ratio_x10 / 10, b.peak_ratio_x10 % 10, b.band_pct);
+
+    return r == TREMOR_WIN_POSITIVE;
+}
+
+/* ====================== 对外接口 ====================== */
+
+bool tremor_feed(const struct decim_sample *s)
+{
+    if (last_ts == 0 || s->ts <= last_ts ||
+        timebase_delta_ms(last_ts, s->ts) > TREM_GAP_MS) {
+        win_n = 0;          /* 断过电：丢掉不完整的窗口，计分保留 */
+    }
+    last_ts = s->ts;
+
+    acc_mag[win_n] = (int16_t)MIN(mag3(&s->v[DECIM_CH_ACC]), INT16_MAX);
+    gyr_mag[win_n] = (uint16_t)MIN(mag3(&s->v[DECIM_CH_GYR]), UINT16_MAX);
+
+    if (++win_n < TREMOR_N) {
+        return false;
+    }
+
+    int r = analyse(s->ts);
+
+    /* 后半窗挪到前面，半窗之后再分析一次 */
+    memmove(acc_mag, &acc_mag[TREM_HOP], (TREMOR_N - TREM_HOP) * sizeof(acc_mag[0]));
+    memmove(gyr_mag, &gyr_mag[TREM_HOP], (TREMOR_N - TREM_HOP) * sizeof(gyr_mag[0]));
+    win_n = TREMOR_N - TREM_HOP;
+
+    if (r < 0) {
+        return false;
+    }
+    if (r > 0) {
+        score = MIN(score + 1, TREM_SCORE_MAX);
+    } else if (score > 0) {
+        score--;
+    }
+
+    bool onset = false;
+
+    if (!active && score >= TREM_SCORE_ENTER) {
+        active = true;
+        onset = true;
+    } else if (active && score <= TREM_SCORE_EXIT) {
+        active = false;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&trem_lock);
+    if (onset) {
+        status.episodes++;
+    }
+    status.active = active;
+    struct tremor_features f = status.last;
+    k_spin_unlock(&trem_lock, key);
+
+    if (onset) {
+        LOG_WRN("Tremor detected: %u mm/s2 at %u.%u Hz (%u%% of energy)",
+                f.band_mms2, f.peak_hz_x10 / 10, f.peak_hz_x10 % 10, f.band_pct);
+    }
+    return onset;
+}
+
+void tremor_get(struct tremor_status *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&trem_lock);
+    *out = status;
+    k_spin_unlock(&trem_lock, key);
+}
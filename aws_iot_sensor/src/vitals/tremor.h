@@ -0,0 +1,71 @@
+#ifndef TREMOR_H_
+#define TREMOR_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "timebase.h"
+#include "decimator.h"
+
+/*
+ * 颤抖 / 寒战检测
+ *
+ * 寒战（低体温、疼痛）和震颤是 5~15 Hz 的加速度能量，倾角阈值看不到。
+ * 由 IMU 50 Hz 流水线的一个 DETECT 级逐样本调用，鬐甲 IMU 的加速度模长
+ * （和项圈朝向无关）攒 128 点窗口（2.56 s，分辨率 0.39 Hz），每半窗分析一次。
+ *
+ * 只在“运动门控”通过的窗口上做 FFT：
+ *  - 陀螺模长均值太大（走动、甩头）：步态谐波会盖住震颤频段，不分析，不计分；
+ *  - 加速度差分 RMS 太小（完全静止）：不可能有震颤，不做 FFT，按阴性计分。
+ * 通过门控的窗口去均值、加 Hann 窗，做实数 FFT（CMSIS-DSP arm_rfft_fast_f32，
+ * 没有 FPU 时用 arm_rfft_q15），算三个频段的 RMS、5~15 Hz 内的峰值频率和
+ * 峰的尖锐程度。阳性窗口用漏桶计分做迟滞，进入震颤状态时触发一次异常抓拍。
+ *
+ * 上报的只是频段能量和峰值特征，不上报频谱。
+ * 门控和频谱特征在 tremor_spectrum.c（纯逻辑，可以单独测试），这里只攒窗口和计分。
+ */
+
+struct tremor_features {
+    tb_ts_t  ts;              /* 窗口结束时间，0 = 还没有分析过 */
+    uint16_t low_mms2;        /* 0.5~5 Hz RMS 加速度（mm/s2） */
+    uint16_t band_mms2;       /* 5~15 Hz */
+    uint16_t high_mms2;       /* 15~25 Hz */
+    uint16_t peak_hz_x10;     /* 5~15 Hz 内最强谱线的频率 x10 */
+    uint8_t  peak_ratio_x10;  /* 峰值 / 带内平均 x10（越大峰越尖） */
+    uint8_t  band_pct;        /* 5~15 Hz 占 0.5~25 Hz 总能量的百分比 */
+};
+
+struct tremor_status {
+    struct tremor_features last;  /* 最近一个做过 FFT 的窗口 */
+    bool     active;              /* 当前是否判定为震颤 / 寒战 */
+    uint32_t episodes;            /* 上电以来进入震颤状态的次数 */
+    uint32_t analysed;            /* 做过 FFT 的窗口数 */
+    uint32_t gated_motion;        /* 运动太大跳过的窗口数 */
+    uint32_t gated_quiet;         /* 太静跳过的窗口数 */
+};
+
+#if defined(CONFIG_HORSE_PIPE_TREMOR)
+
+/* IMU 50 Hz 样本；进入震颤状态的那一个样本返回 true */
+bool tremor_feed(const struct decim_sample *s);
+
+void tremor_get(struct tremor_status *out);
+
+#else
+
+/* 没编进 tremor.c（也就不拉 CMSIS-DSP）：上报字段全 0，永远不触发 */
+static inline bool tremor_feed(const struct decim_sample *s)
+{
+    (void)s;
+    return false;
+}
+
+static inline void tremor_get(struct tremor_status *out)
+{
+    memset(out, 0, sizeof(*out));
+}
+
+#endif /* CONFIG_HORSE_PIPE_TREMOR */
+
+#endif /* TREMOR_H_ */
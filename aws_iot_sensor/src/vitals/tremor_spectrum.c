@@ -0,0 +1,247 @@
+/* tremor_spectrum.c
+ *
+ * 颤抖检测的单窗分析，见 tremor_spectrum.h。
+ */
+
+#include "tremor_spectrum.h"
+
+#include <math.h>
+#include <stdbool.h>
+
+#include <arm_math.h>
+
+/* ====================== 参数可调 ====================== */
+
+#define TREM_FS_HZ          50
+
+/* 频段边界（Hz x10） */
+#define TREM_LOW_HZ_X10     5
+#define TREM_BAND_LO_HZ_X10 50
+#define TREM_BAND_HI_HZ_X10 150
+
+/* 运动门控：陀螺模长窗口均值超过这个（dps）算在走动 / 甩头 */
+#define TREM_GYR_MAX_DPS    30
+
+/* 安静门控：加速度模长相邻差的 RMS 低于这个（LSB x10，1 LSB = 0.01 m/s2）不做 FFT */
+#define TREM_QUIET_LSB_X10  15
+
+/* 阳性窗口：带内 RMS、带内占比、峰的尖锐程度 */
+#define TREM_MIN_MMS2       60
+#define TREM_MIN_PCT        40
+#define TREM_MIN_RATIO_X10  25
+
+/*
+ * 去均值后的模长放大这么多倍再进 Q15 FFT，小幅震颤也有足够的有效位。
+ * 两条路径的功率谱都用 (LSB x TREM_GAIN)^2 做单位。
+ */
+#define TREM_GAIN           64
+
+/* BNO055 默认单位：加速度 1 LSB = 0.01 m/s2 = 10 mm/s2，角速度 1 dps = 16 LSB */
+#define ACC_MMS2_PER_LSB    10
+#define GYR_LSB_PER_DPS     16
+
+/* Hann 窗的功率增益 sum(w^2) / N = 3 / 8 */
+#define HANN_POWER_NUM      3
+#define HANN_POWER_DEN      8
+
+/* 四舍五入到最近的谱线 */
+#define TREM_BIN(hz_x10) \
+    (((hz_x10) * TREMOR_N + TREM_FS_HZ * 10 / 2) / (TREM_FS_HZ * 10))
+
+#if defined(CONFIG_HORSE_TREMOR_FFT_Q15)
+#define TREM_USE_Q15        1
+#else
+#define TREM_USE_Q15        0
+#endif
+
+/* ====================== 状态 ====================== */
+
+static uint64_t power[TREMOR_N / 2];    /* 单边功率谱，(LSB x TREM_GAIN)^2 */
+
+#if TREM_USE_Q15
+static arm_rfft_instance_q15 rfft;
+static q15_t    hann[TREMOR_N];
+static q15_t    fft_in[TREMOR_N];
+static q15_t    fft_out[2 * TREMOR_N];
+#else
+static arm_rfft_fast_instance_f32 rfft;
+static float    hann[TREMOR_N];
+static float    fft_in[TREMOR_N];
+static float    fft_out[TREMOR_N];
+static float    mag2[TREMOR_N / 2];
+#endif
+static bool     fft_ready;
+
+/* ====================== FFT ====================== */
+
+uint32_t tremor_isqrt(uint64_t x)
+{
+    uint64_t r = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    while (bit > x) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (x >= r + bit) {
+            x -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (uint32_t)r;
+}
+
+/* 只在第一次分析时跑一次，Q15 路径唯一的浮点运算 */
+static void fft_setup(void)
+{
+    for (int i = 0; i < TREMOR_N; i++) {
+        float w = 0.5f - 0.5f * cosf(2.0f * PI * i / TREMOR_N);
+
+#if TREM_USE_Q15
+        int32_t q = (int32_t)(w * 32768.0f + 0.5f);
+
+        hann[i] = (q15_t)(q > INT16_MAX ? INT16_MAX : q);
+#else
+        hann[i] = w;
+#endif
+    }
+
+#if TREM_USE_Q15
+    (void)arm_rfft_init_q15(&rfft, TREMOR_N, 0, 1);
+#else
+    (void)arm_rfft_fast_init_f32(&rfft, TREMOR_N);
+#endif
+    fft_ready = true;
+}
+
+/*
+ * 去均值、加窗、FFT，结果写到 power[k] = |X[k] / N|^2 x TREM_GAIN^2（原始 LSB），
+ * 两条路径的单位一样，后面的特征计算不用区分。
+ */
+static void spectrum(const int16_t *acc, int32_t acc_sum)
+{
+#if TREM_USE_Q15
+    /* 均值也放大 TREM_GAIN 倍再取整，不丢小数部分 */
+    int32_t mean_g = (acc_sum * TREM_GAIN + TREMOR_N / 2) / TREMOR_N;
+
+    for (int i = 0; i < TREMOR_N; i++) {
+        int32_t d = acc[i] * TREM_GAIN - mean_g;
+
+        d = d < INT16_MIN ? INT16_MIN : (d > INT16_MAX ? INT16_MAX : d);
+        fft_in[i] = (q15_t)((d * hann[i]) >> 15);
+    }
+
+    /* arm_rfft_q15 每一级蝶形右移 1 位，128 点输出是 X / N（8.8 格式） */
+    arm_rfft_q15(&rfft, fft_in, fft_out);
+
+    for (int b = 0; b < TREMOR_N / 2; b++) {
+        int32_t re = fft_out[2 * b];
+        int32_t im = fft_out[2 * b + 1];
+
+        power[b] = (uint64_t)(re * re) + (uint64_t)(im * im);
+    }
+#else
+    float mean = (float)acc_sum / TREMOR_N;
+
+    for (int i = 0; i < TREMOR_N; i++) {
+        fft_in[i] = (acc[i] - mean) * hann[i];
+    }
+
+    /* 输出打包：[0] = 直流，[1] = 奈奎斯特，之后是 re / im 交替 */
+    arm_rfft_fast_f32(&rfft, fft_in, fft_out, 0);
+    arm_cmplx_mag_squared_f32(fft_out, mag2, TREMOR_N / 2);
+
+    const float k = (float)TREM_GAIN * TREM_GAIN / ((float)TREMOR_N * TREMOR_N);
+
+    for (int b = 0; b < TREMOR_N / 2; b++) {
+        power[b] = (uint64_t)(mag2[b] * k + 0.5f);
+    }
+#endif
+    power[0] = 0;           /* 直流（和打包进来的奈奎斯特）不用 */
+}
+
+/* 单边频段功率 → RMS 加速度（mm/s2），补上 Hann 窗的功率损失 */
+static uint16_t band_rms(uint64_t sum)
+{
+    uint64_t ms = sum * 2 * HANN_POWER_DEN * ACC_MMS2_PER_LSB * ACC_MMS2_PER_LSB /
+                  HANN_POWER_NUM;
+    uint32_t rms = (tremor_isqrt(ms) + TREM_GAIN / 2) / TREM_GAIN;
+
+    return (uint16_t)(rms > UINT16_MAX ? UINT16_MAX : rms);
+}
+
+/* ====================== 每窗分析 ====================== */
+
+enum tremor_win tremor_spectrum_analyse(const int16_t acc_mag[TREMOR_N],
+                                        const uint16_t gyr_mag[TREMOR_N],
+                                        struct tremor_bands *out)
+{
+    uint32_t gyr_sum = 0;
+    int32_t  acc_sum = 0;
+    uint64_t d2 = 0;
+
+    for (int i = 0; i < TREMOR_N; i++) {
+        gyr_sum += gyr_mag[i];
+        acc_sum += acc_mag[i];
+        if (i > 0) {
+            int32_t d = acc_mag[i] - acc_mag[i - 1];
+
+            d2 += (uint64_t)(d * d);
+        }
+    }
+
+    if (gyr_sum > (uint32_t)TREM_GYR_MAX_DPS * GYR_LSB_PER_DPS * TREMOR_N) {
+        return TREMOR_WIN_MOTION;
+    }
+    /* sqrt(d2 / (N - 1)) < QUIET_X10 / 10 */
+    if (d2 * 100 < (uint64_t)TREM_QUIET_LSB_X10 * TREM_QUIET_LSB_X10 * (TREMOR_N - 1)) {
+        return TREMOR_WIN_QUIET;
+    }
+
+    if (!fft_ready) {
+        fft_setup();
+    }
+    spectrum(acc_mag, acc_sum);
+
+    const int b_low = TREM_BIN(TREM_LOW_HZ_X10) > 1 ? TREM_BIN(TREM_LOW_HZ_X10) : 1;
+    const int b_lo  = TREM_BIN(TREM_BAND_LO_HZ_X10);
+    const int b_hi  = TREM_BIN(TREM_BAND_HI_HZ_X10);
+    uint64_t p_low = 0, p_band = 0, p_high = 0;
+    uint64_t p_peak = 0;
+    int      k_peak = b_lo;
+
+    for (int b = b_low; b < TREMOR_N / 2; b++) {
+        if (b < b_lo) {
+            p_low += power[b];
+        } else if (b <= b_hi) {
+            p_band += power[b];
+            if (power[b] > p_peak) {
+                p_peak = power[b];
+                k_peak = b;
+            }
+        } else {
+            p_high += power[b];
+        }
+    }
+
+    uint64_t total = p_low + p_band + p_high;
+    /* 峰值 / 带内平均 = 峰值 x 谱线数 / 带内总和 */
+    uint64_t ratio = p_band > 0 ?
+                     (10 * p_peak * (uint64_t)(b_hi - b_lo + 1) + p_band / 2) / p_band : 0;
+
+    out->low_mms2       = band_rms(p_low);
+    out->band_mms2      = band_rms(p_band);
+    out->high_mms2      = band_rms(p_high);
+    out->peak_hz_x10    = (uint16_t)((k_peak * TREM_FS_HZ * 10 + TREMOR_N / 2) / TREMOR_N);
+    out->peak_ratio_x10 = (uint8_t)(ratio > UINT8_MAX ? UINT8_MAX : ratio);
+    out->band_pct       = (uint8_t)(total > 0 ? (100 * p_band + total / 2) / total : 0);
+
+    bool positive = out->band_mms2 >= TREM_MIN_MMS2 && out->band_pct >= TREM_MIN_PCT &&
+                    out->peak_ratio_x10 >= TREM_MIN_RATIO_X10;
+
+    return positive ? TREMOR_WIN_POSITIVE : TREMOR_WIN_NEGATIVE;
+}
@@ -0,0 +1,46 @@
+#ifndef TREMOR_SPECTRUM_H_
+#define TREMOR_SPECTRUM_H_
+
+#include <stdint.h>
+
+/*
+ * 颤抖检测的单窗分析 —— 纯逻辑，不依赖内核（只用 CMSIS-DSP 的实数 FFT）。
+ *
+ * 输入一个 128 点窗口（50 Hz，2.56 s）的加速度模长和陀螺模长（BNO055 LSB），
+ * 先过运动 / 安静门控，通过的去均值、加 Hann 窗做 FFT，算三个频段的 RMS、
+ * 5~15 Hz 内的峰值频率和峰的尖锐程度，判定这个窗口是否阳性。
+ *
+ * CONFIG_HORSE_TREMOR_FFT_Q15 时整条路径都是定点（arm_rfft_q15 + 整数开方 / 比值），
+ * 没有 FPU 的构建不做任何浮点运算（Hann 窗表只在第一次调用时算一遍）；
+ * 否则用 arm_rfft_fast_f32，功率谱换成同样的整数单位，后面的特征计算共用。
+ * 内部有 FFT 缓冲区，只能在一个线程里调用。
+ */
+
+#define TREMOR_N            128
+
+enum tremor_win {
+    TREMOR_WIN_MOTION = 0,    /* 陀螺太大（走动、甩头），不分析，不计分 */
+    TREMOR_WIN_QUIET,         /* 完全静止，不做 FFT，按阴性计分 */
+    TREMOR_WIN_NEGATIVE,      /* 做了 FFT，阴性 */
+    TREMOR_WIN_POSITIVE,      /* 做了 FFT，阳性 */
+};
+
+/* 一个做过 FFT 的窗口的特征 */
+struct tremor_bands {
+    uint16_t low_mms2;        /* 0.5~5 Hz RMS 加速度（mm/s2） */
+    uint16_t band_mms2;       /* 5~15 Hz */
+    uint16_t high_mms2;       /* 15~25 Hz */
+    uint16_t peak_hz_x10;     /* 5~15 Hz 内最强谱线的频率 x10 */
+    uint8_t  peak_ratio_x10;  /* 峰值 / 带内平均 x10（越大峰越尖） */
+    uint8_t  band_pct;        /* 5~15 Hz 占 0.5~25 Hz 总能量的百分比 */
+};
+
+/* 分析一个窗口；返回 NEGATIVE / POSITIVE 时 out 有效 */
+enum tremor_win tremor_spectrum_analyse(const int16_t acc_mag[TREMOR_N],
+                                        const uint16_t gyr_mag[TREMOR_N],
+                                        struct tremor_bands *out);
+
+/* 整数平方根，向下取整 */
+uint32_t tremor_isqrt(uint64_t x);
+
+#endif /* TREMOR_SPECTRUM_H_ */
@@ -0,0 +1,178 @@
+/* tests/baro_posture/src/baro_posture_test.c
+ *
+ * 气压卧倒判定在天气斜坡上的回放。轨迹是一串分段：
+ *   持续秒数、项圈相对站立抬头时的高度（m）、IMU 是否在线、脖子 pitch，
+ * 按 1 Hz 展开；气压 = 天气（101325 Pa 起，按 hPa/h 线性变化）再按项圈高度换算，
+ * 加 ±2 cm 的高度噪声。0.5~1 hPa/h（锋面过境）下一直站着 / 吃草不能报卧倒，
+ * 真卧倒在斜坡上也要判出来，而且站起来以后能回到站立。
+ */
+#include <zephyr/ztest.h>
+#include <math.h>
+#include "baro_detector.h"
+
+#define P0_PA           101325.0f
+#define TEMP_C          15.0f
+#define RT_OVER_G       29.27f      /* 和 baro_detector.c 一样 */
+
+#define H_GRAZE_M       (-0.7f)     /* 低头吃草 */
+#define H_LYING_M       (-1.0f)     /* 侧卧 */
+#define PITCH_UP_DEG    5
+#define PITCH_GRAZE_DEG 45
+
+struct seg {
+	uint16_t dur_s;
+	float    h_m;
+	uint8_t  imu;
+	int8_t   pitch;
+};
+
+struct replay_result {
+	uint32_t episodes;          /* 站 → 卧的次数 */
+	uint32_t lie_at_s;          /* 第一次卧倒的时间，0 = 没有 */
+	uint32_t stand_at_s;        /* 第一次卧倒以后重新站起的时间，0 = 没有 */
+	float    min_dh;
+	enum posture final;
+};
+
+#define MIN_S(m) ((uint16_t)((m) * 60))
+
+/* 确定的伪随机数，结果可重复 */
+static uint32_t rng = 1;
+
+static float noise(float amp)
+{
+	rng = rng * 1664525u + 1013904223u;
+	return amp * (((float)(rng >> 8) / (float)(1u << 24)) * 2.0f - 1.0f);
+}
+
+static float pressure_at(uint32_t t, float hpa_per_h, float h_m)
+{
+	float weather = P0_PA + hpa_per_h * 100.0f * (float)t / 3600.0f;
+
+	return weather * expf(-(h_m + noise(0.02f)) /
+			      (RT_OVER_G * (TEMP_C + 273.15f)));
+}
+
+static void replay(const struct seg *trace, size_t n, float hpa_per_h,
+		   struct replay_result *res)
+{
+	baro_detector_t bd;
+	uint32_t t = 0;
+
+	baro_detector_init(&bd);
+	memset(res, 0, sizeof(*res));
+
+	for (size_t i = 0; i < n; i++) {
+		for (uint16_t k = 0; k < trace[i].dur_s; k++, t++) {
+			float p = pressure_at(t, hpa_per_h, trace[i].h_m);
+
+			if (baro_detector_update(&bd, t, p, TEMP_C, trace[i].imu,
+						 trace[i].pitch)) {
+				if (bd.state == POSTURE_LYING) {
+					res->episodes++;
+					if (res->lie_at_s == 0) {
+						res->lie_at_s = t;
+					}
+				} else if (res->lie_at_s != 0 && res->stand_at_s == 0) {
+					res->stand_at_s = t;
+				}
+			}
+			if (bd.state != POSTURE_UNKNOWN && bd.dh < res->min_dh) {
+				res->min_dh = bd.dh;
+			}
+		}
+	}
+
+	res->final = bd.state;
+}
+
+/* 一直抬头站着，IMU 断电（只靠气压） */
+static const struct seg trace_stand[] = {
+	{ MIN_S(360), 0.0f, 0, 0 },
+};
+
+/* 站着，吃草 25 分钟 / 抬头 10 分钟交替 */
+static const struct seg trace_graze[] = {
+	{ MIN_S(10), 0.0f,        1, PITCH_UP_DEG },
+	{ MIN_S(25), H_GRAZE_M,   1, PITCH_GRAZE_DEG },
+	{ MIN_S(10), 0.0f,        1, PITCH_UP_DEG },
+	{ MIN_S(25), H_GRAZE_M,   1, PITCH_GRAZE_DEG },
+	{ MIN_S(10), 0.0f,        1, PITCH_UP_DEG },
+	{ MIN_S(25), H_GRAZE_M,   1, PITCH_GRAZE_DEG },
+	{ MIN_S(10), 0.0f,        1, PITCH_UP_DEG },
+};
+
+/* 站 30 分钟，侧卧 30 分钟，再站 30 分钟 */
+static const struct seg trace_lie_imu[] = {
+	{ MIN_S(30), 0.0f,      1, PITCH_UP_DEG },
+	{ MIN_S(30), H_LYING_M, 1, 10 },
+	{ MIN_S(30), 0.0f,      1, PITCH_UP_DEG },
+};
+
+static const struct seg trace_lie_baro[] = {
+	{ MIN_S(30), 0.0f,      0, 0 },
+	{ MIN_S(30), H_LYING_M, 0, 0 },
+	{ MIN_S(30), 0.0f,      0, 0 },
+};
+
+ZTEST(baro_posture, test_01_standing_on_pressure_ramp)
+{
+	static const float rates[] = { 1.0f, -1.0f, 0.5f, -0.5f, 0.0f };
+	struct replay_result res;
+
+	for (size_t i = 0; i < ARRAY_SIZE(rates); i++) {
+		replay(trace_stand, ARRAY_SIZE(trace_stand), rates[i], &res);
+		TC_PRINT("%+.1f hPa/h: min dh %.2f m, episodes %u\n",
+			 (double)rates[i], (double)res.min_dh, res.episodes);
+		zassert_equal(res.episodes, 0, "false LYING at %+.1f hPa/h",
+			      (double)rates[i]);
+		zassert_equal(res.final, POSTURE_STANDING, NULL);
+		/* 参考跟得上斜坡：滞后比站起阈值（-0.25 m）还小 */
+		zassert_true(res.min_dh > -0.2f, "reference lags by %.2f m",
+			     (double)res.min_dh);
+	}
+}
+
+ZTEST(baro_posture, test_02_grazing_bouts_on_pressure_ramp)
+{
+	static const float rates[] = { 1.0f, -1.0f, 0.5f };
+	struct replay_result res;
+
+	for (size_t i = 0; i < ARRAY_SIZE(rates); i++) {
+		replay(trace_graze, ARRAY_SIZE(trace_graze), rates[i], &res);
+		zassert_equal(res.episodes, 0, "false LYING at %+.1f hPa/h",
+			      (double)rates[i]);
+		zassert_equal(res.final, POSTURE_STANDING, NULL);
+	}
+}
+
+ZTEST(baro_posture, test_03_lying_detected_on_ramp_with_imu)
+{
+	static const float rates[] = { 1.0f, -1.0f, 0.0f };
+	struct replay_result res;
+
+	for (size_t i = 0; i < ARRAY_SIZE(rates); i++) {
+		replay(trace_lie_imu, ARRAY_SIZE(trace_lie_imu), rates[i], &res);
+		TC_PRINT("%+.1f hPa/h: lie at %u s, stand at %u s\n",
+			 (double)rates[i], res.lie_at_s, res.stand_at_s);
+		zassert_equal(res.episodes, 1, NULL);
+		/* 20 s 持续 + 快 IIR 一两个样本 */
+		zassert_within(res.lie_at_s, MIN_S(30) + 22, 3, NULL);
+		/* 卧倒 30 分钟、天气漂了几米，站起来照样判得出 */
+		zassert_within(res.stand_at_s, MIN_S(60) + 7, 3, NULL);
+		zassert_equal(res.final, POSTURE_STANDING, NULL);
+	}
+}
+
+ZTEST(baro_posture, test_04_lying_detected_baro_only)
+{
+	struct replay_result res;
+
+	replay(trace_lie_baro, ARRAY_SIZE(trace_lie_baro), 1.0f, &res);
+	zassert_equal(res.episodes, 1, NULL);
+	zassert_within(res.lie_at_s, MIN_S(30) + 62, 3, NULL);
+	zassert_true(res.stand_at_s > MIN_S(60), NULL);
+	zassert_equal(res.final, POSTURE_STANDING, NULL);
+}
+
+ZTEST_SUITE(baro_posture, NULL, NULL, NULL, NULL, NULL);
@@ -0,0 +1,141 @@
+/* tests/bme280_comp/src/bme280_comp_test.c
+ *
+ * BME280 补偿：温度 / 气压用 Bosch 数据手册的算例（25.08 °C，100653.27 Pa），
+ * 湿度和数据手册的浮点公式对比；校准寄存器解析（H4 / H5 共用半字节、负数）
+ * 和测量被跳过时不出数。
+ */
+#include <zephyr/ztest.h>
+#include <string.h>
+#include "bme280_comp.h"
+
+/* 数据手册算例的温度 / 气压校准参数，湿度用一片典型 BME280 的值 */
+static const struct bme280_calib cal = {
+	.t1 = 27504, .t2 = 26435, .t3 = -1000,
+	.p1 = 36477, .p2 = -10685, .p3 = 3024, .p4 = 2855, .p5 = 140,
+	.p6 = -7, .p7 = 15500, .p8 = -14600, .p9 = 6000,
+	.h1 = 75, .h2 = 362, .h3 = 0, .h4 = 313, .h5 = 50, .h6 = 30,
+};
+
+#define ADC_T   519888
+#define ADC_P   415148
+
+static void put16(uint8_t *b, int v)
+{
+	b[0] = (uint8_t)v;
+	b[1] = (uint8_t)(v >> 8);
+}
+
+/* 按寄存器布局把校准参数编回字节 */
+static void pack_calib(const struct bme280_calib *c, uint8_t *tp, uint8_t *h)
+{
+	const int16_t pv[] = { c->p2, c->p3, c->p4, c->p5, c->p6, c->p7, c->p8, c->p9 };
+
+	memset(tp, 0, BME280_CALIB_TP_LEN);
+	put16(&tp[0], c->t1);
+	put16(&tp[2], c->t2);
+	put16(&tp[4], c->t3);
+	put16(&tp[6], c->p1);
+	for (int i = 0; i < 8; i++) {
+		put16(&tp[8 + 2 * i], pv[i]);
+	}
+	tp[25] = c->h1;
+
+	put16(&h[0], c->h2);
+	h[2] = c->h3;
+	h[3] = (uint8_t)(c->h4 >> 4);
+	h[4] = (uint8_t)((c->h4 & 0x0F) | ((c->h5 & 0x0F) << 4));
+	h[5] = (uint8_t)(c->h5 >> 4);
+	h[6] = (uint8_t)c->h6;
+}
+
+/* 逐字段比（结构体里有填充字节，不能 memcmp） */
+static bool calib_equal(const struct bme280_calib *a, const struct bme280_calib *b)
+{
+	return a->t1 == b->t1 && a->t2 == b->t2 && a->t3 == b->t3 &&
+	       a->p1 == b->p1 && a->p2 == b->p2 && a->p3 == b->p3 && a->p4 == b->p4 &&
+	       a->p5 == b->p5 && a->p6 == b->p6 && a->p7 == b->p7 && a->p8 == b->p8 &&
+	       a->p9 == b->p9 && a->h1 == b->h1 && a->h2 == b->h2 && a->h3 == b->h3 &&
+	       a->h4 == b->h4 && a->h5 == b->h5 && a->h6 == b->h6;
+}
+
+/* 数据手册 4.2.3 节的浮点湿度公式 */
+static double hum_ref(const struct bme280_calib *c, int32_t adc_h, int32_t t_fine)
+{
+	double v = t_fine - 76800.0;
+
+	v = (adc_h - (c->h4 * 64.0 + c->h5 / 16384.0 * v)) *
+	    (c->h2 / 65536.0 * (1.0 + c->h6 / 67108864.0 * v * (1.0 + c->h3 / 67108864.0 * v)));
+	v = v * (1.0 - c->h1 * v / 524288.0);
+	return (v < 0.0) ? 0.0 : (v > 100.0) ? 100.0 : v;
+}
+
+ZTEST(bme280_comp, test_datasheet_temp_press)
+{
+	int32_t t_fine;
+
+	zassert_equal(bme280_comp_temp(&cal, ADC_T, &t_fine), 2508);
+	zassert_equal(t_fine, 128422);
+
+	uint32_t p = bme280_comp_press(&cal, ADC_P, t_fine);
+
+	/* 算例的 100653.27 Pa 是浮点公式的结果，整数版本差零点零几 Pa（Q24.8） */
+	zassert_within(p, 25767236, 8, "p %u", p);
+}
+
+ZTEST(bme280_comp, test_humidity_vs_float)
+{
+	static const int32_t adc[] = { 20000, 27000, 30000, 35000, 42000 };
+	static const int32_t tf[] = { 60000, 128422, 160000 };
+
+	for (size_t i = 0; i < ARRAY_SIZE(adc); i++) {
+		for (size_t k = 0; k < ARRAY_SIZE(tf); k++) {
+			double h = bme280_comp_hum(&cal, adc[i], tf[k]) / 1024.0;
+			double r = hum_ref(&cal, adc[i], tf[k]);
+
+			zassert_within(h, r, 0.05, "adc %d t_fine %d: %f vs %f",
+				       adc[i], tf[k], h, r);
+		}
+	}
+}
+
+ZTEST(bme280_comp, test_parse_calib)
+{
+	uint8_t tp[BME280_CALIB_TP_LEN], h[BME280_CALIB_H_LEN];
+	struct bme280_calib neg = cal;
+	struct bme280_calib out;
+
+	/* H4 / H5 是有符号 12 位 */
+	neg.h4 = -300;
+	neg.h5 = -7;
+
+	const struct bme280_calib *in[] = { &cal, &neg };
+
+	for (int i = 0; i < 2; i++) {
+		pack_calib(in[i], tp, h);
+		bme280_comp_parse_calib(&out, tp, h);
+		zassert_true(calib_equal(&out, in[i]), "calib %d", i);
+	}
+}
+
+ZTEST(bme280_comp, test_convert)
+{
+	uint8_t raw[BME280_DATA_LEN] = {
+		ADC_P >> 12, (ADC_P >> 4) & 0xFF, (ADC_P & 0x0F) << 4,
+		ADC_T >> 12, (ADC_T >> 4) & 0xFF, (ADC_T & 0x0F) << 4,
+		30000 >> 8, 30000 & 0xFF,
+	};
+	float t, p, hum;
+
+	zassert_true(bme280_comp_convert(&cal, raw, &t, &p, &hum));
+	zassert_within(t, 25.08f, 0.001f);
+	zassert_within(p, 100.65327f, 0.0001f);
+	zassert_within(hum, (float)hum_ref(&cal, 30000, 128422), 0.05f);
+
+	/* 上电后还没测过：0x80000 */
+	raw[3] = 0x80;
+	raw[4] = 0x00;
+	raw[5] = 0x00;
+	zassert_false(bme280_comp_convert(&cal, raw, &t, &p, &hum));
+}
+
+ZTEST_SUITE(bme280_comp, NULL, NULL, NULL, NULL, NULL);
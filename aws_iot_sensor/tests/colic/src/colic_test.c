@@ -0,0 +1,186 @@
+/* tests/colic/src/colic_test.c
+ *
+ * 用回放轨迹测疝痛检测器。轨迹是一串分段：
+ *   持续秒数、是否卧倒、roll 中心值、roll 摆动幅度（每 5 s 左右翻一次）、IMU 是否在线，
+ * 按 1 Hz 展开喂给 colic_detector_update。
+ */
+#include <zephyr/ztest.h>
+#include <string.h>
+#include "colic_detector.h"
+
+struct seg {
+	uint16_t dur_s;
+	uint8_t  lying;
+	int8_t   roll;
+	int8_t   swing;
+	uint8_t  imu;
+};
+
+struct replay_result {
+	colic_level_t final;
+	colic_level_t max;
+	uint32_t      escalations;
+	uint32_t      alert_at_s;     /* 第一次 ALERT 的时间，0 = 没有 */
+};
+
+#define MIN_S(m) ((uint16_t)((m) * 60))
+
+static uint32_t replay(colic_detector_t *cd, const struct seg *trace, size_t n,
+		       uint32_t t0, struct replay_result *res)
+{
+	uint32_t t = t0;
+
+	for (size_t i = 0; i < n; i++) {
+		for (uint16_t k = 0; k < trace[i].dur_s; k++, t++) {
+			float roll = trace[i].roll +
+				     (((k / 5) & 1) ? trace[i].swing : -trace[i].swing);
+			bool esc = false;
+			colic_level_t lv = colic_detector_update(cd, t, trace[i].lying,
+								 trace[i].imu, roll, &esc);
+
+			if (esc) {
+				res->escalations++;
+			}
+			if (lv > res->max) {
+				res->max = lv;
+			}
+			if (lv == COLIC_LEVEL_ALERT && res->alert_at_s == 0) {
+				res->alert_at_s = t - t0;
+			}
+			res->final = lv;
+		}
+	}
+
+	return t;
+}
+
+/* 正常休息：站 30 分钟，侧卧一次 40 分钟，再站起来吃草 */
+static const struct seg trace_rest[] = {
+	{ MIN_S(30), 0,  0, 2, 1 },
+	{ MIN_S(40), 1, 70, 3, 1 },
+	{ MIN_S(30), 0,  0, 2, 1 },
+};
+
+/* 疝痛：20 分钟内反复卧倒，每次卧倒都来回打滚 */
+static const struct seg trace_colic[] = {
+	{ MIN_S(10), 0,  0,  2, 1 },
+	{ MIN_S(3),  1,  0, 60, 1 },
+	{ MIN_S(4),  0,  0,  5, 1 },
+	{ MIN_S(3),  1,  0, 60, 1 },
+	{ MIN_S(4),  0,  0,  5, 1 },
+	{ MIN_S(3),  1,  0, 60, 1 },
+	{ MIN_S(10), 0,  0,  2, 1 },
+};
+
+/* IMU 断电：只有气压卧倒信号，一小时内卧倒 4 次 */
+static const struct seg trace_baro_only[] = {
+	{ MIN_S(5), 0, 0, 0, 0 },
+	{ MIN_S(2), 1, 0, 0, 0 },
+	{ MIN_S(8), 0, 0, 0, 0 },
+	{ MIN_S(2), 1, 0, 0, 0 },
+	{ MIN_S(8), 0, 0, 0, 0 },
+	{ MIN_S(2), 1, 0, 0, 0 },
+	{ MIN_S(8), 0, 0, 0, 0 },
+	{ MIN_S(2), 1, 0, 0, 0 },
+	{ MIN_S(5), 0, 0, 0, 0 },
+};
+
+/* 每 90 分钟卧倒一次：间隔超过滑动窗口，永远不该报警 */
+static const struct seg trace_sparse[] = {
+	{ MIN_S(85), 0, 0, 2, 1 },
+	{ MIN_S(5),  1, 0, 2, 1 },
+	{ MIN_S(85), 0, 0, 2, 1 },
+	{ MIN_S(5),  1, 0, 2, 1 },
+	{ MIN_S(85), 0, 0, 2, 1 },
+	{ MIN_S(5),  1, 0, 2, 1 },
+};
+
+static const struct seg trace_quiet_2h[] = {
+	{ MIN_S(120), 0, 0, 2, 1 },
+};
+
+ZTEST(horse_colic, test_normal_rest_never_alerts)
+{
+	colic_detector_t cd;
+	struct replay_result res = { 0 };
+
+	colic_detector_init(&cd, 15.0f);
+	replay(&cd, trace_rest, ARRAY_SIZE(trace_rest), 1000, &res);
+
+	zassert_true(res.max < COLIC_LEVEL_ALERT, "one rest episode must not alert");
+	zassert_equal(res.escalations, 1, "lateral rest is at most WATCH");
+}
+
+ZTEST(horse_colic, test_rolling_escalates_to_alert)
+{
+	colic_detector_t cd;
+	struct replay_result res = { 0 };
+
+	colic_detector_init(&cd, 15.0f);
+	replay(&cd, trace_colic, ARRAY_SIZE(trace_colic), 1000, &res);
+
+	zassert_equal(res.max, COLIC_LEVEL_ALERT, "repeated rolling must alert");
+	zassert_true(res.alert_at_s > 0 && res.alert_at_s < 20 * 60,
+		     "alert should fire within the second episode (at %u s)",
+		     res.alert_at_s);
+	zassert_true(colic_detector_roll_count(&cd) >= 3,
+		     "rolls while lying should be counted (%u)",
+		     colic_detector_roll_count(&cd));
+	zassert_equal(res.escalations, 2, "NONE->WATCH->ALERT, escalated twice");
+}
+
+ZTEST(horse_colic, test_baro_only_repeated_lying_alerts)
+{
+	colic_detector_t cd;
+	struct replay_result res = { 0 };
+
+	colic_detector_init(&cd, 15.0f);
+	replay(&cd, trace_baro_only, ARRAY_SIZE(trace_baro_only), 0, &res);
+
+	zassert_equal(res.max, COLIC_LEVEL_ALERT,
+		      "4 lie-downs in an hour must alert without IMU");
+	zassert_equal(colic_detector_roll_count(&cd), 0, "no roll without IMU");
+}
+
+ZTEST(horse_colic, test_sparse_lying_outside_window)
+{
+	colic_detector_t cd;
+	struct replay_result res = { 0 };
+
+	colic_detector_init(&cd, 15.0f);
+	replay(&cd, trace_sparse, ARRAY_SIZE(trace_sparse), 0, &res);
+
+	zassert_equal(res.max, COLIC_LEVEL_NONE, "lie-downs 90 min apart are normal");
+	zassert_equal(colic_detector_lie_count(&cd), 1, "only one in the last hour");
+}
+
+ZTEST(horse_colic, test_window_expires_after_alert)
+{
+	colic_detector_t cd;
+	struct replay_result res = { 0 };
+
+	colic_detector_init(&cd, 15.0f);
+	uint32_t t = replay(&cd, trace_colic, ARRAY_SIZE(trace_colic), 0, &res);
+	zassert_equal(res.final, COLIC_LEVEL_ALERT, "alert right after the episode");
+
+	memset(&res, 0, sizeof(res));
+	replay(&cd, trace_quiet_2h, ARRAY_SIZE(trace_quiet_2h), t, &res);
+	zassert_equal(res.final, COLIC_LEVEL_NONE, "level decays after an hour quiet");
+	zassert_equal(colic_detector_lie_count(&cd), 0, "window must be empty");
+}
+
+ZTEST(horse_colic, test_time_gap_clears_window)
+{
+	colic_detector_t cd;
+	struct replay_result res = { 0 };
+
+	colic_detector_init(&cd, 15.0f);
+	replay(&cd, trace_colic, ARRAY_SIZE(trace_colic), 0, &res);
+
+	/* 一个样本直接跳到 3 小时之后（例如 IMU / BME 都掉线了一段时间） */
+	colic_level_t lv = colic_detector_update(&cd, 3 * 3600, false, true, 0.0f, NULL);
+
+	zassert_equal(lv, COLIC_LEVEL_NONE, "gap longer than the window clears it");
+}
+
+ZTEST_SUITE(horse_colic, NULL, NULL, NULL, NULL, NULL);
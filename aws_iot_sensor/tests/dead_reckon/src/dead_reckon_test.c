@@ -0,0 +1,234 @@
+/* tests/dead_reckon/src/dead_reckon_test.c
+ *
+ * 航位推算：步频检测（正弦起伏、小幅抖动、停下超时），EKF 用 GNSS 速度学步长，
+ * 丢星 60 s 里直走 / 转弯 / 站着时推算的误差和不确定半径，以及长时间推算后
+ * GNSS 回来偏得太远时重置。
+ *
+ * 马按 10 Hz 逐样本模拟：鬐甲加速度模 = 重力 + 每个步态周期一个正弦起伏，
+ * IMU 航向 = 真航向 + 小噪声，GNSS 每秒一个 fix（位置加几米噪声）。
+ */
+#include <zephyr/ztest.h>
+#include <math.h>
+#include <string.h>
+#include "dr_ekf.h"
+#include "step_cadence.h"
+
+#define G               9.81f
+#define PI_F            3.14159265f
+#define LAT0            45.0
+#define LON0            7.0
+#define M_PER_DEG       111320.0
+
+#define WALK_HZ         0.9f        /* 步态周期 */
+#define WALK_MPS        1.5f
+#define WALK_AMP        1.5f        /* 鬐甲起伏 (m/s²) */
+#define GNSS_ACC_M      4.0f
+
+/* 确定的伪随机数，结果可重复 */
+static uint32_t rng = 1;
+
+static float noise(float amp)
+{
+	rng = rng * 1664525u + 1013904223u;
+	return amp * (((float)(rng >> 8) / (float)(1u << 24)) * 2.0f - 1.0f);
+}
+
+/* 模拟的马 + 传感器 */
+struct horse {
+	uint32_t ms;
+	float n, e;             /* 真实位置 (m) */
+	float psi_deg;          /* 真航向 */
+	float speed;            /* 0 = 站着 */
+	float phase;            /* 步态相位 */
+	struct dr_ekf f;
+	struct step_cadence sc;
+	float cadence;
+};
+
+static struct horse h;
+
+static void horse_init(void)
+{
+	memset(&h, 0, sizeof(h));
+	rng = 1;
+	dr_ekf_init(&h.f);
+	step_cadence_init(&h.sc);
+}
+
+static void to_latlon(float n, float e, double *lat, double *lon)
+{
+	*lat = LAT0 + n / M_PER_DEG;
+	*lon = LON0 + e / (M_PER_DEG * cos(LAT0 * M_PI / 180.0));
+}
+
+/* 推算位置离真实位置多远 (m) */
+static float dr_error_m(void)
+{
+	double lat, lon;
+
+	dr_ekf_position(&h.f, &lat, &lon);
+
+	float n = (float)((lat - LAT0) * M_PER_DEG);
+	float e = (float)((lon - LON0) * M_PER_DEG * cos(LAT0 * M_PI / 180.0));
+
+	return hypotf(n - h.n, e - h.e);
+}
+
+/* 走 secs 秒，gnss = false 模拟丢星 */
+static void run(uint32_t secs, bool gnss)
+{
+	for (uint32_t k = 0; k < secs * 10u; k++) {
+		float psi = h.psi_deg * PI_F / 180.0f;
+		float acc = G;
+
+		h.ms += 100u;
+		h.n += h.speed * cosf(psi) * 0.1f;
+		h.e += h.speed * sinf(psi) * 0.1f;
+		if (h.speed > 0.0f) {
+			h.phase += 2.0f * PI_F * WALK_HZ * 0.1f;
+			acc += WALK_AMP * sinf(h.phase);
+		}
+		acc += noise(0.1f);
+
+		h.cadence = step_cadence_feed(&h.sc, h.ms, acc);
+		dr_ekf_predict(&h.f, 0.1f);
+
+		float hd = fmodf(h.psi_deg + noise(3.0f) + 360.0f, 360.0f);
+
+		dr_ekf_update_heading(&h.f, hd, 8.0f);
+		dr_ekf_update_cadence(&h.f, h.cadence);
+
+		if (gnss && h.ms % 1000u == 0u) {
+			double lat, lon;
+
+			to_latlon(h.n + noise(GNSS_ACC_M), h.e + noise(GNSS_ACC_M), &lat, &lon);
+			dr_ekf_update_gnss(&h.f, lat, lon, GNSS_ACC_M,
+					   h.speed + noise(0.1f), h.psi_deg);
+		}
+	}
+}
+
+/* ====================== 步频 ====================== */
+
+ZTEST(dead_reckon, test_cadence_sine)
+{
+	horse_init();
+	h.speed = WALK_MPS;
+	run(20, false);
+
+	zassert_within(h.cadence, WALK_HZ, 0.05f, "cadence %f", (double)h.cadence);
+}
+
+ZTEST(dead_reckon, test_cadence_small_motion)
+{
+	/* 咀嚼、甩尾：幅度过不了门限 */
+	horse_init();
+	for (uint32_t k = 1; k <= 200; k++) {
+		float a = G + 0.3f * sinf(2.0f * PI_F * WALK_HZ * k * 0.1f);
+
+		zassert_equal(step_cadence_feed(&h.sc, k * 100u, a), 0.0f);
+	}
+}
+
+ZTEST(dead_reckon, test_cadence_stop)
+{
+	horse_init();
+	h.speed = WALK_MPS;
+	run(20, false);
+	zassert_true(h.cadence > 0.0f);
+
+	h.speed = 0.0f;
+	run(3, false);
+	zassert_equal(h.cadence, 0.0f, "cadence %f after stop", (double)h.cadence);
+}
+
+/* ====================== EKF ====================== */
+
+ZTEST(dead_reckon, test_stride_learned)
+{
+	horse_init();
+	h.psi_deg = 60.0f;
+	h.speed = WALK_MPS;
+	run(120, true);
+
+	float stride = h.f.x[DR_S];
+
+	zassert_within(stride, WALK_MPS / WALK_HZ, 0.15f, "stride %f", (double)stride);
+	zassert_true(dr_error_m() < GNSS_ACC_M, "err %f", (double)dr_error_m());
+	zassert_true(dr_ekf_radius_m(&h.f) < 3.0f * GNSS_ACC_M);
+}
+
+ZTEST(dead_reckon, test_outage_walking)
+{
+	horse_init();
+	h.psi_deg = 60.0f;
+	h.speed = WALK_MPS;
+	run(120, true);
+
+	float n0 = h.n, e0 = h.e;
+	float r0 = dr_ekf_radius_m(&h.f);
+
+	/* 进树林：直走 30 s，右转 90° 再走 30 s */
+	run(30, false);
+	h.psi_deg = 150.0f;
+	run(30, false);
+
+	float err = dr_error_m();
+	float frozen = hypotf(h.n - n0, h.e - e0);
+	float r = dr_ekf_radius_m(&h.f);
+
+	zassert_true(err < 0.25f * frozen, "dr err %f, frozen fix err %f",
+		     (double)err, (double)frozen);
+	zassert_true(r > r0, "radius did not grow: %f -> %f", (double)r0, (double)r);
+	zassert_true(r >= err, "radius %f < err %f", (double)r, (double)err);
+
+	/* GNSS 回来：半径马上收回去 */
+	run(5, true);
+	zassert_true(dr_ekf_radius_m(&h.f) < 3.0f * GNSS_ACC_M);
+	zassert_true(dr_error_m() < 2.0f * GNSS_ACC_M);
+}
+
+ZTEST(dead_reckon, test_outage_standing)
+{
+	horse_init();
+	h.speed = WALK_MPS;
+	run(60, true);
+	h.speed = 0.0f;
+	run(10, true);
+
+	/* 在棚里站 60 s：步频 0 把速度压住，推算不往外飘 */
+	run(60, false);
+
+	zassert_equal(h.cadence, 0.0f);
+	zassert_true(h.f.x[DR_V] < 0.2f, "v %f", (double)h.f.x[DR_V]);
+	zassert_true(dr_error_m() < GNSS_ACC_M, "err %f", (double)dr_error_m());
+}
+
+ZTEST(dead_reckon, test_reset_after_jump)
+{
+	horse_init();
+	h.speed = WALK_MPS;
+	run(30, true);
+
+	/* 推算和 GNSS 对不上（比如重启后 fix 在 1 km 外）：几个 fix 以后直接重置 */
+	h.n += 1000.0f;
+	run(2, true);
+	zassert_true(dr_error_m() > 500.0f, "single outlier must be gated");
+
+	run(2, true);
+	zassert_true(dr_error_m() < 2.0f * GNSS_ACC_M, "err %f", (double)dr_error_m());
+	zassert_equal(h.f.pos_rejects, 0);
+}
+
+ZTEST(dead_reckon, test_no_fix_no_output)
+{
+	/* 第一个 fix 之前预测和更新都不动 */
+	horse_init();
+	dr_ekf_predict(&h.f, 1.0f);
+	dr_ekf_update_cadence(&h.f, 1.0f);
+	dr_ekf_update_heading(&h.f, 90.0f, 8.0f);
+	zassert_false(h.f.init);
+	zassert_equal(h.f.x[DR_V], 0.0f);
+}
+
+ZTEST_SUITE(dead_reckon, NULL, NULL, NULL, NULL, NULL);
@@ -0,0 +1,598 @@
+/* tests/geofence/src/geofence_test.c
+ *
+ * 电子围栏引擎：单区域的进入 / 离开 / 停留，网格索引和全量扫描结果一致，
+ * 到边界的距离，以及区域数 vs 每个 fix 开销的基准（网格 vs 全量扫描）。
+ *
+ * 随机区域和随机轨迹都在 (40.0, -75.2) 附近 2 km 见方的范围里，
+ * 用固定种子的 LCG 生成，结果可复现。
+ *
+ * test_proj_kernel_speed 的比值（haversine double / 投影 float）要在 M33 上看：
+ * mps2/an521/cpu0 有单精度 FPU、double 走软件库，和 nRF9151 一样。这个比值还没在
+ * an521 上量过；x86-64 主机（gcc -O2，double 是硬件的，不代表目标）上约 x26。
+ */
+#include <zephyr/ztest.h>
+#include <math.h>
+#include <string.h>
+#include "geofence.h"
+
+#define LAT0            40.0
+#define LON0            (-75.2)
+#define M_LAT           111320.0
+#define M_LON           (111320.0 * 0.76604444)   /* cos(40 deg) */
+
+#define FARM_M          2000.0
+#define TRACK_FIXES     3000
+
+static struct geofence gf;
+
+/* ====================== 工具 ====================== */
+
+static uint32_t rng;
+
+static uint32_t rnd(void)
+{
+	rng = rng * 1664525u + 1013904223u;
+	return rng >> 8;
+}
+
+/* [lo, hi) 的均匀随机数 */
+static double rnd_range(double lo, double hi)
+{
+	return lo + (hi - lo) * (double)(rnd() & 0xFFFF) / 65536.0;
+}
+
+static double lat_at(double north_m)
+{
+	return LAT0 + north_m / M_LAT;
+}
+
+static double lon_at(double east_m)
+{
+	return LON0 + east_m / M_LON;
+}
+
+struct evt_log {
+	uint32_t enter, exit, dwell;
+	uint32_t last_exit_ms;
+	uint16_t last_id;
+	uint32_t hash;            /* 和顺序无关的事件指纹 */
+	uint32_t fix;
+};
+
+static void on_evt(const struct geofence_event *evt, void *user)
+{
+	struct evt_log *log = user;
+
+	switch (evt->type) {
+	case GEOFENCE_EVT_ENTER:
+		log->enter++;
+		break;
+	case GEOFENCE_EVT_EXIT:
+		log->exit++;
+		log->last_exit_ms = evt->inside_ms;
+		break;
+	default:
+		log->dwell++;
+		break;
+	}
+	log->last_id = evt->id;
+	log->hash += (evt->id * 2654435761u) ^ (evt->type * 40503u) ^ (log->fix * 97u);
+}
+
+/* 随机区域：大部分是 5~30 m 的圆（水槽、料槽），一部分 20~80 m 的矩形（棚），
+ * 每 50 个里有一个 400~600 m 的大围场
+ */
+static void add_random_zones(struct geofence *g, int n, uint32_t seed)
+{
+	rng = seed;
+	for (int i = 0; i < n; i++) {
+		double e = rnd_range(-FARM_M / 2, FARM_M / 2);
+		double nm = rnd_range(-FARM_M / 2, FARM_M / 2);
+		int err;
+
+		if (i % 50 == 49) {
+			double w = rnd_range(400.0, 600.0);
+
+			err = geofence_add_rect(g, i, GEOFENCE_KIND_PADDOCK,
+						lat_at(nm), lon_at(e),
+						lat_at(nm + w), lon_at(e + w), 0);
+		} else if (i % 4 == 3) {
+			double w = rnd_range(20.0, 80.0);
+			double h = rnd_range(20.0, 80.0);
+
+			err = geofence_add_rect(g, i, GEOFENCE_KIND_SHELTER,
+						lat_at(nm), lon_at(e),
+						lat_at(nm + h), lon_at(e + w), 60000);
+		} else {
+			err = geofence_add_circle(g, i, GEOFENCE_KIND_FEEDER,
+						  lat_at(nm), lon_at(e),
+						  (float)rnd_range(5.0, 30.0), 30000);
+		}
+		zassert_ok(err, "zone %d", i);
+	}
+}
+
+/* 随机游走：1 Hz，大部分时间慢走 / 吃草，偶尔小跑 */
+struct walker {
+	double e, n, hdg;
+};
+
+static void walk_step(struct walker *w)
+{
+	double v = ((rnd() & 31) == 0) ? 4.0 : rnd_range(0.0, 1.5);
+
+	w->hdg += rnd_range(-0.6, 0.6);
+	w->e = fmin(fmax(w->e + v * cos(w->hdg), -FARM_M / 2), FARM_M / 2);
+	w->n = fmin(fmax(w->n + v * sin(w->hdg), -FARM_M / 2), FARM_M / 2);
+}
+
+struct run_result {
+	struct evt_log log;
+	uint64_t tested;
+	uint64_t cycles;
+};
+
+static void run_track(struct geofence *g, uint32_t seed, struct run_result *res)
+{
+	struct walker w = { 0 };
+
+	memset(res, 0, sizeof(*res));
+	rng = seed;
+
+	for (uint32_t k = 0; k < TRACK_FIXES; k++) {
+		walk_step(&w);
+		res->log.fix = k;
+
+		uint32_t c0 = k_cycle_get_32();
+		int t = geofence_update(g, k * 1000u, lat_at(w.n), lon_at(w.e), on_evt, &res->log);
+
+		res->cycles += k_cycle_get_32() - c0;
+		res->tested += t;
+	}
+}
+
+/* ====================== 单区域 ====================== */
+
+ZTEST(geofence, test_circle_enter_dwell_exit)
+{
+	struct evt_log log = { 0 };
+
+	geofence_init(&gf);
+	zassert_ok(geofence_add_circle(&gf, 7, GEOFENCE_KIND_TROUGH,
+				       LAT0, LON0, 10.0f, 3000));
+
+	/* 从 30 m 外往圆心走，每秒 2 m，过了圆心再往外走 */
+	uint32_t t = 0;
+
+	for (double e = -30.0; e <= 30.0; e += 2.0, t += 1000) {
+		log.fix = t / 1000;
+		(void)geofence_update(&gf, t, LAT0, lon_at(e), on_evt, &log);
+		if (fabs(e) <= 9.5) {
+			zassert_true(geofence_is_inside(&gf, 7), "e = %.1f", e);
+		}
+	}
+
+	zassert_equal(log.enter, 1);
+	zassert_equal(log.dwell, 1);
+	zassert_equal(log.exit, 1);
+	zassert_equal(log.last_id, 7);
+	/* -10 m 进，+12 m（加 2 m 迟滞）出：11 个 fix */
+	zassert_within(log.last_exit_ms, 11000, 1000, "inside %u ms", log.last_exit_ms);
+	zassert_false(geofence_is_inside(&gf, 7));
+}
+
+ZTEST(geofence, test_hysteresis_no_chatter)
+{
+	struct evt_log log = { 0 };
+
+	geofence_init(&gf);
+	zassert_ok(geofence_add_circle(&gf, 1, GEOFENCE_KIND_TROUGH,
+				       LAT0, LON0, 10.0f, 0));
+
+	/* 在边界附近 ±1 m 抖动：只进一次，不出 */
+	for (int k = 0; k < 60; k++) {
+		double e = 9.5 + ((k & 1) ? 1.0 : -1.0);
+
+		(void)geofence_update(&gf, k * 1000u, LAT0, lon_at(e), on_evt, &log);
+	}
+	zassert_equal(log.enter, 1);
+	zassert_equal(log.exit, 0);
+	zassert_equal(log.dwell, 0, "dwell_ms = 0 never reports dwell");
+}
+
+ZTEST(geofence, test_rect_and_remove)
+{
+	struct evt_log log = { 0 };
+
+	geofence_init(&gf);
+	zassert_ok(geofence_add_rect(&gf, 3, GEOFENCE_KIND_SHELTER,
+				     lat_at(0), lon_at(0), lat_at(20), lon_at(40), 0));
+	zassert_equal(geofence_add_rect(&gf, 4, GEOFENCE_KIND_SHELTER,
+					lat_at(20), lon_at(0), lat_at(0), lon_at(40), 0),
+		      -EINVAL);
+	zassert_equal(geofence_add_circle(&gf, 5, GEOFENCE_KIND_OTHER,
+					  LAT0, LON0, 0.0f, 0), -EINVAL);
+
+	(void)geofence_update(&gf, 0, lat_at(10), lon_at(30), on_evt, &log);
+	zassert_true(geofence_is_inside(&gf, 3));
+	(void)geofence_update(&gf, 1000, lat_at(10), lon_at(41), on_evt, &log);
+	zassert_true(geofence_is_inside(&gf, 3), "inside hysteresis band");
+	(void)geofence_update(&gf, 2000, lat_at(10), lon_at(45), on_evt, &log);
+	zassert_false(geofence_is_inside(&gf, 3));
+	zassert_equal(log.enter, 1);
+	zassert_equal(log.exit, 1);
+
+	zassert_ok(geofence_remove(&gf, 3));
+	zassert_equal(geofence_remove(&gf, 3), -ENOENT);
+	zassert_equal(geofence_update(&gf, 3000, lat_at(10), lon_at(30), on_evt, &log), 0);
+	zassert_equal(log.enter, 1);
+}
+
+ZTEST(geofence, test_capacity)
+{
+	geofence_init(&gf);
+	for (int i = 0; i < GEOFENCE_MAX_ZONES; i++) {
+		zassert_ok(geofence_add_circle(&gf, i, GEOFENCE_KIND_OTHER,
+					       lat_at(i), LON0, 5.0f, 0));
+	}
+	zassert_equal(geofence_add_circle(&gf, GEOFENCE_MAX_ZONES, GEOFENCE_KIND_OTHER,
+					  LAT0, LON0, 5.0f, 0), -ENOMEM);
+	/* 已有的 id 是替换，不占新位置 */
+	zassert_ok(geofence_add_circle(&gf, 0, GEOFENCE_KIND_TROUGH, LAT0, LON0, 8.0f, 0));
+	zassert_equal(gf.n_zones, GEOFENCE_MAX_ZONES);
+}
+
+/* ====================== 多边形 ====================== */
+
+/* L 形围场（凹多边形），局部坐标（m）：先往东 100，再往北 40，折回…… */
+static const double l_shape_m[][2] = {
+	{ 0, 0 }, { 100, 0 }, { 100, 40 }, { 40, 40 }, { 40, 100 }, { 0, 100 },
+};
+
+static size_t make_poly(struct geofence_vertex *v, const double (*m)[2], size_t n)
+{
+	for (size_t k = 0; k < n; k++) {
+		v[k].lat = lat_at(m[k][1]);
+		v[k].lon = lon_at(m[k][0]);
+	}
+	return n;
+}
+
+/* 近似圆的 n 边形，半径在 r1 / r2 之间交替（星形，凹） */
+static size_t make_star(struct geofence_vertex *v, size_t n, double r1, double r2)
+{
+	for (size_t k = 0; k < n; k++) {
+		double a = 6.2831853 * k / n;
+		double r = (k & 1) ? r2 : r1;
+
+		v[k].lat = lat_at(r * sin(a));
+		v[k].lon = lon_at(r * cos(a));
+	}
+	return n;
+}
+
+ZTEST(geofence, test_polygon_concave)
+{
+	struct geofence_vertex v[8];
+	struct evt_log log = { 0 };
+
+	geofence_init(&gf);
+	zassert_ok(geofence_add_polygon(&gf, 9, GEOFENCE_KIND_PADDOCK, v,
+					make_poly(v, l_shape_m, ARRAY_SIZE(l_shape_m)), 0));
+
+	/* 两条腿里面，凹口里面不算 */
+	(void)geofence_update(&gf, 0, lat_at(20), lon_at(80), on_evt, &log);
+	zassert_true(geofence_is_inside(&gf, 9));
+	(void)geofence_update(&gf, 1000, lat_at(80), lon_at(20), on_evt, &log);
+	zassert_true(geofence_is_inside(&gf, 9));
+	zassert_equal(log.enter, 1);
+
+	/* 走进凹口 1 m：还在迟滞带里；走到 10 m：逃出，这一个 fix 就报离开 */
+	(void)geofence_update(&gf, 2000, lat_at(80), lon_at(41), on_evt, &log);
+	zassert_true(geofence_is_inside(&gf, 9));
+	(void)geofence_update(&gf, 3000, lat_at(80), lon_at(50), on_evt, &log);
+	zassert_false(geofence_is_inside(&gf, 9));
+	zassert_equal(log.exit, 1);
+	zassert_equal(log.last_id, 9);
+
+	/* 不在里面时没有迟滞：凹口边上 1 m 不算进入 */
+	(void)geofence_update(&gf, 4000, lat_at(80), lon_at(41), on_evt, &log);
+	zassert_false(geofence_is_inside(&gf, 9));
+	zassert_equal(log.enter, 1);
+
+	/* 参数检查 */
+	zassert_equal(geofence_add_polygon(&gf, 10, GEOFENCE_KIND_PADDOCK, v, 2, 0), -EINVAL);
+	zassert_equal(geofence_add_polygon(&gf, 10, GEOFENCE_KIND_PADDOCK, v,
+					   make_star(v, 8, 1500, 1500), 0), -EINVAL,
+		      "3 km wide polygon is beyond the projection range");
+}
+
+ZTEST(geofence, test_polygon_slabs_match_edges)
+{
+	static struct geofence_vertex v[GEOFENCE_MAX_POLY_VERTS];
+	size_t n = make_star(v, GEOFENCE_MAX_POLY_VERTS, 300, 220);
+
+	/* 同一个实例逐点比较：条带查找 vs 临时关掉条带、逐边数交点 */
+	geofence_init(&gf);
+	zassert_ok(geofence_add_polygon(&gf, 1, GEOFENCE_KIND_PADDOCK, v, n, 0));
+	(void)geofence_update(&gf, 0, LAT0, LON0, NULL, NULL);
+	zassert_true(gf.zones[0].n_slabs > 0, "64-vertex polygon should use slabs");
+
+	rng = 2024;
+	int in = 0;
+
+	for (int k = 0; k < 5000; k++) {
+		double e = rnd_range(-320, 320), nm = rnd_range(-320, 320);
+		struct geofence_zone *z = &gf.zones[0];
+		uint16_t slabs = z->n_slabs;
+
+		z->inside = false;
+		(void)geofence_update(&gf, k * 1000u, lat_at(nm), lon_at(e), NULL, NULL);
+		bool a = z->inside;
+
+		z->inside = false;
+		z->n_slabs = 0;
+		(void)geofence_update(&gf, k * 1000u, lat_at(nm), lon_at(e), NULL, NULL);
+		bool b = z->inside;
+
+		z->n_slabs = slabs;
+		zassert_equal(a, b, "(%.1f, %.1f)", e, nm);
+		in += a;
+
+		/* 星形的内切圆 / 外接圆之外的点可以直接判断 */
+		double r = sqrt(e * e + nm * nm);
+
+		if (r < 200) {
+			zassert_true(a, "(%.1f, %.1f) r %.1f", e, nm, r);
+		} else if (r > 301) {
+			zassert_false(a, "(%.1f, %.1f) r %.1f", e, nm, r);
+		}
+	}
+	zassert_true(in > 1000);
+}
+
+ZTEST(geofence, test_polygon_replace_remove)
+{
+	struct geofence_vertex v[GEOFENCE_MAX_POLY_VERTS];
+
+	geofence_init(&gf);
+	zassert_ok(geofence_add_polygon(&gf, 1, GEOFENCE_KIND_PADDOCK, v,
+					make_star(v, 40, 100, 80), 0));
+	zassert_ok(geofence_add_polygon(&gf, 2, GEOFENCE_KIND_PADDOCK, v,
+					make_poly(v, l_shape_m, ARRAY_SIZE(l_shape_m)), 0));
+	zassert_equal(gf.n_edges, 46);
+
+	/* 替换 1 号：旧的边释放，2 号的边往前挪，结果不变 */
+	zassert_ok(geofence_add_polygon(&gf, 1, GEOFENCE_KIND_PADDOCK, v,
+					make_star(v, 10, 50, 40), 0));
+	zassert_equal(gf.n_edges, 16);
+	(void)geofence_update(&gf, 0, lat_at(80), lon_at(20), NULL, NULL);
+	zassert_true(geofence_is_inside(&gf, 2));
+	zassert_false(geofence_is_inside(&gf, 1));
+
+	zassert_ok(geofence_remove(&gf, 1));
+	zassert_equal(gf.n_edges, 6);
+	(void)geofence_update(&gf, 1000, lat_at(20), lon_at(80), NULL, NULL);
+	zassert_true(geofence_is_inside(&gf, 2));
+
+	/* 边表满了 */
+	int err = 0;
+
+	for (int id = 10; err == 0; id++) {
+		err = geofence_add_polygon(&gf, id, GEOFENCE_KIND_PADDOCK, v,
+					   make_star(v, GEOFENCE_MAX_POLY_VERTS, 100, 80), 0);
+	}
+	zassert_equal(err, -ENOMEM);
+	zassert_true(gf.n_edges <= GEOFENCE_MAX_EDGES);
+}
+
+/* ====================== 距离内核 ====================== */
+
+ZTEST(geofence, test_proj_kernel_accuracy)
+{
+	static const double lats[] = { 0.0, 40.0, 60.0 };
+
+	rng = 31337;
+	for (size_t i = 0; i < ARRAY_SIZE(lats); i++) {
+		float mlon = geofence_m_per_deg_lon(lats[i]);
+		double worst_500 = 0.0, worst_2k = 0.0;
+
+		for (int k = 0; k < 2000; k++) {
+			double d = rnd_range(1.0, GEOFENCE_PROJ_RANGE_M);
+			double a = rnd_range(0.0, 6.2831853);
+			double lat = lats[i] + d * sin(a) / M_LAT;
+			double lon = LON0 + d * cos(a) / (M_LAT * cos(lats[i] * 0.017453293));
+			double ref = geofence_haversine_m(lats[i], LON0, lat, lon);
+			double err = fabs(sqrt(geofence_proj_dist2(lat, lon, lats[i], LON0, mlon)) - ref);
+
+			if (ref <= 500.0) {
+				worst_500 = fmax(worst_500, err);
+			}
+			worst_2k = fmax(worst_2k, err);
+		}
+
+		TC_PRINT("lat %2.0f: worst error %.3f m (<= 500 m), %.3f m (<= 2 km)\n",
+			 lats[i], worst_500, worst_2k);
+		zassert_true(worst_500 < 0.05, "lat %.0f: %.3f m", lats[i], worst_500);
+		zassert_true(worst_2k < 0.5, "lat %.0f: %.3f m", lats[i], worst_2k);
+	}
+}
+
+ZTEST(geofence, test_proj_kernel_speed)
+{
+	enum { CALLS = 2000 };
+	static double lat[CALLS], lon[CALLS];
+	volatile float sink_f = 0.0f;
+	volatile double sink_d = 0.0;
+	float mlon = geofence_m_per_deg_lon(LAT0);
+	float r2 = 15.0f * 15.0f;
+	int in_f = 0, in_d = 0;
+
+	rng = 555;
+	for (int k = 0; k < CALLS; k++) {
+		lat[k] = lat_at(rnd_range(-40.0, 40.0));
+		lon[k] = lon_at(rnd_range(-40.0, 40.0));
+	}
+
+	uint32_t c0 = k_cycle_get_32();
+
+	for (int k = 0; k < CALLS; k++) {
+		float d2 = geofence_proj_dist2(lat[k], lon[k], LAT0, LON0, mlon);
+
+		in_f += (d2 <= r2);
+		sink_f = d2;
+	}
+
+	uint32_t c1 = k_cycle_get_32();
+
+	for (int k = 0; k < CALLS; k++) {
+		double d = geofence_haversine_m(lat[k], lon[k], LAT0, LON0);
+
+		in_d += (d <= 15.0);
+		sink_d = d;
+	}
+
+	uint32_t c2 = k_cycle_get_32();
+
+	(void)sink_f;
+	(void)sink_d;
+
+	/* qemu 的周期数只是指令数的近似，这里只看同一台机器上的比值 */
+	TC_PRINT("circle test: projected %u cycles/call, haversine %u cycles/call (x%.1f)\n",
+		 (c1 - c0) / CALLS, (c2 - c1) / CALLS,
+		 (double)(c2 - c1) / (double)MAX(c1 - c0, 1u));
+	zassert_true(in_f > 0 && abs(in_f - in_d) <= 2, "proj %d vs haversine %d", in_f, in_d);
+}
+
+/* ====================== 网格 vs 全量扫描 ====================== */
+
+ZTEST(geofence, test_grid_matches_linear)
+{
+	struct run_result grid, lin;
+
+	geofence_init(&gf);
+	add_random_zones(&gf, 300, 12345);
+	run_track(&gf, 777, &grid);
+
+	geofence_init(&gf);
+	gf.no_index = true;
+	add_random_zones(&gf, 300, 12345);
+	run_track(&gf, 777, &lin);
+
+	TC_PRINT("events: enter %u exit %u dwell %u\n",
+		 grid.log.enter, grid.log.exit, grid.log.dwell);
+
+	zassert_true(grid.log.enter > 5, "track should visit zones");
+	zassert_equal(grid.log.enter, lin.log.enter);
+	zassert_equal(grid.log.exit, lin.log.exit);
+	zassert_equal(grid.log.dwell, lin.log.dwell);
+	zassert_equal(grid.log.hash, lin.log.hash, "same events on the same fixes");
+}
+
+/* ====================== 到边界的距离 ====================== */
+
+ZTEST(geofence, test_boundary_dist)
+{
+	struct geofence_vertex v[8];
+	float d;
+
+	geofence_init(&gf);
+	zassert_within(geofence_boundary_dist(&gf, LAT0, LON0, 25.0f), 25.0f, 1e-6f,
+		       "no zones: max_m");
+
+	zassert_ok(geofence_add_circle(&gf, 1, GEOFENCE_KIND_TROUGH, LAT0, LON0, 10.0f, 0));
+	zassert_ok(geofence_add_rect(&gf, 2, GEOFENCE_KIND_SHELTER,
+				     lat_at(200), lon_at(0), lat_at(240), lon_at(60), 0));
+	zassert_ok(geofence_add_polygon(&gf, 3, GEOFENCE_KIND_PADDOCK, v,
+					make_poly(v, l_shape_m, ARRAY_SIZE(l_shape_m)), 0));
+
+	/* 圆：里外都是 |d - r|（测试里的比例尺和引擎差 0.1%，留 0.2 m） */
+	d = geofence_boundary_dist(&gf, lat_at(-4), lon_at(-3), 25.0f);
+	zassert_within(d, 5.0f, 0.2f, "inside circle: %f", (double)d);
+	d = geofence_boundary_dist(&gf, lat_at(-22), lon_at(0), 25.0f);
+	zassert_within(d, 12.0f, 0.2f, "outside circle: %f", (double)d);
+
+	/* 矩形：里面取最近的一条边，外面到角点 */
+	d = geofence_boundary_dist(&gf, lat_at(215), lon_at(30), 25.0f);
+	zassert_within(d, 15.0f, 0.2f, "inside rect: %f", (double)d);
+	d = geofence_boundary_dist(&gf, lat_at(196), lon_at(63), 25.0f);
+	zassert_within(d, 5.0f, 0.2f, "outside rect corner: %f", (double)d);
+
+	/* 多边形：凹口里离两条腿都近（圆在西南角外面，离得更远） */
+	d = geofence_boundary_dist(&gf, lat_at(70), lon_at(47), 25.0f);
+	zassert_within(d, 7.0f, 0.2f, "in the notch: %f", (double)d);
+
+	/* 离所有区域都远 */
+	d = geofence_boundary_dist(&gf, lat_at(500), lon_at(500), 25.0f);
+	zassert_within(d, 25.0f, 1e-6f, "far away: %f", (double)d);
+}
+
+ZTEST(geofence, test_boundary_dist_grid_matches_linear)
+{
+	struct walker w = { 0 };
+	int near = 0;
+
+	geofence_init(&gf);
+	add_random_zones(&gf, 300, 2468);
+
+	rng = 1357;
+	for (int k = 0; k < TRACK_FIXES; k++) {
+		walk_step(&w);
+
+		/* 进出状态决定哪些区域在“当前在里面”的列表里，先正常 update */
+		(void)geofence_update(&gf, k * 1000u, lat_at(w.n), lon_at(w.e), NULL, NULL);
+
+		/* 索引建好以后 no_index 只影响查询方式，同一个 gf 两种都查 */
+		float a = geofence_boundary_dist(&gf, lat_at(w.n), lon_at(w.e), 30.0f);
+
+		gf.no_index = true;
+		float b = geofence_boundary_dist(&gf, lat_at(w.n), lon_at(w.e), 30.0f);
+		gf.no_index = false;
+
+		zassert_equal(a, b, "fix %d: grid %f vs linear %f", k, (double)a, (double)b);
+		near += (a < 30.0f);
+	}
+
+	TC_PRINT("fixes within 30 m of a boundary: %d of %d\n", near, TRACK_FIXES);
+	zassert_true(near > TRACK_FIXES / 10, "track should pass zones");
+}
+
+/* ====================== 基准 ====================== */
+
+ZTEST(geofence, test_benchmark)
+{
+	static const int sizes[] = { 10, 50, 100, 200, 400 };
+
+	TC_PRINT("zones | grid: tested/fix  cycles/fix | linear: tested/fix  cycles/fix\n");
+
+	for (size_t i = 0; i < ARRAY_SIZE(sizes); i++) {
+		struct run_result grid, lin;
+		int n = sizes[i];
+
+		geofence_init(&gf);
+		add_random_zones(&gf, n, 4242);
+		run_track(&gf, 99, &grid);
+
+		geofence_init(&gf);
+		gf.no_index = true;
+		add_random_zones(&gf, n, 4242);
+		run_track(&gf, 99, &lin);
+
+		TC_PRINT("%5d | %15.2f %11u | %17.2f %11u\n", n,
+			 (double)grid.tested / TRACK_FIXES,
+			 (uint32_t)(grid.cycles / TRACK_FIXES),
+			 (double)lin.tested / TRACK_FIXES,
+			 (uint32_t)(lin.cycles / TRACK_FIXES));
+
+		zassert_equal(grid.log.hash, lin.log.hash, "n = %d", n);
+		zassert_equal(lin.tested, (uint64_t)n * TRACK_FIXES);
+		if (n >= 100) {
+			/* 网格只测附近格子 + 大围场 + 当前在里面的 */
+			zassert_true(grid.tested * 10 < lin.tested,
+				     "n = %d: grid %llu vs linear %llu", n,
+				     grid.tested, lin.tested);
+		}
+	}
+}
+
+ZTEST_SUITE(geofence, NULL, NULL, NULL, NULL, NULL);
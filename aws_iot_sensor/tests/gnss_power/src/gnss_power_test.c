@@ -0,0 +1,242 @@
+/* tests/gnss_power/src/gnss_power_test.c
+ *
+ * GNSS 省电策略：静止逐级降到周期 / 单次定位，IMU 动作和走向围栏边界时立刻
+ * 回到 1 Hz，IMU 数据不新鲜时不进单次定位，强制连续，以及每小时统计。
+ *
+ * 用一个按秒走的小模拟器代替 modem：连续定位每秒一个 PVT，周期定位每 60 s
+ * 醒来搜 3 s 出一个 fix，单次定位每 600 s 一次。
+ */
+#include <zephyr/ztest.h>
+#include <string.h>
+#include "gnss_power.h"
+
+#define PERIODIC_S      60
+#define SINGLE_S        600
+#define SEARCH_S        3
+#define FAR_M           1000.0f
+
+static const struct gnss_power_cfg cfg = {
+	.periodic_after_s = GNSS_POWER_PERIODIC_AFTER_S,
+	.single_after_s = GNSS_POWER_SINGLE_AFTER_S,
+	.imu_stale_s = GNSS_POWER_IMU_STALE_S,
+	.move_dps = GNSS_POWER_MOVE_DPS,
+	.move_mps = GNSS_POWER_MOVE_MPS,
+	.approach_m = GNSS_POWER_APPROACH_M,
+	.approach_step_m = GNSS_POWER_APPROACH_STEP_M,
+};
+
+static struct gnss_power p;
+
+/* 模拟器状态：当前工作方式下一次 PVT 在第几秒，第几秒开始的这一轮搜星 */
+struct sim {
+	uint32_t t;                /* s */
+	enum gnss_power_mode mode;
+	uint32_t wake_t;
+	uint32_t switches;
+};
+
+/* 一秒：IMU 活动量（< 0 表示 IMU 没数据）、速度、离边界距离 */
+static void sim_step(struct sim *s, float dps, float speed, float fence_m)
+{
+	uint32_t now = s->t * 1000u;
+
+	if (dps >= 0.0f) {
+		gnss_power_on_imu(&p, now, dps);
+	}
+
+	/* 连续定位每秒一个有效 fix；周期 / 单次醒来先搜 SEARCH_S 秒 */
+	if (s->mode == GNSS_POWER_CONTINUOUS) {
+		gnss_power_on_pvt(&p, now, true, speed, fence_m);
+	} else {
+		uint32_t period = (s->mode == GNSS_POWER_PERIODIC) ? PERIODIC_S : SINGLE_S;
+		uint32_t k = (s->t - s->wake_t) % period;
+
+		if (k < SEARCH_S) {
+			gnss_power_on_pvt(&p, now, k == SEARCH_S - 1, speed, fence_m);
+		}
+	}
+
+	enum gnss_power_mode m = gnss_power_poll(&p, now);
+
+	if (m != s->mode) {
+		s->mode = m;
+		s->wake_t = s->t + 1;
+		s->switches++;
+	}
+	s->t++;
+}
+
+static void sim_run(struct sim *s, uint32_t secs, float dps, float speed, float fence_m)
+{
+	for (uint32_t k = 0; k < secs; k++) {
+		sim_step(s, dps, speed, fence_m);
+	}
+}
+
+static void sim_init(struct sim *s)
+{
+	memset(s, 0, sizeof(*s));
+	gnss_power_init(&p, &cfg, 0);
+}
+
+/* ====================== 工作方式切换 ====================== */
+
+ZTEST(gnss_power, test_rest_steps_down)
+{
+	struct sim s;
+
+	sim_init(&s);
+	zassert_equal(gnss_power_poll(&p, 0), GNSS_POWER_CONTINUOUS);
+
+	/* 站着（IMU 安静，GNSS 速度噪声） */
+	sim_run(&s, GNSS_POWER_PERIODIC_AFTER_S - 1, 2.0f, 0.2f, FAR_M);
+	zassert_equal(s.mode, GNSS_POWER_CONTINUOUS);
+	sim_run(&s, 2, 2.0f, 0.2f, FAR_M);
+	zassert_equal(s.mode, GNSS_POWER_PERIODIC);
+
+	sim_run(&s, GNSS_POWER_SINGLE_AFTER_S - GNSS_POWER_PERIODIC_AFTER_S, 2.0f, 0.2f, FAR_M);
+	zassert_equal(s.mode, GNSS_POWER_SINGLE);
+	zassert_equal(s.switches, 2);
+}
+
+ZTEST(gnss_power, test_imu_motion_snaps_back)
+{
+	struct sim s;
+
+	sim_init(&s);
+	sim_run(&s, 1200, 2.0f, 0.1f, FAR_M);
+	zassert_equal(s.mode, GNSS_POWER_SINGLE);
+
+	/* 单次定位之间只有 IMU：一秒的动作就回到 1 Hz */
+	sim_step(&s, 40.0f, 0.1f, FAR_M);
+	zassert_equal(s.mode, GNSS_POWER_CONTINUOUS);
+
+	/* 又站住：重新计时 */
+	sim_run(&s, GNSS_POWER_PERIODIC_AFTER_S + 1, 2.0f, 0.1f, FAR_M);
+	zassert_equal(s.mode, GNSS_POWER_PERIODIC);
+}
+
+ZTEST(gnss_power, test_gnss_speed_snaps_back)
+{
+	struct sim s;
+
+	/* IMU 没数据（流水线级关了）：只能靠 GNSS 速度，最多降到周期定位 */
+	sim_init(&s);
+	sim_run(&s, 1800, -1.0f, 0.2f, FAR_M);
+	zassert_equal(s.mode, GNSS_POWER_PERIODIC, "no single-shot without IMU");
+
+	/* 走起来：下一个周期 fix 的速度把它拉回 1 Hz */
+	uint32_t t0 = s.t;
+
+	while (s.mode != GNSS_POWER_CONTINUOUS && s.t - t0 < 2 * PERIODIC_S) {
+		sim_step(&s, -1.0f, 1.5f, FAR_M);
+	}
+	zassert_equal(s.mode, GNSS_POWER_CONTINUOUS);
+	zassert_true(s.t - t0 <= PERIODIC_S + SEARCH_S, "took %u s", s.t - t0);
+}
+
+ZTEST(gnss_power, test_imu_goes_stale)
+{
+	struct sim s;
+
+	sim_init(&s);
+	sim_run(&s, 1000, 2.0f, 0.1f, FAR_M);
+	zassert_equal(s.mode, GNSS_POWER_SINGLE);
+
+	/* IMU 掉线：看不到动作了，退回周期定位 */
+	sim_run(&s, GNSS_POWER_IMU_STALE_S, -1.0f, 0.1f, FAR_M);
+	zassert_equal(s.mode, GNSS_POWER_SINGLE);
+	sim_run(&s, 2, -1.0f, 0.1f, FAR_M);
+	zassert_equal(s.mode, GNSS_POWER_PERIODIC);
+}
+
+ZTEST(gnss_power, test_fence_approach)
+{
+	struct sim s;
+
+	/* 站在棚里、离边界 10 m：不算靠近，照样省电 */
+	sim_init(&s);
+	sim_run(&s, 300, 2.0f, 0.1f, 10.0f);
+	zassert_equal(s.mode, GNSS_POWER_PERIODIC);
+
+	/* 慢慢挪向边界（速度、IMU 都在阈值下）：下一个 fix 近了 5 m 就回到 1 Hz */
+	uint32_t t0 = s.t;
+
+	while (s.mode != GNSS_POWER_CONTINUOUS && s.t - t0 < 2 * PERIODIC_S) {
+		sim_step(&s, 2.0f, 0.1f, 5.0f);
+	}
+	zassert_equal(s.mode, GNSS_POWER_CONTINUOUS);
+
+	/* 边界附近抖动（< approach_step_m）不算 */
+	sim_init(&s);
+	for (int k = 0; k < 300; k++) {
+		sim_step(&s, 2.0f, 0.1f, (k & 1) ? 8.0f : 10.0f);
+	}
+	zassert_equal(s.mode, GNSS_POWER_PERIODIC);
+}
+
+ZTEST(gnss_power, test_hold)
+{
+	struct sim s;
+
+	sim_init(&s);
+	gnss_power_set_hold(&p, true, 0);
+	sim_run(&s, 1200, 2.0f, 0.1f, FAR_M);
+	zassert_equal(s.mode, GNSS_POWER_CONTINUOUS, "held while searching / waiting for trough");
+
+	/* 放开以后从现在开始计不动时间 */
+	gnss_power_set_hold(&p, false, s.t * 1000u);
+	sim_run(&s, GNSS_POWER_PERIODIC_AFTER_S - 1, 2.0f, 0.1f, FAR_M);
+	zassert_equal(s.mode, GNSS_POWER_CONTINUOUS);
+	sim_run(&s, 2, 2.0f, 0.1f, FAR_M);
+	zassert_equal(s.mode, GNSS_POWER_PERIODIC);
+}
+
+/* ====================== 每小时统计 ====================== */
+
+ZTEST(gnss_power, test_hourly_stats)
+{
+	struct sim s;
+	struct gnss_power_hour h;
+
+	/* 第一个小时一直在走：3600 个 fix，开机 3600 s */
+	sim_init(&s);
+	sim_run(&s, 3600, 40.0f, 1.5f, FAR_M);
+	zassert_false(gnss_power_take_hour(&p, &h));
+	sim_step(&s, 40.0f, 1.5f, FAR_M);
+	zassert_true(gnss_power_take_hour(&p, &h));
+	zassert_false(gnss_power_take_hour(&p, &h), "only once");
+	zassert_equal(h.fixes, 3600);
+	zassert_equal(h.on_s, 3600);
+	zassert_equal(h.switches, 0);
+	zassert_within(h.mode_s[GNSS_POWER_CONTINUOUS], 3600, 1, "poll granularity");
+
+	/* 第二个小时在棚里站着：2 分钟 1 Hz，13 分钟周期定位，其余单次定位 */
+	sim_run(&s, 3600, 2.0f, 0.1f, FAR_M);
+	zassert_true(gnss_power_take_hour(&p, &h));
+
+	TC_PRINT("resting hour: %u fixes, on %u s, %u switches, cont/per/single %u/%u/%u s\n",
+		 h.fixes, h.on_s, h.switches, h.mode_s[GNSS_POWER_CONTINUOUS],
+		 h.mode_s[GNSS_POWER_PERIODIC], h.mode_s[GNSS_POWER_SINGLE]);
+
+	zassert_equal(h.switches, 2);
+	zassert_within(h.mode_s[GNSS_POWER_CONTINUOUS] + h.mode_s[GNSS_POWER_PERIODIC] +
+		       h.mode_s[GNSS_POWER_SINGLE], 3600, 1);
+	zassert_true(h.fixes < 150, "fixes %u", h.fixes);
+	zassert_true(h.on_s < 3600 / 10, "on-time %u s", h.on_s);
+	zassert_true(h.pvts >= h.fixes);
+}
+
+ZTEST(gnss_power, test_uptime_wrap)
+{
+	/* uptime 毫秒计数回绕前后照常判断 */
+	uint32_t t0 = UINT32_MAX - 30000u;
+
+	gnss_power_init(&p, &cfg, t0);
+	gnss_power_on_imu(&p, t0, 2.0f);
+	zassert_equal(gnss_power_poll(&p, t0 + 60000u), GNSS_POWER_CONTINUOUS);
+	gnss_power_on_imu(&p, t0 + 100000u, 2.0f);
+	zassert_equal(gnss_power_poll(&p, t0 + 121000u), GNSS_POWER_PERIODIC);
+}
+
+ZTEST_SUITE(gnss_power, NULL, NULL, NULL, NULL, NULL);
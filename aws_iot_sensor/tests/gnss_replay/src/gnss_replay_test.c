@@ -0,0 +1,489 @@
+/* tests/gnss_replay/src/gnss_replay_test.c
+ *
+ * GNSS 任务回归测试：真的 gnss_task.c 跑在 native_sim 上，modem 换成回放轨迹的
+ * 替身（src/gnss/sim）。按轨迹走一遍状态机 SEARCHING -> WAIT_TROUGH_MARK ->
+ * NORMAL -> SIGNAL_LOST -> NORMAL，喝水计时，NMEA 回放，静止降到周期定位，
+ * PVT 环形缓冲溢出，以及一小时轨迹加速回放的吞吐。
+ *
+ * GNSS 任务的状态是全局的，用例按名字顺序跑，一个接着一个。
+ * 轨迹在测试里按秒生成；1 倍速回放，固件按 uptime 算的时长和轨迹一致。
+ */
+#include <zephyr/ztest.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "gnss_task.h"
+#include "gnss_sim.h"
+#include "sensor.h"
+#include "paddock.h"
+#include "track_log.h"
+#include "timebase.h"
+
+/* 水槽位置 */
+#define TROUGH_LAT      39.9500000
+#define TROUGH_LON      (-75.1900000)
+
+#define M_PER_DEG_LAT   111320.0
+
+static const struct gpio_dt_spec button1 = GPIO_DT_SPEC_GET(DT_ALIAS(sw0), gpios);
+
+/* ====================== GNSS 任务依赖的假实现 ====================== */
+
+void sensor_get_activity(struct imu_activity *out)
+{
+	/* IMU 没数据：省电策略最多降到周期定位 */
+	memset(out, 0, sizeof(*out));
+}
+
+static atomic_t track_points;
+
+void track_log_feed(tb_ts_t ts, double lat, double lon)
+{
+	ARG_UNUSED(ts);
+	ARG_UNUSED(lat);
+	ARG_UNUSED(lon);
+	atomic_inc(&track_points);
+}
+
+void paddock_on_event(const struct geofence_event *evt, double lat, double lon, tb_ts_t ts)
+{
+	ARG_UNUSED(evt);
+	ARG_UNUSED(lat);
+	ARG_UNUSED(lon);
+	ARG_UNUSED(ts);
+}
+
+bool colic_monitor_boost_active(void)
+{
+	return false;
+}
+
+/* 喝水记录：不落 flash，只按秒累计 */
+static atomic_t water_s;
+
+int water_log_append(uint32_t start_utc, uint32_t dur_ms, uint16_t zone)
+{
+	ARG_UNUSED(start_utc);
+	ARG_UNUSED(zone);
+	atomic_add(&water_s, (dur_ms + 500u) / 1000u);
+	return 0;
+}
+
+uint32_t water_log_today_s(void)
+{
+	return (uint32_t)atomic_get(&water_s);
+}
+
+/* ====================== 轨迹生成 ====================== */
+
+static struct {
+	char buf[256 * 1024];
+	size_t len;
+} trace;
+
+static void tr_reset(void)
+{
+	trace.len = 0;
+}
+
+static void tr_printf(const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	trace.len += vsnprintf(trace.buf + trace.len, sizeof(trace.buf) - trace.len, fmt, ap);
+	va_end(ap);
+	zassert_true(trace.len < sizeof(trace.buf), "trace buffer too small");
+}
+
+/* 定点小数（不靠 printf 的浮点支持） */
+static const char *fx(char *s, double v, int dec)
+{
+	int scale = 1;
+
+	for (int k = 0; k < dec; k++) {
+		scale *= 10;
+	}
+
+	double a = round(fabs(v) * scale);
+	int whole = (int)(a / scale);
+	int frac = (int)(a - (double)whole * scale);
+
+	sprintf(s, "%s%d.%0*d", v < 0 ? "-" : "", whole, dec, frac);
+	return s;
+}
+
+static double north_lat(double north_m)
+{
+	return TROUGH_LAT + north_m / M_PER_DEG_LAT;
+}
+
+static double east_lon(double east_m)
+{
+	return TROUGH_LON + east_m / (M_PER_DEG_LAT * cos(TROUGH_LAT * M_PI / 180.0));
+}
+
+/* PVT 日志的一行：离水槽 north_m / east_m */
+static void tr_fix(uint32_t t, double north_m, double east_m, double speed, double heading)
+{
+	char a[24], b[24], c[24], d[24];
+
+	tr_printf("%u %s %s 12.0 3.5 %s %s\n", t, fx(a, north_lat(north_m), 7),
+		  fx(b, east_lon(east_m), 7), fx(c, speed, 2), fx(d, heading, 1));
+}
+
+static void tr_nofix(uint32_t t)
+{
+	tr_printf("%u -\n", t);
+}
+
+static void tr_nmea(const char *body)
+{
+	uint8_t sum = 0;
+
+	for (const char *p = body; *p; p++) {
+		sum ^= (uint8_t)*p;
+	}
+	tr_printf("$%s*%02X\r\n", body, sum);
+}
+
+/* ddmm.mmmmm / dddmm.mmmmm */
+static const char *nmea_coord(char *s, double deg, int deg_digits)
+{
+	double a = fabs(deg);
+	int d = (int)a;
+	char m[24];
+
+	fx(m, (a - d) * 60.0, 5);
+	sprintf(s, "%0*d%s%s", deg_digits, d, (a - d) * 60.0 < 10.0 ? "0" : "", m);
+	return s;
+}
+
+/* ====================== 观察 GNSS 任务的输出 ====================== */
+
+static struct {
+	uint32_t cursor;
+	enum gnss_status seq[16];      /* 依次出现过的状态 */
+	int n_seq;
+	bool water_msg;                /* 收到过 is_water_gnss */
+	uint32_t msgs;
+	uint32_t lost;                 /* 历史读慢了丢的条数 */
+	struct gnss_status_msg last;
+} mon;
+
+static void pump(void)
+{
+	struct gnss_status_msg m;
+	int ret;
+
+	while ((ret = gnss_history_read(&mon.cursor, &m)) != -EAGAIN) {
+		mon.lost += ret;
+		mon.msgs++;
+		mon.water_msg |= m.is_water_gnss;
+		if (mon.n_seq == 0 || mon.seq[mon.n_seq - 1] != m.status) {
+			if (mon.n_seq < ARRAY_SIZE(mon.seq)) {
+				mon.seq[mon.n_seq++] = m.status;
+			}
+		}
+		mon.last = m;
+	}
+}
+
+static void mon_reset(void)
+{
+	memset(&mon, 0, sizeof(mon));
+	mon.cursor = gnss_history_head();
+}
+
+/* 等轨迹走到第 sec 秒 */
+static void wait_trace_sec(uint32_t sec)
+{
+	struct gnss_sim_stats st;
+
+	for (;;) {
+		pump();
+		gnss_sim_get_stats(&st);
+		if (st.sec >= sec || st.done) {
+			return;
+		}
+		k_msleep(100);
+	}
+}
+
+static bool wait_status(enum gnss_status status, int timeout_s)
+{
+	for (int k = 0; k < timeout_s * 10; k++) {
+		pump();
+		if (mon.msgs > 0 && mon.last.status == status) {
+			return true;
+		}
+		k_msleep(100);
+	}
+	return false;
+}
+
+/* 边等边读历史（只有 32 条，1 Hz 下半分钟就覆盖了） */
+static void wait_done(int timeout_s)
+{
+	for (int k = 0; k < timeout_s * 10; k++) {
+		pump();
+		if (gnss_sim_wait_done(K_MSEC(100)) == 0) {
+			pump();
+			return;
+		}
+	}
+	zassert_unreachable("trace did not finish");
+}
+
+static void press_button1(void)
+{
+	gpio_emul_input_set(button1.port, button1.pin, 1);
+	k_msleep(50);
+	gpio_emul_input_set(button1.port, button1.pin, 0);
+}
+
+static void *suite_setup(void)
+{
+	zassert_ok(gnss_system_init());
+	return NULL;
+}
+
+/* ====================== 状态机 ====================== */
+
+ZTEST(gnss_replay, test_01_state_machine)
+{
+	struct gnss_sim_stats st;
+	struct gnss_pvt_stats ps;
+
+	/*
+	 * 0-4 s 搜星；5-19 站在水槽；20-39 往北走 30 m；40-59 走回水槽；
+	 * 60-71 喝水；72-91 再往北走 30 m，然后站着；100-119 遮挡 20 s
+	 */
+	tr_reset();
+	tr_printf("# horse collar replay: trough, walk, drink, outage\n");
+	tr_printf("start 2025-06-01 12:00:00\n");
+	for (uint32_t t = 0; t < 140; t++) {
+		if (t < 5) {
+			tr_nofix(t);
+		} else if (t < 20 || (t >= 60 && t < 72)) {
+			tr_fix(t, 0.0, 0.0, 0.0, 0.0);
+		} else if (t < 40) {
+			tr_fix(t, 1.5 * (t - 19), 0.0, 1.5, 0.0);
+		} else if (t < 60) {
+			tr_fix(t, 30.0 - 1.5 * (t - 39), 0.0, 1.5, 180.0);
+		} else if (t < 92) {
+			tr_fix(t, 1.5 * (t - 71), 0.0, 1.5, 0.0);
+		} else {
+			tr_fix(t, 30.0, 0.0, 0.1, 0.0);
+		}
+	}
+
+	zassert_equal(gnss_sim_load(GNSS_SIM_PVT_LOG, trace.buf, trace.len), 140);
+	zassert_ok(gnss_sim_add_outage(100, 20));
+
+	mon_reset();
+	gnss_start_after_lte_ready();
+
+	/* 第一个 fix：等标记水槽，然后按键 */
+	zassert_true(wait_status(GNSS_STATUS_WAIT_TROUGH_MARK, 30));
+	press_button1();
+	zassert_true(wait_status(GNSS_STATUS_NORMAL, 5));
+
+	/* 标记时站在水槽里，走开的时候算了一次；以这时的累计为准 */
+	wait_trace_sec(45);
+	double water0 = mon.last.total_water_s;
+
+	wait_done(200);
+
+	enum gnss_status expect[] = {
+		GNSS_STATUS_SEARCHING, GNSS_STATUS_WAIT_TROUGH_MARK, GNSS_STATUS_NORMAL,
+		GNSS_STATUS_SIGNAL_LOST, GNSS_STATUS_NORMAL,
+	};
+
+	zassert_equal(mon.n_seq, ARRAY_SIZE(expect), "%d status changes", mon.n_seq);
+	for (int k = 0; k < ARRAY_SIZE(expect); k++) {
+		zassert_equal(mon.seq[k], expect[k], "status #%d", k);
+	}
+	zassert_true(mon.water_msg, "no is_water_gnss message");
+	zassert_equal(mon.lost, 0);
+
+	/* 第二次在水槽大约 53-78 s */
+	double visit = mon.last.total_water_s - water0;
+
+	TC_PRINT("water: %d s before, %d s visit\n", (int)water0, (int)visit);
+	zassert_true(water0 > 0.0);
+	zassert_true(visit > 18.0 && visit < 32.0, "visit %d s", (int)visit);
+
+	/* 最后停在北边 30 m */
+	zassert_within(mon.last.lat, north_lat(30.0), 1e-6);
+
+	/* 一次初始启动 + 丢星重启 */
+	gnss_sim_get_stats(&st);
+	zassert_equal(st.starts, 2, "starts %u", st.starts);
+	zassert_equal(st.stops, 1, "stops %u", st.stops);
+	zassert_equal(st.frames, 140);
+	zassert_equal(st.fixes, 140 - 5 - 20);
+
+	gnss_get_pvt_stats(&ps);
+	zassert_equal(ps.overruns, 0);
+	zassert_equal(ps.read_errors, 0);
+	zassert_true(atomic_get(&track_points) > 0);
+}
+
+/* ====================== NMEA ====================== */
+
+ZTEST(gnss_replay, test_02_nmea)
+{
+	char body[128], lat[24], lon[24], spd[24];
+	int64_t utc_ms;
+
+	/* 在北边 50 m 往东走 2 m/s，跨过 UTC 午夜；GGA 在 RMC 前面，中间有别的语句和一行坏的 */
+	tr_reset();
+	for (int k = 0; k < 60; k++) {
+		uint32_t tod = (23 * 3600 + 59 * 60 + 30 + k) % 86400;
+		int hh = tod / 3600, mm = tod / 60 % 60, ss = tod % 60;
+		const char *date = (k < 30) ? "010625" : "020625";
+
+		nmea_coord(lat, north_lat(50.0), 2);
+		nmea_coord(lon, east_lon(2.0 * k), 3);
+
+		snprintf(body, sizeof(body), "GNGGA,%02d%02d%02d.00,%s,N,%s,W,1,09,0.9,12.0,M,-34.0,M,,",
+			 hh, mm, ss, lat, lon);
+		tr_nmea(body);
+		tr_nmea("GPGSV,1,1,01,05,45,120,40");
+		snprintf(body, sizeof(body), "GNRMC,%02d%02d%02d.00,A,%s,N,%s,W,%s,90.0,%s,,,A",
+			 hh, mm, ss, lat, lon, fx(spd, 2.0 / 0.514444, 3), date);
+		tr_nmea(body);
+		if (k == 10) {
+			tr_printf("$GNRMC,235940.00,A,garbage*00\r\n");
+		}
+	}
+
+	mon_reset();
+	zassert_equal(gnss_sim_load(GNSS_SIM_NMEA, trace.buf, trace.len), 60);
+
+	struct gnss_sim_stats st;
+
+	gnss_sim_get_stats(&st);
+	zassert_equal(st.bad_lines, 1);
+
+	wait_done(120);
+
+	zassert_true(mon.msgs >= 59, "%u messages", mon.msgs);
+	zassert_equal(mon.last.status, GNSS_STATUS_NORMAL);
+	zassert_within(mon.last.lat, north_lat(50.0), 2e-6);
+	zassert_within(mon.last.lon, east_lon(2.0 * 59), 2e-6);
+	zassert_within(mon.last.speed_mps, 2.0f, 0.01f);
+	zassert_within(mon.last.heading_deg, 90.0f, 0.01f);
+
+	/* 时间基准跟着 PVT 过了午夜 */
+	zassert_true(timebase_to_utc_ms(timebase_now(), &utc_ms));
+	zassert_within(utc_ms, timebase_civil_to_utc_ms(2025, 6, 2, 0, 0, 29, 0), 3000);
+}
+
+/* ====================== 省电策略 ====================== */
+
+ZTEST(gnss_replay, test_03_power_step_down)
+{
+	struct gnss_sim_stats st;
+
+	/* 离水槽 60 m 站 4 分钟：2 分钟后降到周期定位 */
+	tr_reset();
+	tr_printf("start 2025-06-02 08:00:00\n");
+	for (uint32_t t = 0; t < 240; t++) {
+		tr_fix(t, 60.0, 0.0, 0.1, 0.0);
+	}
+
+	mon_reset();
+	zassert_equal(gnss_sim_load(GNSS_SIM_PVT_LOG, trace.buf, trace.len), 240);
+	wait_done(300);
+
+	gnss_sim_get_stats(&st);
+	TC_PRINT("standing 240 s: %u PVTs, interval %u s\n", st.frames, st.interval);
+	zassert_equal(st.interval, CONFIG_HORSE_GNSS_PERIODIC_SEC);
+	zassert_true(st.running);
+	zassert_true(st.frames < 240 - 100, "%u frames", st.frames);
+	zassert_equal(mon.last.status, GNSS_STATUS_NORMAL, "periodic no-fix is not a loss");
+}
+
+/* ====================== PVT 环形缓冲 ====================== */
+
+ZTEST(gnss_replay, test_04_burst_overrun)
+{
+	struct gnss_sim_stats st;
+	struct gnss_pvt_stats before, after;
+
+	/* 走起来回到 1 Hz，然后一个中断里连发 12 帧（缓冲 8 帧） */
+	tr_reset();
+	for (uint32_t t = 0; t < 90; t++) {
+		tr_fix(t, 60.0 + 1.5 * t, 0.0, 1.5, 0.0);
+	}
+
+	mon_reset();
+	zassert_equal(gnss_sim_load(GNSS_SIM_PVT_LOG, trace.buf, trace.len), 90);
+
+	for (int k = 0; k < 700; k++) {
+		gnss_sim_get_stats(&st);
+		if (st.interval == 1 && st.running) {
+			break;
+		}
+		k_msleep(100);
+	}
+	zassert_equal(st.interval, 1, "back to 1 Hz");
+	k_msleep(1500);
+
+	gnss_get_pvt_stats(&before);
+	gnss_sim_burst(11);
+	k_msleep(2000);
+	gnss_get_pvt_stats(&after);
+
+	zassert_equal(after.frames - before.frames, 12 + 1, "burst + next second");
+	zassert_equal(after.overruns - before.overruns, 4);
+	zassert_equal(after.max_depth, 8);
+	zassert_equal(after.read_errors, 0);
+
+	wait_done(120);
+}
+
+/* ====================== 吞吐 ====================== */
+
+ZTEST(gnss_replay, test_05_throughput)
+{
+	struct gnss_sim_stats st;
+	struct gnss_pvt_stats before, after;
+	uint32_t t0;
+
+	/* 一小时的走动轨迹，50 倍速（每 20 ms 一帧） */
+	tr_reset();
+	for (uint32_t t = 0; t < 3600; t++) {
+		tr_fix(t, 300.0 + 1.5 * t, 0.0, 1.5, 0.0);
+	}
+
+	gnss_get_pvt_stats(&before);
+	mon_reset();
+	gnss_sim_set_speed(50.0f);
+	zassert_equal(gnss_sim_load(GNSS_SIM_PVT_LOG, trace.buf, trace.len), 3600);
+
+	t0 = k_uptime_get_32();
+	wait_done(200);
+	gnss_sim_set_speed(1.0f);    /* 下一条用例装入时才生效 */
+	gnss_sim_get_stats(&st);
+	gnss_get_pvt_stats(&after);
+
+	TC_PRINT("replayed %u PVTs in %u ms (sim): %u msgs, overruns %u, max depth %u\n",
+		 st.frames, k_uptime_get_32() - t0, mon.msgs,
+		 after.overruns - before.overruns, after.max_depth);
+
+	zassert_equal(st.frames, 3600);
+	zassert_equal(after.overruns, before.overruns);
+	zassert_equal(after.read_errors, 0);
+	zassert_equal(mon.msgs, 3600);
+	zassert_equal(mon.lost, 0);
+	zassert_within(mon.last.lat, north_lat(300.0 + 1.5 * 3599), 1e-6);
+}
+
+ZTEST_SUITE(gnss_replay, NULL, suite_setup, NULL, NULL, NULL);
@@ -0,0 +1,258 @@
+/* tests/imu_fusion/src/imu_fusion_test.c
+ *
+ * Mahony 滤波的精度：100 Hz 合成的鬐甲 IMU。
+ * 真实姿态由欧拉角随时间的函数给出，陀螺 = 机体角速度 + 零偏 + 噪声，
+ * 加速度计 = 机体系下的重力方向 + 步态引起的线加速度（上下 + 前后）+ 噪声，
+ * 磁力计 = 机体系下的地磁场 + 噪声。和固件同样的增益（imu_fusion.c 的 MAHONY_KP / MAHONY_KI）。
+ *
+ * 各用例打印的误差就是提交里报的精度数字（陀螺零偏 0.5 dps）：
+ *   一个 10 s 采集段（滤波器每段复位）：倾角 < 0.8°，heading < 2.2°；
+ *   连续静止 3 分钟以后零偏被积分项吃掉：倾角、heading 都 < 0.1°；
+ *   连续走动 10 分钟：RMS heading 0.7°、roll 0.7°（前后冲击）、pitch 0.2°，单点最大 5°。
+ */
+#include <zephyr/ztest.h>
+#include <math.h>
+#include "mahony.h"
+
+#define FS_HZ           100
+#define DT              (1.0 / FS_HZ)
+#define PI_D            3.14159265358979
+#define D2R             (PI_D / 180.0)
+
+#define KP              1.0f
+#define KI              0.02f
+
+#define GYR_BIAS_DPS    0.5         /* BNO055 陀螺零偏量级 */
+#define GYR_NOISE_DPS   0.1
+#define ACC_NOISE_G     0.01
+#define MAG_NOISE       0.01        /* 相对场强 */
+
+/* 走动时的 RMS 门限 (deg)，实测约一半 */
+#define RMS_TILT        1.2
+#define RMS_HEADING     1.2
+
+/* 地磁场（世界系 x = 北，z = 上）：倾角约 60° */
+static const double mag_w[3] = { 0.5, 0.0, -0.866 };
+
+/* 确定的伪随机数，结果可重复 */
+static uint32_t rng = 1;
+
+static double noise(double amp)
+{
+	rng = rng * 1664525u + 1013904223u;
+	return amp * (((double)(rng >> 8) / (double)(1u << 24)) * 2.0 - 1.0);
+}
+
+/* 欧拉角 (rad，ZYX：psi 逆时针、theta 绕 Y、phi 绕 X) -> 机体到世界的四元数 */
+static void euler_to_q(double phi, double theta, double psi, double q[4])
+{
+	double cr = cos(phi / 2), sr = sin(phi / 2);
+	double cp = cos(theta / 2), sp = sin(theta / 2);
+	double cy = cos(psi / 2), sy = sin(psi / 2);
+
+	q[0] = cr * cp * cy + sr * sp * sy;
+	q[1] = sr * cp * cy - cr * sp * sy;
+	q[2] = cr * sp * cy + sr * cp * sy;
+	q[3] = cr * cp * sy - sr * sp * cy;
+}
+
+/* 世界系向量 v 转到机体系：R(q)^T v */
+static void to_body(const double q[4], const double v[3], double out[3])
+{
+	double w = q[0], x = q[1], y = q[2], z = q[3];
+
+	out[0] = (1 - 2 * (y * y + z * z)) * v[0] + 2 * (x * y + w * z) * v[1] +
+		 2 * (x * z - w * y) * v[2];
+	out[1] = 2 * (x * y - w * z) * v[0] + (1 - 2 * (x * x + z * z)) * v[1] +
+		 2 * (y * z + w * x) * v[2];
+	out[2] = 2 * (x * z + w * y) * v[0] + 2 * (y * z - w * x) * v[1] +
+		 (1 - 2 * (x * x + y * y)) * v[2];
+}
+
+/* 机体角速度：ω = 2 q* ⊗ dq/dt */
+static void body_rate(const double q0[4], const double q1[4], double w[3])
+{
+	double d[4];
+
+	for (int i = 0; i < 4; i++) {
+		d[i] = (q1[i] - q0[i]) / DT;
+	}
+	double a = q0[0], b = -q0[1], c = -q0[2], e = -q0[3];
+
+	w[0] = 2 * (a * d[1] + b * d[0] + c * d[3] - e * d[2]);
+	w[1] = 2 * (a * d[2] - b * d[3] + c * d[0] + e * d[1]);
+	w[2] = 2 * (a * d[3] + b * d[2] - c * d[1] + e * d[0]);
+}
+
+/* 真实姿态（rad）：walking = false 时站着不动 */
+struct pose {
+	double phi, theta, psi;
+};
+
+static struct pose pose_at(double t, bool walking, double psi0)
+{
+	struct pose p = { .phi = -20.0 * D2R, .theta = 10.0 * D2R, .psi = psi0 };
+
+	if (walking) {
+		/* 步态 0.9 Hz：左右摆 ±3°、前后点头 ±5°（2 倍频），慢慢转弯 */
+		p.phi += 5.0 * D2R * sin(2 * PI_D * 1.8 * t);
+		p.theta += 3.0 * D2R * sin(2 * PI_D * 0.9 * t);
+		p.psi += 90.0 * D2R * sin(2 * PI_D * t / 120.0);
+	}
+	return p;
+}
+
+static double wrap180(double d)
+{
+	while (d > 180.0) {
+		d -= 360.0;
+	}
+	while (d < -180.0) {
+		d += 360.0;
+	}
+	return d;
+}
+
+struct err {
+	double rms[3];          /* heading / roll / pitch (deg) */
+	double max[3];
+};
+
+/* 跑 secs 秒，skip 秒以后开始统计误差 */
+static struct err run(struct mahony *m, double secs, double skip, bool walking, double psi0)
+{
+	struct err e = { 0 };
+	double sum[3] = { 0 };
+	uint32_t n = 0;
+	double qa[4], qb[4];
+	struct pose p = pose_at(0, walking, psi0);
+
+	euler_to_q(p.phi, p.theta, p.psi, qa);
+
+	for (uint32_t k = 1; k <= (uint32_t)(secs * FS_HZ); k++) {
+		double t = k * DT;
+
+		p = pose_at(t, walking, psi0);
+		euler_to_q(p.phi, p.theta, p.psi, qb);
+
+		double w[3], up[3], acc[3], mag[3];
+		static const double up_w[3] = { 0, 0, 1 };
+
+		body_rate(qa, qb, w);
+		to_body(qb, up_w, up);
+		to_body(qb, mag_w, mag);
+
+		/* 步态的线加速度：竖直 ±0.15 g 跟着头点，前后 ±0.1 g 每步一次 */
+		double surge[3] = { 0 }, sb[3];
+
+		if (walking) {
+			double a = 0.1 * sin(2 * PI_D * 0.9 * t + 1.0);
+
+			surge[0] = a * cos(p.psi);
+			surge[1] = a * sin(p.psi);
+			surge[2] = 0.15 * sin(2 * PI_D * 1.8 * t);
+		}
+		to_body(qb, surge, sb);
+
+		for (int i = 0; i < 3; i++) {
+			acc[i] = up[i] + sb[i] + noise(ACC_NOISE_G);
+			mag[i] += noise(MAG_NOISE);
+			w[i] += (GYR_BIAS_DPS + noise(GYR_NOISE_DPS)) * D2R;
+		}
+
+		mahony_update(m, w[0], w[1], w[2], acc[0], acc[1], acc[2],
+			      mag[0], mag[1], mag[2], DT);
+
+		if (t >= skip) {
+			struct mahony truth = { .q = { qb[0], qb[1], qb[2], qb[3] } };
+			float eh, er, ep, th, tr, tp;
+
+			mahony_euler(m, &eh, &er, &ep);
+			mahony_euler(&truth, &th, &tr, &tp);
+
+			double d[3] = { wrap180(eh - th), er - tr, wrap180(ep - tp) };
+
+			for (int i = 0; i < 3; i++) {
+				sum[i] += d[i] * d[i];
+				e.max[i] = fmax(e.max[i], fabs(d[i]));
+			}
+			n++;
+		}
+		for (int i = 0; i < 4; i++) {
+			qa[i] = qb[i];
+		}
+	}
+
+	for (int i = 0; i < 3; i++) {
+		e.rms[i] = sqrt(sum[i] / n);
+	}
+	TC_PRINT("rms h/r/p %.2f %.2f %.2f  max %.2f %.2f %.2f deg\n",
+		 e.rms[0], e.rms[1], e.rms[2], e.max[0], e.max[1], e.max[2]);
+	return e;
+}
+
+ZTEST(imu_fusion, test_session_standing)
+{
+	/* 一个 10 s 采集段：第一个样本按重力 / 磁北对齐，零偏还没学到 */
+	struct mahony m;
+
+	rng = 1;
+	mahony_init(&m, KP, KI);
+
+	struct err e = run(&m, 10.0, 0.0, false, 135.0 * D2R);
+
+	zassert_true(e.max[1] < 1.0 && e.max[2] < 1.0, "tilt err %f %f", e.max[1], e.max[2]);
+	zassert_true(e.max[0] < 3.0, "heading err %f", e.max[0]);
+}
+
+ZTEST(imu_fusion, test_bias_learned)
+{
+	/* 一直开着：积分项吃掉陀螺零偏 */
+	struct mahony m;
+
+	rng = 3;
+	mahony_init(&m, KP, KI);
+	(void)run(&m, 180.0, 180.0, false, 300.0 * D2R);
+
+	struct err e = run(&m, 60.0, 0.0, false, 300.0 * D2R);
+
+	zassert_true(e.max[1] < 0.3 && e.max[2] < 0.3, "tilt err %f %f", e.max[1], e.max[2]);
+	zassert_true(e.max[0] < 0.5, "heading err %f", e.max[0]);
+}
+
+ZTEST(imu_fusion, test_walking)
+{
+	/* 10 分钟走动，带陀螺零偏和步态加速度 */
+	struct mahony m;
+
+	rng = 2;
+	mahony_init(&m, KP, KI);
+
+	struct err e = run(&m, 600.0, 0.0, true, 40.0 * D2R);
+
+	zassert_true(e.rms[1] < RMS_TILT && e.rms[2] < RMS_TILT, "tilt rms %f %f",
+		     e.rms[1], e.rms[2]);
+	zassert_true(e.rms[0] < RMS_HEADING, "heading rms %f", e.rms[0]);
+}
+
+ZTEST(imu_fusion, test_no_mag)
+{
+	/* 不用磁力计（ACCGYRO 模式）：倾角照样收敛 */
+	struct mahony m;
+	float h, r, p;
+
+	mahony_init(&m, KP, KI);
+	for (int k = 0; k < 10 * FS_HZ; k++) {
+		double q[4], up[3];
+		static const double up_w[3] = { 0, 0, 1 };
+
+		euler_to_q(-20.0 * D2R, 10.0 * D2R, 0.0, q);
+		to_body(q, up_w, up);
+		mahony_update(&m, 0, 0, 0, up[0], up[1], up[2], 0, 0, 0, DT);
+	}
+	mahony_euler(&m, &h, &r, &p);
+	zassert_within(r, 10.0f, 0.5f, "roll %f", (double)r);
+	zassert_within(p, -20.0f, 0.5f, "pitch %f", (double)p);
+}
+
+ZTEST_SUITE(imu_fusion, NULL, NULL, NULL, NULL, NULL);
@@ -0,0 +1,117 @@
+/* tests/respiration/src/respiration_test.c
+ *
+ * 自相关呼吸频率估计：64 s、2 Hz 的合成鬐甲 pitch，
+ * 呼吸起伏（正弦或者吸气快呼气慢的不对称波形）+ 均匀噪声 + 慢漂移，
+ * 6~30 次/分钟要在 1 次/分钟以内；再快 2 Hz 下一口气只有 3~4 个样本，放宽到 1.5 次/分钟，
+ * 但不能报成一半 / 三分之一的频率。纯噪声和平直信号不出结果或者质量分低。
+ */
+#include <zephyr/ztest.h>
+#include <math.h>
+#include "resp_acorr.h"
+
+#define FS_HZ           2.0f
+#define WIN             128         /* 和 respiration.c 的窗口一样长 */
+#define PI_F            3.14159265f
+
+#define AMP_DEG         0.3f        /* 呼吸引起的 pitch 起伏 */
+#define NOISE_DEG       0.1f
+#define DRIFT_DEG       0.5f        /* 整个窗口的慢漂移 */
+
+static float x[WIN];
+
+/* 确定的伪随机数，结果可重复 */
+static uint32_t rng = 1;
+
+static float noise(float amp)
+{
+	rng = rng * 1664525u + 1013904223u;
+	return amp * (((float)(rng >> 8) / (float)(1u << 24)) * 2.0f - 1.0f);
+}
+
+/* 一个周期里前 1/3 吸气、后 2/3 呼气的三角波，谐波比正弦多 */
+static float breath_shape(float phase)
+{
+	float p = phase - floorf(phase);
+
+	return (p < 1.0f / 3.0f) ? 3.0f * p : 1.5f * (1.0f - p);
+}
+
+static void synth(float bpm, bool asym, float amp, float nz)
+{
+	float f = bpm / 60.0f;
+
+	for (int i = 0; i < WIN; i++) {
+		float t = i / FS_HZ;
+		float b = asym ? 2.0f * breath_shape(f * t + 0.2f) - 1.0f
+			       : sinf(2.0f * PI_F * f * t + 0.7f);
+
+		x[i] = 12.0f + DRIFT_DEG * i / WIN + amp * b + noise(nz);
+	}
+}
+
+static void check_rate(float bpm, bool asym)
+{
+	int tol_x10 = (bpm <= 30.0f) ? 10 : 15;
+	uint16_t bpm_x10;
+	uint8_t q;
+
+	synth(bpm, asym, AMP_DEG, NOISE_DEG);
+	zassert_true(resp_acorr_estimate(x, WIN, FS_HZ, &bpm_x10, &q),
+		     "no peak at %d bpm", (int)bpm);
+	zassert_within(bpm_x10, (int)(bpm * 10.0f), tol_x10,
+		       "%d bpm estimated as %u.%u", (int)bpm, bpm_x10 / 10, bpm_x10 % 10);
+	zassert_true(q >= 30, "quality %u at %d bpm", q, (int)bpm);
+}
+
+ZTEST(respiration, test_sine_rates)
+{
+	rng = 1;
+	for (int bpm = 6; bpm <= 42; bpm++) {
+		check_rate(bpm, false);
+	}
+}
+
+ZTEST(respiration, test_asymmetric_breath)
+{
+	/* 谐波不能被当成呼吸频率，整数倍滞后也不能报成一半 */
+	rng = 7;
+	for (int bpm = 6; bpm <= 42; bpm++) {
+		check_rate(bpm, true);
+	}
+}
+
+ZTEST(respiration, test_noise_only)
+{
+	uint16_t bpm_x10;
+	uint8_t q = 0;
+
+	rng = 3;
+	synth(12.0f, false, 0.0f, NOISE_DEG);
+
+	bool ok = resp_acorr_estimate(x, WIN, FS_HZ, &bpm_x10, &q);
+
+	zassert_true(!ok || q < 30, "noise reported %u.%u bpm q=%u",
+		     bpm_x10 / 10, bpm_x10 % 10, q);
+}
+
+ZTEST(respiration, test_flat)
+{
+	uint16_t bpm_x10;
+	uint8_t q;
+
+	for (int i = 0; i < WIN; i++) {
+		x[i] = 5.0f + 0.01f * i;        /* 只有趋势：去趋势以后全是 0 */
+	}
+	zassert_false(resp_acorr_estimate(x, WIN, FS_HZ, &bpm_x10, &q));
+}
+
+ZTEST(respiration, test_short_window)
+{
+	uint16_t bpm_x10;
+	uint8_t q;
+
+	synth(12.0f, false, AMP_DEG, 0.0f);
+	zassert_false(resp_acorr_estimate(x, 40, FS_HZ, &bpm_x10, &q));
+}
+
+ZTEST_SUITE(respiration, NULL, NULL, NULL, NULL, NULL);
@@ -0,0 +1,228 @@
+/* tests/track/src/track_test.c
+ *
+ * 轨迹化简：误差上界（每个输入点到它所在那段折线的距离）、压缩率、
+ * 编码往返。轨迹用固定种子的随机游走生成：吃草（原地 + GNSS 噪声）、
+ * 慢走、小跑、折返。
+ */
+#include <zephyr/ztest.h>
+#include <math.h>
+#include <string.h>
+#include "track_compress.h"
+
+#define LAT0_E6         40000000
+#define LON0_E6         (-75200000)
+#define M_PER_E6_LAT    0.11119493
+#define M_PER_E6_LON    (0.11119493 * 0.76604444)   /* cos(40 deg) */
+
+#define TOL_M           5.0f
+#define MAX_GAP_S       300
+#define N_FIX           3600
+
+static struct track_point in[N_FIX];
+static struct track_point out[N_FIX + 2];
+static uint8_t msg[8192];
+static struct track_point dec[N_FIX + 2];
+
+static uint32_t rng;
+
+static double rnd_range(double lo, double hi)
+{
+	rng = rng * 1664525u + 1013904223u;
+	return lo + (hi - lo) * (double)((rng >> 8) & 0xFFFF) / 65536.0;
+}
+
+static double gauss(void)
+{
+	double s = 0.0;
+
+	for (int i = 0; i < 6; i++) {
+		s += rnd_range(-1.0, 1.0);
+	}
+	return s * 0.7;
+}
+
+static struct track_point at(uint32_t t, double e, double n)
+{
+	return (struct track_point){
+		.t = t,
+		.lat_e6 = LAT0_E6 + (int32_t)lround(n / M_PER_E6_LAT),
+		.lon_e6 = LON0_E6 + (int32_t)lround(e / M_PER_E6_LON),
+	};
+}
+
+/* 一小时：每 2~5 分钟换一种行为 */
+static void make_track(uint32_t seed)
+{
+	double e = 0, n = 0, hdg = 0, v = 0;
+	uint32_t next_mode = 0;
+
+	rng = seed;
+	for (uint32_t t = 0; t < N_FIX; t++) {
+		if (t >= next_mode) {
+			double r = rnd_range(0, 1);
+
+			v = (r < 0.4) ? 0.0 : (r < 0.8) ? 1.5 : 4.0;
+			next_mode = t + (uint32_t)rnd_range(120, 300);
+		}
+		if (v == 1.5 && rnd_range(0, 1) < 0.01) {
+			hdg += 3.14159;     /* 折返 */
+		}
+		hdg += rnd_range(-0.15, 0.15);
+		e += v * cos(hdg);
+		n += v * sin(hdg);
+		in[t] = at(1700000000u + t, e + 1.5 * gauss(), n + 1.5 * gauss());
+	}
+}
+
+static size_t compress(const struct track_point *pts, size_t n)
+{
+	struct track_compressor tc;
+	size_t m = 0;
+
+	track_init(&tc, TOL_M, MAX_GAP_S);
+	for (size_t i = 0; i < n; i++) {
+		m += track_feed(&tc, &pts[i], &out[m]);
+	}
+	m += track_flush(&tc, &out[m]);
+	return m;
+}
+
+static void to_m(const struct track_point *p, double *x, double *y)
+{
+	*x = (p->lon_e6 - LON0_E6) * M_PER_E6_LON;
+	*y = (p->lat_e6 - LAT0_E6) * M_PER_E6_LAT;
+}
+
+static double seg_dist(const struct track_point *p, const struct track_point *a,
+		       const struct track_point *b)
+{
+	double px, py, ax, ay, bx, by;
+
+	to_m(p, &px, &py);
+	to_m(a, &ax, &ay);
+	to_m(b, &bx, &by);
+
+	double ex = bx - ax, ey = by - ay;
+	double len2 = ex * ex + ey * ey;
+	double t = len2 > 0 ? ((px - ax) * ex + (py - ay) * ey) / len2 : 0;
+
+	t = fmin(fmax(t, 0), 1);
+	return hypot(px - ax - t * ex, py - ay - t * ey);
+}
+
+/* 每个输入点到时间上覆盖它的那段折线的最大距离 */
+static double worst_error(const struct track_point *pts, size_t n, size_t m)
+{
+	double worst = 0;
+	size_t s = 0;
+
+	for (size_t i = 0; i < n; i++) {
+		while (s + 1 < m && out[s + 1].t < pts[i].t) {
+			s++;
+		}
+		double d = (s + 1 < m) ? seg_dist(&pts[i], &out[s], &out[s + 1]) :
+			   seg_dist(&pts[i], &out[s], &out[s]);
+
+		worst = fmax(worst, d);
+	}
+	return worst;
+}
+
+ZTEST(track, test_straight_line)
+{
+	for (uint32_t t = 0; t < 100; t++) {
+		in[t] = at(t, 1.5 * t, 0.5 * t);
+	}
+	size_t m = compress(in, 100);
+
+	zassert_equal(m, 2, "straight line keeps only its ends, got %u", (unsigned int)m);
+	zassert_equal(out[0].t, 0);
+	zassert_equal(out[1].t, 99);
+}
+
+ZTEST(track, test_standing_still)
+{
+	rng = 1;
+	for (uint32_t t = 0; t < 1800; t++) {
+		in[t] = at(t, 1.0 * gauss(), 1.0 * gauss());
+	}
+	size_t m = compress(in, 1800);
+
+	/* 起点 + 每 5 分钟一个 + 收尾，再加上噪声偶尔超过 tol 引起的点
+	 * （独立白噪声比实际的 GNSS 漂移苛刻）
+	 */
+	TC_PRINT("standing still: 1800 fixes -> %u points\n", (unsigned int)m);
+	zassert_true(m >= 1800 / MAX_GAP_S);
+	zassert_true(m <= 30, "got %u points", (unsigned int)m);
+	zassert_true(worst_error(in, 1800, m) <= TOL_M + 0.2);
+}
+
+ZTEST(track, test_backtrack)
+{
+	/* 往东 30 m 再折回 20 m：不能把最远点丢掉 */
+	uint32_t t = 0;
+
+	for (int k = 0; k <= 30; k++, t++) {
+		in[t] = at(t, k, 0);
+	}
+	for (int k = 29; k >= 10; k--, t++) {
+		in[t] = at(t, k, 0);
+	}
+	size_t m = compress(in, t);
+
+	zassert_true(m >= 3, "got %u points", (unsigned int)m);
+	zassert_true(worst_error(in, t, m) <= TOL_M + 0.2);
+}
+
+ZTEST(track, test_error_bound_and_ratio)
+{
+	for (uint32_t seed = 1; seed <= 5; seed++) {
+		make_track(seed * 7919u);
+
+		size_t m = compress(in, N_FIX);
+		double worst = worst_error(in, N_FIX, m);
+		size_t len = 0;
+		size_t k = track_encode(out, m, msg, sizeof(msg), &len);
+
+		TC_PRINT("seed %u: %u fixes -> %u points (%.1f%%), %u bytes vs %u raw, "
+			 "worst %.2f m\n", seed, N_FIX, (unsigned int)m, 100.0 * m / N_FIX,
+			 (unsigned int)len, (unsigned int)(N_FIX * sizeof(struct track_point)),
+			 worst);
+
+		/* 微度取整带来约 0.1 m */
+		zassert_true(worst <= TOL_M + 0.2, "seed %u: %.2f m", seed, worst);
+		zassert_true(m < N_FIX / 5, "seed %u: %u points", seed, (unsigned int)m);
+		zassert_equal(k, m);
+		zassert_true(len < m * 8, "seed %u: %u bytes", seed, (unsigned int)len);
+	}
+}
+
+ZTEST(track, test_encode_roundtrip)
+{
+	make_track(42);
+	size_t m = compress(in, N_FIX);
+	size_t len = 0;
+
+	/* 小缓冲：一条消息放不下，分几条发 */
+	size_t done = 0;
+	int msgs = 0;
+
+	while (done < m) {
+		size_t k = track_encode(&out[done], m - done, msg, 128, &len);
+
+		zassert_true(k > 0 && len <= 128);
+		zassert_equal(track_decode(msg, len, dec, ARRAY_SIZE(dec)), (int)k);
+		zassert_mem_equal(dec, &out[done], k * sizeof(dec[0]));
+		done += k;
+		msgs++;
+	}
+	zassert_true(msgs > 1);
+
+	/* 坏消息 */
+	zassert_true(track_encode(out, m, msg, sizeof(msg), &len) == m);
+	zassert_equal(track_decode(msg, len - 1, dec, ARRAY_SIZE(dec)), -EBADMSG);
+	msg[0] ^= 0xFF;
+	zassert_equal(track_decode(msg, len, dec, ARRAY_SIZE(dec)), -EBADMSG);
+}
+
+ZTEST_SUITE(track, NULL, NULL, NULL, NULL, NULL);
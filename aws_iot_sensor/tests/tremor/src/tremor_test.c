@@ -0,0 +1,140 @@
+/* tests/tremor/src/tremor_test.c
+ *
+ * 颤抖检测的单窗分析：128 点、50 Hz 的合成加速度模长（静止时 ~1 g = 981 LSB），
+ * 叠加 8 Hz（寒战）或 2 Hz（呼吸 / 慢晃动）的正弦和小噪声，陀螺模长 1 dps 左右。
+ * 8 Hz 要判阳性、峰值频率落在最近的谱线上、带内 RMS 和合成幅度对得上；
+ * 2 Hz 能量落在低频段，判阴性。两条 FFT 路径（f32 / Q15）跑同一组用例。
+ */
+#include <zephyr/ztest.h>
+#include <math.h>
+#include "tremor_spectrum.h"
+
+#define FS_HZ           50.0f
+#define PI_F            3.14159265f
+#define ACC_1G_LSB      981
+#define GYR_REST_LSB    16          /* 1 dps */
+
+static int16_t  acc[TREMOR_N];
+static uint16_t gyr[TREMOR_N];
+
+/* 确定的伪随机数，结果可重复 */
+static uint32_t rng = 1;
+
+static float noise(float amp)
+{
+	rng = rng * 1664525u + 1013904223u;
+	return amp * (((float)(rng >> 8) / (float)(1u << 24)) * 2.0f - 1.0f);
+}
+
+/* 两个正弦（幅度单位 LSB，1 LSB = 10 mm/s2）+ 噪声 */
+static void synth(float f1, float a1, float f2, float a2, float nz, uint16_t gyr_lsb)
+{
+	for (int i = 0; i < TREMOR_N; i++) {
+		float t = i / FS_HZ;
+		float v = ACC_1G_LSB + a1 * sinf(2.0f * PI_F * f1 * t) +
+			  a2 * sinf(2.0f * PI_F * f2 * t + 0.4f) + noise(nz);
+
+		acc[i] = (int16_t)lroundf(v);
+		gyr[i] = gyr_lsb;
+	}
+}
+
+/* 正弦幅度 a（LSB）的 RMS，mm/s2 */
+static float rms_mms2(float a)
+{
+	return a * 10.0f / sqrtf(2.0f);
+}
+
+ZTEST(tremor, test_01_isqrt)
+{
+	static const uint64_t xs[] = {
+		0, 1, 2, 3, 4, 15, 16, 17, 99, 100, 65535, 65536,
+		4294967295ull, 1000000007ull * 1000ull, (1ull << 62) + 12345, UINT64_MAX,
+	};
+
+	for (size_t i = 0; i < ARRAY_SIZE(xs); i++) {
+		uint64_t r = tremor_isqrt(xs[i]);
+
+		zassert_true(r * r <= xs[i], "isqrt(%llu) = %llu too big",
+			     (unsigned long long)xs[i], (unsigned long long)r);
+		zassert_true((r + 1) * (r + 1) > xs[i] || r == UINT32_MAX,
+			     "isqrt(%llu) = %llu too small",
+			     (unsigned long long)xs[i], (unsigned long long)r);
+	}
+}
+
+ZTEST(tremor, test_02_8hz_shivering_positive)
+{
+	struct tremor_bands b;
+
+	synth(8.0f, 20.0f, 2.0f, 0.0f, 0.5f, GYR_REST_LSB);
+	enum tremor_win r = tremor_spectrum_analyse(acc, gyr, &b);
+
+	TC_PRINT("8 Hz: band %u low %u high %u mm/s2, peak %u x10 Hz, ratio %u, %u%%\n",
+		 b.band_mms2, b.low_mms2, b.high_mms2, b.peak_hz_x10,
+		 b.peak_ratio_x10, b.band_pct);
+	zassert_equal(r, TREMOR_WIN_POSITIVE, NULL);
+	/* 8 Hz 落在 7.8 / 8.2 Hz 两条谱线之间（分辨率 0.39 Hz） */
+	zassert_within(b.peak_hz_x10, 80, 3, "peak %u", b.peak_hz_x10);
+	zassert_true(b.band_pct >= 90, "band %u%%", b.band_pct);
+	zassert_within(b.band_mms2, rms_mms2(20.0f), rms_mms2(20.0f) * 0.1f,
+		       "band %u mm/s2", b.band_mms2);
+	zassert_true(b.peak_ratio_x10 >= 25, NULL);
+}
+
+ZTEST(tremor, test_03_2hz_sway_negative)
+{
+	struct tremor_bands b;
+
+	synth(2.0f, 20.0f, 8.0f, 0.0f, 0.5f, GYR_REST_LSB);
+	enum tremor_win r = tremor_spectrum_analyse(acc, gyr, &b);
+
+	TC_PRINT("2 Hz: band %u low %u high %u mm/s2, peak %u x10 Hz, %u%%\n",
+		 b.band_mms2, b.low_mms2, b.high_mms2, b.peak_hz_x10, b.band_pct);
+	zassert_equal(r, TREMOR_WIN_NEGATIVE, NULL);
+	zassert_true(b.band_pct <= 10, "band %u%%", b.band_pct);
+	zassert_within(b.low_mms2, rms_mms2(20.0f), rms_mms2(20.0f) * 0.1f,
+		       "low %u mm/s2", b.low_mms2);
+}
+
+ZTEST(tremor, test_04_mixed_band_share)
+{
+	struct tremor_bands b;
+
+	/* 8 Hz 和 2 Hz 幅度 1:2 → 带内能量约占 1 / 5 */
+	synth(8.0f, 10.0f, 2.0f, 20.0f, 0.5f, GYR_REST_LSB);
+	enum tremor_win r = tremor_spectrum_analyse(acc, gyr, &b);
+
+	zassert_equal(r, TREMOR_WIN_NEGATIVE, NULL);
+	zassert_within(b.band_pct, 20, 5, "band %u%%", b.band_pct);
+	zassert_within(b.peak_hz_x10, 80, 3, "peak %u", b.peak_hz_x10);
+}
+
+ZTEST(tremor, test_05_small_tremor_resolved)
+{
+	struct tremor_bands b;
+
+	/* 0.05 m/s2 的小幅震颤：不到阳性阈值，但 Q15 路径也要量得准 */
+	synth(10.0f, 5.0f, 2.0f, 0.0f, 0.3f, GYR_REST_LSB);
+	enum tremor_win r = tremor_spectrum_analyse(acc, gyr, &b);
+
+	zassert_equal(r, TREMOR_WIN_NEGATIVE, NULL);
+	zassert_within(b.peak_hz_x10, 100, 3, "peak %u", b.peak_hz_x10);
+	zassert_within(b.band_mms2, rms_mms2(5.0f), rms_mms2(5.0f) * 0.15f,
+		       "band %u mm/s2", b.band_mms2);
+}
+
+ZTEST(tremor, test_06_gates)
+{
+	struct tremor_bands b;
+
+	/* 走动：陀螺 40 dps */
+	synth(8.0f, 20.0f, 2.0f, 0.0f, 0.5f, 40 * 16);
+	zassert_equal(tremor_spectrum_analyse(acc, gyr, &b), TREMOR_WIN_MOTION, NULL);
+
+	/* 完全静止：只有 ±0.5 LSB 的量化噪声 */
+	synth(8.0f, 0.0f, 2.0f, 0.0f, 0.5f, GYR_REST_LSB);
+	zassert_equal(tremor_spectrum_analyse(acc, gyr, &b), TREMOR_WIN_QUIET, NULL);
+}
+
+ZTEST_SUITE(tremor, NULL, NULL, NULL, NULL, NULL);
@@ -0,0 +1,61 @@
+#ifndef PIPELINE_H_
+#define PIPELINE_H_
+
+#include <zephyr/sys/util.h>
+
+/*
+ * 编译期处理流水线
+ *
+ * 一条流水线用一个 X-macro 列表声明，每一项 X(kind, fn, enabled)：
+ *   kind     ACQUIRE / FILTER / DETECT / AGGREGATE / SINK（按这个顺序写，只做标注）
+ *   fn       enum pipe_rc fn(ctx_type *ctx)，一般是 static 函数
+ *   enabled  1，或者 Kconfig 符号（未定义 = 关，和 IS_ENABLED 一样）
+ *
+ * 例：
+ *   #define MY_PIPELINE(X)                                          \
+ *       X(ACQUIRE,   stage_read,     1)                              \
+ *       X(FILTER,    stage_range,    CONFIG_MY_RANGE_CHECK)          \
+ *       X(SINK,      stage_log,      CONFIG_MY_LOG)
+ *
+ *   PIPELINE_RUN(MY_PIPELINE, &ctx);
+ *
+ * PIPELINE_RUN 按顺序展开成直接调用。关掉的级别预处理后只剩
+ * if (0 && fn(ctx))，编译器删掉调用，--gc-sections 再删掉函数本体；
+ * 没有函数指针表，也没有运行时注册。每个产品变体只编进它打开的级别。
+ *
+ * 某一级返回 PIPE_STOP 时后面的级别都不跑（例如过滤级丢掉无效样本）。
+ */
+
+enum pipe_rc {
+    PIPE_CONTINUE = 0,
+    PIPE_STOP,
+};
+
+#define Z_PIPE_CALL(kind, fn, enabled)                                  \
+    if (IS_ENABLED(enabled) && fn(z_pipe_ctx) != PIPE_CONTINUE) {       \
+        break;                                                          \
+    }
+
+#define PIPELINE_RUN(list, ctx)                                         \
+    do {                                                                \
+        __typeof__(ctx) z_pipe_ctx = (ctx);                             \
+        list(Z_PIPE_CALL)                                               \
+    } while (0)
+
+/* 打开的级别数（编译期常量） */
+#define Z_PIPE_COUNT(kind, fn, enabled) + IS_ENABLED(enabled)
+#define PIPELINE_STAGES(list) (0 list(Z_PIPE_COUNT))
+
+/* 启动时打印一条流水线实际编进来的级别，调用处要有 LOG_MODULE_REGISTER */
+#define Z_PIPE_LOG(kind, fn, enabled)                                   \
+    if (IS_ENABLED(enabled)) {                                          \
+        LOG_INF("  %-9s %s", #kind, #fn);                               \
+    }
+
+#define PIPELINE_LOG(name, list)                                        \
+    do {                                                                \
+        LOG_INF("Pipeline %s: %d stage(s)", name, PIPELINE_STAGES(list)); \
+        list(Z_PIPE_LOG)                                                \
+    } while (0)
+
+#endif /* PIPELINE_H_ */
@@ -10,6 +10,9 @@
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/logging/log.h>
 #include <math.h>
+#include <string.h>
+
+#include "pipeline.h"
 
 LOG_MODULE_REGISTER(app, LOG_LEVEL_INF);
 
@@ -201,6 +204,162 @@ typedef enum {
 	STATE_HIND    /* 向后倾 */
 } balance_state_t;
 
+/* ====== 马背平衡监控参数 ====== */
+
+#define LR_THRESH     15.0f  /* 左右阈值 (deg) */
+#define FH_THRESH     15.0f  /* 前后阈值 (deg) */
+#define MIN_SAMPLES   10     /* 连续多少帧超限才认为失衡 ≈ 1s */
+
+/* 每个 “BNO-only 10 秒窗口” 开始时清零 */
+static struct {
+	bool first_sample;
+	balance_state_t last_state;
+
+	/* baseline：第一次读到的 roll / pitch 作为 0 点 */
+	float roll0;
+	float pitch0;
+
+	/* 去抖计数 + 方向 */
+	uint8_t lr_over_cnt;
+	uint8_t fh_over_cnt;
+	int lr_dir;  /* -1=左, +1=右 */
+	int fh_dir;  /* -1=前, +1=后 */
+} bal;
+
+/* 一帧在流水线里传递的数据，级别见下面的 BNO_PIPELINE */
+struct bno_pipe_ctx {
+	float heading;
+	float roll;
+	float pitch;
+	bool baseline;                /* 本帧刚设了 baseline，不做判断 */
+	balance_state_t prev_state;
+	balance_state_t cur_state;
+};
+
+/* ACQUIRE：读一帧欧拉角 */
+static enum pipe_rc stage_read_eul(struct bno_pipe_ctx *c)
+{
+	uint8_t raw[6];
+	int ret = bno_rd(REG_EUL_H_L, raw, sizeof(raw));
+
+	if (ret) {
+		LOG_ERR("BNO055 read EUL failed (%d)", ret);
+		return PIPE_STOP;
+	}
+
+	int16_t heading_raw = (int16_t)((raw[1] << 8) | raw[0]);
+	int16_t roll_raw    = (int16_t)((raw[3] << 8) | raw[2]);
+	int16_t pitch_raw   = (int16_t)((raw[5] << 8) | raw[4]);
+
+	c->heading = heading_raw / 16.0f;
+	c->roll    = roll_raw    / 16.0f;
+	c->pitch   = pitch_raw   / 16.0f;
+	return PIPE_CONTINUE;
+}
+
+/* DETECT：相对 baseline 的偏移 + 连续超限去抖 */
+static enum pipe_rc stage_balance(struct bno_pipe_ctx *c)
+{
+	if (bal.first_sample) {
+		/* 第一次采样：记录基准，只打印一次 baseline */
+		bal.roll0  = c->roll;
+		bal.pitch0 = c->pitch;
+		bal.first_sample = false;
+		bal.last_state = STATE_NORMAL;
+		c->baseline = true;
+
+		LOG_INF("Normal baseline set: roll0=%.2f, pitch0=%.2f",
+			(double)bal.roll0, (double)bal.pitch0);
+		return PIPE_CONTINUE;
+	}
+
+	/* 相对 baseline 的偏移 */
+	float d_roll  = c->roll  - bal.roll0;   /* 左右 */
+	float d_pitch = c->pitch - bal.pitch0;  /* 前后 */
+
+	bool lr_over = fabsf(d_roll)  > LR_THRESH;
+	bool fh_over = fabsf(d_pitch) > FH_THRESH;
+
+	/* 左右方向的“连续超限”计数 */
+	if (lr_over) {
+		bal.lr_dir = (d_roll < 0.0f) ? -1 : +1;
+		if (bal.lr_over_cnt < 255) {
+			bal.lr_over_cnt++;
+		}
+	} else {
+		bal.lr_over_cnt = 0;
+	}
+
+	/* 前后方向的“连续超限”计数 */
+	if (fh_over) {
+		bal.fh_dir = (d_pitch < 0.0f) ? -1 : +1;
+		if (bal.fh_over_cnt < 255) {
+			bal.fh_over_cnt++;
+		}
+	} else {
+		bal.fh_over_cnt = 0;
+	}
+
+	/* 根据连续计数 + 方向 来判定当前状态 */
+	c->cur_state = STATE_NORMAL;
+
+	if (bal.lr_over_cnt >= MIN_SAMPLES &&
+	    bal.lr_over_cnt >= bal.fh_over_cnt) {
+		c->cur_state = (bal.lr_dir < 0) ? STATE_LEFT : STATE_RIGHT;
+	} else if (bal.fh_over_cnt >= MIN_SAMPLES) {
+		c->cur_state = (bal.fh_dir < 0) ? STATE_FRONT : STATE_HIND;
+	}
+
+	c->prev_state = bal.last_state;
+	bal.last_state = c->cur_state;
+	return PIPE_CONTINUE;
+}
+
+/* SINK：在正常范围内，每帧打一条 Normal */
+static enum pipe_rc stage_log_normal(struct bno_pipe_ctx *c)
+{
+	if (!c->baseline && c->cur_state == STATE_NORMAL) {
+		LOG_INF("Normal");
+	}
+	return PIPE_CONTINUE;
+}
+
+/* SINK：只有进入某个失衡状态时，打一条 warning */
+static enum pipe_rc stage_log_warning(struct bno_pipe_ctx *c)
+{
+	if (c->baseline) {
+		return PIPE_CONTINUE;
+	}
+
+	if (c->cur_state != c->prev_state && c->cur_state != STATE_NORMAL) {
+		switch (c->cur_state) {
+		case STATE_LEFT:
+			LOG_WRN("Left–right imbalance: leaning left");
+			break;
+		case STATE_RIGHT:
+			LOG_WRN("Left–right imbalance: leaning right");
+			break;
+		case STATE_FRONT:
+			LOG_WRN("Front–hind imbalance: front-heavy (leaning forward)");
+			break;
+		case STATE_HIND:
+			LOG_WRN("Front–hind imbalance: hind-heavy (leaning backward)");
+			break;
+		default:
+			break;
+		}
+	}
+
+	return PIPE_CONTINUE;
+}
+
+/* 级别在编译期由 Kconfig 决定，见 pipeline.h */
+#define BNO_PIPELINE(X)                                                   \
+	X(ACQUIRE, stage_read_eul,    1)                                  \
+	X(DETECT,  stage_balance,     1)                                  \
+	X(SINK,    stage_log_normal,  CONFIG_SENSOR_SHELL_LOG_NORMAL)     \
+	X(SINK,    stage_log_warning, CONFIG_SENSOR_SHELL_LOG_IMBALANCE)
+
 static void bno055_thread(void *p1, void *p2, void *p3)
 {
 	ARG_UNUSED(p1);
@@ -212,6 +371,8 @@ static void bno055_thread(void *p1, void *p2, void *p3)
 		return;
 	}
 
+	PIPELINE_LOG("bno", BNO_PIPELINE);
+
 	while (1) {
 
 		/* 等待到 “BNO-only 阶段” 才工作 */
@@ -258,121 +419,17 @@ static void bno055_thread(void *p1, void *p2, void *p3)
 		}
 		k_msleep(50);
 
-		/* ====== 马背平衡监控参数 ====== */
-
-		const float LR_THRESH     = 15.0f; /* 左右阈值 (deg) */
-		const float FH_THRESH     = 15.0f; /* 前后阈值 (deg) */
-		const uint8_t MIN_SAMPLES = 10;    /* 连续多少帧超限才认为失衡 ≈ 1s */
-
-		bool first_sample = true;
-		balance_state_t last_state = STATE_NORMAL;
-
-		/* baseline：第一次读到的 roll / pitch 作为 0 点 */
-		float roll0  = 0.0f;
-		float pitch0 = 0.0f;
-
-		/* 去抖计数 + 方向 */
-		uint8_t lr_over_cnt = 0;
-		uint8_t fh_over_cnt = 0;
-		int lr_dir = 0;  /* -1=左, +1=右 */
-		int fh_dir = 0;  /* -1=前, +1=后 */
+		memset(&bal, 0, sizeof(bal));
+		bal.first_sample = true;
+		bal.last_state = STATE_NORMAL;
 
 		/* 在当前这个 “BNO-only 10 秒窗口” 内循环采样，
 		 * 当 main 把 g_phase 切回 BME_ONLY 时，就会跳出这个循环。
 		 */
 		while (g_phase == HB_PHASE_BNO_ONLY) {
-			uint8_t raw[6];
-
-			ret = bno_rd(REG_EUL_H_L, raw, sizeof(raw));
-			if (ret) {
-				LOG_ERR("BNO055 read EUL failed (%d)", ret);
-				k_msleep(100);
-				continue;
-			}
-
-			int16_t heading_raw = (int16_t)((raw[1] << 8) | raw[0]);
-			int16_t roll_raw    = (int16_t)((raw[3] << 8) | raw[2]);
-			int16_t pitch_raw   = (int16_t)((raw[5] << 8) | raw[4]);
-
-			float heading = heading_raw / 16.0f;
-			float roll    = roll_raw    / 16.0f;
-			float pitch   = pitch_raw   / 16.0f;
-			(void)heading; /* 暂时不用 heading，避免编译警告 */
-
-			if (first_sample) {
-				/* 第一次采样：记录基准，只打印一次 baseline */
-				roll0  = roll;
-				pitch0 = pitch;
-				first_sample = false;
-				last_state = STATE_NORMAL;
-
-				LOG_INF("Normal baseline set: roll0=%.2f, pitch0=%.2f",
-					(double)roll0, (double)pitch0);
-			} else {
-				/* 相对 baseline 的偏移 */
-				float d_roll  = roll  - roll0;   /* 左右 */
-				float d_pitch = pitch - pitch0;  /* 前后 */
-
-				bool lr_over = fabsf(d_roll)  > LR_THRESH;
-				bool fh_over = fabsf(d_pitch) > FH_THRESH;
-
-				/* 左右方向的“连续超限”计数 */
-				if (lr_over) {
-					lr_dir = (d_roll < 0.0f) ? -1 : +1;
-					if (lr_over_cnt < 255) {
-						lr_over_cnt++;
-					}
-				} else {
-					lr_over_cnt = 0;
-				}
-
-				/* 前后方向的“连续超限”计数 */
-				if (fh_over) {
-					fh_dir = (d_pitch < 0.0f) ? -1 : +1;
-					if (fh_over_cnt < 255) {
-						fh_over_cnt++;
-					}
-				} else {
-					fh_over_cnt = 0;
-				}
-
-				/* 根据连续计数 + 方向 来判定当前状态 */
-				balance_state_t cur_state = STATE_NORMAL;
-
-				if (lr_over_cnt >= MIN_SAMPLES &&
-				    lr_over_cnt >= fh_over_cnt) {
-					cur_state = (lr_dir < 0) ? STATE_LEFT : STATE_RIGHT;
-				} else if (fh_over_cnt >= MIN_SAMPLES) {
-					cur_state = (fh_dir < 0) ? STATE_FRONT : STATE_HIND;
-				}
-
-				/* 在正常范围内，每帧打一条 Normal（你可以以后改成降低频率） */
-				if (cur_state == STATE_NORMAL) {
-					LOG_INF("Normal");
-				}
-
-				/* 只有进入某个失衡状态时，打一条 warning */
-				if (cur_state != last_state && cur_state != STATE_NORMAL) {
-					switch (cur_state) {
-					case STATE_LEFT:
-						LOG_WRN("Left–right imbalance: leaning left");
-						break;
-					case STATE_RIGHT:
-						LOG_WRN("Left–right imbalance: leaning right");
-						break;
-					case STATE_FRONT:
-						LOG_WRN("Front–hind imbalance: front-heavy (leaning forward)");
-						break;
-					case STATE_HIND:
-						LOG_WRN("Front–hind imbalance: hind-heavy (leaning backward)");
-						break;
-					default:
-						break;
-					}
-				}
-
-				last_state = cur_state;
-			}
+			struct bno_pipe_ctx ctx = { 0 };
+
+			PIPELINE_RUN(BNO_PIPELINE, &ctx);
 
 			/* 100 ms 一帧 */
 			k_msleep(100);